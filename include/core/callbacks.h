@@ -1,5 +1,7 @@
 #ifndef CALLBACKS_H
 #define CALLBACKS_H
+#include "core/mac_table.h"
+#include "core/pineap_table.h"
 #include "esp_wifi_types.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -11,37 +13,10 @@
 #include "host/ble_gap.h"
 #endif
 
-#define MAX_PINEAP_NETWORKS 20
-#define MAX_SSIDS_PER_BSSID 10
 #define RECENT_SSID_COUNT 5
 
-// PineAP detection structures
-typedef struct {
-  uint8_t bssid[6];
-  uint8_t ssid_count;
-  bool is_pineap;
-  time_t first_seen;
-  uint32_t ssid_hashes[MAX_SSIDS_PER_BSSID];
-  // Circular buffer for recent SSIDs
-  char recent_ssids[RECENT_SSID_COUNT][33];
-  uint8_t recent_ssid_index;
-  TaskHandle_t log_task_handle;
-  int8_t last_channel;
-  int8_t last_rssi;
-} pineap_network_t;
-
-// Structure for passing data to logging task
-typedef struct {
-  uint8_t bssid[6];
-  char recent_ssids[RECENT_SSID_COUNT][33];
-  int ssid_count;
-  int8_t channel;
-  int8_t rssi;
-  struct pineap_network_t *network; // Add network pointer
-} pineap_log_data_t;
-
 // PineAP detection control functions
-void start_pineap_detection(void);
+esp_err_t start_pineap_detection(void);
 void stop_pineap_detection(void);
 
 // Forward declarations of callback functions
@@ -54,12 +29,14 @@ void wifi_probe_scan_callback(void *buf, wifi_promiscuous_pkt_type_t type);
 void wifi_raw_scan_callback(void *buf, wifi_promiscuous_pkt_type_t type);
 void wifi_eapol_scan_callback(void *buf, wifi_promiscuous_pkt_type_t type);
 void wardriving_scan_callback(void *buf, wifi_promiscuous_pkt_type_t type);
+// Clears (allocating on first use) the table that suppresses repeat
+// wardriving rows for the same BSSID.
+esp_err_t wardriving_dedup_reset(void);
+void wardriving_dedup_stats(uint32_t *sightings, uint32_t *logged, mac_table_stats_t *table);
 void ble_wardriving_callback(struct ble_gap_event *event, void *arg);
 void ble_skimmer_scan_callback(struct ble_gap_event *event, void *arg);
 void gps_event_handler(void *event_handler_arg, esp_event_base_t event_base,
                        int32_t event_id, void *event_data);
-void wifi_stations_sniffer_callback(void *buf,
-                                    wifi_promiscuous_pkt_type_t type);
 
 typedef enum {
   WPS_MODE_NONE = 0, // No WPS support
@@ -74,7 +51,6 @@ typedef struct {
   wps_modes_t wps_mode; // WPS mode (PIN or PBC)
 } wps_network_t;
 
-extern gps_t *gps;
 extern wps_network_t detected_wps_networks[MAX_WPS_NETWORKS];
 extern int detected_network_count;
 extern esp_timer_handle_t stop_timer;
@@ -0,0 +1,56 @@
+#ifndef CAPTURE_INDEX_H
+#define CAPTURE_INDEX_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Append-only manifest of capture files kept on the SD card. Every session
+// appends an open record and a close record, so the next file number for a
+// base name is a table lookup instead of a directory scan, and listings only
+// read the tail of one file.
+#define CAPTURE_INDEX_PATH "/mnt/ghostesp/captures.idx"
+#define CAPTURE_INDEX_NAME_LEN 32
+#define CAPTURE_INDEX_MAX_NAMES 48
+#define CAPTURE_INDEX_LIST_MAX 64
+
+typedef enum {
+  CAPTURE_FILE_PCAP,
+  CAPTURE_FILE_PCAPNG,
+  CAPTURE_FILE_CSV,
+  CAPTURE_FILE_GWD, // Binary wardriving log, see wardrive_format.h
+  CAPTURE_FILE_TYPE_COUNT
+} capture_file_type_t;
+
+typedef struct {
+  capture_file_type_t type;
+  char base_name[CAPTURE_INDEX_NAME_LEN];
+  uint16_t file_index;
+  uint32_t start_time; // Unix seconds, 0 if the clock was not set
+  uint32_t size;       // Bytes, valid once closed
+  uint32_t packets;    // Packets, CSV rows or GWD records; valid once closed
+  bool closed;
+} capture_index_entry_t;
+
+// Reserves the next file number for base_name and records the session start.
+// Returns ESP_ERR_INVALID_STATE when no SD card is mounted.
+esp_err_t capture_index_open(capture_file_type_t type, const char *base_name,
+                             int *file_index);
+// Records the final size and packet count of a session.
+esp_err_t capture_index_close(capture_file_type_t type, const char *base_name,
+                              int file_index, uint32_t size, uint32_t packets);
+// Marks the capture stored at path as deleted; ignores non-capture paths.
+void capture_index_forget_path(const char *path);
+// Next file number for base_name without reserving it.
+int capture_index_peek(capture_file_type_t type, const char *base_name);
+// Builds the on-card path of a capture file.
+void capture_index_format_path(char *buffer, size_t size,
+                               capture_file_type_t type, const char *base_name,
+                               int file_index);
+// Fills entries with up to max of the most recent sessions, oldest first.
+// Deleted captures are skipped.
+size_t capture_index_list(capture_index_entry_t *entries, size_t max);
+const char *capture_index_type_name(capture_file_type_t type);
+
+#endif // CAPTURE_INDEX_H
@@ -0,0 +1,67 @@
+#ifndef CAPTURE_ROTATE_H
+#define CAPTURE_ROTATE_H
+
+#include "core/capture_index.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Rotation splits a long capture into numbered files. The next file is
+// created, pre-allocated and given its header on a background task, so the
+// owner only swaps FILE pointers between two writes.
+#define CAPTURE_ROTATE_PATH_LEN 128
+#define CAPTURE_ROTATE_MIN_BYTES (64 * 1024)
+
+typedef struct {
+  uint32_t max_bytes;   // 0 disables size based rotation
+  uint32_t max_seconds; // 0 disables time based rotation
+} capture_rotation_t;
+
+typedef esp_err_t (*capture_header_writer_t)(FILE *f, void *ctx);
+
+typedef struct {
+  FILE *file;
+  int index;             // Capture index number, -1 if not indexed
+  uint32_t header_bytes; // Bytes written by the header writer
+  char path[CAPTURE_ROTATE_PATH_LEN];
+} capture_file_t;
+
+typedef struct {
+  // Filled in by the owner before the first capture_spare_prepare()
+  capture_file_type_t type;
+  char base_name[CAPTURE_INDEX_NAME_LEN];
+  uint32_t prealloc_bytes;
+  capture_header_writer_t write_header;
+  void *ctx;
+
+  capture_file_t next;     // Valid while ready is set
+  capture_file_t retired;  // Handed back by a swap, finalized in background
+  uint32_t retired_packets;
+  bool ready;
+  bool busy; // A background job for this spare is queued or running
+} capture_spare_t;
+
+static inline bool capture_rotation_enabled(const capture_rotation_t *rotation) {
+  return rotation != NULL &&
+         (rotation->max_bytes != 0 || rotation->max_seconds != 0);
+}
+
+// Creates, pre-allocates and writes the header of the next numbered file.
+// Blocking; used for the first file of a session and by the background task.
+esp_err_t capture_file_create(const capture_spare_t *spare, capture_file_t *out);
+// Cuts off the unused pre-allocation, records the file in the capture index
+// and closes it.
+void capture_file_finalize(capture_file_t *file, capture_file_type_t type,
+                           const char *base_name, uint32_t packets);
+
+// Starts preparing the next file in the background if none is ready.
+esp_err_t capture_spare_prepare(capture_spare_t *spare);
+// Swaps current for the prepared file if one is ready; never blocks. The old
+// file is finalized in the background and the following one is prepared.
+bool capture_spare_swap(capture_spare_t *spare, capture_file_t *current,
+                        uint32_t packets);
+// Waits for background work and deletes an unused prepared file.
+void capture_spare_shutdown(capture_spare_t *spare);
+
+#endif // CAPTURE_ROTATE_H
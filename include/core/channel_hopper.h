@@ -0,0 +1,78 @@
+#ifndef CHANNEL_HOPPER_H
+#define CHANNEL_HOPPER_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// One channel hopper shared by every monitor mode. Modes that want to hop
+// acquire it and release it when they stop; it runs while anyone holds it.
+// Frames counted by the frame dispatcher are credited to the channel they
+// were heard on, which the weighted policy uses to spend more time where
+// there is traffic.
+
+#if defined(CONFIG_IDF_TARGET_ESP32C5)
+#define CHANNEL_HOPPER_HAS_5GHZ 1
+#define CHANNEL_HOPPER_MAX_CHANNELS 48
+#else
+#define CHANNEL_HOPPER_HAS_5GHZ 0
+#define CHANNEL_HOPPER_MAX_CHANNELS 14
+#endif
+
+#define CHANNEL_HOPPER_MIN_DWELL_MS 20
+#define CHANNEL_HOPPER_MAX_DWELL_MS 5000
+
+typedef enum {
+  CHANNEL_HOP_FIXED = 0, // Equal dwell on every channel in turn
+  CHANNEL_HOP_WEIGHTED,  // Dwell in proportion to recent frames and beacons
+  CHANNEL_HOP_LOCK,      // Stay on one channel, visit the others briefly
+} channel_hop_policy_t;
+
+typedef struct {
+  channel_hop_policy_t policy;
+  uint16_t dwell_ms;      // Per channel (fixed), average (weighted) or
+                          // per excursion (lock)
+  uint8_t lock_channel;   // Lock policy only
+  uint16_t lock_ms;       // Time on lock_channel between excursions
+} channel_hop_config_t;
+
+#define CHANNEL_HOP_CONFIG_DEFAULT()                                           \
+  {                                                                            \
+    .policy = CHANNEL_HOP_FIXED, .dwell_ms = 200, .lock_channel = 1,           \
+    .lock_ms = 1000,                                                           \
+  }
+
+typedef struct {
+  uint8_t channel;
+  uint32_t visits;
+  uint32_t dwell_ms;
+  uint32_t frames;
+  uint32_t beacons;
+  uint16_t weight; // Current share used by the weighted policy, per mille
+} channel_hop_stats_t;
+
+// Starts hopping on the first acquire; stops after the last release.
+esp_err_t channel_hopper_acquire(void);
+void channel_hopper_release(void);
+// Stops regardless of holders, e.g. when monitor mode ends.
+void channel_hopper_reset(void);
+bool channel_hopper_running(void);
+
+void channel_hopper_get_config(channel_hop_config_t *config);
+esp_err_t channel_hopper_set_config(const channel_hop_config_t *config);
+
+// Replaces the channel set; channels the radio cannot tune are rejected.
+esp_err_t channel_hopper_set_channels(const uint8_t *channels, int count);
+// Default set: 2.4 GHz 1-13, plus the 5 GHz channels on dual-band targets.
+void channel_hopper_default_channels(void);
+int channel_hopper_get_channels(uint8_t *channels, int max);
+bool channel_hopper_channel_valid(uint8_t channel);
+
+// Called by the frame dispatcher for every frame received.
+void channel_hopper_note_frame(bool beacon);
+
+int channel_hopper_get_stats(channel_hop_stats_t *stats, int max);
+void channel_hopper_reset_stats(void);
+const char *channel_hopper_policy_name(channel_hop_policy_t policy);
+
+#endif // CHANNEL_HOPPER_H
@@ -0,0 +1,60 @@
+#ifndef CHANNEL_SURVEY_H
+#define CHANNEL_SURVEY_H
+
+#include "core/channel_hopper.h"
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Per-channel congestion survey. Every frame the monitor hands over is
+// folded into fixed counters for the channel it was heard on: frames by
+// type, bytes, estimated airtime, an RSSI histogram and a distinct
+// transmitter sketch. Nothing allocates or searches per frame, so the
+// survey can run next to captures without slowing them down.
+
+#define SURVEY_MAX_CHANNELS CHANNEL_HOPPER_MAX_CHANNELS
+
+// RSSI buckets are 10 dB wide: below -90, -90..-81, ..., -40..-31, -30 and up.
+#define SURVEY_RSSI_BUCKETS 8
+#define SURVEY_RSSI_FLOOR -90
+#define SURVEY_RSSI_STEP 10
+
+// Distinct transmitters are estimated by linear counting over a bitmap of
+// hashed addresses, so memory stays fixed however many devices are heard.
+#define SURVEY_TX_BITMAP_BITS 512
+
+typedef struct {
+  uint8_t channel;
+  uint32_t mgmt_frames;
+  uint32_t ctrl_frames;
+  uint32_t data_frames;
+  uint64_t bytes;
+  uint64_t airtime_us;
+  uint32_t dwell_ms;  // Time the hopper spent listening here
+  uint16_t busy_x10;  // Airtime as a share of dwell, tenths of a percent
+  int8_t rssi_max;
+  uint32_t rssi_hist[SURVEY_RSSI_BUCKETS];
+  uint16_t transmitters; // Estimated distinct transmitter addresses
+} channel_survey_t;
+
+// Registers the survey as a monitor consumer and starts hopping.
+esp_err_t channel_survey_start(void);
+void channel_survey_stop(void);
+bool channel_survey_running(void);
+void channel_survey_reset(void);
+
+// Accounts one received frame. This is the whole per-frame path and only
+// touches the packet it is given, so recorded frames can be replayed into it.
+void channel_survey_record(const wifi_promiscuous_pkt_t *pkt);
+
+// Estimated on-air time of a frame from its PHY rate and length.
+uint32_t channel_survey_airtime_us(const wifi_pkt_rx_ctrl_t *rx_ctrl);
+
+// Copies the channels seen so far, in the order they were first heard.
+int channel_survey_get(channel_survey_t *out, int max);
+
+// Returns the report as a JSON string the caller frees, or NULL.
+char *channel_survey_to_json(void);
+
+#endif // CHANNEL_SURVEY_H
@@ -0,0 +1,39 @@
+#ifndef DEAUTH_WATCH_H
+#define DEAUTH_WATCH_H
+
+#include "core/deauth_window.h"
+#include "core/mac_table.h"
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Deauthentication/disassociation flood watch. Frames are counted per BSSID
+// and per unicast target in deauth_window sliding windows held in
+// mac_tables, so memory is fixed and a frame costs two hash lookups. When a
+// window reaches the threshold a "DEAUTHWATCH start" line is printed, saying
+// whether the frames are broadcast or targeted and which source they claim;
+// "DEAUTHWATCH end" follows once the rate has dropped.
+
+typedef struct {
+  uint32_t frames;
+  uint32_t alerts;  // Floods started
+  uint32_t dropped; // Alerts lost to a full queue
+  uint16_t threshold;
+  mac_table_stats_t bssids;
+  mac_table_stats_t targets;
+} deauth_watch_stats_t;
+
+// Registers the watch as a monitor consumer and starts hopping. threshold is
+// frames per DEAUTH_WINDOW_BUCKETS-second window; 0 keeps
+// CONFIG_DEAUTHWATCH_THRESHOLD.
+esp_err_t deauth_watch_start(uint16_t threshold);
+void deauth_watch_stop(void);
+bool deauth_watch_running(void);
+
+// Accounts one deauthentication or disassociation frame.
+void deauth_watch_record(const wifi_promiscuous_pkt_t *pkt);
+
+void deauth_watch_get_stats(deauth_watch_stats_t *stats);
+
+#endif // DEAUTH_WATCH_H
@@ -0,0 +1,65 @@
+#ifndef DEAUTH_WINDOW_H
+#define DEAUTH_WINDOW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Sliding-window rate tracking for deauthentication and disassociation
+// floods. A window is a ring of per-second buckets with a running sum, so
+// adding a frame or reading the rate is O(1) and the state is a few bytes,
+// whatever the frame rate. Time comes in as bucket numbers from the
+// caller. No ESP-IDF dependencies, so frame timelines can be replayed on a
+// host.
+
+#define DEAUTH_WINDOW_BUCKETS 8
+#define DEAUTH_WINDOW_BUCKET_MS 1000
+
+typedef struct {
+  uint32_t head; // Bucket number counts[head % DEAUTH_WINDOW_BUCKETS] holds
+  uint16_t sum;
+  uint8_t counts[DEAUTH_WINDOW_BUCKETS]; // Saturate at 255 per bucket
+} deauth_window_t;
+
+// Slides the window forward to bucket now and returns the frames in it: the
+// current bucket plus the DEAUTH_WINDOW_BUCKETS - 1 before it.
+uint16_t deauth_window_advance(deauth_window_t *window, uint32_t now);
+// Counts one frame in bucket now; returns the new sum.
+uint16_t deauth_window_add(deauth_window_t *window, uint32_t now);
+
+typedef enum {
+  DEAUTH_FLOOD_NONE,
+  DEAUTH_FLOOD_STARTED,
+  DEAUTH_FLOOD_ENDED,
+} deauth_flood_event_t;
+
+typedef struct {
+  const uint8_t *source; // Claimed transmitter (addr2)
+  bool broadcast;        // Sent to the broadcast address
+  uint16_t reason;       // 0 when the body is protected
+  uint8_t subtype;       // Deauthentication or disassociation
+} deauth_frame_t;
+
+// One address's flood state. The counters cover the current episode, which
+// starts with the first frame after a window with none in it.
+typedef struct {
+  deauth_window_t window;
+  uint32_t frames;
+  uint32_t broadcast;
+  uint16_t peak; // Highest window sum this episode
+  uint16_t reason;
+  uint8_t source[6];
+  uint8_t subtype;
+  bool sources_vary;
+  bool flooding;
+} deauth_flood_t;
+
+// Accounts a frame. A flood starts when the window reaches threshold and
+// ends once it falls below half of it.
+deauth_flood_event_t deauth_flood_record(deauth_flood_t *flood,
+                                         const deauth_frame_t *frame,
+                                         uint32_t now, uint16_t threshold);
+// Ends a flood whose frames have stopped; call it periodically.
+deauth_flood_event_t deauth_flood_expire(deauth_flood_t *flood, uint32_t now,
+                                         uint16_t threshold);
+
+#endif // DEAUTH_WINDOW_H
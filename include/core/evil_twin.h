@@ -0,0 +1,26 @@
+#ifndef EVIL_TWIN_H
+#define EVIL_TWIN_H
+
+#include "core/ssid_map.h"
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Evil-twin and rogue-AP watch. Beacons and probe responses are folded into
+// an ssid_map; an AP advertising a known SSID with different security, from
+// a different vendor or on a different channel than the first AP heard with
+// it raises an alert. Alerts are queued to a worker task and printed as one
+// "EVILWATCH" line each, so host tools can follow the stream.
+
+// Registers the watch as a monitor consumer and starts hopping.
+esp_err_t evil_twin_start(void);
+void evil_twin_stop(void);
+bool evil_twin_running(void);
+
+// Accounts one beacon or probe response.
+void evil_twin_record(const wifi_promiscuous_pkt_t *pkt);
+
+void evil_twin_get_stats(ssid_map_stats_t *stats, uint32_t *dropped);
+
+#endif // EVIL_TWIN_H
@@ -0,0 +1,77 @@
+#ifndef FRAME_DISPATCH_H
+#define FRAME_DISPATCH_H
+
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Owns the one promiscuous callback the Wi-Fi driver allows and fans frames
+// out to any number of consumers. A frame's class is its frame control type
+// and subtype (type * 16 + subtype); each consumer subscribes to a 64-bit
+// mask of classes. Delivering a frame costs one table lookup, and consumers
+// only ever see the classes they asked for.
+
+#define FRAME_DISPATCH_MAX_CONSUMERS 8
+#define FRAME_DISPATCH_NAME_LEN 16
+
+#define FRAME_TYPE_MGMT 0
+#define FRAME_TYPE_CTRL 1
+#define FRAME_TYPE_DATA 2
+
+// Management subtypes
+#define FRAME_SUBTYPE_ASSOC_REQ 0x0
+#define FRAME_SUBTYPE_ASSOC_RESP 0x1
+#define FRAME_SUBTYPE_REASSOC_REQ 0x2
+#define FRAME_SUBTYPE_REASSOC_RESP 0x3
+#define FRAME_SUBTYPE_PROBE_REQ 0x4
+#define FRAME_SUBTYPE_PROBE_RESP 0x5
+#define FRAME_SUBTYPE_BEACON 0x8
+#define FRAME_SUBTYPE_DISASSOC 0xa
+#define FRAME_SUBTYPE_AUTH 0xb
+#define FRAME_SUBTYPE_DEAUTH 0xc
+#define FRAME_SUBTYPE_ACTION 0xd
+
+#define FRAME_CLASS(type, subtype) (((type) << 4) | (subtype))
+#define FRAME_BIT(type, subtype) (1ULL << FRAME_CLASS(type, subtype))
+#define FRAME_MGMT_BIT(subtype) FRAME_BIT(FRAME_TYPE_MGMT, subtype)
+
+#define FRAME_MASK_MGMT 0x000000000000FFFFULL
+#define FRAME_MASK_CTRL 0x00000000FFFF0000ULL
+#define FRAME_MASK_DATA 0x0000FFFF00000000ULL
+#define FRAME_MASK_ALL (FRAME_MASK_MGMT | FRAME_MASK_CTRL | FRAME_MASK_DATA)
+
+typedef void (*frame_consumer_cb_t)(void *buf, wifi_promiscuous_pkt_type_t type);
+
+typedef struct {
+  char name[FRAME_DISPATCH_NAME_LEN];
+  uint64_t mask;
+  uint32_t hits;
+  uint32_t avg_us_x100; // Mean time per call, hundredths of a microsecond
+  uint64_t total_us;
+} frame_consumer_stats_t;
+
+typedef struct {
+  uint32_t frames;    // Everything the driver handed over
+  uint32_t unclaimed; // Frames no consumer subscribed to
+} frame_dispatch_totals_t;
+
+// Adds a consumer, or replaces the mask and callback of the one with the same
+// name. Names group mutually exclusive users, e.g. the PCAP capture modes.
+esp_err_t frame_dispatch_add(const char *name, uint64_t mask,
+                             frame_consumer_cb_t callback);
+esp_err_t frame_dispatch_remove(const char *name);
+void frame_dispatch_clear(void);
+
+// Union of all consumer masks; the driver filter is derived from it.
+uint64_t frame_dispatch_mask(void);
+int frame_dispatch_count(void);
+
+// The callback to install with esp_wifi_set_promiscuous_rx_cb().
+void frame_dispatch_rx(void *buf, wifi_promiscuous_pkt_type_t type);
+
+int frame_dispatch_get_stats(frame_consumer_stats_t *stats, int max,
+                             frame_dispatch_totals_t *totals);
+void frame_dispatch_reset_stats(void);
+
+#endif // FRAME_DISPATCH_H
@@ -0,0 +1,101 @@
+#ifndef IEEE80211_IE_H
+#define IEEE80211_IE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Walks the tagged parameters (information elements) of 802.11 management
+// frames. Nothing is copied or allocated: every pointer handed out points
+// into the frame, so results are only valid while the frame buffer is.
+
+#define IEEE80211_MGMT_HDR_LEN 24
+
+#define IEEE80211_IE_SSID 0
+#define IEEE80211_IE_DS_PARAMS 3
+#define IEEE80211_IE_HT_CAP 45
+#define IEEE80211_IE_RSN 48
+#define IEEE80211_IE_HT_OPERATION 61
+#define IEEE80211_IE_VHT_CAP 191
+#define IEEE80211_IE_VHT_OPERATION 192
+#define IEEE80211_IE_VENDOR 221
+
+#define IEEE80211_SSID_MAX_LEN 32
+
+// Capability information bits of beacons and probe responses
+#define IEEE80211_CAP_ESS 0x0001
+#define IEEE80211_CAP_IBSS 0x0002
+#define IEEE80211_CAP_PRIVACY 0x0010
+
+#define WPS_ATTR_CONFIG_METHODS 0x1008
+
+typedef struct {
+  uint8_t id;
+  uint8_t len;
+  const uint8_t *data;
+} ieee80211_ie_t;
+
+typedef struct {
+  const uint8_t *pos;
+  const uint8_t *end;
+  bool malformed; // Stopped on an element that overran the buffer or
+                  // failed the length check; pos points at it
+} ieee80211_ie_iter_t;
+
+typedef enum {
+  IEEE80211_SECURITY_OPEN = 0,
+  IEEE80211_SECURITY_WEP,
+  IEEE80211_SECURITY_WPA,
+  IEEE80211_SECURITY_WPA2,
+} ieee80211_security_t;
+
+// Everything the frame consumers look at, gathered in a single pass.
+typedef struct {
+  uint16_t capability; // Beacon/probe response only, else 0
+  const uint8_t *ssid;
+  uint8_t ssid_len;
+  bool has_ssid;
+  uint8_t channel; // DS parameter set, else HT operation, else 0
+  const uint8_t *rsn;
+  uint8_t rsn_len;
+  const uint8_t *wpa; // Microsoft WPA vendor element, after the OUI/type
+  uint8_t wpa_len;
+  const uint8_t *wps; // WPS vendor element, after the OUI/type
+  uint8_t wps_len;
+  const uint8_t *ht_cap;
+  const uint8_t *vht_cap;
+  uint16_t ie_count;
+  bool malformed;
+} ieee80211_ies_t;
+
+void ieee80211_ie_iter_init(ieee80211_ie_iter_t *it, const uint8_t *ies,
+                            size_t len);
+// Returns the next element, or false at the end of the buffer or on the first
+// element that is truncated or has an impossible length.
+bool ieee80211_ie_next(ieee80211_ie_iter_t *it, ieee80211_ie_t *ie);
+
+// True if len is allowed for an element with this id.
+bool ieee80211_ie_length_valid(uint8_t id, uint8_t len);
+
+// Offset of the first element of a management frame, or 0 if the subtype
+// carries none or the frame is too short for its fixed fields.
+size_t ieee80211_mgmt_ie_offset(const uint8_t *frame, size_t len);
+
+void ieee80211_parse_ies(const uint8_t *ies, size_t len, ieee80211_ies_t *out);
+// Parses a whole management frame, including the capability field. Returns
+// false if it has no elements to parse.
+bool ieee80211_parse_mgmt(const uint8_t *frame, size_t len,
+                          ieee80211_ies_t *out);
+
+ieee80211_security_t ieee80211_security(const ieee80211_ies_t *ies);
+const char *ieee80211_security_name(ieee80211_security_t security);
+
+// Copies the SSID as a C string, with trailing whitespace removed. out must
+// hold IEEE80211_SSID_MAX_LEN + 1 bytes. Returns the copied length.
+size_t ieee80211_ssid_copy(const ieee80211_ies_t *ies, char *out);
+
+// Finds a big-endian WPS attribute inside ies->wps.
+bool ieee80211_wps_attr_find(const ieee80211_ies_t *ies, uint16_t attr_id,
+                             const uint8_t **value, uint16_t *value_len);
+
+#endif // IEEE80211_IE_H
@@ -0,0 +1,57 @@
+#ifndef MAC_TABLE_H
+#define MAC_TABLE_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed-size hash table keyed by 6-byte MAC addresses, for the per-device
+// state scan modes keep (wardriving dedup, station tracking, ...).
+//
+// Open addressing: an address lives in one of MAC_TABLE_PROBE consecutive
+// slots after its hash. When all of them are taken the least recently used
+// entry in that window is evicted, so inserts never fail and never walk the
+// table. Memory is allocated once at init; nothing allocates per lookup.
+//
+// Not locked; callers that share a table between tasks serialize access.
+
+#define MAC_TABLE_PROBE 8
+
+typedef struct {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t inserts;
+  uint32_t evictions;
+  uint32_t count; // Entries currently stored
+  uint32_t capacity;
+} mac_table_stats_t;
+
+typedef struct {
+  uint8_t *slots;
+  size_t slot_size;  // Entry header plus value, rounded up for alignment
+  size_t value_size;
+  uint32_t mask;     // capacity - 1
+  uint32_t clock;    // Bumped on every access; stamps entries for LRU
+  mac_table_stats_t stats;
+} mac_table_t;
+
+typedef void (*mac_table_visit_cb_t)(const uint8_t mac[6], void *value, void *ctx);
+
+// capacity is rounded up to a power of two. Values start zeroed.
+esp_err_t mac_table_init(mac_table_t *table, uint32_t capacity, size_t value_size);
+void mac_table_free(mac_table_t *table);
+void mac_table_clear(mac_table_t *table);
+
+// Returns the value stored for mac, or NULL. Counts a hit or a miss.
+void *mac_table_find(mac_table_t *table, const uint8_t mac[6]);
+// Returns the value for mac, adding a zeroed entry (and possibly evicting
+// the least recently used one nearby) if it was not there. *created tells
+// the two cases apart and may be NULL.
+void *mac_table_upsert(mac_table_t *table, const uint8_t mac[6], bool *created);
+bool mac_table_remove(mac_table_t *table, const uint8_t mac[6]);
+
+void mac_table_foreach(mac_table_t *table, mac_table_visit_cb_t visit, void *ctx);
+void mac_table_get_stats(const mac_table_t *table, mac_table_stats_t *stats);
+
+#endif // MAC_TABLE_H
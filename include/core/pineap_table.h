@@ -0,0 +1,55 @@
+#ifndef PINEAP_TABLE_H
+#define PINEAP_TABLE_H
+
+#include "core/mac_table.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Per-BSSID state of the PineAP detector: the SSIDs each BSSID has
+// advertised recently, kept as hashes in a mac_table keyed by the BSSID.
+// A BSSID advertising PINEAP_MIN_SSIDS or more live SSIDs is flagged. The
+// caller owns the table and its locking. No ESP-IDF dependencies beyond
+// mac_table, so beacon streams can be replayed on a host.
+
+#define PINEAP_SSIDS_PER_BSSID 6
+#define PINEAP_MIN_SSIDS 2 // Live SSIDs needed to flag a BSSID
+
+// Each SSID is forgotten after age_s seconds without a beacon.
+typedef struct {
+  uint32_t ssid_hashes[PINEAP_SSIDS_PER_BSSID];
+  uint32_t ssid_seen_s[PINEAP_SSIDS_PER_BSSID]; // Uptime when last heard
+  char last_ssid[33];
+  uint8_t ssid_count;
+  int8_t last_channel;
+  int8_t last_rssi;
+} pineap_network_t;
+
+// A new SSID from a BSSID that already advertises others, queued for the
+// alert worker.
+typedef struct {
+  uint8_t bssid[6];
+  char ssid[33];
+  char previous_ssid[33];
+  uint8_t live_ssids;
+  int8_t channel;
+  int8_t rssi;
+} pineap_alert_t;
+
+// djb2 over the lowercased SSID, so case variants count as one.
+uint32_t pineap_hash_ssid(const char *ssid);
+
+// Forgets SSIDs not heard within age_s and records hash as heard now.
+// Returns true if hash was not in the set. When the set is full the SSID
+// heard longest ago makes room.
+bool pineap_note_ssid(pineap_network_t *network, uint32_t hash, uint32_t now_s,
+                      uint32_t age_s);
+
+// Accounts one beacon from bssid advertising ssid (NUL-terminated, at most
+// 32 bytes). Returns true and fills *alert when it is a new SSID from a
+// flagged BSSID.
+bool pineap_table_observe(mac_table_t *table, const uint8_t bssid[6],
+                          const char *ssid, int8_t channel, int8_t rssi,
+                          uint32_t now_s, uint32_t age_s,
+                          pineap_alert_t *alert);
+
+#endif // PINEAP_TABLE_H
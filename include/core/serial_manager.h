@@ -3,6 +3,7 @@
 #ifndef SERIAL_MANAGER_H
 #define SERIAL_MANAGER_H
 
+#include <esp_err.h>
 #include <esp_types.h>
 #include <managers/display_manager.h>
 
@@ -16,6 +17,28 @@ int handle_serial_command(const char *input);
 
 void simulateCommand(const char *commandString);
 
+#define SERIAL_BAUD_MIN 9600
+#define SERIAL_BAUD_MAX 2000000
+#define SERIAL_BAUD_CONFIRM_SECONDS 10
+
+typedef struct {
+  uint32_t baud;
+  uint32_t bytes;
+  int64_t elapsed_us;
+} serial_selftest_result_t;
+
+uint32_t serial_manager_get_baud(void);
+
+// Switches the console UART to baud and waits up to confirm_ms for the host
+// to answer the probe at the new rate. Reverts and returns ESP_ERR_TIMEOUT if
+// it does not.
+esp_err_t serial_manager_set_baud(uint32_t baud, uint32_t confirm_ms);
+
+// Writes a test pattern to the console UART for duration_ms and reports how
+// many bytes actually left it.
+esp_err_t serial_manager_selftest(uint32_t duration_ms,
+                                  serial_selftest_result_t *result);
+
 QueueHandle_tt commandQueue;
 
 typedef struct {
@@ -0,0 +1,69 @@
+#ifndef SERIAL_STREAM_H
+#define SERIAL_STREAM_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Capture data sent over UART0 when there is no SD card.
+//
+// Legacy mode (the default) wraps each block in [BUF/BEGIN]/[BUF/CLOSE] text
+// markers, which is what existing host tools expect. Framed mode sends
+// COBS-encoded frames instead, each preceded and followed by a zero byte:
+//
+//   channel(1) flags(1) seq(2, LE) payload(0..SERIAL_STREAM_MAX_PAYLOAD)
+//   crc32(4, LE, over everything before it)
+//
+// Sequence numbers are per channel, so a host sees exactly where frames were
+// lost. Frames are queued on a TX ring and sent by a background task. When
+// the ring is full, log and reply frames are dropped; capture writers wait,
+// since a gap would corrupt the rest of their file.
+// scripts/serial_stream/ghost_stream_decode.c splits a recording back into
+// files.
+
+#define SERIAL_STREAM_MAX_PAYLOAD 1024
+#define SERIAL_STREAM_HEADER_LEN 4
+#define SERIAL_STREAM_CRC_LEN 4
+
+// Set on the first frame of a new capture; the host starts a new file.
+#define SERIAL_FRAME_FLAG_OPEN 0x01
+
+typedef enum {
+  SERIAL_CHANNEL_PCAP = 1,
+  SERIAL_CHANNEL_CSV = 2,
+  SERIAL_CHANNEL_LOG = 3,
+  SERIAL_CHANNEL_REPLY = 4, // Console output of serial commands
+  SERIAL_CHANNEL_COUNT
+} serial_channel_t;
+
+typedef struct {
+  uint32_t frames_sent;
+  uint32_t frames_dropped; // Log/reply frames lost to a full ring
+  uint32_t tx_waits;       // Times a capture writer waited for ring space
+  uint32_t bytes_queued;   // Encoded bytes, delimiters included
+  uint32_t ring_high_water;
+} serial_stream_stats_t;
+
+esp_err_t serial_stream_init(void);
+esp_err_t serial_stream_set_framing(bool enabled);
+bool serial_stream_framing_enabled(void);
+
+// A block of capture output. In legacy mode begin/end emit the text markers;
+// line_break keeps the newline some callers always sent after the close
+// marker. new_capture flags the next frame so the host opens a new file.
+void serial_stream_begin(serial_channel_t channel, bool new_capture);
+esp_err_t serial_stream_put(serial_channel_t channel, const void *data,
+                            size_t len);
+void serial_stream_end(serial_channel_t channel, bool line_break);
+
+// stdout replacement that sends console output on the reply channel, or NULL
+// while framing is off.
+FILE *serial_stream_reply_file(void);
+void serial_stream_get_stats(serial_stream_stats_t *stats);
+// Waits until everything queued so far has left the UART, e.g. before the
+// baud rate changes. Returns ESP_ERR_TIMEOUT if it did not drain in time.
+esp_err_t serial_stream_flush(uint32_t timeout_ms);
+
+#endif // SERIAL_STREAM_H
@@ -0,0 +1,79 @@
+#ifndef SSID_MAP_H
+#define SSID_MAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Multimap from SSID to the access points advertising it, for evil-twin and
+// rogue-AP detection. Every SSID keeps the profile (security, vendor OUI,
+// channel) of the first AP heard with it; each AP that later shows up with
+// the same SSID is compared against that profile once, when it is first
+// heard or changes, so a beacon costs two hash lookups however many
+// networks are around.
+//
+// Both tables use open addressing over SSID_MAP_PROBE slots and evict the
+// least recently heard entry in that window when it is full, so memory is
+// fixed at init and nothing allocates per beacon. Not locked. No ESP-IDF
+// dependencies, so recorded beacons can be replayed on a host.
+
+#define SSID_MAP_PROBE 8
+
+// Reasons an AP does not match the SSID's profile
+#define SSID_MAP_MISMATCH_SECURITY 0x01
+#define SSID_MAP_MISMATCH_VENDOR 0x02 // Different OUI, both globally assigned
+#define SSID_MAP_MISMATCH_CHANNEL 0x04
+
+typedef struct {
+  uint8_t bssid[6];
+  uint8_t security; // ieee80211_security_t
+  uint8_t channel;  // From the beacon's DS parameter set
+} ssid_map_ap_t;
+
+typedef struct {
+  uint8_t reasons;     // SSID_MAP_MISMATCH_*
+  bool changed;        // The AP itself changed security or channel
+  ssid_map_ap_t ap;    // The AP just heard
+  ssid_map_ap_t other; // The profile it was compared against
+  uint16_t aps;        // APs currently known to advertise the SSID
+} ssid_map_alert_t;
+
+typedef struct {
+  uint32_t beacons;
+  uint32_t aps;       // (BSSID, SSID) pairs stored
+  uint32_t ssids;     // SSIDs stored
+  uint32_t evictions; // Pairs forgotten to make room
+  uint32_t alerts;
+  uint32_t ap_capacity;
+  uint32_t ssid_capacity;
+} ssid_map_stats_t;
+
+typedef struct {
+  void *aps;
+  void *ssids;
+  uint32_t ap_mask;
+  uint32_t ssid_mask;
+  uint32_t clock;
+  ssid_map_stats_t stats;
+} ssid_map_t;
+
+// Capacities are rounded up to a power of two. Returns false without
+// memory.
+bool ssid_map_init(ssid_map_t *map, uint32_t aps, uint32_t ssids);
+void ssid_map_free(ssid_map_t *map);
+void ssid_map_clear(ssid_map_t *map);
+
+uint32_t ssid_map_hash(const uint8_t *ssid, size_t len);
+
+// Records one beacon. Returns true and fills alert when the AP is new or
+// has changed and no longer matches the profile of its SSID.
+bool ssid_map_observe(ssid_map_t *map, const uint8_t *ssid, size_t ssid_len,
+                      const ssid_map_ap_t *ap, ssid_map_alert_t *alert);
+
+// Copies up to max APs heard with the SSID; returns how many were copied.
+int ssid_map_lookup(const ssid_map_t *map, const uint8_t *ssid,
+                    size_t ssid_len, ssid_map_ap_t *out, int max);
+
+void ssid_map_get_stats(const ssid_map_t *map, ssid_map_stats_t *stats);
+
+#endif // SSID_MAP_H
@@ -0,0 +1,48 @@
+#ifndef STATION_TRACKER_H
+#define STATION_TRACKER_H
+
+#include "core/mac_table.h"
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Client stations heard in data frames, keyed by station MAC in a
+// mac_table sized by CONFIG_STATION_TRACKER_ENTRIES. The least recently
+// heard stations make room when it is full. The radio callback only
+// updates counters; "stations" prints a sorted snapshot.
+
+typedef struct {
+  uint8_t mac[6];
+  uint8_t bssid[6];       // AP the station last exchanged data with
+  uint32_t first_seen_ms; // Uptime
+  uint32_t last_seen_ms;
+  uint32_t frames; // Both directions
+  uint32_t bytes;
+  int16_t rssi_x16; // Moving average of frames it sent, dBm * 16
+  uint8_t channel;
+} station_info_t;
+
+typedef enum {
+  STATION_SORT_RECENT,
+  STATION_SORT_FRAMES,
+  STATION_SORT_RSSI,
+} station_sort_t;
+
+// Adds the tracker as the "stations" monitor consumer, allocating its table
+// on first use. Stations already seen are kept.
+esp_err_t station_tracker_start(void);
+// Removes the consumer; the table is kept for "stations".
+void station_tracker_stop(void);
+void station_tracker_reset(void);
+
+// Accounts one data frame. This is the whole per-frame path and only
+// touches the packet it is given, so recorded frames can be replayed into it.
+void station_tracker_record(const wifi_promiscuous_pkt_t *pkt);
+
+// Copies up to max stations, best first by sort, and returns how many. Only
+// a buffer with room for the whole table sees every station before sorting.
+int station_tracker_snapshot(station_info_t *out, int max, station_sort_t sort);
+void station_tracker_get_stats(mac_table_stats_t *stats);
+
+#endif // STATION_TRACKER_H
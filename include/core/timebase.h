@@ -0,0 +1,45 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+
+// Maps the monotonic esp_timer clock onto UTC. GPS fixes, SNTP and the
+// PCF8563 RTC discipline the mapping; captures and logs convert through it,
+// so files from one session share a clock no matter which path wrote them.
+// Conversions are lock-free and safe from ISR and Wi-Fi RX context.
+
+// Ordered by trust; a source only overrides a better one that has gone stale.
+typedef enum {
+  TIMEBASE_SOURCE_NONE,   // Uptime only
+  TIMEBASE_SOURCE_SYSTEM, // Whatever the system clock said at adoption
+  TIMEBASE_SOURCE_RTC,
+  TIMEBASE_SOURCE_NTP,
+  TIMEBASE_SOURCE_GPS,
+} timebase_source_t;
+
+typedef struct {
+  timebase_source_t source;
+  int64_t offset_us;   // UTC minus esp_timer at synced_us
+  int64_t synced_us;   // esp_timer time of the last discipline
+  int32_t drift_ppb;   // Local oscillator error, positive if it runs slow
+  uint32_t syncs;      // Disciplines accepted from the current source
+} timebase_state_t;
+
+// Seeds the timebase from the RTC when the board has one.
+void timebase_init(void);
+
+// Feeds one observation: utc_us was the time at esp_timer time local_us.
+// Task context only; may set the system clock and write the RTC.
+void timebase_discipline(timebase_source_t source, int64_t utc_us,
+                         int64_t local_us);
+
+// Adopts the system clock if nothing better has disciplined the timebase,
+// e.g. after a manual settimeofday(). Task context only.
+void timebase_adopt_system_clock(void);
+
+int64_t timebase_to_utc_us(int64_t local_us);
+int64_t timebase_now_utc_us(void);
+timebase_state_t timebase_get_state(void);
+const char *timebase_source_name(timebase_source_t source);
+
+#endif // TIMEBASE_H
@@ -40,8 +40,14 @@ void ble_start_raw_ble_packetscan(void);
 void ble_start_blespam_detector(void);
 void ble_start_capture(void);
 void ble_start_scanning(void);
+// Share of each scan interval spent listening, 5-100, used from the next
+// ble_start_scanning(). 0 restores the stack defaults (continuous), as does
+// ble_stop().
+void ble_set_scan_duty(uint8_t percent);
 void ble_start_skimmer_detection(void);
 void ble_stop_skimmer_detection(void);
+// Writes a discovery event to the BLE capture as an HCI LE Advertising Report.
+esp_err_t ble_pcap_write_adv_report(const struct ble_gap_event *event);
 
 #endif
 #endif // BLE_MANAGER_H
\ No newline at end of file
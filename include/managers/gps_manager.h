@@ -9,6 +9,27 @@
 extern nmea_parser_handle_t nmea_hdl;
 extern gps_date_t cacheddate;
 
+// One consistent fix, published by the parser task after each complete
+// sentence group. Position, time and quality always come from the same group.
+typedef struct {
+    uint32_t seq;         // Publish count; 0 means nothing published yet
+    bool has_fix;         // The receiver reports a fix
+    bool valid;           // Fix, date, time and ranges all checked; safe to log
+    uint8_t fix;          // gps_fix_t
+    uint8_t fix_mode;     // gps_fix_mode_t
+    uint8_t sats;
+    int32_t lat_e7;       // Degrees * 1e7
+    int32_t lon_e7;
+    int32_t alt_cm;
+    uint16_t accuracy_dm; // HDOP * 5 m
+    uint16_t millis;
+    uint32_t timestamp;   // UTC seconds since 1970, 0 without a valid date
+    float speed;          // m/s
+    float course;         // Degrees over ground
+    float dop_h;
+    int64_t published_us;
+} gps_snapshot_t;
+
 // Struct definition for GPSManager
 typedef struct {
     bool isinitilized;
@@ -17,7 +38,18 @@ typedef struct {
 // Function prototypes
 void gps_manager_init(GPSManager *manager);
 void gps_manager_deinit(GPSManager *manager);
-esp_err_t gps_manager_log_wardriving_data(wardriving_data_t *data);
+// Lock free and constant time; safe from the radio callbacks.
+gps_snapshot_t gps_get_snapshot(void);
+// True for a valid fix published within the last few seconds; a receiver
+// that stopped talking leaves its last fix behind.
+bool gps_snapshot_fresh(const gps_snapshot_t *fix);
+// Called from the parser task with each completed fix.
+void gps_manager_publish(const gps_t *gps);
+// Stamps the record with the fix and queues it for the logger task. fix comes
+// from gps_get_snapshot(), so callers that already took one reuse it.
+esp_err_t gps_manager_log_wardriving_record(wardrive_record_t *record, const gps_snapshot_t *fix);
+// Prints a short fix summary, at most every few seconds.
+void gps_manager_print_status(void);
 bool gps_is_timeout_detected(void);
 GPSManager g_gpsManager;
 
@@ -9,16 +9,6 @@
 #define RANDOM_SSID_LEN 8
 #define BEACON_INTERVAL 0x0064 // 100 Time Units (TU)
 #define CAPABILITY_INFO 0x0411 // Capability information (ESS)
-#define MAX_STATIONS 50
-
-typedef struct {
-  uint8_t station_mac[6]; // MAC address of the station (client)
-  uint8_t ap_bssid[6];    // BSSID (MAC address) of the access point
-} station_ap_pair_t;
-
-static station_ap_pair_t
-    station_ap_list[MAX_STATIONS]; // Array to store station-AP pairs
-static int station_count = 0;
 
 extern wifi_ap_record_t *scanned_aps;
 extern wifi_ap_record_t selected_ap;
@@ -131,11 +121,14 @@ void wifi_manager_start_ip_lookup();
 
 void wifi_manager_connect_wifi(const char *ssid, const char *password);
 
-void wifi_manager_stop_monitor_mode();
+// Adds callback as a monitor consumer for the frame classes in frame_mask
+// (see core/frame_dispatch.h), entering promiscuous mode if needed. Starting
+// a consumer under a name already in use replaces it.
+void wifi_manager_start_monitor_mode(const char *name, uint64_t frame_mask,
+                                     wifi_promiscuous_cb_t_t callback);
 
-void wifi_manager_start_monitor_mode(wifi_promiscuous_cb_t_t callback);
-
-void wifi_manager_list_stations();
+// Removes one consumer; promiscuous mode ends with the last one
+void wifi_manager_stop_monitor_consumer(const char *name);
 
 void wifi_manager_start_deauth();
 
@@ -146,9 +139,6 @@ void wifi_manager_stop_deauth();
 esp_err_t wifi_manager_broadcast_deauth(uint8_t bssid[6], int channel,
                                         uint8_t mac[6]);
 
-void wifi_stations_sniffer_callback(void *buf,
-                                    wifi_promiscuous_pkt_type_t type);
-
 void wifi_manager_stop_evil_portal();
 
 esp_err_t wifi_manager_start_evil_portal(const char *URL, const char *SSID,
@@ -1,5 +1,9 @@
 #include "core/callbacks.h"
+#include "core/channel_hopper.h"
+#include "core/ieee80211_ie.h"
 #include "esp_wifi.h"
+#include "freertos/queue.h"
+#include "managers/ble_manager.h"
 #include "managers/gps_manager.h"
 #include "managers/rgb_manager.h"
 #include "managers/views/terminal_screen.h"
@@ -8,6 +12,7 @@
 #include "vendor/pcap.h"
 #include <ctype.h>
 #include <esp_log.h>
+#include <math.h>
 #include <string.h>
 #include <time.h>
 #include "esp_rom_sys.h"  // Contains esp_rom_printf
@@ -25,21 +30,6 @@
 #define WIFI_PKT_PROBE_RESP 0x05 // Probe Response subtype
 #define WIFI_PKT_EAPOL 0x80
 #define ESP_WIFI_VENDOR_METADATA_LEN 8 // Channel(1) + RSSI(1) + Rate(1) + Timestamp(4) + Noise(1)
-#define MIN_SSIDS_FOR_DETECTION 2 // Minimum SSIDs needed to flag as PineAP
-#define MAX_PINEAP_NETWORKS 20
-#define MAX_SSIDS_PER_BSSID 10
-#define MAX_WIFI_CHANNEL 13
-#define CHANNEL_HOP_INTERVAL_MS 200
-#define RECENT_SSID_COUNT 5
-#define LOG_DELAY_MS 5000
-static pineap_network_t pineap_networks[MAX_PINEAP_NETWORKS] DRAM_ATTR;
-static int pineap_network_count = 0;
-static bool pineap_detection_active = false;
-static uint8_t current_channel = 1;
-static esp_timer_handle_t channel_hop_timer = NULL;
-static uint32_t hash_ssid(const char *ssid);
-static bool ssid_hash_exists(pineap_network_t *network, uint32_t hash);
-static void trim_trailing(char *str);
 static bool compare_bssid(const uint8_t *bssid1, const uint8_t *bssid2);
 static bool is_beacon_packet(const wifi_promiscuous_pkt_t *pkt);
 static const char *SKIMMER_TAG = "SKIMMER_DETECT";
@@ -51,137 +41,200 @@ wps_network_t detected_wps_networks[MAX_WPS_NETWORKS];
 int detected_network_count = 0;
 esp_timer_handle_t stop_timer;
 int should_store_wps = 1;
-gps_t *gps = NULL;
 extern RGBManager_t rgb_manager;
-typedef struct {
-    uint8_t bssid[6];
-    time_t detection_time;
-    time_t last_update_time;
-} blacklisted_ap_t;
 
-static blacklisted_ap_t blacklist[MAX_PINEAP_NETWORKS];
-static int blacklist_count = 0;
-
-static bool is_blacklisted(const uint8_t *bssid) {
-    for (int i = 0; i < blacklist_count; i++) {
-        if (memcmp(blacklist[i].bssid, bssid, 6) == 0) {
-            return true;
-        }
-    }
-    return false;
-}
+#ifndef CONFIG_PINEAP_MAX_NETWORKS
+#define CONFIG_PINEAP_MAX_NETWORKS 256
+#endif
+#ifndef CONFIG_PINEAP_SSID_AGE_S
+#define CONFIG_PINEAP_SSID_AGE_S 300
+#endif
 
-static bool should_update_blacklisted(const uint8_t *bssid) {
-    for (int i = 0; i < blacklist_count; i++) {
-        if (memcmp(blacklist[i].bssid, bssid, 6) == 0) {
-            time_t current_time = time(NULL);
-            // Allow updates every 30 seconds
-            if (current_time - blacklist[i].last_update_time >= 30) {
-                blacklist[i].last_update_time = current_time;
-                return true;
-            }
-            return false;
-        }
-    }
-    return false;
-}
+#define PINEAP_ALERT_QUEUE_LEN 16
+#define PINEAP_REPORT_ENTRIES 16     // Flagged BSSIDs the alert worker remembers
+#define PINEAP_REPORT_DELAY_US (5 * 1000000LL)   // Gather SSIDs before reporting
+#define PINEAP_REPORT_REPEAT_US (30 * 1000000LL) // Minimum gap between reports
 
-static void add_to_blacklist(const uint8_t *bssid) {
-    time_t current_time = time(NULL);
+// What the alert worker has gathered about one flagged BSSID.
+typedef struct {
+    char ssids[RECENT_SSID_COUNT][IEEE80211_SSID_MAX_LEN + 1];
+    uint8_t ssid_index;
+    uint8_t ssid_count;
+    uint8_t live_ssids;
+    int8_t channel;
+    int8_t rssi;
+    int64_t due_us; // 0 when no report is pending
+    int64_t reported_us;
+} pineap_report_t;
+
+// The detector table belongs to the Wi-Fi callback, which only touches it
+// under pineap_lock while detection is active; the console reads its
+// statistics under the lock and clears it once detection is off.
+static mac_table_t pineap_networks;
+static portMUX_TYPE pineap_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool pineap_detection_active = false;
+static uint32_t pineap_alerts_dropped = 0;
+static QueueHandle_t pineap_alert_queue = NULL;
+static mac_table_t pineap_reports; // Owned by the worker
 
-    // First check if BSSID exists
-    for (int i = 0; i < blacklist_count; i++) {
-        if (memcmp(blacklist[i].bssid, bssid, 6) == 0) {
-            blacklist[i].last_update_time = current_time;
+static void pineap_report_add_ssid(pineap_report_t *report, const char *ssid) {
+    if (ssid[0] == '\0') {
+        return;
+    }
+    for (int i = 0; i < report->ssid_count; i++) {
+        if (strcasecmp(report->ssids[i], ssid) == 0) {
             return;
         }
     }
-
-    // If not found and we have space, add new entry
-    if (blacklist_count < MAX_PINEAP_NETWORKS) {
-        memcpy(blacklist[blacklist_count].bssid, bssid, 6);
-        blacklist[blacklist_count].detection_time = current_time;
-        blacklist[blacklist_count].last_update_time = current_time;
-        blacklist_count++;
+    strlcpy(report->ssids[report->ssid_index], ssid, sizeof(report->ssids[0]));
+    report->ssid_index = (report->ssid_index + 1) % RECENT_SSID_COUNT;
+    if (report->ssid_count < RECENT_SSID_COUNT) {
+        report->ssid_count++;
     }
 }
 
+static void pineap_print_report(const uint8_t *bssid, const pineap_report_t *report) {
+    char mac_str[18];
+    snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x", bssid[0], bssid[1],
+             bssid[2], bssid[3], bssid[4], bssid[5]);
 
-static void channel_hop_timer_callback(void *arg) {
-    if (!pineap_detection_active)
-        return;
-
-    current_channel = (current_channel % MAX_WIFI_CHANNEL) + 1;
-    esp_wifi_set_channel(current_channel, WIFI_SECOND_CHAN_NONE);
-}
-
-static esp_err_t start_channel_hopping(void) {
-    esp_timer_create_args_t timer_args = {.callback = channel_hop_timer_callback,
-                                          .name = "channel_hop"};
-
-    if (channel_hop_timer == NULL) {
-        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &channel_hop_timer));
+    char ssids_str[RECENT_SSID_COUNT * (IEEE80211_SSID_MAX_LEN + 2)] = {0};
+    for (int i = 0; i < report->ssid_count; i++) {
+        if (i > 0)
+            strlcat(ssids_str, ", ", sizeof(ssids_str));
+        strlcat(ssids_str, report->ssids[i], sizeof(ssids_str));
     }
 
-    return esp_timer_start_periodic(channel_hop_timer, CHANNEL_HOP_INTERVAL_MS * 1000);
-}
+    // Pulse RGB purple (red + blue) to indicate Pineapple detection
+    pulse_once(&rgb_manager, 255, 0, 255);
 
-static void stop_channel_hopping(void) {
-    if (channel_hop_timer) {
-        esp_timer_stop(channel_hop_timer);
-        esp_timer_delete(channel_hop_timer);
-        channel_hop_timer = NULL;
-    }
+    printf("\nPineapple detected!\nBSSID: %s\n", mac_str);
+    printf("Channel: %d\n", report->channel);
+    printf("RSSI: %d\n", report->rssi);
+    printf("SSIDs (%d): %s\n", report->live_ssids, ssids_str);
+    TERMINAL_VIEW_ADD_TEXT("\nPineapple detected!\n");
+    TERMINAL_VIEW_ADD_TEXT("BSSID: %s\n", mac_str);
+    TERMINAL_VIEW_ADD_TEXT("Channel: %d\n", report->channel);
+    TERMINAL_VIEW_ADD_TEXT("RSSI: %d\n", report->rssi);
+    TERMINAL_VIEW_ADD_TEXT("SSIDs (%d): %s\n", report->live_ssids, ssids_str);
 }
 
-static pineap_network_t *find_or_create_network(const uint8_t *bssid) {
-    for (int i = 0; i < pineap_network_count; i++) {
-        if (compare_bssid(pineap_networks[i].bssid, bssid)) {
-            return &pineap_networks[i];
-        }
+typedef struct {
+    int64_t now_us;
+    int64_t next_due_us;
+} pineap_due_scan_t;
+
+static void pineap_report_due(const uint8_t mac[6], void *value, void *ctx) {
+    pineap_due_scan_t *scan = ctx;
+    pineap_report_t *report = value;
+    if (report->due_us == 0) {
+        return;
     }
+    if (report->due_us <= scan->now_us) {
+        pineap_print_report(mac, report);
+        report->due_us = 0;
+        report->reported_us = scan->now_us;
+    } else if (scan->next_due_us == 0 || report->due_us < scan->next_due_us) {
+        scan->next_due_us = report->due_us;
+    }
+}
+
+// Collects SSIDs for flagged BSSIDs and reports each one a few seconds after
+// it is flagged, and at most every 30 seconds after that. Lives for the rest
+// of the session once PineAP detection has been started.
+static void pineap_alert_task(void *arg) {
+    pineap_alert_t alert;
+    TickType_t wait = portMAX_DELAY;
+
+    while (1) {
+        if (xQueueReceive(pineap_alert_queue, &alert, wait) == pdTRUE) {
+            bool created;
+            pineap_report_t *report = mac_table_upsert(&pineap_reports, alert.bssid, &created);
+            int64_t now_us = esp_timer_get_time();
+            pineap_report_add_ssid(report, alert.previous_ssid);
+            pineap_report_add_ssid(report, alert.ssid);
+            report->live_ssids = alert.live_ssids;
+            report->channel = alert.channel;
+            report->rssi = alert.rssi;
+            if (report->due_us == 0 &&
+                (created || now_us - report->reported_us >= PINEAP_REPORT_REPEAT_US)) {
+                report->due_us = now_us + PINEAP_REPORT_DELAY_US;
+            }
+        }
 
-    // If not found and we have space, create new entry
-    if (pineap_network_count < MAX_PINEAP_NETWORKS) {
-        pineap_network_t *network = &pineap_networks[pineap_network_count++];
-        memcpy(network->bssid, bssid, 6);
-        network->ssid_count = 0;
-        network->is_pineap = false;
-        network->first_seen = time(NULL);
-        return network;
+        pineap_due_scan_t scan = {.now_us = esp_timer_get_time()};
+        mac_table_foreach(&pineap_reports, pineap_report_due, &scan);
+        wait = scan.next_due_us == 0 ? portMAX_DELAY
+                                     : pdMS_TO_TICKS((scan.next_due_us - scan.now_us) / 1000) + 1;
     }
-
-    return NULL;
 }
 
-static uint32_t hash_ssid(const char *ssid) {
-    uint32_t hash = 5381;
-    int c;
-    while ((c = *ssid++))
-        hash = ((hash << 5) + hash) + c; // hash * 33 + c
-    return hash;
+static esp_err_t pineap_alert_worker_start(void) {
+    if (pineap_alert_queue != NULL) {
+        return ESP_OK;
+    }
+    if (mac_table_init(&pineap_reports, PINEAP_REPORT_ENTRIES, sizeof(pineap_report_t)) !=
+        ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+    pineap_alert_queue = xQueueCreate(PINEAP_ALERT_QUEUE_LEN, sizeof(pineap_alert_t));
+    if (pineap_alert_queue == NULL) {
+        mac_table_free(&pineap_reports);
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(pineap_alert_task, "pineap_log", 4096, NULL, 1, NULL) != pdPASS) {
+        vQueueDelete(pineap_alert_queue);
+        pineap_alert_queue = NULL;
+        mac_table_free(&pineap_reports);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
 }
 
-static bool ssid_hash_exists(pineap_network_t *network, uint32_t hash) {
-    for (int i = 0; i < network->ssid_count; i++) {
-        if (network->ssid_hashes[i] == hash) {
-            return true;
+esp_err_t start_pineap_detection(void) {
+    if (pineap_networks.slots == NULL) {
+        if (mac_table_init(&pineap_networks, CONFIG_PINEAP_MAX_NETWORKS,
+                           sizeof(pineap_network_t)) != ESP_OK) {
+            ESP_LOGE(TAG, "No memory for the PineAP table");
+            return ESP_ERR_NO_MEM;
         }
+    } else {
+        // Once the callback has seen detection off under the lock it leaves
+        // the table alone, so the clear runs outside the critical section.
+        portENTER_CRITICAL(&pineap_lock);
+        pineap_detection_active = false;
+        portEXIT_CRITICAL(&pineap_lock);
+        mac_table_clear(&pineap_networks);
+    }
+    if (pineap_alert_worker_start() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start the PineAP alert worker");
+        return ESP_ERR_NO_MEM;
     }
-    return false;
-}
 
-void start_pineap_detection(void) {
+    pineap_alerts_dropped = 0;
+    portENTER_CRITICAL(&pineap_lock);
     pineap_detection_active = true;
-    pineap_network_count = 0;
-    memset(pineap_networks, 0, sizeof(pineap_networks));
-    current_channel = 1;
-    start_channel_hopping();
+    portEXIT_CRITICAL(&pineap_lock);
+    channel_hopper_acquire();
+    return ESP_OK;
 }
 
 void stop_pineap_detection(void) {
+    if (!pineap_detection_active) {
+        return;
+    }
     pineap_detection_active = false;
-    stop_channel_hopping();
+    channel_hopper_release();
+
+    mac_table_stats_t stats;
+    portENTER_CRITICAL(&pineap_lock);
+    mac_table_get_stats(&pineap_networks, &stats);
+    portEXIT_CRITICAL(&pineap_lock);
+    printf("PineAP: %lu BSSIDs tracked (%lu evicted), %lu alerts dropped\n",
+           (unsigned long)stats.count, (unsigned long)stats.evictions,
+           (unsigned long)pineap_alerts_dropped);
+    TERMINAL_VIEW_ADD_TEXT("PineAP: %lu BSSIDs tracked\n(%lu evicted)\n",
+                           (unsigned long)stats.count, (unsigned long)stats.evictions);
 }
 
 #define IRAM_PRINTF(fmt, ...) do { \
@@ -189,119 +242,14 @@ void stop_pineap_detection(void) {
     esp_rom_printf(flash_fmt, ##__VA_ARGS__); \
 } while(0)
 
-void log_pineap_detection(void *arg) {
-    pineap_log_data_t *log_data = (pineap_log_data_t *)arg;
-    pineap_network_t *network = log_data->network;
-
-    vTaskDelay(pdMS_TO_TICKS(5000));
-
-    char mac_str[18];
-    snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x", log_data->bssid[0],
-             log_data->bssid[1], log_data->bssid[2], log_data->bssid[3], log_data->bssid[4],
-             log_data->bssid[5]);
-
-    // Build SSIDs string, filtering out empty SSIDs
-    char ssids_str[256] = {0};
-    int valid_ssid_count = 0;
-
-    // Use the most up-to-date SSIDs from the network structure
-    for (int i = 0; i < network->ssid_count && i < RECENT_SSID_COUNT; i++) {
-        if (strlen(network->recent_ssids[i]) > 0) {
-            if (valid_ssid_count > 0)
-                strcat(ssids_str, ", ");
-            strcat(ssids_str, network->recent_ssids[i]);
-            valid_ssid_count++;
-        }
-    }
-
-    // Only log if we have valid SSIDs
-    if (valid_ssid_count >= MIN_SSIDS_FOR_DETECTION) {
-        // Pulse RGB purple (red + blue) to indicate Pineapple detection
-        pulse_once(&rgb_manager, 255, 0, 255);
-
-        IRAM_PRINTF("\nPineapple detected!\nBSSID: %02x:%02x:%02x:%02x:%02x:%02x\n", 
-                   log_data->bssid[0], log_data->bssid[1], log_data->bssid[2],
-                   log_data->bssid[3], log_data->bssid[4], log_data->bssid[5]);
-        IRAM_PRINTF("Channel: %d\n", network->last_channel);
-        IRAM_PRINTF("RSSI: %d\n", network->last_rssi);
-        IRAM_PRINTF("SSIDs (%d): %s\n", valid_ssid_count, ssids_str);
-
-        // Evil Twin Detection: Check for same SSID from different BSSIDs
-        for (int i = 0; i < pineap_network_count; i++) {
-            if (i != (network - pineap_networks) && // Skip self
-                strcasecmp(network->recent_ssids[0], pineap_networks[i].recent_ssids[0]) == 0) {
-                IRAM_PRINTF("Evil Twin:\nSSID '%.100s'\nBSSID %.17s vs %.100s\n",
-                           network->recent_ssids[0], mac_str, pineap_networks[i].bssid);
-                TERMINAL_VIEW_ADD_TEXT(
-                    "Evil Twin Detected:\nSame SSID '%.100s'\nfrom BSSID %.17s and\n%.100s\n",
-                    network->recent_ssids[0], mac_str, pineap_networks[i].bssid);
-            }
-        }
-
-        TERMINAL_VIEW_ADD_TEXT("\nPineapple detected!\n");
-        TERMINAL_VIEW_ADD_TEXT("BSSID: %s\n", mac_str);
-        TERMINAL_VIEW_ADD_TEXT("Channel: %d\n", network->last_channel);
-        TERMINAL_VIEW_ADD_TEXT("RSSI: %d\n", network->last_rssi);
-        TERMINAL_VIEW_ADD_TEXT("SSIDs (%d): %s\n", valid_ssid_count, ssids_str);
-    }
-
-    free(log_data);
-    network->log_task_handle = NULL; // Clear handle before deletion
-    vTaskDelete(NULL);
-}
-
-static void start_log_task(pineap_network_t *network, const char *new_ssid, int8_t channel,
-                           int8_t rssi) {
-    // Check if a task is already running
-    if (network->log_task_handle != NULL) {
-        TaskHandle_t existing_handle = network->log_task_handle;
-        network->log_task_handle = NULL; // Clear it first to avoid race conditions
-        vTaskDelete(existing_handle);    // Clean up existing task
-    }
-
-    pineap_log_data_t *log_data = malloc(sizeof(pineap_log_data_t));
-    if (!log_data)
-        return;
-
-    // Copy network data
-    memcpy(log_data->bssid, network->bssid, 6);
-    memcpy(log_data->recent_ssids, network->recent_ssids, sizeof(network->recent_ssids));
-    log_data->ssid_count = network->ssid_count;
-    log_data->channel = channel;
-    log_data->rssi = rssi;
-    log_data->network = network;
-    BaseType_t result = xTaskCreate(log_pineap_detection, "pineap_log", 4096, log_data, 1,
-                                    &network->log_task_handle);
-    if (result != pdPASS) {
-        free(log_data);
-        network->log_task_handle = NULL;
-    }
-}
-
-// Helper function to check if SSID is valid and unique
-static bool is_valid_unique_ssid(const char *new_ssid, pineap_network_t *network) {
-    // Check if SSID is empty or just whitespace
-    if (strlen(new_ssid) == 0)
-        return false;
-
-    bool all_whitespace = true;
-    for (const char *p = new_ssid; *p; p++) {
+// Helper function to check if SSID is worth tracking
+static bool is_valid_ssid(const char *ssid) {
+    for (const char *p = ssid; *p; p++) {
         if (!isspace((unsigned char)*p)) {
-            all_whitespace = false;
-            break;
-        }
-    }
-    if (all_whitespace)
-        return false;
-
-    // Check if this SSID is already in our recent list
-    for (int i = 0; i < network->ssid_count && i < RECENT_SSID_COUNT; i++) {
-        if (strcasecmp(network->recent_ssids[i], new_ssid) == 0) {
-            return false; // SSID already exists (case insensitive)
+            return true;
         }
     }
-
-    return true;
+    return false; // Empty or just whitespace
 }
 
 void wifi_pineap_detector_callback(void *buf, wifi_promiscuous_pkt_type_t type) {
@@ -316,90 +264,36 @@ void wifi_pineap_detector_callback(void *buf, wifi_promiscuous_pkt_type_t type)
     if (!is_beacon_packet(ppkt))
         return;
 
-    // Find or create network
-    pineap_network_t *network = find_or_create_network(hdr->addr3);
-    if (!network)
+    // The SSID element can sit anywhere among the tagged parameters
+    ieee80211_ies_t ies;
+    if (!ieee80211_parse_mgmt(ppkt->payload, ppkt->rx_ctrl.sig_len, &ies) || !ies.has_ssid)
         return;
 
-    // Update channel and RSSI
-    network->last_channel = ppkt->rx_ctrl.channel;
-    network->last_rssi = ppkt->rx_ctrl.rssi;
-
-    // Extract SSID from beacon
-    const uint8_t *payload = ppkt->payload;
-    int len = ppkt->rx_ctrl.sig_len;
-
-    // Skip fixed parameters (24 bytes header + 12 bytes fixed params)
-    int index = 36;
-    if (index + 2 > len)
+    char ssid[IEEE80211_SSID_MAX_LEN + 1];
+    ieee80211_ssid_copy(&ies, ssid);
+    if (!is_valid_ssid(ssid))
         return;
 
-    // Look specifically for SSID element (ID = 0)
-    if (payload[index] != 0)
-        return;
-
-    uint8_t ie_len = payload[index + 1];
-    if (ie_len > 32 || index + 2 + ie_len > len)
-        return;
+    uint32_t now_s = esp_timer_get_time() / 1000000;
+    pineap_alert_t alert;
 
-    // Get SSID
-    char ssid[33] = {0};
-    memcpy(ssid, &payload[index + 2], ie_len);
-    ssid[ie_len] = '\0';
-    trim_trailing(ssid);
+    portENTER_CRITICAL(&pineap_lock);
+    bool flagged = pineap_detection_active &&
+                   pineap_table_observe(&pineap_networks, hdr->addr3, ssid,
+                                        ppkt->rx_ctrl.channel, ppkt->rx_ctrl.rssi,
+                                        now_s, CONFIG_PINEAP_SSID_AGE_S, &alert);
+    portEXIT_CRITICAL(&pineap_lock);
 
-    // Only proceed if this is a valid and unique SSID
-    if (!is_valid_unique_ssid(ssid, network))
+    if (!flagged)
         return;
 
-    uint32_t ssid_hash = hash_ssid(ssid);
-
-    // If this is a new SSID hash for this BSSID, add it
-    if (!ssid_hash_exists(network, ssid_hash) && network->ssid_count < MAX_SSIDS_PER_BSSID) {
-        network->ssid_hashes[network->ssid_count++] = ssid_hash;
-
-        // Add to recent SSIDs circular buffer
-        strncpy(network->recent_ssids[network->recent_ssid_index], ssid, 32);
-        network->recent_ssid_index = (network->recent_ssid_index + 1) % RECENT_SSID_COUNT;
-
-        // If we detect multiple SSIDs from same BSSID, mark as potential Pineap
-        if (network->ssid_count >= MIN_SSIDS_FOR_DETECTION &&
-            (!is_blacklisted(hdr->addr3) || should_update_blacklisted(hdr->addr3))) {
-
-            network->is_pineap = true;
-            add_to_blacklist(hdr->addr3);
-
-            // Create new logging task if previous one has completed
-            if (network->log_task_handle == NULL) {
-                pineap_log_data_t *log_data = malloc(sizeof(pineap_log_data_t));
-                if (!log_data)
-                    return;
-
-                memcpy(log_data->bssid, network->bssid, 6);
-                log_data->network = network; // Pass network pointer for up-to-date info
-
-                BaseType_t result = xTaskCreate(log_pineap_detection, "pineap_log", 4096, log_data,
-                                                1, &network->log_task_handle);
-                if (result != pdPASS) {
-                    free(log_data);
-                    network->log_task_handle = NULL;
-                }
-            }
-
-            // Write to PCAP if capture is active
-            if (pcap_file != NULL) {
-                pcap_write_packet_to_buffer(ppkt->payload, ppkt->rx_ctrl.sig_len,
-                                            PCAP_CAPTURE_WIFI);
-            }
-        }
+    if (xQueueSend(pineap_alert_queue, &alert, 0) != pdTRUE) {
+        pineap_alerts_dropped++;
     }
-}
 
-static void trim_trailing(char *str) {
-    int i = strlen(str) - 1;
-    while (i >= 0 && (str[i] == ' ' || str[i] == '\t' || str[i] == '\n' || str[i] == '\r')) {
-        str[i] = '\0';
-        i--;
+    // Write to PCAP if capture is active
+    if (pcap_is_capturing(PCAP_CAPTURE_WIFI)) {
+        pcap_write_wifi_packet(ppkt);
     }
 }
 
@@ -407,7 +301,8 @@ void gps_event_handler(void *event_handler_arg, esp_event_base_t event_base, int
                        void *event_data) {
     switch (event_id) {
     case GPS_UPDATE:
-        gps = (gps_t *)event_data;
+        // event_data is the parser's copy of the fix, valid only during this call
+        gps_manager_publish((const gps_t *)event_data);
         break;
     default:
         break;
@@ -494,12 +389,107 @@ bool is_pwn_response(const wifi_promiscuous_pkt_t *pkt) {
 void wifi_raw_scan_callback(void *buf, wifi_promiscuous_pkt_type_t type) {
     wifi_promiscuous_pkt_t *pkt = (wifi_promiscuous_pkt_t *)buf;
     if (pkt->rx_ctrl.sig_len > 0) {
-        esp_err_t ret =
-            pcap_write_packet_to_buffer(pkt->payload, pkt->rx_ctrl.sig_len, PCAP_CAPTURE_WIFI);
-        if (ret != ESP_OK) {
-            ESP_LOGE("RAW_SCAN", "Failed to write packet to buffer");
+        // A full ring drops the frame and counts it in the session stats;
+        // logging here would stall the RX task on every drop.
+        pcap_write_wifi_packet(pkt);
+    }
+}
+
+#ifndef CONFIG_WARDRIVE_DEDUP_ENTRIES
+#define CONFIG_WARDRIVE_DEDUP_ENTRIES 1024
+#endif
+#ifndef CONFIG_WARDRIVE_DEDUP_RSSI_DB
+#define CONFIG_WARDRIVE_DEDUP_RSSI_DB 6
+#endif
+#ifndef CONFIG_WARDRIVE_DEDUP_MOVE_M
+#define CONFIG_WARDRIVE_DEDUP_MOVE_M 50
+#endif
+
+// What was last logged for a BSSID, so repeat beacons can be dropped.
+typedef struct {
+    int32_t lat_e7;
+    int32_t lon_e7;
+    int8_t best_rssi;
+    bool has_fix;
+    bool logged; // A row for this BSSID reached the logger
+} wardrive_sighting_t;
+
+static mac_table_t wardrive_seen;
+static uint32_t wardrive_sightings = 0;
+static uint32_t wardrive_logged = 0;
+
+esp_err_t wardriving_dedup_reset(void) {
+    if (wardrive_seen.slots == NULL) {
+        esp_err_t err = mac_table_init(&wardrive_seen, CONFIG_WARDRIVE_DEDUP_ENTRIES,
+                                       sizeof(wardrive_sighting_t));
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "No memory for the wardriving dedup table, logging every beacon");
+            return err;
         }
+    } else {
+        mac_table_clear(&wardrive_seen);
+    }
+    wardrive_sightings = 0;
+    wardrive_logged = 0;
+    return ESP_OK;
+}
+
+void wardriving_dedup_stats(uint32_t *sightings, uint32_t *logged, mac_table_stats_t *table) {
+    *sightings = wardrive_sightings;
+    *logged = wardrive_logged;
+    mac_table_get_stats(&wardrive_seen, table);
+}
+
+// Equirectangular approximation; plenty for distances of a few hundred meters.
+static float wardrive_distance_m(int32_t lat1_e7, int32_t lon1_e7, int32_t lat2_e7,
+                                 int32_t lon2_e7) {
+    float lat_rad = lat1_e7 * 1e-7f * (float)M_PI / 180.0f;
+    float dy = (lat2_e7 - lat1_e7) * 1e-7f * 110574.0f;
+    float dx = (lon2_e7 - lon1_e7) * 1e-7f * 111320.0f * cosf(lat_rad);
+    return sqrtf(dx * dx + dy * dy);
+}
+
+// A sighting is logged the first time a BSSID is heard, when its signal is
+// a threshold stronger than the best logged so far, or when we have moved
+// far enough from where it was last logged. *slot is the BSSID's entry, or
+// NULL without a table; nothing is recorded in it until the row has been
+// accepted, see wardriving_mark_logged().
+static bool wardriving_should_log(const uint8_t *bssid, int rssi, bool has_fix,
+                                  int32_t lat_e7, int32_t lon_e7, wardrive_sighting_t **slot) {
+    wardrive_sightings++;
+    *slot = NULL;
+    if (wardrive_seen.slots == NULL) {
+        return true;
+    }
+
+    wardrive_sighting_t *seen = mac_table_upsert(&wardrive_seen, bssid, NULL);
+    *slot = seen;
+
+    bool log = !seen->logged || rssi >= seen->best_rssi + CONFIG_WARDRIVE_DEDUP_RSSI_DB;
+    if (!log && has_fix) {
+        log = !seen->has_fix || wardrive_distance_m(seen->lat_e7, seen->lon_e7, lat_e7,
+                                                    lon_e7) > CONFIG_WARDRIVE_DEDUP_MOVE_M;
     }
+    return log;
+}
+
+// Called once the logger has taken the row. A row it refused, for a stale
+// fix or a full queue, leaves the BSSID free to be logged next time.
+static void wardriving_mark_logged(wardrive_sighting_t *seen, int rssi, bool has_fix,
+                                   int32_t lat_e7, int32_t lon_e7) {
+    wardrive_logged++;
+    if (seen == NULL) {
+        return;
+    }
+    if (!seen->logged || rssi > seen->best_rssi) {
+        seen->best_rssi = rssi;
+    }
+    if (has_fix) {
+        seen->lat_e7 = lat_e7;
+        seen->lon_e7 = lon_e7;
+        seen->has_fix = true;
+    }
+    seen->logged = true;
 }
 
 void wardriving_scan_callback(void *buf, wifi_promiscuous_pkt_type_t type) {
@@ -511,141 +501,83 @@ void wardriving_scan_callback(void *buf, wifi_promiscuous_pkt_type_t type) {
     const wifi_ieee80211_packet_t *ipkt = (wifi_ieee80211_packet_t *)pkt->payload;
     const wifi_ieee80211_mac_hdr_t *hdr = &ipkt->hdr;
 
-    const uint8_t *payload = pkt->payload;
-    int len = pkt->rx_ctrl.sig_len;
-
     uint8_t frame_type = hdr->frame_ctrl & 0xFC;
     if (frame_type != 0x80 && frame_type != 0x50) {
         return;
     }
 
-    int index = 36;
-    char ssid[33] = {0};
-    uint8_t bssid[6];
-    memcpy(bssid, hdr->addr3, 6);
-
-    int rssi = pkt->rx_ctrl.rssi;
-    int channel = pkt->rx_ctrl.channel;
-
-    bool network_found = false;
-    char encryption_type[8] = "OPEN";
-
-    while (index + 1 < len) {
-        uint8_t id = payload[index];
-        uint8_t ie_len = payload[index + 1];
-
-        if (index + 2 + ie_len > len) {
-            break;
-        }
-
-        if (id == 0 && ie_len <= 32) {
-            memcpy(ssid, &payload[index + 2], ie_len);
-            ssid[ie_len] = '\0';
-            trim_trailing(ssid);
-        }
-
-        if (id == 48) {
-            strncpy(encryption_type, "WPA2", sizeof(encryption_type));
-        } else if (id == 221) {
-            uint32_t oui =
-                (payload[index + 2] << 16) | (payload[index + 3] << 8) | payload[index + 4];
-            uint8_t oui_type = payload[index + 5];
-            if (oui == 0x0050f2 && oui_type == 0x01) {
-                strncpy(encryption_type, "WPA", sizeof(encryption_type));
-            } else if (oui == 0x0050f2 && oui_type == 0x02) {
-                strncpy(encryption_type, "WEP", sizeof(encryption_type));
-            }
-        }
-
-        index += (2 + ie_len);
+    ieee80211_ies_t ies;
+    if (!ieee80211_parse_mgmt(pkt->payload, pkt->rx_ctrl.sig_len, &ies)) {
+        return;
     }
 
-    double latitude = 0;
-    double longitude = 0;
+    char ssid[IEEE80211_SSID_MAX_LEN + 1];
+    ieee80211_ssid_copy(&ies, ssid);
+    size_t ssid_len = strlen(ssid);
+    // Rows without a fresh fix or a usable SSID are never logged, so they
+    // are turned away before the dedup table is touched.
+    gps_snapshot_t fix = gps_get_snapshot();
+    if (!gps_snapshot_fresh(&fix) || ssid_len <= 2) {
+        return;
+    }
 
-    if (gps != NULL) {
-        latitude = gps->latitude;
-        longitude = gps->longitude;
+    const uint8_t *bssid = hdr->addr3;
+    int rssi = pkt->rx_ctrl.rssi;
+    wardrive_sighting_t *seen;
+    if (!wardriving_should_log(bssid, rssi, true, fix.lat_e7, fix.lon_e7, &seen)) {
+        return;
     }
 
-    wardriving_data_t wardriving_data;
-    strncpy(wardriving_data.ssid, ssid, sizeof(wardriving_data.ssid) - 1);
-    wardriving_data.ssid[sizeof(wardriving_data.ssid) - 1] = '\0'; // Null-terminate
-    snprintf(wardriving_data.bssid, sizeof(wardriving_data.bssid), "%02x:%02x:%02x:%02x:%02x:%02x",
-             bssid[0], bssid[1], bssid[2], bssid[3], bssid[4], bssid[5]);
-    wardriving_data.rssi = rssi;
-    wardriving_data.channel = channel;
-    wardriving_data.latitude = latitude;
-    wardriving_data.longitude = longitude;
-    strncpy(wardriving_data.encryption_type, encryption_type,
-            sizeof(wardriving_data.encryption_type) - 1);
-    wardriving_data.encryption_type[sizeof(wardriving_data.encryption_type) - 1] = '\0';
+    wardrive_record_t record = {0};
+    memcpy(record.mac, bssid, 6);
+    record.kind = WARDRIVE_RECORD_WIFI;
+    // The advertised channel, not the one we overheard it on
+    record.channel = ies.channel ? ies.channel : pkt->rx_ctrl.channel;
+    record.rssi = rssi;
+    record.auth = ieee80211_security(&ies);
+    record.name_len = ssid_len;
+    memcpy(record.name, ssid, ssid_len);
 
-    esp_err_t err = gps_manager_log_wardriving_data(&wardriving_data);
+    if (gps_manager_log_wardriving_record(&record, &fix) == ESP_OK) {
+        wardriving_mark_logged(seen, rssi, true, fix.lat_e7, fix.lon_e7);
+    }
 }
 
 void wifi_probe_scan_callback(void *buf, wifi_promiscuous_pkt_type_t type) {
-    if (type != WIFI_PKT_MGMT)
-        return;
     wifi_promiscuous_pkt_t *pkt = (wifi_promiscuous_pkt_t *)buf;
     if (pkt->rx_ctrl.sig_len > 0) {
-        esp_err_t ret =
-            pcap_write_packet_to_buffer(pkt->payload, pkt->rx_ctrl.sig_len, PCAP_CAPTURE_WIFI);
-        if (ret != ESP_OK) {
-            ESP_LOGE("PROBE_SCAN", "Failed to write packet to buffer");
-        }
+        pcap_write_wifi_packet(pkt);
     }
 }
 
 void wifi_beacon_scan_callback(void *buf, wifi_promiscuous_pkt_type_t type) {
-    if (type != WIFI_PKT_MGMT)
-        return;
     wifi_promiscuous_pkt_t *pkt = (wifi_promiscuous_pkt_t *)buf;
     if (pkt->rx_ctrl.sig_len > 0) {
-        esp_err_t ret =
-            pcap_write_packet_to_buffer(pkt->payload, pkt->rx_ctrl.sig_len, PCAP_CAPTURE_WIFI);
-        if (ret != ESP_OK) {
-            ESP_LOGE("BEACON_SCAN", "Failed to write packet to buffer");
-        }
+        pcap_write_wifi_packet(pkt);
     }
 }
 
 void wifi_deauth_scan_callback(void *buf, wifi_promiscuous_pkt_type_t type) {
-    if (type != WIFI_PKT_MGMT)
-        return;
     wifi_promiscuous_pkt_t *pkt = (wifi_promiscuous_pkt_t *)buf;
     if (pkt->rx_ctrl.sig_len > 0) {
-        esp_err_t ret =
-            pcap_write_packet_to_buffer(pkt->payload, pkt->rx_ctrl.sig_len, PCAP_CAPTURE_WIFI);
-        if (ret != ESP_OK) {
-            ESP_LOGE("DEAUTH_SCAN", "Failed to write packet to buffer");
-        }
+        pcap_write_wifi_packet(pkt);
     }
 }
 
 void wifi_pwn_scan_callback(void *buf, wifi_promiscuous_pkt_type_t type) {
-    if (type != WIFI_PKT_MGMT)
-        return;
     wifi_promiscuous_pkt_t *pkt = (wifi_promiscuous_pkt_t *)buf;
     if (pkt->rx_ctrl.sig_len > 0) {
-        esp_err_t ret =
-            pcap_write_packet_to_buffer(pkt->payload, pkt->rx_ctrl.sig_len, PCAP_CAPTURE_WIFI);
-        if (ret != ESP_OK) {
-            ESP_LOGE("PWN_SCAN", "Failed to write packet to buffer");
-        }
+        pcap_write_wifi_packet(pkt);
     }
 }
 
 void wifi_eapol_scan_callback(void *buf, wifi_promiscuous_pkt_type_t type) {
-    if (type != WIFI_PKT_MGMT)
-        return;
     wifi_promiscuous_pkt_t *pkt = (wifi_promiscuous_pkt_t *)buf;
+    // Of the data frames, only the handshake itself is worth keeping
+    if (type == WIFI_PKT_DATA && (pkt->rx_ctrl.sig_len < 34 || !is_eapol_response(pkt)))
+        return;
     if (pkt->rx_ctrl.sig_len > 0) {
-        esp_err_t ret =
-            pcap_write_packet_to_buffer(pkt->payload, pkt->rx_ctrl.sig_len, PCAP_CAPTURE_WIFI);
-        if (ret != ESP_OK) {
-            ESP_LOGE("EAPOL_SCAN", "Failed to write packet to buffer");
-        }
+        pcap_write_wifi_packet(pkt);
     }
 }
 
@@ -658,106 +590,70 @@ void wifi_wps_detection_callback(void *buf, wifi_promiscuous_pkt_type_t type) {
     const wifi_ieee80211_packet_t *ipkt = (wifi_ieee80211_packet_t *)pkt->payload;
     const wifi_ieee80211_mac_hdr_t *hdr = &ipkt->hdr;
 
-    const uint8_t *payload = pkt->payload;
-    int len = pkt->rx_ctrl.sig_len;
-
     uint8_t frame_type = hdr->frame_ctrl & 0xFC;
     if (frame_type != 0x80 && frame_type != 0x50) {
         return;
     }
 
-    int index = 36;
-    char ssid[33] = {0};
-    bool wps_found = false;
+    ieee80211_ies_t ies;
+    if (!ieee80211_parse_mgmt(pkt->payload, pkt->rx_ctrl.sig_len, &ies) || ies.wps == NULL) {
+        return;
+    }
+
+    char ssid[IEEE80211_SSID_MAX_LEN + 1];
+    ieee80211_ssid_copy(&ies, ssid);
     uint8_t bssid[6];
     memcpy(bssid, hdr->addr3, 6);
 
-    while (index + 1 < len) {
-        uint8_t id = payload[index];
-        uint8_t ie_len = payload[index + 1];
+    if (is_network_duplicate(ssid, bssid)) {
+        return;
+    }
 
-        if (index + 2 + ie_len > len) {
-            break;
-        }
+    const uint8_t *value;
+    uint16_t value_len;
+    if (!ieee80211_wps_attr_find(&ies, WPS_ATTR_CONFIG_METHODS, &value, &value_len) ||
+        value_len != 2) {
+        return;
+    }
 
-        if (id == 0 && ie_len <= 32) {
-            memcpy(ssid, &payload[index + 2], ie_len);
-            ssid[ie_len] = '\0';
-            trim_trailing(ssid);
-        }
+    uint16_t config_methods = (value[0] << 8) | value[1];
 
-        if (is_network_duplicate(ssid, bssid)) {
-            return;
-        }
+    IRAM_PRINTF("Configuration Methods found: 0x%04x\n", config_methods);
 
-        if (id == 221 && ie_len >= 4) {
-            uint32_t oui =
-                (payload[index + 2] << 16) | (payload[index + 3] << 8) | payload[index + 4];
-            uint8_t oui_type = payload[index + 5];
-
-            if (oui == 0x0050f2 && oui_type == 0x04) {
-                wps_found = true;
-
-                int attr_index = index + 6;
-                int wps_ie_end = index + 2 + ie_len;
-
-                while (attr_index + 4 <= wps_ie_end) {
-                    uint16_t attr_id = (payload[attr_index] << 8) | payload[attr_index + 1];
-                    uint16_t attr_len = (payload[attr_index + 2] << 8) | payload[attr_index + 3];
-
-                    if (attr_len > (wps_ie_end - (attr_index + 4))) {
-                        break;
-                    }
-
-                    if (attr_id == 0x1008 && attr_len == 2) {
-                        uint16_t config_methods =
-                            (payload[attr_index + 4] << 8) | payload[attr_index + 5];
-
-                        IRAM_PRINTF("Configuration Methods found: 0x%04x\n", config_methods);
-
-                        if (config_methods & WPS_CONF_METHODS_PBC) {
-                            IRAM_PRINTF("WPS Push Button detected:\n%s\n", ssid);
-                            TERMINAL_VIEW_ADD_TEXT("WPS Push Button detected:\n%s\n", ssid);
-                        } else if (config_methods &
-                                   (WPS_CONF_METHODS_PIN_DISPLAY | WPS_CONF_METHODS_PIN_KEYPAD)) {
-                            IRAM_PRINTF("WPS PIN detected:\n%s\n", ssid);
-                            TERMINAL_VIEW_ADD_TEXT("WPS PIN detected:\n%s\n", ssid);
-                        }
-
-                        if (should_store_wps == 1) {
-                            wps_network_t new_network;
-                            strncpy(new_network.ssid, ssid, sizeof(new_network.ssid) - 1);
-                            new_network.ssid[sizeof(new_network.ssid) - 1] =
-                                '\0'; // Ensure null termination
-                            memcpy(new_network.bssid, bssid, sizeof(new_network.bssid));
-                            new_network.wps_enabled = true;
-                            new_network.wps_mode = config_methods & (WPS_CONF_METHODS_PIN_DISPLAY |
-                                                                     WPS_CONF_METHODS_PIN_KEYPAD)
-                                                       ? WPS_MODE_PIN
-                                                       : WPS_MODE_PBC;
-
-                            detected_wps_networks[detected_network_count++] = new_network;
-                        } else {
-                            pcap_write_packet_to_buffer(pkt->payload, pkt->rx_ctrl.sig_len,
-                                                        PCAP_CAPTURE_WIFI);
-                        }
-
-                        if (detected_network_count >= MAX_WPS_NETWORKS) {
-                            IRAM_PRINTF("Maximum number of WPS networks detected\nStopping monitor "
-                                   "mode.\n");
-                            TERMINAL_VIEW_ADD_TEXT(
-                                "Maximum number of WPS networks detected\nStopping "
-                                "monitor mode.\n");
-                            wifi_manager_stop_monitor_mode();
-                        }
-                    }
-
-                    attr_index += (4 + attr_len);
-                }
-            }
+    if (config_methods & WPS_CONF_METHODS_PBC) {
+        IRAM_PRINTF("WPS Push Button detected:\n%s\n", ssid);
+        TERMINAL_VIEW_ADD_TEXT("WPS Push Button detected:\n%s\n", ssid);
+    } else if (config_methods & (WPS_CONF_METHODS_PIN_DISPLAY | WPS_CONF_METHODS_PIN_KEYPAD)) {
+        IRAM_PRINTF("WPS PIN detected:\n%s\n", ssid);
+        TERMINAL_VIEW_ADD_TEXT("WPS PIN detected:\n%s\n", ssid);
+    }
+
+    if (should_store_wps == 1) {
+        if (detected_network_count >= MAX_WPS_NETWORKS) {
+            return; // Monitor mode is already being stopped
         }
 
-        index += (2 + ie_len);
+        wps_network_t new_network;
+        strncpy(new_network.ssid, ssid, sizeof(new_network.ssid) - 1);
+        new_network.ssid[sizeof(new_network.ssid) - 1] = '\0'; // Ensure null termination
+        memcpy(new_network.bssid, bssid, sizeof(new_network.bssid));
+        new_network.wps_enabled = true;
+        new_network.wps_mode =
+            config_methods & (WPS_CONF_METHODS_PIN_DISPLAY | WPS_CONF_METHODS_PIN_KEYPAD)
+                ? WPS_MODE_PIN
+                : WPS_MODE_PBC;
+
+        detected_wps_networks[detected_network_count++] = new_network;
+    } else {
+        pcap_write_wifi_packet(pkt);
+    }
+
+    if (detected_network_count >= MAX_WPS_NETWORKS) {
+        IRAM_PRINTF("Maximum number of WPS networks detected\nStopping monitor "
+                    "mode.\n");
+        TERMINAL_VIEW_ADD_TEXT("Maximum number of WPS networks detected\nStopping "
+                               "monitor mode.\n");
+        wifi_manager_stop_monitor_consumer("capture");
     }
 }
 
@@ -771,36 +667,23 @@ void ble_wardriving_callback(struct ble_gap_event *event, void *arg) {
         return;
     }
 
-    wardriving_data_t wardriving_data = {0};
-    wardriving_data.ble_data.is_ble_device = true;
-
-    // Get BLE MAC and RSSI
-    snprintf(wardriving_data.ble_data.ble_mac, sizeof(wardriving_data.ble_data.ble_mac),
-             "%02x:%02x:%02x:%02x:%02x:%02x", event->disc.addr.val[0], event->disc.addr.val[1],
-             event->disc.addr.val[2], event->disc.addr.val[3], event->disc.addr.val[4],
-             event->disc.addr.val[5]);
-
-    wardriving_data.ble_data.ble_rssi = event->disc.rssi;
+    wardrive_record_t record = {0};
+    record.kind = WARDRIVE_RECORD_BLE;
+    // NimBLE stores the address least significant byte first.
+    for (int i = 0; i < 6; i++) {
+        record.mac[i] = event->disc.addr.val[5 - i];
+    }
+    record.rssi = event->disc.rssi;
 
     // Parse BLE name if available
     if (event->disc.length_data > 0) {
         ble_hs_adv_parse(event->disc.data, event->disc.length_data, ble_hs_adv_parse_fields_cb,
-                         &wardriving_data);
-    }
-
-    // Get GPS data from the global handle
-    gps_t *gps = &((esp_gps_t *)nmea_hdl)->parent;
-    if (gps != NULL && gps->valid) {
-        wardriving_data.gps_quality.satellites_used = gps->sats_in_use;
-        wardriving_data.gps_quality.hdop = gps->dop_h;
-        wardriving_data.gps_quality.speed = gps->speed;
-        wardriving_data.gps_quality.course = gps->cog;
-        wardriving_data.gps_quality.fix_quality = gps->fix;
-        wardriving_data.gps_quality.has_valid_fix = (gps->fix >= GPS_FIX_GPS);
+                         &record);
     }
 
     // Use GPS manager to log data
-    esp_err_t err = gps_manager_log_wardriving_data(&wardriving_data);
+    gps_snapshot_t fix = gps_get_snapshot();
+    esp_err_t err = gps_manager_log_wardriving_record(&record, &fix);
     if (err != ESP_OK) {
         ESP_LOGD("BLE_WD", "Skipped logging entry\nGPS data not ready");
     }
@@ -808,12 +691,12 @@ void ble_wardriving_callback(struct ble_gap_event *event, void *arg) {
 
 // Move the callback implementation inside the ESP32S2 guard
 static int ble_hs_adv_parse_fields_cb(const struct ble_hs_adv_field *field, void *arg) {
-    wardriving_data_t *data = (wardriving_data_t *)arg;
+    wardrive_record_t *record = (wardrive_record_t *)arg;
 
     if (field->type == BLE_HS_ADV_TYPE_COMP_NAME) {
-        size_t name_len = MIN(field->length, sizeof(data->ble_data.ble_name) - 1);
-        memcpy(data->ble_data.ble_name, field->value, name_len);
-        data->ble_data.ble_name[name_len] = '\0';
+        size_t name_len = MIN(field->length, sizeof(record->name));
+        memcpy(record->name, field->value, name_len);
+        record->name_len = name_len;
     }
 
     return 0;
@@ -882,40 +765,10 @@ void ble_skimmer_scan_callback(struct ble_gap_event *event, void *arg) {
                 // pulse rgb red once when skimmer is detected
                 pulse_once(&rgb_manager, 255, 0, 0);
 
-                // Create enhanced PCAP packet with metadata
-                if (pcap_file != NULL) {
-                    // Format: [Timestamp][MAC][RSSI][Name][Raw Data]
-                    uint8_t enhanced_packet[256] = {0};
-                    size_t packet_len = 0;
-
-                    // Add MAC address
-                    memcpy(enhanced_packet + packet_len, event->disc.addr.val, 6);
-                    packet_len += 6;
-
-                    // Add RSSI
-                    enhanced_packet[packet_len++] = (uint8_t)event->disc.rssi;
-
-                    // Add device name length and name
-                    enhanced_packet[packet_len++] = (uint8_t)name_len;
-                    memcpy(enhanced_packet + packet_len, device_name, name_len);
-                    packet_len += name_len;
-
-                    // Add reason for flagging
-                    const char *reason = suspicious_names[i];
-                    uint8_t reason_len = strlen(reason);
-                    enhanced_packet[packet_len++] = reason_len;
-                    memcpy(enhanced_packet + packet_len, reason, reason_len);
-                    packet_len += reason_len;
-
-                    // Add raw advertisement data
-                    memcpy(enhanced_packet + packet_len, event->disc.data, event->disc.length_data);
-                    packet_len += event->disc.length_data;
-
-                    // Write to PCAP with proper BLE packet format
-                    pcap_write_packet_to_buffer(enhanced_packet, packet_len,
-                                                PCAP_CAPTURE_BLUETOOTH);
-
-                    // Force flush to ensure suspicious device is captured
+                // Record the flagged advertisement and have the writer push
+                // it to the card straight away
+                if (pcap_is_capturing(PCAP_CAPTURE_BLUETOOTH)) {
+                    ble_pcap_write_adv_report(event);
                     pcap_flush_buffer_to_file();
                 }
                 break;
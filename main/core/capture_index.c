@@ -0,0 +1,573 @@
+// capture_index.c
+
+#include "core/capture_index.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "managers/sd_card_manager.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TAG "CaptureIndex"
+
+#define CAPTURE_INDEX_MAGIC 0x58494347 // "GCIX"
+#define CAPTURE_INDEX_ROOT "/mnt/ghostesp"
+#define CAPTURE_INDEX_PCAP_DIR "/mnt/ghostesp/pcaps"
+#define CAPTURE_INDEX_GPS_DIR "/mnt/ghostesp/gps"
+#define CAPTURE_INDEX_TMP_PATH "/mnt/ghostesp/captures.tmp"
+// Hash slots for base names; a power of two larger than the name limit.
+#define CAPTURE_INDEX_SLOTS 64
+// The manifest is rewritten as seeds plus a recent tail once it grows past
+// this, which bounds the one-off replay at boot.
+#define CAPTURE_INDEX_COMPACT_BYTES (64 * 1024)
+// Records scanned for a listing: an open, a close and room for deletes.
+#define CAPTURE_INDEX_LIST_WINDOW(max) ((max) * 3)
+
+typedef enum {
+    CAPTURE_RECORD_OPEN = 1,
+    CAPTURE_RECORD_CLOSE = 2,
+    CAPTURE_RECORD_DELETE = 3,
+    CAPTURE_RECORD_SEED = 4, // Highest index found on the card, no session
+} capture_record_kind_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint8_t kind;
+    uint8_t type;
+    uint16_t file_index;
+    char base_name[CAPTURE_INDEX_NAME_LEN];
+    uint32_t start_time;
+    uint32_t size;
+    uint32_t packets;
+    uint8_t reserved[8];
+    uint32_t crc;
+} capture_record_t;
+
+_Static_assert(sizeof(capture_record_t) == 64, "capture record must be 64 bytes");
+
+// PCAP and PCAPNG files share a directory and a number sequence.
+typedef enum {
+    CAPTURE_GROUP_PCAPS,
+    CAPTURE_GROUP_GPS,
+} capture_group_t;
+
+typedef struct {
+    bool used;
+    uint8_t group;
+    uint16_t next_index;
+    char base_name[CAPTURE_INDEX_NAME_LEN];
+} capture_slot_t;
+
+static capture_slot_t capture_slots[CAPTURE_INDEX_SLOTS];
+static size_t capture_slot_count = 0;
+static bool capture_index_loaded = false;
+static SemaphoreHandle_t capture_index_mutex = NULL;
+static portMUX_TYPE capture_index_mutex_init = portMUX_INITIALIZER_UNLOCKED;
+
+static capture_group_t capture_group_of(capture_file_type_t type) {
+    return type == CAPTURE_FILE_CSV || type == CAPTURE_FILE_GWD ? CAPTURE_GROUP_GPS
+                                                                : CAPTURE_GROUP_PCAPS;
+}
+
+const char *capture_index_type_name(capture_file_type_t type) {
+    switch (type) {
+    case CAPTURE_FILE_PCAP:
+        return "pcap";
+    case CAPTURE_FILE_PCAPNG:
+        return "pcapng";
+    case CAPTURE_FILE_CSV:
+        return "csv";
+    case CAPTURE_FILE_GWD:
+        return "gwd";
+    default:
+        return "unknown";
+    }
+}
+
+void capture_index_format_path(char *buffer, size_t size, capture_file_type_t type,
+                               const char *base_name, int file_index) {
+    const char *dir =
+        capture_group_of(type) == CAPTURE_GROUP_GPS ? CAPTURE_INDEX_GPS_DIR : CAPTURE_INDEX_PCAP_DIR;
+    snprintf(buffer, size, "%s/%s_%d.%s", dir, base_name, file_index,
+             capture_index_type_name(type));
+}
+
+static uint32_t capture_hash(uint8_t group, const char *base_name) {
+    // FNV-1a over the group and the name
+    uint32_t hash = 2166136261u ^ group;
+    hash *= 16777619u;
+    for (const char *p = base_name; *p; p++) {
+        hash ^= (uint8_t)*p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static capture_slot_t *capture_slot_find(uint8_t group, const char *base_name, bool create) {
+    uint32_t pos = capture_hash(group, base_name) & (CAPTURE_INDEX_SLOTS - 1);
+
+    for (int probe = 0; probe < CAPTURE_INDEX_SLOTS; probe++) {
+        capture_slot_t *slot = &capture_slots[pos];
+        if (!slot->used) {
+            if (!create || capture_slot_count >= CAPTURE_INDEX_MAX_NAMES) {
+                return NULL;
+            }
+            slot->used = true;
+            slot->group = group;
+            slot->next_index = 0;
+            strlcpy(slot->base_name, base_name, sizeof(slot->base_name));
+            capture_slot_count++;
+            return slot;
+        }
+        if (slot->group == group && strcmp(slot->base_name, base_name) == 0) {
+            return slot;
+        }
+        pos = (pos + 1) & (CAPTURE_INDEX_SLOTS - 1);
+    }
+    return NULL;
+}
+
+static void capture_slot_advance(uint8_t group, const char *base_name, int file_index) {
+    capture_slot_t *slot = capture_slot_find(group, base_name, true);
+    if (slot == NULL) {
+        ESP_LOGW(TAG, "Index full, %s will not be tracked", base_name);
+        return;
+    }
+    if (file_index >= slot->next_index) {
+        slot->next_index = file_index + 1;
+    }
+}
+
+static uint32_t capture_record_crc(const capture_record_t *record) {
+    return esp_rom_crc32_le(0, (const uint8_t *)record, offsetof(capture_record_t, crc));
+}
+
+static bool capture_record_valid(const capture_record_t *record) {
+    return record->magic == CAPTURE_INDEX_MAGIC && record->type < CAPTURE_FILE_TYPE_COUNT &&
+           memchr(record->base_name, '\0', sizeof(record->base_name)) != NULL &&
+           record->crc == capture_record_crc(record);
+}
+
+static void capture_record_init(capture_record_t *record, capture_record_kind_t kind,
+                                capture_file_type_t type, const char *base_name, int file_index) {
+    memset(record, 0, sizeof(*record));
+    record->magic = CAPTURE_INDEX_MAGIC;
+    record->kind = kind;
+    record->type = type;
+    record->file_index = file_index;
+    strlcpy(record->base_name, base_name, sizeof(record->base_name));
+}
+
+static esp_err_t capture_record_write(FILE *f, capture_record_t *record) {
+    record->crc = capture_record_crc(record);
+    return fwrite(record, sizeof(*record), 1, f) == 1 ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t capture_index_append(capture_record_t *record) {
+    FILE *f = fopen(CAPTURE_INDEX_PATH, "ab");
+    if (f == NULL) {
+        ESP_LOGE(TAG, "Failed to open %s for append", CAPTURE_INDEX_PATH);
+        return ESP_FAIL;
+    }
+    esp_err_t ret = capture_record_write(f, record);
+    fclose(f);
+    return ret;
+}
+
+// Finds the highest "<base>_<n>.<ext>" number per base name in dir. Used
+// once, when the card has no manifest yet.
+static void capture_index_seed_dir(FILE *out, const char *dir_path, capture_group_t group) {
+    DIR *dir = opendir(dir_path);
+    if (!dir) {
+        return;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        const char *underscore = strrchr(entry->d_name, '_');
+        if (underscore == NULL || underscore == entry->d_name) {
+            continue;
+        }
+        size_t base_len = underscore - entry->d_name;
+        if (base_len >= CAPTURE_INDEX_NAME_LEN) {
+            continue;
+        }
+
+        int index;
+        char ext[8];
+        if (sscanf(underscore, "_%d.%7s", &index, ext) != 2 || index < 0) {
+            continue;
+        }
+        if (group == CAPTURE_GROUP_GPS ? strcmp(ext, "csv") != 0 && strcmp(ext, "gwd") != 0
+                                       : strncmp(ext, "pcap", 4) != 0) {
+            continue;
+        }
+
+        char base_name[CAPTURE_INDEX_NAME_LEN];
+        memcpy(base_name, entry->d_name, base_len);
+        base_name[base_len] = '\0';
+        capture_slot_advance(group, base_name, index);
+    }
+    closedir(dir);
+
+    if (out == NULL) {
+        return;
+    }
+    for (int i = 0; i < CAPTURE_INDEX_SLOTS; i++) {
+        capture_slot_t *slot = &capture_slots[i];
+        if (slot->used && slot->group == group && slot->next_index > 0) {
+            capture_record_t record;
+            capture_record_init(&record, CAPTURE_RECORD_SEED,
+                                group == CAPTURE_GROUP_GPS ? CAPTURE_FILE_CSV : CAPTURE_FILE_PCAP,
+                                slot->base_name, slot->next_index - 1);
+            capture_record_write(out, &record);
+        }
+    }
+}
+
+static void capture_index_seed(void) {
+    ESP_LOGI(TAG, "No capture index, building one from the card");
+    FILE *f = fopen(CAPTURE_INDEX_PATH, "wb");
+    capture_index_seed_dir(f, CAPTURE_INDEX_PCAP_DIR, CAPTURE_GROUP_PCAPS);
+    capture_index_seed_dir(f, CAPTURE_INDEX_GPS_DIR, CAPTURE_GROUP_GPS);
+    if (f != NULL) {
+        fclose(f);
+    }
+}
+
+// Rewrites the manifest as one seed per name followed by the most recent
+// records, so listings keep working after compaction.
+static void capture_index_compact(long valid_records) {
+    long keep = CAPTURE_INDEX_LIST_WINDOW(CAPTURE_INDEX_LIST_MAX);
+    if (keep > valid_records) {
+        keep = valid_records;
+    }
+
+    FILE *in = fopen(CAPTURE_INDEX_PATH, "rb");
+    FILE *out = fopen(CAPTURE_INDEX_TMP_PATH, "wb");
+    if (in == NULL || out == NULL) {
+        if (in)
+            fclose(in);
+        if (out)
+            fclose(out);
+        return;
+    }
+
+    bool ok = true;
+    for (int i = 0; i < CAPTURE_INDEX_SLOTS && ok; i++) {
+        capture_slot_t *slot = &capture_slots[i];
+        if (slot->used && slot->next_index > 0) {
+            capture_record_t record;
+            capture_record_init(&record, CAPTURE_RECORD_SEED,
+                                slot->group == CAPTURE_GROUP_GPS ? CAPTURE_FILE_CSV
+                                                                 : CAPTURE_FILE_PCAP,
+                                slot->base_name, slot->next_index - 1);
+            ok = capture_record_write(out, &record) == ESP_OK;
+        }
+    }
+
+    capture_record_t record;
+    fseek(in, (valid_records - keep) * (long)sizeof(record), SEEK_SET);
+    while (ok && fread(&record, sizeof(record), 1, in) == 1) {
+        ok = fwrite(&record, sizeof(record), 1, out) == 1;
+    }
+    fclose(in);
+    fclose(out);
+
+    // FAT cannot rename over an existing file.
+    if (!ok || unlink(CAPTURE_INDEX_PATH) != 0 ||
+        rename(CAPTURE_INDEX_TMP_PATH, CAPTURE_INDEX_PATH) != 0) {
+        ESP_LOGW(TAG, "Failed to compact capture index");
+        unlink(CAPTURE_INDEX_TMP_PATH);
+        return;
+    }
+    ESP_LOGI(TAG, "Compacted capture index to %ld records", keep);
+}
+
+// Replays the manifest once per boot to rebuild the next-index table.
+static esp_err_t capture_index_load(void) {
+    if (capture_index_loaded) {
+        return ESP_OK;
+    }
+    if (!sd_card_exists(CAPTURE_INDEX_ROOT)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    memset(capture_slots, 0, sizeof(capture_slots));
+    capture_slot_count = 0;
+
+    FILE *f = fopen(CAPTURE_INDEX_PATH, "rb");
+    if (f == NULL) {
+        capture_index_seed();
+        capture_index_loaded = true;
+        return ESP_OK;
+    }
+
+    capture_record_t record;
+    long records = 0;
+    while (fread(&record, sizeof(record), 1, f) == 1) {
+        records++;
+        if (!capture_record_valid(&record)) {
+            continue;
+        }
+        if (record.kind == CAPTURE_RECORD_OPEN || record.kind == CAPTURE_RECORD_SEED) {
+            capture_slot_advance(capture_group_of(record.type), record.base_name,
+                                 record.file_index);
+        }
+    }
+    long file_size = ftell(f);
+    fclose(f);
+
+    // A record cut short by power loss would misalign every later append.
+    long valid_size = records * (long)sizeof(record);
+    if (file_size > valid_size) {
+        ESP_LOGW(TAG, "Dropping %ld byte partial record", file_size - valid_size);
+        truncate(CAPTURE_INDEX_PATH, valid_size);
+    }
+    if (valid_size > CAPTURE_INDEX_COMPACT_BYTES) {
+        capture_index_compact(records);
+    }
+
+    capture_index_loaded = true;
+    return ESP_OK;
+}
+
+static bool capture_index_lock(void) {
+    if (capture_index_mutex == NULL) {
+        // Captures can start from several tasks at once; only the first
+        // mutex created is kept.
+        SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+        if (mutex == NULL) {
+            return false;
+        }
+        portENTER_CRITICAL(&capture_index_mutex_init);
+        if (capture_index_mutex == NULL) {
+            capture_index_mutex = mutex;
+            mutex = NULL;
+        }
+        portEXIT_CRITICAL(&capture_index_mutex_init);
+        if (mutex != NULL) {
+            vSemaphoreDelete(mutex);
+        }
+    }
+    return xSemaphoreTake(capture_index_mutex, portMAX_DELAY) == pdTRUE;
+}
+
+static void capture_index_unlock(void) { xSemaphoreGive(capture_index_mutex); }
+
+esp_err_t capture_index_open(capture_file_type_t type, const char *base_name, int *file_index) {
+    if (base_name == NULL || file_index == NULL || type >= CAPTURE_FILE_TYPE_COUNT ||
+        strlen(base_name) >= CAPTURE_INDEX_NAME_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!capture_index_lock()) {
+        return ESP_FAIL;
+    }
+
+    esp_err_t ret = capture_index_load();
+    if (ret != ESP_OK) {
+        capture_index_unlock();
+        return ret;
+    }
+
+    uint8_t group = capture_group_of(type);
+    capture_slot_t *slot = capture_slot_find(group, base_name, true);
+    int index = slot ? slot->next_index : 0;
+
+    // Files copied onto the card by hand are not in the manifest; a single
+    // stat keeps them from being overwritten.
+    char path[128];
+    for (;;) {
+        capture_index_format_path(path, sizeof(path), type, base_name, index);
+        if (!sd_card_exists(path)) {
+            break;
+        }
+        index++;
+    }
+    if (slot) {
+        slot->next_index = index + 1;
+    }
+
+    capture_record_t record;
+    capture_record_init(&record, CAPTURE_RECORD_OPEN, type, base_name, index);
+    time_t now = time(NULL);
+    // Anything before 2020 means the clock was never set.
+    record.start_time = now > 1577836800 ? (uint32_t)now : 0;
+    if (capture_index_append(&record) != ESP_OK) {
+        ESP_LOGW(TAG, "Capture %s_%d not recorded in index", base_name, index);
+    }
+
+    capture_index_unlock();
+    *file_index = index;
+    return ESP_OK;
+}
+
+esp_err_t capture_index_close(capture_file_type_t type, const char *base_name, int file_index,
+                              uint32_t size, uint32_t packets) {
+    if (base_name == NULL || file_index < 0 || type >= CAPTURE_FILE_TYPE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!capture_index_lock()) {
+        return ESP_FAIL;
+    }
+
+    esp_err_t ret = capture_index_load();
+    if (ret == ESP_OK) {
+        capture_record_t record;
+        capture_record_init(&record, CAPTURE_RECORD_CLOSE, type, base_name, file_index);
+        record.size = size;
+        record.packets = packets;
+        ret = capture_index_append(&record);
+    }
+
+    capture_index_unlock();
+    return ret;
+}
+
+void capture_index_forget_path(const char *path) {
+    if (path == NULL) {
+        return;
+    }
+
+    const char *name = strrchr(path, '/');
+    const char *underscore = strrchr(path, '_');
+    if (name == NULL || underscore == NULL || underscore < name) {
+        return;
+    }
+    name++;
+
+    capture_file_type_t type;
+    if (strncmp(path, CAPTURE_INDEX_PCAP_DIR "/", strlen(CAPTURE_INDEX_PCAP_DIR) + 1) == 0) {
+        type = strstr(underscore, ".pcapng") ? CAPTURE_FILE_PCAPNG : CAPTURE_FILE_PCAP;
+    } else if (strncmp(path, CAPTURE_INDEX_GPS_DIR "/", strlen(CAPTURE_INDEX_GPS_DIR) + 1) == 0) {
+        type = strstr(underscore, ".gwd") ? CAPTURE_FILE_GWD : CAPTURE_FILE_CSV;
+    } else {
+        return;
+    }
+
+    int index;
+    size_t base_len = underscore - name;
+    if (base_len == 0 || base_len >= CAPTURE_INDEX_NAME_LEN ||
+        sscanf(underscore, "_%d.", &index) != 1) {
+        return;
+    }
+
+    char base_name[CAPTURE_INDEX_NAME_LEN];
+    memcpy(base_name, name, base_len);
+    base_name[base_len] = '\0';
+
+    if (!capture_index_lock()) {
+        return;
+    }
+    // Numbers are never reused, so the next-index table is left alone.
+    if (capture_index_load() == ESP_OK) {
+        capture_record_t record;
+        capture_record_init(&record, CAPTURE_RECORD_DELETE, type, base_name, index);
+        capture_index_append(&record);
+    }
+    capture_index_unlock();
+}
+
+int capture_index_peek(capture_file_type_t type, const char *base_name) {
+    if (base_name == NULL || !capture_index_lock()) {
+        return -1;
+    }
+
+    int index = -1;
+    if (capture_index_load() == ESP_OK) {
+        capture_slot_t *slot = capture_slot_find(capture_group_of(type), base_name, false);
+        index = slot ? slot->next_index : 0;
+    }
+
+    capture_index_unlock();
+    return index;
+}
+
+static bool capture_record_same_file(const capture_record_t *a, const capture_record_t *b) {
+    return capture_group_of(a->type) == capture_group_of(b->type) &&
+           a->file_index == b->file_index && strcmp(a->base_name, b->base_name) == 0;
+}
+
+size_t capture_index_list(capture_index_entry_t *entries, size_t max) {
+    if (entries == NULL || max == 0) {
+        return 0;
+    }
+    if (max > CAPTURE_INDEX_LIST_MAX) {
+        max = CAPTURE_INDEX_LIST_MAX;
+    }
+    if (!capture_index_lock()) {
+        return 0;
+    }
+    if (capture_index_load() != ESP_OK) {
+        capture_index_unlock();
+        return 0;
+    }
+
+    size_t window = CAPTURE_INDEX_LIST_WINDOW(max);
+    capture_record_t *records = malloc(window * sizeof(capture_record_t));
+    FILE *f = records ? fopen(CAPTURE_INDEX_PATH, "rb") : NULL;
+    if (f == NULL) {
+        free(records);
+        capture_index_unlock();
+        return 0;
+    }
+
+    // Only the tail of the manifest is read.
+    fseek(f, 0, SEEK_END);
+    long total = ftell(f) / (long)sizeof(capture_record_t);
+    long first = total > (long)window ? total - (long)window : 0;
+    fseek(f, first * (long)sizeof(capture_record_t), SEEK_SET);
+    size_t count = fread(records, sizeof(capture_record_t), window, f);
+    fclose(f);
+    capture_index_unlock();
+
+    // Walk backwards from the newest open, folding in any later close or
+    // delete of the same file.
+    size_t found = 0;
+    for (size_t i = count; i-- > 0 && found < max;) {
+        const capture_record_t *open = &records[i];
+        if (!capture_record_valid(open) || open->kind != CAPTURE_RECORD_OPEN) {
+            continue;
+        }
+
+        capture_index_entry_t *entry = &entries[found];
+        memset(entry, 0, sizeof(*entry));
+        entry->type = open->type;
+        strlcpy(entry->base_name, open->base_name, sizeof(entry->base_name));
+        entry->file_index = open->file_index;
+        entry->start_time = open->start_time;
+
+        bool deleted = false;
+        for (size_t j = i + 1; j < count; j++) {
+            const capture_record_t *later = &records[j];
+            if (!capture_record_valid(later) || !capture_record_same_file(open, later)) {
+                continue;
+            }
+            if (later->kind == CAPTURE_RECORD_CLOSE) {
+                entry->closed = true;
+                entry->size = later->size;
+                entry->packets = later->packets;
+            } else if (later->kind == CAPTURE_RECORD_DELETE) {
+                deleted = true;
+            }
+        }
+        if (!deleted) {
+            found++;
+        }
+    }
+    free(records);
+
+    // Oldest first reads naturally on the console.
+    for (size_t i = 0; i < found / 2; i++) {
+        capture_index_entry_t tmp = entries[i];
+        entries[i] = entries[found - 1 - i];
+        entries[found - 1 - i] = tmp;
+    }
+    return found;
+}
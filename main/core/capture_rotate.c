@@ -0,0 +1,190 @@
+// capture_rotate.c
+
+#include "core/capture_rotate.h"
+#include "esp_idf_version.h"
+#include "esp_log.h"
+#include "esp_vfs_fat.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include <string.h>
+#include <unistd.h>
+
+#define TAG "CaptureRotate"
+
+// Below the PCAP writers so preparing a file never delays a drain.
+#define CAPTURE_ROTATE_PRIORITY 2
+#define CAPTURE_ROTATE_QUEUE_LEN 4
+
+static QueueHandle_t capture_rotate_queue = NULL;
+static TaskHandle_t capture_rotate_task_handle = NULL;
+
+// Reserves the clusters for the whole file up front, contiguously where the
+// FAT driver can do it, so appends never walk or grow the cluster chain.
+static FILE *capture_file_preallocate(const char *path, uint32_t size) {
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+    if (size > 0 && esp_vfs_fat_create_contiguous_file("/mnt", path, size, true) == ESP_OK) {
+        return fopen(path, "r+b");
+    }
+#endif
+    FILE *f = fopen(path, "wb");
+    if (f != NULL && size > 0) {
+        if (fseek(f, size - 1, SEEK_SET) != 0 || fputc(0, f) == EOF || fflush(f) != 0) {
+            ESP_LOGW(TAG, "Could not pre-allocate %lu bytes for %s", (unsigned long)size, path);
+        }
+        rewind(f);
+    }
+    return f;
+}
+
+esp_err_t capture_file_create(const capture_spare_t *spare, capture_file_t *out) {
+    out->file = NULL;
+    out->index = -1;
+    out->header_bytes = 0;
+
+    esp_err_t ret = capture_index_open(spare->type, spare->base_name, &out->index);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    capture_index_format_path(out->path, sizeof(out->path), spare->type, spare->base_name,
+                              out->index);
+
+    out->file = capture_file_preallocate(out->path, spare->prealloc_bytes);
+    if (out->file == NULL) {
+        ESP_LOGE(TAG, "Failed to create %s", out->path);
+        return ESP_FAIL;
+    }
+
+    if (spare->write_header != NULL && spare->write_header(out->file, spare->ctx) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write header to %s", out->path);
+        capture_file_finalize(out, spare->type, spare->base_name, 0);
+        return ESP_FAIL;
+    }
+    fflush(out->file);
+    long pos = ftell(out->file);
+    out->header_bytes = pos > 0 ? (uint32_t)pos : 0;
+    return ESP_OK;
+}
+
+void capture_file_finalize(capture_file_t *file, capture_file_type_t type, const char *base_name,
+                           uint32_t packets) {
+    if (file->file == NULL) {
+        return;
+    }
+
+    fflush(file->file);
+    long size = ftell(file->file);
+    if (size < 0) {
+        size = 0;
+    }
+    // Drop whatever was pre-allocated past the last record.
+    if (ftruncate(fileno(file->file), size) != 0) {
+        ESP_LOGW(TAG, "Failed to trim %s", file->path);
+    }
+    fclose(file->file);
+    file->file = NULL;
+
+    if (file->index >= 0) {
+        capture_index_close(type, base_name, file->index, (uint32_t)size, packets);
+    }
+}
+
+static void capture_rotate_task(void *pvParameters) {
+    capture_spare_t *spare;
+
+    while (1) {
+        if (xQueueReceive(capture_rotate_queue, &spare, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        if (spare->retired.file != NULL) {
+            capture_file_finalize(&spare->retired, spare->type, spare->base_name,
+                                  spare->retired_packets);
+        }
+
+        if (!__atomic_load_n(&spare->ready, __ATOMIC_ACQUIRE)) {
+            if (capture_file_create(spare, &spare->next) == ESP_OK) {
+                __atomic_store_n(&spare->ready, true, __ATOMIC_RELEASE);
+            }
+        }
+
+        __atomic_store_n(&spare->busy, false, __ATOMIC_RELEASE);
+    }
+}
+
+static esp_err_t capture_rotate_start(void) {
+    if (capture_rotate_queue != NULL) {
+        return ESP_OK;
+    }
+
+    capture_rotate_queue = xQueueCreate(CAPTURE_ROTATE_QUEUE_LEN, sizeof(capture_spare_t *));
+    if (capture_rotate_queue == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(capture_rotate_task, "capture_rotate", 4096, NULL, CAPTURE_ROTATE_PRIORITY,
+                    &capture_rotate_task_handle) != pdPASS) {
+        vQueueDelete(capture_rotate_queue);
+        capture_rotate_queue = NULL;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t capture_spare_queue(capture_spare_t *spare) {
+    esp_err_t ret = capture_rotate_start();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    __atomic_store_n(&spare->busy, true, __ATOMIC_RELEASE);
+    if (xQueueSend(capture_rotate_queue, &spare, 0) != pdTRUE) {
+        __atomic_store_n(&spare->busy, false, __ATOMIC_RELEASE);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t capture_spare_prepare(capture_spare_t *spare) {
+    if (__atomic_load_n(&spare->busy, __ATOMIC_ACQUIRE) ||
+        __atomic_load_n(&spare->ready, __ATOMIC_ACQUIRE)) {
+        return ESP_OK;
+    }
+    return capture_spare_queue(spare);
+}
+
+bool capture_spare_swap(capture_spare_t *spare, capture_file_t *current, uint32_t packets) {
+    if (__atomic_load_n(&spare->busy, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    if (!__atomic_load_n(&spare->ready, __ATOMIC_ACQUIRE)) {
+        // A failed preparation is retried on the next rotation check.
+        capture_spare_prepare(spare);
+        return false;
+    }
+
+    spare->retired = *current;
+    spare->retired_packets = packets;
+    *current = spare->next;
+    spare->next.file = NULL;
+    __atomic_store_n(&spare->ready, false, __ATOMIC_RELEASE);
+
+    if (capture_spare_queue(spare) != ESP_OK) {
+        // Nothing will pick the old file up, so close it here.
+        capture_file_finalize(&spare->retired, spare->type, spare->base_name, packets);
+    }
+    return true;
+}
+
+void capture_spare_shutdown(capture_spare_t *spare) {
+    while (__atomic_load_n(&spare->busy, __ATOMIC_ACQUIRE)) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    if (__atomic_load_n(&spare->ready, __ATOMIC_ACQUIRE) && spare->next.file != NULL) {
+        fclose(spare->next.file);
+        spare->next.file = NULL;
+        unlink(spare->next.path);
+        capture_index_forget_path(spare->next.path);
+    }
+    __atomic_store_n(&spare->ready, false, __ATOMIC_RELEASE);
+}
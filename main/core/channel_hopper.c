@@ -0,0 +1,382 @@
+// channel_hopper.c
+
+#include "core/channel_hopper.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+#define TAG "ChannelHopper"
+
+// Weighted policy: activity is frames per second with a beacon counting as
+// this many frames, since a beacon means an AP lives on the channel.
+#define HOP_BEACON_WEIGHT 8
+// Added to every channel's score so quiet channels are still visited.
+#define HOP_SCORE_FLOOR 16
+// Longest weighted dwell, as a multiple of the average dwell.
+#define HOP_WEIGHTED_MAX_FACTOR 2
+// Shortest weighted dwell: one beacon interval (100 TU) and the retune, so
+// a visit to a quiet channel still hears every AP on it. Capped at the
+// configured average dwell.
+#define HOP_WEIGHTED_MIN_DWELL_MS 105
+
+typedef struct {
+  uint8_t channel;
+  uint32_t visits;
+  uint32_t dwell_ms;
+  uint32_t frames;
+  uint32_t beacons;
+  uint32_t score; // Moving average of activity, scaled by 16
+} hop_channel_t;
+
+static const uint8_t channels_2ghz[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13};
+#if CHANNEL_HOPPER_HAS_5GHZ
+static const uint8_t channels_5ghz[] = {36,  40,  44,  48,  52,  56,  60,  64,  100,
+                                        104, 108, 112, 116, 120, 124, 128, 132, 136,
+                                        140, 144, 149, 153, 157, 161, 165};
+#endif
+
+static hop_channel_t hop_channels[CHANNEL_HOPPER_MAX_CHANNELS];
+static int hop_channel_count = 0;
+static channel_hop_config_t hop_config = CHANNEL_HOP_CONFIG_DEFAULT();
+static portMUX_TYPE hop_lock = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t hop_timer = NULL;
+static int hop_holders = 0;
+static bool hop_active = false;
+
+static int hop_current = -1;  // Slot being dwelt on, -1 if not in the set
+static int hop_next = 0;      // Next slot for fixed/weighted/excursions
+static bool hop_on_lock = false;
+static int64_t dwell_started_us = 0;
+static uint32_t dwell_frames = 0;
+static uint32_t dwell_beacons = 0;
+
+bool channel_hopper_channel_valid(uint8_t channel) {
+  if (channel >= 1 && channel <= 14) {
+    return true;
+  }
+#if CHANNEL_HOPPER_HAS_5GHZ
+  if (channel >= 36 && channel <= 64) {
+    return channel % 4 == 0;
+  }
+  if (channel >= 100 && channel <= 144) {
+    return channel % 4 == 0;
+  }
+  if (channel >= 149 && channel <= 177) {
+    return channel % 4 == 1;
+  }
+#endif
+  return false;
+}
+
+static int hop_find_slot(uint8_t channel) {
+  for (int i = 0; i < hop_channel_count; i++) {
+    if (hop_channels[i].channel == channel) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Credits what was heard during the dwell that just ended. Lock held.
+static void hop_close_dwell(int64_t now) {
+  uint32_t frames = dwell_frames;
+  uint32_t beacons = dwell_beacons;
+  dwell_frames = 0;
+  dwell_beacons = 0;
+
+  if (hop_current < 0 || hop_current >= hop_channel_count) {
+    return;
+  }
+
+  hop_channel_t *ch = &hop_channels[hop_current];
+  uint32_t elapsed_ms = (uint32_t)((now - dwell_started_us) / 1000);
+  if (elapsed_ms == 0) {
+    elapsed_ms = 1;
+  }
+  ch->visits++;
+  ch->dwell_ms += elapsed_ms;
+  ch->frames += frames;
+  ch->beacons += beacons;
+
+  uint32_t activity = (frames + beacons * HOP_BEACON_WEIGHT) * 1000 / elapsed_ms;
+  ch->score = (ch->score * 3 + activity * 16) / 4;
+}
+
+static uint32_t hop_weighted_total(void) {
+  uint32_t total = 0;
+  for (int i = 0; i < hop_channel_count; i++) {
+    total += hop_channels[i].score + HOP_SCORE_FLOOR;
+  }
+  return total;
+}
+
+// Picks where to go next and for how long. Lock held.
+static uint8_t hop_choose(uint32_t *dwell_ms) {
+  if (hop_config.policy == CHANNEL_HOP_LOCK) {
+    int lock_slot = hop_find_slot(hop_config.lock_channel);
+    bool can_excurse = hop_channel_count > (lock_slot >= 0 ? 1 : 0);
+
+    if (hop_on_lock && can_excurse) {
+      if (hop_next >= hop_channel_count) {
+        hop_next = 0;
+      }
+      if (hop_next == lock_slot) {
+        hop_next = (hop_next + 1) % hop_channel_count;
+      }
+      hop_current = hop_next;
+      hop_next = (hop_next + 1) % hop_channel_count;
+      hop_on_lock = false;
+      *dwell_ms = hop_config.dwell_ms;
+      return hop_channels[hop_current].channel;
+    }
+
+    hop_current = lock_slot;
+    hop_on_lock = true;
+    *dwell_ms = hop_config.lock_ms;
+    return hop_config.lock_channel;
+  }
+
+  if (hop_next >= hop_channel_count) {
+    hop_next = 0;
+  }
+  hop_current = hop_next;
+  hop_next = (hop_next + 1) % hop_channel_count;
+  *dwell_ms = hop_config.dwell_ms;
+
+  if (hop_config.policy == CHANNEL_HOP_WEIGHTED) {
+    // Keep the cycle length of the fixed policy, shared out by activity.
+    uint32_t total = hop_weighted_total();
+    uint32_t share = hop_channels[hop_current].score + HOP_SCORE_FLOOR;
+    uint32_t dwell = (uint32_t)((uint64_t)hop_config.dwell_ms * hop_channel_count * share / total);
+    uint32_t max_dwell = hop_config.dwell_ms * HOP_WEIGHTED_MAX_FACTOR;
+    uint32_t min_dwell = hop_config.dwell_ms < HOP_WEIGHTED_MIN_DWELL_MS
+                             ? hop_config.dwell_ms
+                             : HOP_WEIGHTED_MIN_DWELL_MS;
+
+    if (dwell < min_dwell) {
+      dwell = min_dwell;
+    } else if (dwell > max_dwell) {
+      dwell = max_dwell;
+    }
+    *dwell_ms = dwell;
+  }
+  return hop_channels[hop_current].channel;
+}
+
+static void channel_hopper_tick(void *arg) {
+  uint32_t dwell_ms;
+  uint8_t channel;
+
+  taskENTER_CRITICAL(&hop_lock);
+  if (!hop_active || hop_channel_count == 0) {
+    taskEXIT_CRITICAL(&hop_lock);
+    return;
+  }
+  int64_t now = esp_timer_get_time();
+  hop_close_dwell(now);
+  channel = hop_choose(&dwell_ms);
+  dwell_started_us = now;
+  taskEXIT_CRITICAL(&hop_lock);
+
+  esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+
+  // Re-checked so a reset that raced this tick is not undone.
+  if (hop_active) {
+    esp_timer_start_once(hop_timer, (uint64_t)dwell_ms * 1000);
+  }
+}
+
+void channel_hopper_default_channels(void) {
+  taskENTER_CRITICAL(&hop_lock);
+  memset(hop_channels, 0, sizeof(hop_channels));
+  hop_channel_count = 0;
+  for (size_t i = 0; i < sizeof(channels_2ghz); i++) {
+    hop_channels[hop_channel_count++].channel = channels_2ghz[i];
+  }
+#if CHANNEL_HOPPER_HAS_5GHZ
+  for (size_t i = 0; i < sizeof(channels_5ghz); i++) {
+    hop_channels[hop_channel_count++].channel = channels_5ghz[i];
+  }
+#endif
+  hop_current = -1;
+  hop_next = 0;
+  taskEXIT_CRITICAL(&hop_lock);
+}
+
+esp_err_t channel_hopper_set_channels(const uint8_t *channels, int count) {
+  if (count <= 0 || count > CHANNEL_HOPPER_MAX_CHANNELS) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  for (int i = 0; i < count; i++) {
+    if (!channel_hopper_channel_valid(channels[i])) {
+      return ESP_ERR_INVALID_ARG;
+    }
+  }
+
+  taskENTER_CRITICAL(&hop_lock);
+  memset(hop_channels, 0, sizeof(hop_channels));
+  hop_channel_count = 0;
+  for (int i = 0; i < count; i++) {
+    if (hop_find_slot(channels[i]) < 0) {
+      hop_channels[hop_channel_count++].channel = channels[i];
+    }
+  }
+  hop_current = -1;
+  hop_next = 0;
+  taskEXIT_CRITICAL(&hop_lock);
+  return ESP_OK;
+}
+
+int channel_hopper_get_channels(uint8_t *channels, int max) {
+  int count = 0;
+  taskENTER_CRITICAL(&hop_lock);
+  for (int i = 0; i < hop_channel_count && count < max; i++) {
+    channels[count++] = hop_channels[i].channel;
+  }
+  taskEXIT_CRITICAL(&hop_lock);
+  return count;
+}
+
+void channel_hopper_get_config(channel_hop_config_t *config) {
+  taskENTER_CRITICAL(&hop_lock);
+  *config = hop_config;
+  taskEXIT_CRITICAL(&hop_lock);
+}
+
+esp_err_t channel_hopper_set_config(const channel_hop_config_t *config) {
+  if (config->dwell_ms < CHANNEL_HOPPER_MIN_DWELL_MS ||
+      config->dwell_ms > CHANNEL_HOPPER_MAX_DWELL_MS) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (config->policy == CHANNEL_HOP_LOCK &&
+      (!channel_hopper_channel_valid(config->lock_channel) ||
+       config->lock_ms < CHANNEL_HOPPER_MIN_DWELL_MS)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  taskENTER_CRITICAL(&hop_lock);
+  hop_config = *config;
+  hop_on_lock = false;
+  taskEXIT_CRITICAL(&hop_lock);
+  return ESP_OK;
+}
+
+static esp_err_t channel_hopper_start(void) {
+  if (hop_timer == NULL) {
+    esp_timer_create_args_t timer_args = {.callback = channel_hopper_tick,
+                                          .name = "channel_hop"};
+    esp_err_t ret = esp_timer_create(&timer_args, &hop_timer);
+    if (ret != ESP_OK) {
+      return ret;
+    }
+  }
+  if (hop_channel_count == 0) {
+    channel_hopper_default_channels();
+  }
+
+#if CHANNEL_HOPPER_HAS_5GHZ
+  esp_wifi_set_band_mode(WIFI_BAND_MODE_AUTO);
+#endif
+
+  taskENTER_CRITICAL(&hop_lock);
+  hop_active = true;
+  hop_current = -1;
+  hop_on_lock = false;
+  taskEXIT_CRITICAL(&hop_lock);
+
+  channel_hopper_tick(NULL);
+  ESP_LOGI(TAG, "Hopping %d channels, %s policy", hop_channel_count,
+           channel_hopper_policy_name(hop_config.policy));
+  return ESP_OK;
+}
+
+static void channel_hopper_stop(void) {
+  taskENTER_CRITICAL(&hop_lock);
+  hop_active = false;
+  hop_close_dwell(esp_timer_get_time());
+  hop_current = -1;
+  taskEXIT_CRITICAL(&hop_lock);
+
+  if (hop_timer != NULL) {
+    esp_timer_stop(hop_timer);
+  }
+}
+
+esp_err_t channel_hopper_acquire(void) {
+  if (hop_holders++ > 0) {
+    return ESP_OK;
+  }
+  esp_err_t ret = channel_hopper_start();
+  if (ret != ESP_OK) {
+    hop_holders = 0;
+  }
+  return ret;
+}
+
+void channel_hopper_release(void) {
+  if (hop_holders == 0) {
+    return; // Already stopped by a reset
+  }
+  if (--hop_holders == 0) {
+    channel_hopper_stop();
+  }
+}
+
+void channel_hopper_reset(void) {
+  if (hop_holders > 0) {
+    hop_holders = 0;
+    channel_hopper_stop();
+  }
+}
+
+bool channel_hopper_running(void) { return hop_active; }
+
+void channel_hopper_note_frame(bool beacon) {
+  dwell_frames++;
+  if (beacon) {
+    dwell_beacons++;
+  }
+}
+
+int channel_hopper_get_stats(channel_hop_stats_t *stats, int max) {
+  int count = 0;
+
+  taskENTER_CRITICAL(&hop_lock);
+  uint32_t total = hop_weighted_total();
+  for (int i = 0; i < hop_channel_count && count < max; i++) {
+    const hop_channel_t *ch = &hop_channels[i];
+    channel_hop_stats_t *out = &stats[count++];
+    out->channel = ch->channel;
+    out->visits = ch->visits;
+    out->dwell_ms = ch->dwell_ms;
+    out->frames = ch->frames;
+    out->beacons = ch->beacons;
+    out->weight = total ? (uint16_t)((ch->score + HOP_SCORE_FLOOR) * 1000 / total) : 0;
+  }
+  taskEXIT_CRITICAL(&hop_lock);
+  return count;
+}
+
+void channel_hopper_reset_stats(void) {
+  taskENTER_CRITICAL(&hop_lock);
+  for (int i = 0; i < hop_channel_count; i++) {
+    uint8_t channel = hop_channels[i].channel;
+    memset(&hop_channels[i], 0, sizeof(hop_channels[i]));
+    hop_channels[i].channel = channel;
+  }
+  taskEXIT_CRITICAL(&hop_lock);
+}
+
+const char *channel_hopper_policy_name(channel_hop_policy_t policy) {
+  switch (policy) {
+  case CHANNEL_HOP_WEIGHTED:
+    return "weighted";
+  case CHANNEL_HOP_LOCK:
+    return "lock";
+  default:
+    return "fixed";
+  }
+}
@@ -0,0 +1,289 @@
+// channel_survey.c
+
+#include "core/channel_survey.h"
+#include "core/frame_dispatch.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "managers/wifi_manager.h"
+#include <cJSON.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SURVEY_CONSUMER "survey"
+#define SURVEY_TX_WORDS (SURVEY_TX_BITMAP_BITS / 32)
+
+// Microseconds of preamble and PLCP header ahead of the payload.
+#define PREAMBLE_DSSS_LONG_US 192
+#define PREAMBLE_DSSS_SHORT_US 96
+#define PREAMBLE_OFDM_US 20
+#define PREAMBLE_HT_US 36
+
+typedef struct {
+  uint8_t channel;
+  uint32_t frames[3]; // Indexed by frame type: management, control, data
+  uint64_t bytes;
+  uint64_t airtime_us;
+  int8_t rssi_max;
+  uint32_t rssi_hist[SURVEY_RSSI_BUCKETS];
+  uint32_t tx_bitmap[SURVEY_TX_WORDS];
+} survey_slot_t;
+
+static survey_slot_t survey_slots[SURVEY_MAX_CHANNELS];
+static int survey_slot_count = 0;
+// Channel number to slot index + 1; 0 until the channel is first heard.
+static uint8_t survey_slot_of[256];
+static uint32_t survey_dropped = 0;
+static bool survey_active = false;
+static portMUX_TYPE survey_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Legacy PHY rate codes (wifi_phy_rate_t) in units of 100 kbps. Codes 0-3 are
+// DSSS with a long preamble, 5-7 with a short one and 8-15 are OFDM.
+static const uint16_t legacy_rate_x10[16] = {10,  20,  55,  110, 10,  20,  55,  110,
+                                             480, 240, 120, 60,  540, 360, 180, 90};
+// Single stream HT rates for MCS 0-7 with the long guard interval.
+static const uint16_t ht20_rate_x10[8] = {65, 130, 195, 260, 390, 520, 585, 650};
+static const uint16_t ht40_rate_x10[8] = {135, 270, 405, 540, 810, 1080, 1215, 1350};
+
+static uint32_t survey_frame_us(uint32_t bytes, uint32_t rate_x10, uint32_t preamble_us) {
+  return preamble_us + (bytes * 8 * 10 + rate_x10 - 1) / rate_x10;
+}
+
+static uint32_t survey_legacy_airtime_us(uint32_t code, uint32_t bytes) {
+  code &= 0xf;
+  uint32_t preamble = code < 4    ? PREAMBLE_DSSS_LONG_US
+                      : code < 8  ? PREAMBLE_DSSS_SHORT_US
+                                  : PREAMBLE_OFDM_US;
+  return survey_frame_us(bytes, legacy_rate_x10[code], preamble);
+}
+
+static uint32_t survey_ht_airtime_us(uint32_t mcs, bool wide, bool short_gi,
+                                     uint32_t bytes) {
+  uint32_t streams = (mcs >> 3) + 1;
+  uint32_t rate = (wide ? ht40_rate_x10 : ht20_rate_x10)[mcs & 7] * streams;
+  if (short_gi) {
+    rate = rate * 10 / 9;
+  }
+  return survey_frame_us(bytes, rate, PREAMBLE_HT_US);
+}
+
+uint32_t channel_survey_airtime_us(const wifi_pkt_rx_ctrl_t *rx_ctrl) {
+  uint32_t bytes = rx_ctrl->sig_len;
+#if defined(CONFIG_IDF_TARGET_ESP32C5) || defined(CONFIG_IDF_TARGET_ESP32C6)
+  // These targets report HT frames through the rate code itself:
+  // 0x10-0x17 are MCS 0-7 with the long guard interval, 0x18-0x1f short.
+  if (rx_ctrl->rate >= 0x10) {
+    return survey_ht_airtime_us(rx_ctrl->rate & 7, false, rx_ctrl->rate >= 0x18, bytes);
+  }
+  return survey_legacy_airtime_us(rx_ctrl->rate, bytes);
+#else
+  // rate is only meaningful for 11b/g frames; HT frames carry an MCS instead.
+  if (rx_ctrl->sig_mode != 0) {
+    return survey_ht_airtime_us(rx_ctrl->mcs, rx_ctrl->cwb, rx_ctrl->sgi, bytes);
+  }
+  return survey_legacy_airtime_us(rx_ctrl->rate, bytes);
+#endif
+}
+
+static survey_slot_t *survey_slot(uint8_t channel) {
+  uint8_t index = survey_slot_of[channel];
+  if (index != 0) {
+    return &survey_slots[index - 1];
+  }
+
+  survey_slot_t *slot = NULL;
+  taskENTER_CRITICAL(&survey_lock);
+  index = survey_slot_of[channel];
+  if (index != 0) {
+    slot = &survey_slots[index - 1];
+  } else if (survey_slot_count < SURVEY_MAX_CHANNELS) {
+    slot = &survey_slots[survey_slot_count++];
+    memset(slot, 0, sizeof(*slot));
+    slot->channel = channel;
+    slot->rssi_max = INT8_MIN;
+    survey_slot_of[channel] = survey_slot_count;
+  }
+  taskEXIT_CRITICAL(&survey_lock);
+  return slot;
+}
+
+// Control frames other than CTS and ACK carry a transmitter address.
+static bool survey_has_transmitter(uint8_t type, uint8_t subtype) {
+  if (type != FRAME_TYPE_CTRL) {
+    return true;
+  }
+  return subtype != 0xc && subtype != 0xd;
+}
+
+static uint32_t survey_addr_hash(const uint8_t *addr) {
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < 6; i++) {
+    hash = (hash ^ addr[i]) * 16777619u;
+  }
+  return (hash ^ (hash >> 16)) % SURVEY_TX_BITMAP_BITS;
+}
+
+void channel_survey_record(const wifi_promiscuous_pkt_t *pkt) {
+  const wifi_pkt_rx_ctrl_t *rx = &pkt->rx_ctrl;
+  if (rx->sig_len < 2) {
+    return;
+  }
+
+  survey_slot_t *slot = survey_slot(rx->channel);
+  if (slot == NULL) {
+    survey_dropped++;
+    return;
+  }
+
+  uint8_t fc = pkt->payload[0];
+  uint8_t type = (fc >> 2) & 0x3;
+  if (type < 3) {
+    slot->frames[type]++;
+  }
+  slot->bytes += rx->sig_len;
+  slot->airtime_us += channel_survey_airtime_us(rx);
+
+  int rssi = rx->rssi;
+  int bucket = rssi < SURVEY_RSSI_FLOOR
+                   ? 0
+                   : 1 + (rssi - SURVEY_RSSI_FLOOR) / SURVEY_RSSI_STEP;
+  if (bucket >= SURVEY_RSSI_BUCKETS) {
+    bucket = SURVEY_RSSI_BUCKETS - 1;
+  }
+  slot->rssi_hist[bucket]++;
+  if (rssi > slot->rssi_max) {
+    slot->rssi_max = rssi;
+  }
+
+  if (rx->sig_len >= 16 && survey_has_transmitter(type, fc >> 4)) {
+    uint32_t bit = survey_addr_hash(pkt->payload + 10);
+    slot->tx_bitmap[bit / 32] |= 1u << (bit % 32);
+  }
+}
+
+static uint16_t survey_estimate_transmitters(const uint32_t *bitmap) {
+  int set = 0;
+  for (int i = 0; i < SURVEY_TX_WORDS; i++) {
+    set += __builtin_popcount(bitmap[i]);
+  }
+  int empty = SURVEY_TX_BITMAP_BITS - set;
+  if (empty == 0) {
+    empty = 1; // Saturated; report the largest estimate the bitmap allows
+  }
+  float m = SURVEY_TX_BITMAP_BITS;
+  return (uint16_t)lroundf(m * logf(m / empty));
+}
+
+int channel_survey_get(channel_survey_t *out, int max) {
+  channel_hop_stats_t hops[CHANNEL_HOPPER_MAX_CHANNELS];
+  int hop_count = channel_hopper_get_stats(hops, CHANNEL_HOPPER_MAX_CHANNELS);
+  int count = survey_slot_count < max ? survey_slot_count : max;
+
+  for (int i = 0; i < count; i++) {
+    const survey_slot_t *slot = &survey_slots[i];
+    channel_survey_t *s = &out[i];
+
+    memset(s, 0, sizeof(*s));
+    s->channel = slot->channel;
+    s->mgmt_frames = slot->frames[FRAME_TYPE_MGMT];
+    s->ctrl_frames = slot->frames[FRAME_TYPE_CTRL];
+    s->data_frames = slot->frames[FRAME_TYPE_DATA];
+    s->bytes = slot->bytes;
+    s->airtime_us = slot->airtime_us;
+    s->rssi_max = slot->rssi_max;
+    memcpy(s->rssi_hist, slot->rssi_hist, sizeof(s->rssi_hist));
+    s->transmitters = survey_estimate_transmitters(slot->tx_bitmap);
+
+    for (int h = 0; h < hop_count; h++) {
+      if (hops[h].channel == slot->channel) {
+        s->dwell_ms = hops[h].dwell_ms;
+        break;
+      }
+    }
+    if (s->dwell_ms > 0) {
+      uint64_t busy = s->airtime_us / s->dwell_ms; // per mille
+      s->busy_x10 = busy > 1000 ? 1000 : (uint16_t)busy;
+    }
+  }
+  return count;
+}
+
+char *channel_survey_to_json(void) {
+  channel_survey_t *survey = malloc(SURVEY_MAX_CHANNELS * sizeof(channel_survey_t));
+  if (survey == NULL) {
+    return NULL;
+  }
+  int count = channel_survey_get(survey, SURVEY_MAX_CHANNELS);
+
+  cJSON *root = cJSON_CreateObject();
+  cJSON_AddBoolToObject(root, "running", survey_active);
+  cJSON_AddNumberToObject(root, "rssi_floor", SURVEY_RSSI_FLOOR);
+  cJSON_AddNumberToObject(root, "rssi_step", SURVEY_RSSI_STEP);
+  cJSON_AddNumberToObject(root, "dropped", survey_dropped);
+  cJSON *channels = cJSON_AddArrayToObject(root, "channels");
+
+  for (int i = 0; i < count; i++) {
+    const channel_survey_t *s = &survey[i];
+    cJSON *item = cJSON_CreateObject();
+    cJSON_AddNumberToObject(item, "channel", s->channel);
+    cJSON_AddNumberToObject(item, "mgmt", s->mgmt_frames);
+    cJSON_AddNumberToObject(item, "ctrl", s->ctrl_frames);
+    cJSON_AddNumberToObject(item, "data", s->data_frames);
+    cJSON_AddNumberToObject(item, "bytes", (double)s->bytes);
+    cJSON_AddNumberToObject(item, "airtime_us", (double)s->airtime_us);
+    cJSON_AddNumberToObject(item, "dwell_ms", s->dwell_ms);
+    cJSON_AddNumberToObject(item, "busy_pct", s->busy_x10 / 10.0);
+    cJSON_AddNumberToObject(item, "rssi_max", s->rssi_max);
+    cJSON *hist = cJSON_AddArrayToObject(item, "rssi_hist");
+    for (int b = 0; b < SURVEY_RSSI_BUCKETS; b++) {
+      cJSON_AddItemToArray(hist, cJSON_CreateNumber(s->rssi_hist[b]));
+    }
+    cJSON_AddNumberToObject(item, "transmitters", s->transmitters);
+    cJSON_AddItemToArray(channels, item);
+  }
+  free(survey);
+
+  char *json = cJSON_PrintUnformatted(root);
+  cJSON_Delete(root);
+  return json;
+}
+
+static void survey_rx(void *buf, wifi_promiscuous_pkt_type_t type) {
+  channel_survey_record((const wifi_promiscuous_pkt_t *)buf);
+}
+
+void channel_survey_reset(void) {
+  taskENTER_CRITICAL(&survey_lock);
+  memset(survey_slot_of, 0, sizeof(survey_slot_of));
+  survey_slot_count = 0;
+  survey_dropped = 0;
+  taskEXIT_CRITICAL(&survey_lock);
+  // Dwell comes from the hopper, so its counters restart with ours.
+  channel_hopper_reset_stats();
+}
+
+esp_err_t channel_survey_start(void) {
+  if (survey_active) {
+    return ESP_OK;
+  }
+  channel_survey_reset();
+  wifi_manager_start_monitor_mode(SURVEY_CONSUMER, FRAME_MASK_ALL, survey_rx);
+  esp_err_t ret = channel_hopper_acquire();
+  if (ret != ESP_OK) {
+    wifi_manager_stop_monitor_consumer(SURVEY_CONSUMER);
+    return ret;
+  }
+  survey_active = true;
+  return ESP_OK;
+}
+
+void channel_survey_stop(void) {
+  if (!survey_active) {
+    return;
+  }
+  wifi_manager_stop_monitor_consumer(SURVEY_CONSUMER);
+  channel_hopper_release();
+  survey_active = false;
+}
+
+bool channel_survey_running(void) { return survey_active; }
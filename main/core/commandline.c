@@ -2,6 +2,16 @@
 
 #include "core/commandline.h"
 #include "core/callbacks.h"
+#include "core/capture_index.h"
+#include "core/channel_hopper.h"
+#include "core/channel_survey.h"
+#include "core/deauth_watch.h"
+#include "core/evil_twin.h"
+#include "core/station_tracker.h"
+#include "core/frame_dispatch.h"
+#include "core/serial_manager.h"
+#include "core/serial_stream.h"
+#include "core/timebase.h"
 #include "esp_sntp.h"
 #include "managers/ap_manager.h"
 #include "managers/ble_manager.h"
@@ -21,6 +31,14 @@
 #include <vendor/dial_client.h>
 #include "esp_wifi.h"
 
+// Frames that announce an AP and its SSID
+#define AP_ANNOUNCE_FRAMES                                                                         \
+    (FRAME_MGMT_BIT(FRAME_SUBTYPE_BEACON) | FRAME_MGMT_BIT(FRAME_SUBTYPE_PROBE_RESP))
+// A crackable handshake needs the EAPOL frames plus one that names the network
+#define CAPTURE_EAPOL_FRAMES                                                                       \
+    (FRAME_MASK_DATA | AP_ANNOUNCE_FRAMES | FRAME_MGMT_BIT(FRAME_SUBTYPE_ASSOC_REQ) |              \
+     FRAME_MGMT_BIT(FRAME_SUBTYPE_REASSOC_REQ))
+
 static Command *command_list_head = NULL;
 TaskHandle_t VisualizerHandle = NULL;
 
@@ -87,8 +105,9 @@ void cmd_wifi_scan_start(int argc, char **argv) {
 }
 
 void cmd_wifi_scan_stop(int argc, char **argv) {
-    wifi_manager_stop_monitor_mode();
-    pcap_file_close();
+    wifi_manager_stop_monitor_consumer("capture");
+    station_tracker_stop();
+    pcap_file_close_type(PCAP_CAPTURE_WIFI);
     printf("WiFi scan stopped.\n");
     TERMINAL_VIEW_ADD_TEXT("WiFi scan stopped.\n");
 }
@@ -99,12 +118,85 @@ void cmd_wifi_scan_results(int argc, char **argv) {
     wifi_manager_print_scan_results_with_oui();
 }
 
+#define STATIONS_DEFAULT_ROWS 50
+
+static void print_stations_report(station_sort_t sort, int rows) {
+    mac_table_stats_t stats;
+    station_tracker_get_stats(&stats);
+    if (stats.count == 0) {
+        printf("No stations found.\n");
+        TERMINAL_VIEW_ADD_TEXT("No stations found.\n");
+        return;
+    }
+
+    station_info_t *list = malloc(stats.count * sizeof(station_info_t));
+    if (list == NULL) {
+        printf("Out of memory\n");
+        return;
+    }
+    // The table may have grown since the stats were read; the newest
+    // stations then miss this snapshot.
+    int count = station_tracker_snapshot(list, stats.count, sort);
+    uint32_t now_ms = esp_timer_get_time() / 1000;
+
+    printf("%d stations (%lu evicted), showing %d:\n", count, (unsigned long)stats.evictions,
+           count < rows ? count : rows);
+    printf("Station            AP                 Ch  RSSI  Frames     Bytes  Seen   Age\n");
+    TERMINAL_VIEW_ADD_TEXT("%d stations:\n", count);
+    for (int i = 0; i < count && i < rows; i++) {
+        const station_info_t *st = &list[i];
+        char rssi[8] = "   -";
+        if (st->rssi_x16 != 0) {
+            snprintf(rssi, sizeof(rssi), "%4d", st->rssi_x16 / 16);
+        }
+        printf("%02X:%02X:%02X:%02X:%02X:%02X  %02X:%02X:%02X:%02X:%02X:%02X  %2u  %s  %6lu  %8lu  %4lus  %4lus\n",
+               st->mac[0], st->mac[1], st->mac[2], st->mac[3], st->mac[4], st->mac[5],
+               st->bssid[0], st->bssid[1], st->bssid[2], st->bssid[3], st->bssid[4],
+               st->bssid[5], st->channel, rssi, (unsigned long)st->frames,
+               (unsigned long)st->bytes,
+               (unsigned long)((st->last_seen_ms - st->first_seen_ms) / 1000),
+               (unsigned long)((now_ms - st->last_seen_ms) / 1000));
+        TERMINAL_VIEW_ADD_TEXT("%02X:%02X:%02X:%02X:%02X:%02X\n -> %02X:%02X:%02X:%02X:%02X:%02X\n",
+                               st->mac[0], st->mac[1], st->mac[2], st->mac[3], st->mac[4],
+                               st->mac[5], st->bssid[0], st->bssid[1], st->bssid[2],
+                               st->bssid[3], st->bssid[4], st->bssid[5]);
+    }
+    free(list);
+}
+
+void handle_stations_cmd(int argc, char **argv) {
+    station_sort_t sort = STATION_SORT_RECENT;
+    int rows = STATIONS_DEFAULT_ROWS;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "reset") == 0) {
+            station_tracker_reset();
+            printf("Station table cleared\n");
+            TERMINAL_VIEW_ADD_TEXT("Station table cleared\n");
+            return;
+        } else if (strcmp(argv[i], "recent") == 0) {
+            sort = STATION_SORT_RECENT;
+        } else if (strcmp(argv[i], "frames") == 0) {
+            sort = STATION_SORT_FRAMES;
+        } else if (strcmp(argv[i], "rssi") == 0) {
+            sort = STATION_SORT_RSSI;
+        } else if (atoi(argv[i]) > 0) {
+            rows = atoi(argv[i]);
+        } else {
+            printf("Usage: stations [recent|frames|rssi] [rows] | stations reset\n");
+            TERMINAL_VIEW_ADD_TEXT("Usage: stations [recent|frames|rssi] [rows]\n");
+            return;
+        }
+    }
+    print_stations_report(sort, rows);
+}
+
 void handle_list(int argc, char **argv) {
     if (argc > 1 && strcmp(argv[1], "-a") == 0) {
         cmd_wifi_scan_results(argc, argv);
         return;
     } else if (argc > 1 && strcmp(argv[1], "-s") == 0) {
-        wifi_manager_list_stations();
+        print_stations_report(STATION_SORT_RECENT, STATIONS_DEFAULT_ROWS);
         printf("Listed Stations...\n");
         TERMINAL_VIEW_ADD_TEXT("Listed Stations...\n");
         return;
@@ -152,7 +244,11 @@ void handle_stop_spam(int argc, char **argv) {
 }
 
 void handle_sta_scan(int argc, char **argv) {
-    wifi_manager_start_monitor_mode(wifi_stations_sniffer_callback);
+    if (station_tracker_start() != ESP_OK) {
+        printf("Failed to start station scan\n");
+        TERMINAL_VIEW_ADD_TEXT("Failed to start station scan\n");
+        return;
+    }
     printf("Started Station Scan...\n");
     TERMINAL_VIEW_ADD_TEXT("Started Station Scan...\n");
 }
@@ -218,17 +314,35 @@ void discover_task(void *pvParameter) {
     vTaskDelete(NULL);
 }
 
+static bool wardriving_active = false;
+static bool wardriving_ble = false; // startwd -ble is scanning BLE alongside Wi-Fi
+
+// Stops every monitor mode through its own stop path, so none is left
+// believing it still runs; promiscuous mode ends with the last consumer.
+static void stop_monitor_modes(void) {
+    wifi_manager_stop_monitor_consumer("capture");
+    station_tracker_stop();
+    stop_pineap_detection();
+    wifi_manager_stop_monitor_consumer("pineap");
+    if (wardriving_active) {
+        wifi_manager_stop_monitor_consumer("wardrive");
+        channel_hopper_release();
+        wardriving_active = false;
+    }
+    channel_survey_stop();
+    evil_twin_stop();
+    deauth_watch_stop();
+}
+
 void handle_stop_flipper(int argc, char **argv) {
     wifi_manager_stop_deauth();
 #ifndef CONFIG_IDF_TARGET_ESP32S2
     ble_stop();
 #endif
-    if (buffer_offset > 0) { // Only flush if there's data in buffer
-        csv_flush_buffer_to_file();
-    }
-    csv_file_close();                  // Close any open CSV files
+    stop_monitor_modes();
+    csv_file_close(); // Flush and close any open CSV files
+    wardriving_ble = false;
     gps_manager_deinit(&g_gpsManager); // Clean up GPS if active
-    wifi_manager_stop_monitor_mode();  // Stop any active monitoring
     printf("Stopped activities.\nClosed files.\n");
     TERMINAL_VIEW_ADD_TEXT("Stopped activities.\nClosed files.\n");
 }
@@ -237,6 +351,14 @@ void handle_dial_command(int argc, char **argv) {
     xTaskCreate(&discover_task, "discover_task", 10240, NULL, 5, NULL);
 }
 
+#ifdef CONFIG_HAS_RTC_CLOCK
+// SNTP has just set the system clock; pass the same time to the timebase.
+static void sntp_time_synced(struct timeval *tv) {
+    timebase_discipline(TIMEBASE_SOURCE_NTP, (int64_t)tv->tv_sec * 1000000 + tv->tv_usec,
+                        esp_timer_get_time());
+}
+#endif
+
 void handle_wifi_connection(int argc, char **argv) {
     if (argc < 2) {
         printf("Usage: %s \"<SSID>\" \"<PASSWORD>\"\n", argv[0]);
@@ -369,6 +491,7 @@ void handle_wifi_connection(int argc, char **argv) {
 #ifdef CONFIG_HAS_RTC_CLOCK
     sntp_setoperatingmode(SNTP_OPMODE_POLL);
     sntp_setservername(0, "pool.ntp.org");
+    sntp_set_time_sync_notification_cb(sntp_time_synced);
     sntp_init();
 #endif
 }
@@ -636,14 +759,74 @@ void handle_ip_lookup(int argc, char **argv) {
     wifi_manager_start_ip_lookup();
 }
 
+// Handles -rotate-mb/-rotate-min at argv[*i]. Returns 1 when consumed, 0 when
+// argv[*i] is not a rotation option and -1 on a bad value.
+static int parse_rotation_option(int argc, char **argv, int *i, capture_rotation_t *rotation) {
+    bool megabytes = strcmp(argv[*i], "-rotate-mb") == 0;
+    if (!megabytes && strcmp(argv[*i], "-rotate-min") != 0) {
+        return 0;
+    }
+
+    int value = *i + 1 < argc ? atoi(argv[++*i]) : 0;
+    if (value <= 0 || (megabytes && value > 2048) || (!megabytes && value > 24 * 60)) {
+        printf("Error: Invalid value for %s\n", megabytes ? "-rotate-mb" : "-rotate-min");
+        TERMINAL_VIEW_ADD_TEXT("Error: Invalid rotation value\n");
+        return -1;
+    }
+
+    if (megabytes) {
+        rotation->max_bytes = (uint32_t)value * 1024 * 1024;
+    } else {
+        rotation->max_seconds = (uint32_t)value * 60;
+    }
+    return 1;
+}
+
+static bool parse_capture_options(int argc, char **argv, pcap_session_config_t *config) {
+    for (int i = 2; i < argc; i++) {
+        int rotation = parse_rotation_option(argc, argv, &i, &config->rotation);
+        if (rotation < 0) {
+            return false;
+        } else if (rotation > 0) {
+            continue;
+        }
+
+        if (strcmp(argv[i], "-pcapng") == 0) {
+            config->format = PCAP_FORMAT_PCAPNG;
+        } else if (strcmp(argv[i], "-snap") == 0 && i + 1 < argc) {
+            int snaplen = atoi(argv[++i]);
+            if (snaplen < 32) {
+                printf("Error: Snap length must be at least 32 bytes\n");
+                TERMINAL_VIEW_ADD_TEXT("Error: Snap length must be at least 32 bytes\n");
+                return false;
+            }
+            config->snaplen = snaplen;
+        } else if (strcmp(argv[i], "-mgmt-full") == 0) {
+            config->mgmt_full = true;
+        } else if (strcmp(argv[i], "-data-hdr") == 0) {
+            config->data_headers_only = true;
+        } else {
+            printf("Error: Unknown capture option %s\n", argv[i]);
+            TERMINAL_VIEW_ADD_TEXT("Error: Unknown capture option %s\n", argv[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
 void handle_capture_scan(int argc, char **argv) {
-    if (argc != 2) {
+    if (argc < 2) {
         printf("Error: Incorrect number of arguments.\n");
         TERMINAL_VIEW_ADD_TEXT("Error: Incorrect number of arguments.\n");
         return;
     }
 
     char *capturetype = argv[1];
+    pcap_session_config_t capture_config = PCAP_SESSION_CONFIG_DEFAULT();
+
+    if (!parse_capture_options(argc, argv, &capture_config)) {
+        return;
+    }
 
     if (capturetype == NULL || capturetype[0] == '\0') {
         printf("Error: Capture Type cannot be empty.\n");
@@ -654,83 +837,92 @@ void handle_capture_scan(int argc, char **argv) {
     if (strcmp(capturetype, "-probe") == 0) {
         printf("Starting probe request\npacket capture...\n");
         TERMINAL_VIEW_ADD_TEXT("Starting probe request\npacket capture...\n");
-        int err = pcap_file_open("probescan", PCAP_CAPTURE_WIFI);
+        int err = pcap_file_open_ex("probescan", PCAP_CAPTURE_WIFI, &capture_config);
 
         if (err != ESP_OK) {
             printf("Error: pcap failed to open\n");
             TERMINAL_VIEW_ADD_TEXT("Error: pcap failed to open\n");
             return;
         }
-        wifi_manager_start_monitor_mode(wifi_probe_scan_callback);
+        wifi_manager_start_monitor_mode("capture",
+                                        FRAME_MGMT_BIT(FRAME_SUBTYPE_PROBE_REQ) |
+                                            FRAME_MGMT_BIT(FRAME_SUBTYPE_PROBE_RESP),
+                                        wifi_probe_scan_callback);
     }
 
     if (strcmp(capturetype, "-deauth") == 0) {
-        int err = pcap_file_open("deauthscan", PCAP_CAPTURE_WIFI);
+        int err = pcap_file_open_ex("deauthscan", PCAP_CAPTURE_WIFI, &capture_config);
 
         if (err != ESP_OK) {
             printf("Error: pcap failed to open\n");
             TERMINAL_VIEW_ADD_TEXT("Error: pcap failed to open\n");
             return;
         }
-        wifi_manager_start_monitor_mode(wifi_deauth_scan_callback);
+        wifi_manager_start_monitor_mode("capture",
+                                        FRAME_MGMT_BIT(FRAME_SUBTYPE_DEAUTH) |
+                                            FRAME_MGMT_BIT(FRAME_SUBTYPE_DISASSOC),
+                                        wifi_deauth_scan_callback);
     }
 
     if (strcmp(capturetype, "-beacon") == 0) {
         printf("Starting beacon\npacket capture...\n");
         TERMINAL_VIEW_ADD_TEXT("Starting beacon\npacket capture...\n");
-        int err = pcap_file_open("beaconscan", PCAP_CAPTURE_WIFI);
+        int err = pcap_file_open_ex("beaconscan", PCAP_CAPTURE_WIFI, &capture_config);
 
         if (err != ESP_OK) {
             printf("Error: pcap failed to open\n");
             TERMINAL_VIEW_ADD_TEXT("Error: pcap failed to open\n");
             return;
         }
-        wifi_manager_start_monitor_mode(wifi_beacon_scan_callback);
+        wifi_manager_start_monitor_mode("capture", FRAME_MGMT_BIT(FRAME_SUBTYPE_BEACON),
+                                        wifi_beacon_scan_callback);
     }
 
     if (strcmp(capturetype, "-raw") == 0) {
         printf("Starting raw\npacket capture...\n");
         TERMINAL_VIEW_ADD_TEXT("Starting raw\npacket capture...\n");
-        int err = pcap_file_open("rawscan", PCAP_CAPTURE_WIFI);
+        int err = pcap_file_open_ex("rawscan", PCAP_CAPTURE_WIFI, &capture_config);
 
         if (err != ESP_OK) {
             printf("Error: pcap failed to open\n");
             TERMINAL_VIEW_ADD_TEXT("Error: pcap failed to open\n");
             return;
         }
-        wifi_manager_start_monitor_mode(wifi_raw_scan_callback);
+        wifi_manager_start_monitor_mode("capture", FRAME_MASK_MGMT | FRAME_MASK_DATA,
+                                        wifi_raw_scan_callback);
     }
 
     if (strcmp(capturetype, "-eapol") == 0) {
         printf("Starting EAPOL\npacket capture...\n");
         TERMINAL_VIEW_ADD_TEXT("Starting EAPOL\npacket capture...\n");
-        int err = pcap_file_open("eapolscan", PCAP_CAPTURE_WIFI);
+        int err = pcap_file_open_ex("eapolscan", PCAP_CAPTURE_WIFI, &capture_config);
 
         if (err != ESP_OK) {
             printf("Error: pcap failed to open\n");
             TERMINAL_VIEW_ADD_TEXT("Error: pcap failed to open\n");
             return;
         }
-        wifi_manager_start_monitor_mode(wifi_eapol_scan_callback);
+        wifi_manager_start_monitor_mode("capture", CAPTURE_EAPOL_FRAMES, wifi_eapol_scan_callback);
     }
 
     if (strcmp(capturetype, "-pwn") == 0) {
         printf("Starting PWN\npacket capture...\n");
         TERMINAL_VIEW_ADD_TEXT("Starting PWN\npacket capture...\n");
-        int err = pcap_file_open("pwnscan", PCAP_CAPTURE_WIFI);
+        int err = pcap_file_open_ex("pwnscan", PCAP_CAPTURE_WIFI, &capture_config);
 
         if (err != ESP_OK) {
             printf("Error: pcap failed to open\n");
             TERMINAL_VIEW_ADD_TEXT("Error: pcap failed to open\n");
             return;
         }
-        wifi_manager_start_monitor_mode(wifi_pwn_scan_callback);
+        wifi_manager_start_monitor_mode("capture", FRAME_MGMT_BIT(FRAME_SUBTYPE_BEACON),
+                                        wifi_pwn_scan_callback);
     }
 
     if (strcmp(capturetype, "-wps") == 0) {
         printf("Starting WPS\npacket capture...\n");
         TERMINAL_VIEW_ADD_TEXT("Starting WPS\npacket capture...\n");
-        int err = pcap_file_open("wpsscan", PCAP_CAPTURE_WIFI);
+        int err = pcap_file_open_ex("wpsscan", PCAP_CAPTURE_WIFI, &capture_config);
 
         should_store_wps = 0;
 
@@ -739,30 +931,49 @@ void handle_capture_scan(int argc, char **argv) {
             TERMINAL_VIEW_ADD_TEXT("Error: pcap failed to open\n");
             return;
         }
-        wifi_manager_start_monitor_mode(wifi_wps_detection_callback);
+        wifi_manager_start_monitor_mode("capture", AP_ANNOUNCE_FRAMES, wifi_wps_detection_callback);
     }
 
     if (strcmp(capturetype, "-stop") == 0) {
         printf("Stopping packet capture...\n");
         TERMINAL_VIEW_ADD_TEXT("Stopping packet capture...\n");
-        wifi_manager_stop_monitor_mode();
+        wifi_manager_stop_monitor_consumer("capture");
 #ifndef CONFIG_IDF_TARGET_ESP32S2
         ble_stop();
         ble_stop_skimmer_detection();
 #endif
         pcap_file_close();
+
+        pcap_stats_t stats;
+        if (pcap_get_stats(&stats) == ESP_OK && stats.packets_written > 0) {
+            printf("Captured %lu packets, dropped %lu (%lu bytes)\n",
+                   (unsigned long)stats.packets_written,
+                   (unsigned long)stats.packets_dropped,
+                   (unsigned long)stats.bytes_dropped);
+            printf("Wrote %llu bytes, saved %llu by truncation\n",
+                   (unsigned long long)stats.bytes_flushed,
+                   (unsigned long long)stats.bytes_saved);
+            TERMINAL_VIEW_ADD_TEXT("Captured %lu packets\nDropped %lu\nSaved %llu KB\n",
+                                   (unsigned long)stats.packets_written,
+                                   (unsigned long)stats.packets_dropped,
+                                   (unsigned long long)(stats.bytes_saved / 1024));
+        }
     }
 #ifndef CONFIG_IDF_TARGET_ESP32S2
     if (strcmp(capturetype, "-ble") == 0) {
         printf("Starting BLE packet capture...\n");
         TERMINAL_VIEW_ADD_TEXT("Starting BLE packet capture...\n");
+        if (capture_config.format == PCAP_FORMAT_PCAPNG &&
+            !pcap_is_capturing(PCAP_CAPTURE_BLUETOOTH)) {
+            pcap_file_open_ex("ble_capture", PCAP_CAPTURE_BLUETOOTH, &capture_config);
+        }
         ble_start_capture();
     }
 
     if (strcmp(capturetype, "-skimmer") == 0) {
         printf("Skimmer detection started.\n");
         TERMINAL_VIEW_ADD_TEXT("Skimmer detection started.\n");
-        int err = pcap_file_open("skimmer_scan", PCAP_CAPTURE_BLUETOOTH);
+        int err = pcap_file_open_ex("skimmer_scan", PCAP_CAPTURE_BLUETOOTH, &capture_config);
         if (err != ESP_OK) {
             printf("Warning: PCAP capture failed to start\n");
             TERMINAL_VIEW_ADD_TEXT("Warning: PCAP capture failed to start\n");
@@ -789,24 +1000,140 @@ void handle_reboot(int argc, char **argv) {
     esp_restart();
 }
 
+#ifndef CONFIG_WARDRIVE_BLE_SCAN_DUTY
+#define CONFIG_WARDRIVE_BLE_SCAN_DUTY 30
+#endif
+
+static void print_wardrive_rates(void) {
+    wardrive_logger_stats_t logger;
+    wardrive_logger_get_stats(&logger);
+    uint32_t seconds = logger.seconds ? logger.seconds : 1;
+
+    printf("Wi-Fi: %lu records, %lu/min\n", (unsigned long)logger.wifi_written,
+           (unsigned long)((uint64_t)logger.wifi_written * 60 / seconds));
+    TERMINAL_VIEW_ADD_TEXT("Wi-Fi: %lu, %lu/min\n", (unsigned long)logger.wifi_written,
+                           (unsigned long)((uint64_t)logger.wifi_written * 60 / seconds));
+    if (wardriving_ble || logger.ble_written > 0) {
+        printf("BLE: %lu records, %lu/min\n", (unsigned long)logger.ble_written,
+               (unsigned long)((uint64_t)logger.ble_written * 60 / seconds));
+        TERMINAL_VIEW_ADD_TEXT("BLE: %lu, %lu/min\n", (unsigned long)logger.ble_written,
+                               (unsigned long)((uint64_t)logger.ble_written * 60 / seconds));
+    }
+    printf("Logger: %lu rows written, %lu dropped while busy, %lus\n",
+           (unsigned long)logger.written, (unsigned long)logger.dropped,
+           (unsigned long)logger.seconds);
+}
+
 void handle_startwd(int argc, char **argv) {
     bool stop_flag = false;
+    bool stats_flag = false;
+    bool with_ble = false;
+    int ble_duty = CONFIG_WARDRIVE_BLE_SCAN_DUTY;
+    capture_rotation_t rotation = {0};
+    wardrive_log_format_t format = WARDRIVE_LOG_CSV;
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-s") == 0) {
             stop_flag = true;
             break;
         }
+        if (strcmp(argv[i], "-stats") == 0) {
+            stats_flag = true;
+            continue;
+        }
+        if (strcmp(argv[i], "-bin") == 0) {
+            format = WARDRIVE_LOG_BINARY;
+            continue;
+        }
+        if (strcmp(argv[i], "-ble") == 0) {
+            with_ble = true;
+            continue;
+        }
+        if (strcmp(argv[i], "-duty") == 0) {
+            ble_duty = i + 1 < argc ? atoi(argv[++i]) : 0;
+            if (ble_duty < 5 || ble_duty > 100) {
+                printf("Error: -duty takes a percentage from 5 to 100\n");
+                TERMINAL_VIEW_ADD_TEXT("Error: Invalid -duty value\n");
+                return;
+            }
+            continue;
+        }
+        if (parse_rotation_option(argc, argv, &i, &rotation) < 0) {
+            return;
+        }
     }
 
+    if (stats_flag) {
+        if (!wardriving_active) {
+            printf("Wardriving is not running.\n");
+            TERMINAL_VIEW_ADD_TEXT("Wardriving is not running.\n");
+            return;
+        }
+        print_wardrive_rates();
+        return;
+    }
+
+#ifdef CONFIG_IDF_TARGET_ESP32S2
+    if (with_ble) {
+        printf("BLE is not available on this chip, wardriving Wi-Fi only.\n");
+        TERMINAL_VIEW_ADD_TEXT("No BLE on this chip, Wi-Fi only.\n");
+        with_ble = false;
+    }
+#endif
+
     if (stop_flag) {
+        wifi_manager_stop_monitor_consumer("wardrive");
+#ifndef CONFIG_IDF_TARGET_ESP32S2
+        if (wardriving_ble) {
+            ble_stop();
+            wardriving_ble = false;
+        }
+#endif
         gps_manager_deinit(&g_gpsManager);
-        wifi_manager_stop_monitor_mode();
+        if (wardriving_active) {
+            uint32_t sightings, logged;
+            mac_table_stats_t table;
+
+            channel_hopper_release();
+            wardriving_active = false;
+            csv_file_close();
+            wardriving_dedup_stats(&sightings, &logged, &table);
+            printf("Logged %lu of %lu sightings, %lu BSSIDs tracked (%lu evicted)\n",
+                   (unsigned long)logged, (unsigned long)sightings, (unsigned long)table.count,
+                   (unsigned long)table.evictions);
+            TERMINAL_VIEW_ADD_TEXT("Logged %lu of %lu\n", (unsigned long)logged,
+                                   (unsigned long)sightings);
+            print_wardrive_rates();
+        }
         printf("Wardriving stopped.\n");
         TERMINAL_VIEW_ADD_TEXT("Wardriving stopped.\n");
     } else {
         gps_manager_init(&g_gpsManager);
-        wifi_manager_start_monitor_mode(wardriving_scan_callback);
+        if (!wardriving_active) {
+            if (wardrive_log_open("wardriving", &rotation, format) != ESP_OK) {
+                printf("Failed to open log file for wardriving\n");
+                TERMINAL_VIEW_ADD_TEXT("Failed to open log file for wardriving\n");
+                return;
+            }
+            wardriving_dedup_reset();
+        }
+        wifi_manager_start_monitor_mode("wardrive", AP_ANNOUNCE_FRAMES, wardriving_scan_callback);
+        if (!wardriving_active) {
+            channel_hopper_acquire();
+            wardriving_active = true;
+        }
+#ifndef CONFIG_IDF_TARGET_ESP32S2
+        // Both radios log into the session file opened above, from the same
+        // GPS fix; the coexistence scheduler splits airtime per the duty.
+        if (with_ble && !wardriving_ble) {
+            ble_set_scan_duty(ble_duty);
+            ble_register_handler(ble_wardriving_callback);
+            ble_start_scanning();
+            wardriving_ble = true;
+            printf("BLE scanning %d%% of the time.\n", ble_duty);
+            TERMINAL_VIEW_ADD_TEXT("BLE scanning %d%% of the time.\n", ble_duty);
+        }
+#endif
         printf("Wardriving started.\n");
         TERMINAL_VIEW_ADD_TEXT("Wardriving started.\n");
     }
@@ -898,6 +1225,15 @@ void handle_help(int argc, char **argv) {
     TERMINAL_VIEW_ADD_TEXT("    Description: Start scanning for Wi-Fi stations.\n");
     TERMINAL_VIEW_ADD_TEXT("    Usage: scansta\n\n");
 
+    printf("stations\n");
+    printf("    Description: List stations found by scansta with their AP, channel,\n");
+    printf("                 signal, traffic and timing\n");
+    printf("    Usage: stations [recent|frames|rssi] [rows] | stations reset\n\n");
+    TERMINAL_VIEW_ADD_TEXT("stations\n");
+    TERMINAL_VIEW_ADD_TEXT("    Description: List stations found by scansta with their AP, channel,\n");
+    TERMINAL_VIEW_ADD_TEXT("                 signal, traffic and timing\n");
+    TERMINAL_VIEW_ADD_TEXT("    Usage: stations [recent|frames|rssi] [rows] | stations reset\n\n");
+
     printf("stopscan\n");
     printf("    Description: Stop any ongoing Wi-Fi scan.\n");
     printf("    Usage: stopscan\n\n");
@@ -1034,7 +1370,14 @@ void handle_help(int argc, char **argv) {
     printf("        -raw   :   Start Capturing Raw Packets\n");
     printf("        -wps   :   Start Capturing WPS Packets and there Auth Type");
     printf("        -pwn   :   Start Capturing Pwnagotchi Packets");
-    printf("        -stop   : Stops the active capture\n\n");
+    printf("        -stop   : Stops the active capture\n");
+    printf("    Options:\n");
+    printf("        -pcapng : Write PCAPNG so Wi-Fi and BLE can share a file\n");
+    printf("        -snap <bytes> : Keep at most this many bytes per packet\n");
+    printf("        -mgmt-full : Never truncate management frames\n");
+    printf("        -data-hdr : Keep only the headers of data frames\n");
+    printf("        -rotate-mb <n> : Start a new file every n MB\n");
+    printf("        -rotate-min <n> : Start a new file every n minutes\n\n");
     TERMINAL_VIEW_ADD_TEXT("capture\n");
     TERMINAL_VIEW_ADD_TEXT("    Description: Start a WiFi Capture (Requires SD Card or Flipper)\n");
     TERMINAL_VIEW_ADD_TEXT("    Usage: capture [OPTION]\n");
@@ -1045,7 +1388,104 @@ void handle_help(int argc, char **argv) {
     TERMINAL_VIEW_ADD_TEXT("        -raw   :   Start Capturing Raw Packets\n");
     TERMINAL_VIEW_ADD_TEXT("        -wps   :   Start Capturing WPS Packets and there Auth Type");
     TERMINAL_VIEW_ADD_TEXT("        -pwn   :   Start Capturing Pwnagotchi Packets");
-    TERMINAL_VIEW_ADD_TEXT("        -stop   : Stops the active capture\n\n");
+    TERMINAL_VIEW_ADD_TEXT("        -stop   : Stops the active capture\n");
+    TERMINAL_VIEW_ADD_TEXT("    Options:\n");
+    TERMINAL_VIEW_ADD_TEXT("        -pcapng : Write PCAPNG so Wi-Fi and BLE can share a file\n");
+    TERMINAL_VIEW_ADD_TEXT("        -snap <bytes> : Keep at most this many bytes per packet\n");
+    TERMINAL_VIEW_ADD_TEXT("        -mgmt-full : Never truncate management frames\n");
+    TERMINAL_VIEW_ADD_TEXT("        -data-hdr : Keep only the headers of data frames\n");
+    TERMINAL_VIEW_ADD_TEXT("        -rotate-mb <n> : Start a new file every n MB\n");
+    TERMINAL_VIEW_ADD_TEXT("        -rotate-min <n> : Start a new file every n minutes\n\n");
+
+    printf("captures\n");
+    printf("    Description: List recent captures and wardriving logs on the SD card\n");
+    printf("    Usage: captures [count]\n\n");
+    TERMINAL_VIEW_ADD_TEXT("captures\n");
+    TERMINAL_VIEW_ADD_TEXT("    Description: List recent captures and wardriving logs on the SD card\n");
+    TERMINAL_VIEW_ADD_TEXT("    Usage: captures [count]\n\n");
+
+    printf("serial\n");
+    printf("    Description: Configure serial output used when there is no SD card\n");
+    printf("    Usage: serial <framing on|off|stats|baud [rate] [seconds]|selftest [seconds]>\n");
+    printf("    Arguments:\n");
+    printf("        framing on  : Send captures, logs and replies as CRC-checked frames\n");
+    printf("        framing off : Use the [BUF/BEGIN]/[BUF/CLOSE] text markers\n");
+    printf("        stats       : Show frame counters\n");
+    printf("        baud <rate> : Switch baud rate; reconnect and send 'ok' to keep it,\n");
+    printf("                      otherwise it reverts after [seconds] (default 10)\n");
+    printf("        selftest    : Measure the bytes/sec the port actually delivers\n\n");
+
+    TERMINAL_VIEW_ADD_TEXT("serial\n");
+    TERMINAL_VIEW_ADD_TEXT("    Description: Configure serial output used when there is no SD card\n");
+    TERMINAL_VIEW_ADD_TEXT("    Usage: serial <framing on|off|stats|baud [rate] [seconds]|selftest [seconds]>\n");
+    TERMINAL_VIEW_ADD_TEXT("    Arguments:\n");
+    TERMINAL_VIEW_ADD_TEXT("        framing on  : Send captures, logs and replies as CRC-checked frames\n");
+    TERMINAL_VIEW_ADD_TEXT("        framing off : Use the [BUF/BEGIN]/[BUF/CLOSE] text markers\n");
+    TERMINAL_VIEW_ADD_TEXT("        stats       : Show frame counters\n");
+    TERMINAL_VIEW_ADD_TEXT("        baud <rate> : Switch baud rate; reconnect and send 'ok' to keep it,\n");
+    TERMINAL_VIEW_ADD_TEXT("                      otherwise it reverts after [seconds] (default 10)\n");
+    TERMINAL_VIEW_ADD_TEXT("        selftest    : Measure the bytes/sec the port actually delivers\n\n");
+
+    printf("frames\n");
+    printf("    Description: Show what each monitor consumer receives and costs\n");
+    printf("    Usage: frames [reset]\n\n");
+    TERMINAL_VIEW_ADD_TEXT("frames\n");
+    TERMINAL_VIEW_ADD_TEXT("    Description: Show what each monitor consumer receives and costs\n");
+    TERMINAL_VIEW_ADD_TEXT("    Usage: frames [reset]\n\n");
+
+    printf("hop\n");
+    printf("    Description: Configure the channel hopper used by pineap and wardriving\n");
+    printf("    Usage: hop [start|stop|fixed [ms]|weighted [ms]|lock <ch> [lock_ms] [ms]|\n");
+    printf("                channels <list|default>|stats [reset]]\n");
+    printf("    Arguments:\n");
+    printf("        fixed    : Equal dwell on every channel (default 200 ms)\n");
+    printf("        weighted : Dwell longer on channels with more frames and beacons\n");
+    printf("        lock     : Stay on <ch> for lock_ms, then visit one other channel\n");
+    printf("        channels : Comma separated list, e.g. 1,6,11\n\n");
+    TERMINAL_VIEW_ADD_TEXT("hop\n");
+    TERMINAL_VIEW_ADD_TEXT("    Description: Configure the channel hopper used by pineap and wardriving\n");
+    TERMINAL_VIEW_ADD_TEXT("    Usage: hop [start|stop|fixed [ms]|weighted [ms]|lock <ch> [lock_ms] [ms]|\n");
+    TERMINAL_VIEW_ADD_TEXT("                channels <list|default>|stats [reset]]\n");
+    TERMINAL_VIEW_ADD_TEXT("    Arguments:\n");
+    TERMINAL_VIEW_ADD_TEXT("        fixed    : Equal dwell on every channel (default 200 ms)\n");
+    TERMINAL_VIEW_ADD_TEXT("        weighted : Dwell longer on channels with more frames and beacons\n");
+    TERMINAL_VIEW_ADD_TEXT("        lock     : Stay on <ch> for lock_ms, then visit one other channel\n");
+    TERMINAL_VIEW_ADD_TEXT("        channels : Comma separated list, e.g. 1,6,11\n\n");
+
+    printf("survey\n");
+    printf("    Description: Measure how busy each channel is while hopping\n");
+    printf("    Usage: survey [start|stop|reset|json]\n");
+    printf("    Arguments:\n");
+    printf("        (none) : Print frames, airtime, busy share, RSSI spread and transmitters\n");
+    printf("        json   : Print the same report as JSON (also served at /api/survey)\n\n");
+    TERMINAL_VIEW_ADD_TEXT("survey\n");
+    TERMINAL_VIEW_ADD_TEXT("    Description: Measure how busy each channel is while hopping\n");
+    TERMINAL_VIEW_ADD_TEXT("    Usage: survey [start|stop|reset|json]\n");
+    TERMINAL_VIEW_ADD_TEXT("    Arguments:\n");
+    TERMINAL_VIEW_ADD_TEXT("        (none) : Print frames, airtime, busy share, RSSI spread and transmitters\n");
+    TERMINAL_VIEW_ADD_TEXT("        json   : Print the same report as JSON (also served at /api/survey)\n\n");
+
+    printf("evilwatch\n");
+    printf("    Description: Alert when an SSID is advertised with different security, vendor\n");
+    printf("                 or channel than the first AP heard with it\n");
+    printf("    Usage: evilwatch [start|stop|stats]\n\n");
+    TERMINAL_VIEW_ADD_TEXT("evilwatch\n");
+    TERMINAL_VIEW_ADD_TEXT("    Description: Alert when an SSID is advertised with different security, vendor\n");
+    TERMINAL_VIEW_ADD_TEXT("                 or channel than the first AP heard with it\n");
+    TERMINAL_VIEW_ADD_TEXT("    Usage: evilwatch [start|stop|stats]\n\n");
+
+    printf("deauthwatch\n");
+    printf("    Description: Alert on deauthentication and disassociation floods per AP and\n");
+    printf("                 per client, with the claimed source and broadcast or targeted\n");
+    printf("    Usage: deauthwatch [start [threshold]|stop|stats]\n");
+    printf("    Arguments:\n");
+    printf("        threshold : Frames in %d seconds that start a flood\n\n", DEAUTH_WINDOW_BUCKETS);
+    TERMINAL_VIEW_ADD_TEXT("deauthwatch\n");
+    TERMINAL_VIEW_ADD_TEXT("    Description: Alert on deauthentication and disassociation floods per AP and\n");
+    TERMINAL_VIEW_ADD_TEXT("                 per client, with the claimed source and broadcast or targeted\n");
+    TERMINAL_VIEW_ADD_TEXT("    Usage: deauthwatch [start [threshold]|stop|stats]\n");
+    TERMINAL_VIEW_ADD_TEXT("    Arguments:\n");
+    TERMINAL_VIEW_ADD_TEXT("        threshold : Frames in %d seconds that start a flood\n\n", DEAUTH_WINDOW_BUCKETS);
 
     printf("connect\n");
     printf("    Description: Connects to Specific WiFi Network\n");
@@ -1076,16 +1516,44 @@ void handle_help(int argc, char **argv) {
     TERMINAL_VIEW_ADD_TEXT("    aligment options: CM = Center Middle, TL = Top Left, TR = Top "
                            "Right, BR = Bottom Right, BL = Bottom Left\n\n");
 
+    printf("startwd\n");
+    printf("    Description: Start/Stop Wi-Fi wardriving with GPS logging\n");
+    printf("    Usage: startwd [-s] [-stats] [-ble [-duty <n>]] [-bin] [-rotate-mb <n>] "
+           "[-rotate-min <n>]\n");
+    printf("    Arguments:\n");
+    printf("        -s  : Stop wardriving\n");
+    printf("        -stats : Show records per minute for each radio\n");
+    printf("        -ble : Also log BLE devices into the same file\n");
+    printf("        -duty : Percent of airtime BLE scans while Wi-Fi sniffs (5-100)\n");
+    printf("        -bin : Log compact .gwd blocks to SD\n");
+    printf("        -rotate-mb/-rotate-min : Start a new log every n MB or minutes\n\n");
+    TERMINAL_VIEW_ADD_TEXT("startwd\n");
+    TERMINAL_VIEW_ADD_TEXT("    Description: Start/Stop Wi-Fi wardriving with GPS logging\n");
+    TERMINAL_VIEW_ADD_TEXT("    Usage: startwd [-s] [-stats] [-ble [-duty <n>]] [-bin] "
+                           "[-rotate-mb <n>] [-rotate-min <n>]\n");
+    TERMINAL_VIEW_ADD_TEXT("    Arguments:\n");
+    TERMINAL_VIEW_ADD_TEXT("        -s  : Stop wardriving\n");
+    TERMINAL_VIEW_ADD_TEXT("        -stats : Records per minute per radio\n");
+    TERMINAL_VIEW_ADD_TEXT("        -ble : Also log BLE devices\n");
+    TERMINAL_VIEW_ADD_TEXT("        -duty : BLE share of airtime (5-100)\n");
+    TERMINAL_VIEW_ADD_TEXT("        -bin : Log compact .gwd blocks to SD\n");
+    TERMINAL_VIEW_ADD_TEXT("        -rotate-mb/-rotate-min : Start a new log every n MB or minutes\n\n");
+
     printf("blewardriving\n");
     printf("    Description: Start/Stop BLE wardriving with GPS logging\n");
-    printf("    Usage: blewardriving [-s]\n");
+    printf("    Usage: blewardriving [-s] [-bin] [-rotate-mb <n>] [-rotate-min <n>]\n");
     printf("    Arguments:\n");
-    printf("        -s  : Stop BLE wardriving\n\n");
+    printf("        -s  : Stop BLE wardriving\n");
+    printf("        -bin : Log compact .gwd blocks to SD, convert with "
+           "scripts/wardrive\n");
+    printf("        -rotate-mb/-rotate-min : Start a new log every n MB or minutes\n\n");
     TERMINAL_VIEW_ADD_TEXT("blewardriving\n");
     TERMINAL_VIEW_ADD_TEXT("    Description: Start/Stop BLE wardriving with GPS logging\n");
-    TERMINAL_VIEW_ADD_TEXT("    Usage: blewardriving [-s]\n");
+    TERMINAL_VIEW_ADD_TEXT("    Usage: blewardriving [-s] [-bin] [-rotate-mb <n>] [-rotate-min <n>]\n");
     TERMINAL_VIEW_ADD_TEXT("    Arguments:\n");
-    TERMINAL_VIEW_ADD_TEXT("        -s  : Stop BLE wardriving\n\n");
+    TERMINAL_VIEW_ADD_TEXT("        -s  : Stop BLE wardriving\n");
+    TERMINAL_VIEW_ADD_TEXT("        -bin : Log compact .gwd blocks to SD\n");
+    TERMINAL_VIEW_ADD_TEXT("        -rotate-mb/-rotate-min : Start a new log every n MB or minutes\n\n");
 
     printf("Port Scanner\n");
     printf("    Description: Scan ports on local subnet or specific IP\n");
@@ -1191,20 +1659,26 @@ void handle_gps_info(int argc, char **argv) {
 #ifndef CONFIG_IDF_TARGET_ESP32S2
 void handle_ble_wardriving(int argc, char **argv) {
     bool stop_flag = false;
+    capture_rotation_t rotation = {0};
+    wardrive_log_format_t format = WARDRIVE_LOG_CSV;
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-s") == 0) {
             stop_flag = true;
             break;
         }
+        if (strcmp(argv[i], "-bin") == 0) {
+            format = WARDRIVE_LOG_BINARY;
+            continue;
+        }
+        if (parse_rotation_option(argc, argv, &i, &rotation) < 0) {
+            return;
+        }
     }
 
     if (stop_flag) {
         ble_stop();
         gps_manager_deinit(&g_gpsManager);
-        if (buffer_offset > 0) { // Only flush if there's data in buffer
-            csv_flush_buffer_to_file();
-        }
         csv_file_close();
         printf("BLE wardriving stopped.\n");
         TERMINAL_VIEW_ADD_TEXT("BLE wardriving stopped.\n");
@@ -1213,10 +1687,10 @@ void handle_ble_wardriving(int argc, char **argv) {
             gps_manager_init(&g_gpsManager);
         }
 
-        // Open CSV file for BLE wardriving
-        esp_err_t err = csv_file_open("ble_wardriving");
+        // Open the log file for BLE wardriving
+        esp_err_t err = wardrive_log_open("ble_wardriving", &rotation, format);
         if (err != ESP_OK) {
-            printf("Failed to open CSV file for BLE wardriving\n");
+            printf("Failed to open log file for BLE wardriving\n");
             return;
         }
 
@@ -1233,8 +1707,8 @@ void handle_pineap_detection(int argc, char **argv) {
         printf("Stopping PineAP detection...\n");
         TERMINAL_VIEW_ADD_TEXT("Stopping PineAP detection...\n");
         stop_pineap_detection();
-        wifi_manager_stop_monitor_mode();
-        pcap_file_close();
+        wifi_manager_stop_monitor_consumer("pineap");
+        pcap_file_close_type(PCAP_CAPTURE_WIFI);
         return;
     }
     // Open PCAP file for logging detections
@@ -1245,8 +1719,14 @@ void handle_pineap_detection(int argc, char **argv) {
     }
 
     // Start PineAP detection with channel hopping
-    start_pineap_detection();
-    wifi_manager_start_monitor_mode(wifi_pineap_detector_callback);
+    if (start_pineap_detection() != ESP_OK) {
+        printf("Failed to start PineAP detection\n");
+        TERMINAL_VIEW_ADD_TEXT("Failed to start PineAP detection\n");
+        pcap_file_close_type(PCAP_CAPTURE_WIFI);
+        return;
+    }
+    wifi_manager_start_monitor_mode("pineap", FRAME_MGMT_BIT(FRAME_SUBTYPE_BEACON),
+                                    wifi_pineap_detector_callback);
 
     printf("Monitoring for Pineapples\n");
     TERMINAL_VIEW_ADD_TEXT("Monitoring for Pineapples\n");
@@ -1445,10 +1925,482 @@ void handle_setrgb(int argc, char **argv) {
     }
 }
 
+// What capture_index_entry_t.packets counts for each kind of file.
+static const char *capture_count_unit(capture_file_type_t type) {
+    switch (type) {
+    case CAPTURE_FILE_CSV:
+        return "rows";
+    case CAPTURE_FILE_GWD:
+        return "records";
+    default:
+        return "packets";
+    }
+}
+
+void handle_captures(int argc, char **argv) {
+    size_t max = 16;
+    if (argc > 1) {
+        int requested = atoi(argv[1]);
+        if (requested <= 0) {
+            printf("Usage: captures [count]\n");
+            TERMINAL_VIEW_ADD_TEXT("Usage: captures [count]\n");
+            return;
+        }
+        max = requested > CAPTURE_INDEX_LIST_MAX ? CAPTURE_INDEX_LIST_MAX : requested;
+    }
+
+    capture_index_entry_t *entries = malloc(max * sizeof(capture_index_entry_t));
+    if (entries == NULL) {
+        printf("Out of memory\n");
+        TERMINAL_VIEW_ADD_TEXT("Out of memory\n");
+        return;
+    }
+
+    size_t count = capture_index_list(entries, max);
+    if (count == 0) {
+        printf("No captures recorded (is the SD card mounted?)\n");
+        TERMINAL_VIEW_ADD_TEXT("No captures recorded\n");
+        free(entries);
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const capture_index_entry_t *e = &entries[i];
+        if (e->closed) {
+            printf("%s_%u.%s  %lu bytes  %lu %s\n", e->base_name, e->file_index,
+                   capture_index_type_name(e->type), (unsigned long)e->size,
+                   (unsigned long)e->packets, capture_count_unit(e->type));
+            TERMINAL_VIEW_ADD_TEXT("%s_%u.%s\n%lu bytes\n", e->base_name, e->file_index,
+                                   capture_index_type_name(e->type), (unsigned long)e->size);
+        } else {
+            printf("%s_%u.%s  (open or interrupted)\n", e->base_name, e->file_index,
+                   capture_index_type_name(e->type));
+            TERMINAL_VIEW_ADD_TEXT("%s_%u.%s\n(open)\n", e->base_name, e->file_index,
+                                   capture_index_type_name(e->type));
+        }
+    }
+    free(entries);
+}
+
+void handle_serial_cmd(int argc, char **argv) {
+    if (argc >= 3 && strcmp(argv[1], "framing") == 0) {
+        bool enable;
+        if (strcmp(argv[2], "on") == 0) {
+            enable = true;
+        } else if (strcmp(argv[2], "off") == 0) {
+            enable = false;
+        } else {
+            printf("Usage: serial framing <on|off>\n");
+            TERMINAL_VIEW_ADD_TEXT("Usage: serial framing <on|off>\n");
+            return;
+        }
+
+        // Say it while the host still reads plain text.
+        if (enable) {
+            printf("Switching to framed serial output\n");
+            fflush(stdout);
+        }
+        esp_err_t err = serial_stream_set_framing(enable);
+        if (err != ESP_OK) {
+            printf("Failed to change framing: %s\n", esp_err_to_name(err));
+            TERMINAL_VIEW_ADD_TEXT("Failed to change framing\n");
+            return;
+        }
+        if (!enable) {
+            printf("Framed serial output disabled\n");
+        }
+        TERMINAL_VIEW_ADD_TEXT("Serial framing %s\n", enable ? "on" : "off");
+        return;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "stats") == 0) {
+        serial_stream_stats_t stats;
+        serial_stream_get_stats(&stats);
+        printf("Framing: %s\n", serial_stream_framing_enabled() ? "on" : "off");
+        printf("Frames sent: %lu, dropped: %lu, writer waits: %lu\n",
+               (unsigned long)stats.frames_sent, (unsigned long)stats.frames_dropped,
+               (unsigned long)stats.tx_waits);
+        printf("Bytes queued: %lu, ring high water: %lu\n", (unsigned long)stats.bytes_queued,
+               (unsigned long)stats.ring_high_water);
+        TERMINAL_VIEW_ADD_TEXT("Frames sent: %lu\nDropped: %lu\n",
+                               (unsigned long)stats.frames_sent,
+                               (unsigned long)stats.frames_dropped);
+        return;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "baud") == 0) {
+        if (argc < 3) {
+            printf("Baud rate: %lu\n", (unsigned long)serial_manager_get_baud());
+            TERMINAL_VIEW_ADD_TEXT("Baud rate: %lu\n", (unsigned long)serial_manager_get_baud());
+            return;
+        }
+
+        uint32_t baud = strtoul(argv[2], NULL, 10);
+        int seconds = argc >= 4 ? atoi(argv[3]) : SERIAL_BAUD_CONFIRM_SECONDS;
+        if (baud < SERIAL_BAUD_MIN || baud > SERIAL_BAUD_MAX || seconds <= 0) {
+            printf("Baud rate must be %d-%d\n", SERIAL_BAUD_MIN, SERIAL_BAUD_MAX);
+            TERMINAL_VIEW_ADD_TEXT("Invalid baud rate\n");
+            return;
+        }
+
+        uint32_t previous = serial_manager_get_baud();
+        printf("Switching to %lu baud. Reconnect at the new rate and send 'ok' within %d s,\n"
+               "otherwise the port returns to %lu baud.\n",
+               (unsigned long)baud, seconds, (unsigned long)previous);
+        TERMINAL_VIEW_ADD_TEXT("Switching to %lu baud\n", (unsigned long)baud);
+
+        esp_err_t err = serial_manager_set_baud(baud, seconds * 1000);
+        if (err == ESP_OK) {
+            printf("Baud rate set to %lu\n", (unsigned long)serial_manager_get_baud());
+            TERMINAL_VIEW_ADD_TEXT("Baud rate set to %lu\n", (unsigned long)baud);
+        } else {
+            printf("No confirmation, staying at %lu baud\n", (unsigned long)previous);
+            TERMINAL_VIEW_ADD_TEXT("No confirmation, reverted to %lu\n", (unsigned long)previous);
+        }
+        return;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "selftest") == 0) {
+        int seconds = argc >= 3 ? atoi(argv[2]) : 2;
+        if (seconds <= 0 || seconds > 30) {
+            seconds = 2;
+        }
+
+        serial_selftest_result_t result;
+        if (serial_manager_selftest(seconds * 1000, &result) != ESP_OK ||
+            result.elapsed_us <= 0) {
+            printf("Serial self-test failed\n");
+            TERMINAL_VIEW_ADD_TEXT("Serial self-test failed\n");
+            return;
+        }
+
+        // 8N1 puts ten bits on the wire per byte.
+        uint32_t achieved = (uint32_t)((uint64_t)result.bytes * 1000000 / result.elapsed_us);
+        uint32_t line_rate = result.baud / 10;
+        printf("Sent %lu bytes in %lu ms: %lu bytes/sec (%lu%% of %lu baud)\n",
+               (unsigned long)result.bytes, (unsigned long)(result.elapsed_us / 1000),
+               (unsigned long)achieved,
+               (unsigned long)(line_rate ? (uint64_t)achieved * 100 / line_rate : 0),
+               (unsigned long)result.baud);
+        TERMINAL_VIEW_ADD_TEXT("Serial: %lu bytes/sec\n", (unsigned long)achieved);
+        return;
+    }
+
+    printf("Usage: serial <framing on|off|stats|baud [rate] [seconds]|selftest [seconds]>\n");
+    TERMINAL_VIEW_ADD_TEXT("Usage: serial <framing|stats|baud|selftest>\n");
+}
+
+void handle_frames_cmd(int argc, char **argv) {
+    if (argc >= 2 && strcmp(argv[1], "reset") == 0) {
+        frame_dispatch_reset_stats();
+        printf("Monitor counters reset\n");
+        TERMINAL_VIEW_ADD_TEXT("Monitor counters reset\n");
+        return;
+    }
+
+    frame_consumer_stats_t stats[FRAME_DISPATCH_MAX_CONSUMERS];
+    frame_dispatch_totals_t totals;
+    int count = frame_dispatch_get_stats(stats, FRAME_DISPATCH_MAX_CONSUMERS, &totals);
+
+    printf("Frames received: %lu, unclaimed: %lu\n", (unsigned long)totals.frames,
+           (unsigned long)totals.unclaimed);
+    TERMINAL_VIEW_ADD_TEXT("Frames: %lu\n", (unsigned long)totals.frames);
+    if (count == 0) {
+        printf("No monitor consumers running\n");
+        TERMINAL_VIEW_ADD_TEXT("No monitor consumers\n");
+        return;
+    }
+
+    printf("%-16s %-18s %10s %10s %12s\n", "Consumer", "Mask", "Frames", "Avg us",
+           "Total ms");
+    for (int i = 0; i < count; i++) {
+        printf("%-16s 0x%016llx %10lu %7lu.%02lu %12llu\n", stats[i].name,
+               (unsigned long long)stats[i].mask, (unsigned long)stats[i].hits,
+               (unsigned long)(stats[i].avg_us_x100 / 100),
+               (unsigned long)(stats[i].avg_us_x100 % 100),
+               (unsigned long long)(stats[i].total_us / 1000));
+        TERMINAL_VIEW_ADD_TEXT("%s: %lu\n", stats[i].name, (unsigned long)stats[i].hits);
+    }
+}
+
+static bool manual_hop_held = false;
+
+static void print_hop_status(void) {
+    channel_hop_config_t config;
+    uint8_t channels[CHANNEL_HOPPER_MAX_CHANNELS];
+    int count = channel_hopper_get_channels(channels, CHANNEL_HOPPER_MAX_CHANNELS);
+    char list[CHANNEL_HOPPER_MAX_CHANNELS * 4 + 1];
+    int len = 0;
+
+    channel_hopper_get_config(&config);
+    list[0] = '\0';
+    for (int i = 0; i < count; i++) {
+        len += snprintf(list + len, sizeof(list) - len, i ? ",%u" : "%u", channels[i]);
+    }
+
+    printf("Hopper: %s, policy %s, dwell %u ms\n",
+           channel_hopper_running() ? "running" : "idle",
+           channel_hopper_policy_name(config.policy), config.dwell_ms);
+    TERMINAL_VIEW_ADD_TEXT("Hopper: %s, %s\n", channel_hopper_running() ? "running" : "idle",
+                           channel_hopper_policy_name(config.policy));
+    if (config.policy == CHANNEL_HOP_LOCK) {
+        printf("Locked on %u for %u ms between excursions\n", config.lock_channel,
+               config.lock_ms);
+        TERMINAL_VIEW_ADD_TEXT("Lock: ch %u\n", config.lock_channel);
+    }
+    printf("Channels: %s\n", list);
+    TERMINAL_VIEW_ADD_TEXT("Channels: %d\n", count);
+}
+
+static void print_hop_stats(void) {
+    channel_hop_stats_t stats[CHANNEL_HOPPER_MAX_CHANNELS];
+    int count = channel_hopper_get_stats(stats, CHANNEL_HOPPER_MAX_CHANNELS);
+
+    printf("%4s %8s %10s %10s %10s %7s\n", "Ch", "Visits", "Dwell ms", "Frames", "Beacons",
+           "Weight");
+    for (int i = 0; i < count; i++) {
+        printf("%4u %8lu %10lu %10lu %10lu %5u.%u%%\n", stats[i].channel,
+               (unsigned long)stats[i].visits, (unsigned long)stats[i].dwell_ms,
+               (unsigned long)stats[i].frames, (unsigned long)stats[i].beacons,
+               stats[i].weight / 10, stats[i].weight % 10);
+        TERMINAL_VIEW_ADD_TEXT("Ch %u: %lu frames\n", stats[i].channel,
+                               (unsigned long)stats[i].frames);
+    }
+}
+
+static esp_err_t parse_hop_channels(const char *arg) {
+    if (strcmp(arg, "default") == 0 || strcmp(arg, "all") == 0) {
+        channel_hopper_default_channels();
+        return ESP_OK;
+    }
+
+    uint8_t channels[CHANNEL_HOPPER_MAX_CHANNELS];
+    int count = 0;
+    const char *p = arg;
+    while (*p != '\0') {
+        char *end;
+        long channel = strtol(p, &end, 10);
+        if (end == p || channel <= 0 || channel > 255 || count >= CHANNEL_HOPPER_MAX_CHANNELS) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        channels[count++] = (uint8_t)channel;
+        p = (*end == ',') ? end + 1 : end;
+        if (*end != ',' && *end != '\0') {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    return channel_hopper_set_channels(channels, count);
+}
+
+void handle_hop_cmd(int argc, char **argv) {
+    if (argc < 2) {
+        print_hop_status();
+        return;
+    }
+
+    esp_err_t err = ESP_OK;
+    channel_hop_config_t config;
+    channel_hopper_get_config(&config);
+
+    if (strcmp(argv[1], "start") == 0) {
+        if (!manual_hop_held) {
+            err = channel_hopper_acquire();
+            manual_hop_held = (err == ESP_OK);
+        }
+    } else if (strcmp(argv[1], "stop") == 0) {
+        if (manual_hop_held) {
+            channel_hopper_release();
+            manual_hop_held = false;
+        }
+    } else if (strcmp(argv[1], "fixed") == 0 || strcmp(argv[1], "weighted") == 0) {
+        config.policy = argv[1][0] == 'f' ? CHANNEL_HOP_FIXED : CHANNEL_HOP_WEIGHTED;
+        if (argc >= 3) {
+            config.dwell_ms = (uint16_t)atoi(argv[2]);
+        }
+        err = channel_hopper_set_config(&config);
+    } else if (strcmp(argv[1], "lock") == 0 && argc >= 3) {
+        config.policy = CHANNEL_HOP_LOCK;
+        config.lock_channel = (uint8_t)atoi(argv[2]);
+        if (argc >= 4) {
+            config.lock_ms = (uint16_t)atoi(argv[3]);
+        }
+        if (argc >= 5) {
+            config.dwell_ms = (uint16_t)atoi(argv[4]);
+        }
+        err = channel_hopper_set_config(&config);
+    } else if (strcmp(argv[1], "channels") == 0 && argc >= 3) {
+        err = parse_hop_channels(argv[2]);
+    } else if (strcmp(argv[1], "stats") == 0) {
+        if (argc >= 3 && strcmp(argv[2], "reset") == 0) {
+            channel_hopper_reset_stats();
+            printf("Hopper counters reset\n");
+            TERMINAL_VIEW_ADD_TEXT("Hopper counters reset\n");
+        } else {
+            print_hop_stats();
+        }
+        return;
+    } else {
+        printf("Usage: hop [start|stop|fixed [ms]|weighted [ms]|lock <ch> [lock_ms] [ms]|"
+               "channels <list|default>|stats [reset]]\n");
+        TERMINAL_VIEW_ADD_TEXT("Usage: hop [start|stop|fixed|weighted|lock|channels|stats]\n");
+        return;
+    }
+
+    if (err != ESP_OK) {
+        printf("Invalid hopper setting (dwell %d-%d ms, channel must be supported)\n",
+               CHANNEL_HOPPER_MIN_DWELL_MS, CHANNEL_HOPPER_MAX_DWELL_MS);
+        TERMINAL_VIEW_ADD_TEXT("Invalid hopper setting\n");
+        return;
+    }
+    print_hop_status();
+}
+
+static void print_survey_report(void) {
+    channel_survey_t *survey = malloc(SURVEY_MAX_CHANNELS * sizeof(channel_survey_t));
+    if (survey == NULL) {
+        printf("Out of memory\n");
+        return;
+    }
+    int count = channel_survey_get(survey, SURVEY_MAX_CHANNELS);
+
+    printf("Survey %s, %d channels heard\n", channel_survey_running() ? "running" : "stopped",
+           count);
+    TERMINAL_VIEW_ADD_TEXT("Survey: %d channels\n", count);
+    if (count > 0) {
+        printf("%4s %8s %8s %8s %10s %7s %5s %4s  RSSI <-90 ... >=-30\n", "Ch", "Mgmt", "Ctrl",
+               "Data", "KB", "Busy", "Max", "Tx");
+    }
+    for (int i = 0; i < count; i++) {
+        const channel_survey_t *s = &survey[i];
+        printf("%4u %8lu %8lu %8lu %10llu %5u.%u%% %5d %4u ", s->channel,
+               (unsigned long)s->mgmt_frames, (unsigned long)s->ctrl_frames,
+               (unsigned long)s->data_frames, (unsigned long long)(s->bytes / 1024),
+               s->busy_x10 / 10, s->busy_x10 % 10, s->rssi_max, s->transmitters);
+        for (int b = 0; b < SURVEY_RSSI_BUCKETS; b++) {
+            printf(" %lu", (unsigned long)s->rssi_hist[b]);
+        }
+        printf("\n");
+        TERMINAL_VIEW_ADD_TEXT("Ch %u: %u.%u%% busy, %u tx\n", s->channel, s->busy_x10 / 10,
+                               s->busy_x10 % 10, s->transmitters);
+    }
+    free(survey);
+}
+
+void handle_survey_cmd(int argc, char **argv) {
+    if (argc < 2) {
+        print_survey_report();
+        return;
+    }
+
+    if (strcmp(argv[1], "start") == 0) {
+        if (channel_survey_start() != ESP_OK) {
+            printf("Failed to start survey\n");
+            TERMINAL_VIEW_ADD_TEXT("Failed to start survey\n");
+            return;
+        }
+        printf("Channel survey started, run 'survey' for the report\n");
+        TERMINAL_VIEW_ADD_TEXT("Channel survey started\n");
+    } else if (strcmp(argv[1], "stop") == 0) {
+        channel_survey_stop();
+        printf("Channel survey stopped\n");
+        TERMINAL_VIEW_ADD_TEXT("Channel survey stopped\n");
+    } else if (strcmp(argv[1], "reset") == 0) {
+        channel_survey_reset();
+        printf("Survey counters reset\n");
+        TERMINAL_VIEW_ADD_TEXT("Survey counters reset\n");
+    } else if (strcmp(argv[1], "json") == 0) {
+        char *json = channel_survey_to_json();
+        if (json == NULL) {
+            printf("Out of memory\n");
+            return;
+        }
+        printf("%s\n", json);
+        free(json);
+    } else {
+        printf("Usage: survey [start|stop|reset|json]\n");
+        TERMINAL_VIEW_ADD_TEXT("Usage: survey [start|stop|reset|json]\n");
+    }
+}
+
+static void print_evilwatch_stats(void) {
+    ssid_map_stats_t stats;
+    uint32_t dropped;
+    evil_twin_get_stats(&stats, &dropped);
+    printf("Evilwatch %s: %lu beacons, %lu SSIDs, %lu APs (%lu evicted), %lu alerts, "
+           "%lu dropped\n",
+           evil_twin_running() ? "running" : "stopped", (unsigned long)stats.beacons,
+           (unsigned long)stats.ssids, (unsigned long)stats.aps, (unsigned long)stats.evictions,
+           (unsigned long)stats.alerts, (unsigned long)dropped);
+    TERMINAL_VIEW_ADD_TEXT("Evilwatch: %lu SSIDs\n%lu APs, %lu alerts\n", (unsigned long)stats.ssids,
+                           (unsigned long)stats.aps, (unsigned long)stats.alerts);
+}
+
+void handle_evilwatch_cmd(int argc, char **argv) {
+    if (argc < 2 || strcmp(argv[1], "start") == 0) {
+        if (evil_twin_start() != ESP_OK) {
+            printf("Failed to start evilwatch\n");
+            TERMINAL_VIEW_ADD_TEXT("Failed to start evilwatch\n");
+            return;
+        }
+        printf("Watching for evil twins, run 'evilwatch stop' to end\n");
+        TERMINAL_VIEW_ADD_TEXT("Watching for evil twins\n");
+    } else if (strcmp(argv[1], "stop") == 0) {
+        evil_twin_stop();
+        print_evilwatch_stats();
+    } else if (strcmp(argv[1], "stats") == 0) {
+        print_evilwatch_stats();
+    } else {
+        printf("Usage: evilwatch [start|stop|stats]\n");
+        TERMINAL_VIEW_ADD_TEXT("Usage: evilwatch [start|stop|stats]\n");
+    }
+}
+
+static void print_deauthwatch_stats(void) {
+    deauth_watch_stats_t stats;
+    deauth_watch_get_stats(&stats);
+    printf("Deauthwatch %s: %lu frames, %lu APs, %lu targets (%lu evicted), %lu floods, "
+           "%lu dropped, threshold %u/%ds\n",
+           deauth_watch_running() ? "running" : "stopped", (unsigned long)stats.frames,
+           (unsigned long)stats.bssids.count, (unsigned long)stats.targets.count,
+           (unsigned long)(stats.bssids.evictions + stats.targets.evictions),
+           (unsigned long)stats.alerts, (unsigned long)stats.dropped, stats.threshold,
+           DEAUTH_WINDOW_BUCKETS);
+    TERMINAL_VIEW_ADD_TEXT("Deauthwatch: %lu frames\n%lu floods\n", (unsigned long)stats.frames,
+                           (unsigned long)stats.alerts);
+}
+
+void handle_deauthwatch_cmd(int argc, char **argv) {
+    if (argc < 2 || strcmp(argv[1], "start") == 0) {
+        int threshold = argc > 2 ? atoi(argv[2]) : 0;
+        // Buckets saturate at 255 frames, so larger thresholds never trip.
+        if (threshold < 0 || threshold > DEAUTH_WINDOW_BUCKETS * UINT8_MAX) {
+            printf("Threshold must be between 1 and %d\n", DEAUTH_WINDOW_BUCKETS * UINT8_MAX);
+            TERMINAL_VIEW_ADD_TEXT("Invalid threshold\n");
+            return;
+        }
+        if (deauth_watch_start(threshold) != ESP_OK) {
+            printf("Failed to start deauthwatch\n");
+            TERMINAL_VIEW_ADD_TEXT("Failed to start deauthwatch\n");
+            return;
+        }
+        printf("Watching for deauth floods, run 'deauthwatch stop' to end\n");
+        TERMINAL_VIEW_ADD_TEXT("Watching for deauth floods\n");
+    } else if (strcmp(argv[1], "stop") == 0) {
+        deauth_watch_stop();
+        print_deauthwatch_stats();
+    } else if (strcmp(argv[1], "stats") == 0) {
+        print_deauthwatch_stats();
+    } else {
+        printf("Usage: deauthwatch [start [threshold]|stop|stats]\n");
+        TERMINAL_VIEW_ADD_TEXT("Usage: deauthwatch [start [threshold]|stop|stats]\n");
+    }
+}
+
 void register_commands() {
     register_command("help", handle_help);
     register_command("scanap", cmd_wifi_scan_start);
     register_command("scansta", handle_sta_scan);
+    register_command("stations", handle_stations_cmd);
     register_command("scanlocal", handle_ip_lookup);
     register_command("stopscan", cmd_wifi_scan_stop);
     register_command("attack", handle_attack_cmd);
@@ -1458,6 +2410,13 @@ void register_commands() {
     register_command("stopdeauth", handle_stop_deauth);
     register_command("select", handle_select_cmd);
     register_command("capture", handle_capture_scan);
+    register_command("captures", handle_captures);
+    register_command("serial", handle_serial_cmd);
+    register_command("frames", handle_frames_cmd);
+    register_command("hop", handle_hop_cmd);
+    register_command("survey", handle_survey_cmd);
+    register_command("evilwatch", handle_evilwatch_cmd);
+    register_command("deauthwatch", handle_deauthwatch_cmd);
     register_command("startportal", handle_start_portal);
     register_command("stopportal", stop_portal);
     register_command("connect", handle_wifi_connection);
@@ -0,0 +1,292 @@
+// deauth_watch.c
+
+#include "core/deauth_watch.h"
+#include "core/channel_hopper.h"
+#include "core/deauth_window.h"
+#include "core/frame_dispatch.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "managers/views/terminal_screen.h"
+#include "managers/wifi_manager.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TAG "DeauthWatch"
+#define DEAUTH_WATCH_CONSUMER "deauthwatch"
+#define DEAUTH_WATCH_QUEUE_LEN 16
+#define DEAUTH_FRAME_MIN_LEN 26 // Header plus reason code
+
+#ifndef CONFIG_DEAUTHWATCH_ENTRIES
+#define CONFIG_DEAUTHWATCH_ENTRIES 128
+#endif
+#ifndef CONFIG_DEAUTHWATCH_THRESHOLD
+#define CONFIG_DEAUTHWATCH_THRESHOLD 16
+#endif
+
+// Value of both tables. peer is the BSSID for a target entry, and the last
+// unicast target for a BSSID entry.
+typedef struct {
+  deauth_flood_t flood;
+  uint8_t peer[6];
+  bool has_peer;
+} deauth_entry_t;
+
+typedef struct {
+  deauth_flood_event_t event;
+  bool per_target;
+  uint8_t addr[6];
+  deauth_entry_t entry;
+} deauth_alert_t;
+
+static mac_table_t deauth_bssids;
+static mac_table_t deauth_targets;
+static portMUX_TYPE deauth_lock = portMUX_INITIALIZER_UNLOCKED;
+static QueueHandle_t deauth_queue = NULL;
+static uint16_t deauth_threshold = CONFIG_DEAUTHWATCH_THRESHOLD;
+static uint32_t deauth_frames = 0;
+static uint32_t deauth_alerts = 0;
+static uint32_t deauth_dropped = 0;
+static bool deauth_active = false;
+
+static inline uint32_t deauth_bucket_now(void) {
+  return esp_timer_get_time() / (DEAUTH_WINDOW_BUCKET_MS * 1000);
+}
+
+#define MAC_FMT "%02x:%02x:%02x:%02x:%02x:%02x"
+#define MAC_ARGS(m) (m)[0], (m)[1], (m)[2], (m)[3], (m)[4], (m)[5]
+
+static void deauth_print(const deauth_alert_t *alert) {
+  const deauth_flood_t *flood = &alert->entry.flood;
+  const char *key = alert->per_target ? "target" : "bssid";
+
+  if (alert->event == DEAUTH_FLOOD_ENDED) {
+    printf("DEAUTHWATCH end %s=" MAC_FMT " frames=%lu peak=%u/%ds\n", key,
+           MAC_ARGS(alert->addr), (unsigned long)flood->frames, flood->peak,
+           DEAUTH_WINDOW_BUCKETS);
+    TERMINAL_VIEW_ADD_TEXT("Deauth flood ended\n" MAC_FMT "\n%lu frames\n",
+                           MAC_ARGS(alert->addr), (unsigned long)flood->frames);
+    return;
+  }
+
+  // The claimed source says who the attacker pretends to be: the AP
+  // kicking its clients, or a client leaving.
+  const char *kind = flood->broadcast == flood->frames ? "broadcast"
+                     : flood->broadcast == 0           ? "targeted"
+                                                       : "mixed";
+  const uint8_t *bssid = alert->per_target ? alert->entry.peer : alert->addr;
+  const char *role = memcmp(flood->source, bssid, 6) == 0 ? "ap" : "client";
+  const char *type = flood->subtype == FRAME_SUBTYPE_DISASSOC ? "disassoc" : "deauth";
+
+  printf("DEAUTHWATCH start %s=" MAC_FMT " rate=%u/%ds frames=%lu kind=%s type=%s "
+         "src=" MAC_FMT " as=%s%s reason=%u",
+         key, MAC_ARGS(alert->addr), flood->peak, DEAUTH_WINDOW_BUCKETS,
+         (unsigned long)flood->frames, kind, type, MAC_ARGS(flood->source), role,
+         flood->sources_vary ? " sources=varied" : "", flood->reason);
+  if (alert->entry.has_peer) {
+    printf(" %s=" MAC_FMT, alert->per_target ? "bssid" : "target", MAC_ARGS(alert->entry.peer));
+  }
+  printf("\n");
+  TERMINAL_VIEW_ADD_TEXT("Deauth flood!\n%s " MAC_FMT "\n%s %s, %u/%ds\nfrom " MAC_FMT " (%s)\n",
+                         key, MAC_ARGS(alert->addr), kind, type, flood->peak,
+                         DEAUTH_WINDOW_BUCKETS, MAC_ARGS(flood->source), role);
+}
+
+static void deauth_queue_alert(deauth_flood_event_t event, bool per_target, const uint8_t *addr,
+                               const deauth_entry_t *entry) {
+  deauth_alert_t alert = {.event = event, .per_target = per_target, .entry = *entry};
+  memcpy(alert.addr, addr, 6);
+  if (event == DEAUTH_FLOOD_STARTED) {
+    deauth_alerts++;
+  }
+  if (xQueueSend(deauth_queue, &alert, 0) != pdTRUE) {
+    deauth_dropped++;
+  }
+}
+
+typedef struct {
+  uint32_t now;
+  bool per_target;
+  deauth_alert_t ended[4];
+  int count;
+} deauth_sweep_t;
+
+static void deauth_expire(const uint8_t mac[6], void *value, void *ctx) {
+  deauth_sweep_t *sweep = ctx;
+  deauth_entry_t *entry = value;
+  if (sweep->count == 4 ||
+      deauth_flood_expire(&entry->flood, sweep->now, deauth_threshold) != DEAUTH_FLOOD_ENDED) {
+    return;
+  }
+  deauth_alert_t *alert = &sweep->ended[sweep->count++];
+  alert->event = DEAUTH_FLOOD_ENDED;
+  alert->per_target = sweep->per_target;
+  memcpy(alert->addr, mac, 6);
+  alert->entry = *entry;
+}
+
+// Ends floods whose frames stopped arriving; the rest are caught next time.
+static void deauth_sweep(mac_table_t *table, bool per_target) {
+  deauth_sweep_t sweep = {.now = deauth_bucket_now(), .per_target = per_target};
+  taskENTER_CRITICAL(&deauth_lock);
+  mac_table_foreach(table, deauth_expire, &sweep);
+  taskEXIT_CRITICAL(&deauth_lock);
+  for (int i = 0; i < sweep.count; i++) {
+    deauth_print(&sweep.ended[i]);
+  }
+}
+
+// Prints alerts away from the Wi-Fi task and checks for floods that have
+// died down once a second. Lives for the rest of the session once the
+// watch has been started.
+static void deauth_watch_task(void *arg) {
+  deauth_alert_t alert;
+  while (1) {
+    if (xQueueReceive(deauth_queue, &alert, pdMS_TO_TICKS(DEAUTH_WINDOW_BUCKET_MS)) == pdTRUE) {
+      deauth_print(&alert);
+    }
+    if (deauth_active) {
+      deauth_sweep(&deauth_bssids, false);
+      deauth_sweep(&deauth_targets, true);
+    }
+  }
+}
+
+void deauth_watch_record(const wifi_promiscuous_pkt_t *pkt) {
+  const uint8_t *frame = pkt->payload;
+  if (pkt->rx_ctrl.sig_len < DEAUTH_FRAME_MIN_LEN) {
+    return;
+  }
+  uint8_t subtype = frame[0] >> 4;
+  if ((frame[0] & 0x0C) != 0 ||
+      (subtype != FRAME_SUBTYPE_DEAUTH && subtype != FRAME_SUBTYPE_DISASSOC)) {
+    return;
+  }
+
+  const uint8_t *target = frame + 4;
+  const uint8_t *bssid = frame + 16;
+  deauth_frame_t info = {
+      .source = frame + 10,
+      .broadcast = (target[0] & 0x01) != 0,
+      // Management frame protection encrypts the reason code.
+      .reason = (frame[1] & 0x40) ? 0 : frame[24] | frame[25] << 8,
+      .subtype = subtype,
+  };
+  uint32_t now = deauth_bucket_now();
+
+  deauth_flood_event_t bssid_event, target_event = DEAUTH_FLOOD_NONE;
+  deauth_entry_t bssid_copy, target_copy;
+  taskENTER_CRITICAL(&deauth_lock);
+  deauth_frames++;
+  deauth_entry_t *entry = mac_table_upsert(&deauth_bssids, bssid, NULL);
+  if (!info.broadcast) {
+    memcpy(entry->peer, target, 6);
+    entry->has_peer = true;
+  }
+  bssid_event = deauth_flood_record(&entry->flood, &info, now, deauth_threshold);
+  if (bssid_event != DEAUTH_FLOOD_NONE) {
+    bssid_copy = *entry;
+  }
+
+  if (!info.broadcast) {
+    entry = mac_table_upsert(&deauth_targets, target, NULL);
+    memcpy(entry->peer, bssid, 6);
+    entry->has_peer = true;
+    target_event = deauth_flood_record(&entry->flood, &info, now, deauth_threshold);
+    if (target_event != DEAUTH_FLOOD_NONE) {
+      target_copy = *entry;
+    }
+  }
+  taskEXIT_CRITICAL(&deauth_lock);
+
+  if (bssid_event != DEAUTH_FLOOD_NONE) {
+    deauth_queue_alert(bssid_event, false, bssid, &bssid_copy);
+  }
+  if (target_event != DEAUTH_FLOOD_NONE) {
+    deauth_queue_alert(target_event, true, target, &target_copy);
+  }
+}
+
+static void deauth_rx(void *buf, wifi_promiscuous_pkt_type_t type) {
+  deauth_watch_record((const wifi_promiscuous_pkt_t *)buf);
+}
+
+static esp_err_t deauth_tables_reset(void) {
+  if (deauth_bssids.slots == NULL) {
+    if (mac_table_init(&deauth_bssids, CONFIG_DEAUTHWATCH_ENTRIES, sizeof(deauth_entry_t)) !=
+            ESP_OK ||
+        mac_table_init(&deauth_targets, CONFIG_DEAUTHWATCH_ENTRIES, sizeof(deauth_entry_t)) !=
+            ESP_OK) {
+      mac_table_free(&deauth_bssids);
+      return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+  }
+  taskENTER_CRITICAL(&deauth_lock);
+  mac_table_clear(&deauth_bssids);
+  mac_table_clear(&deauth_targets);
+  taskEXIT_CRITICAL(&deauth_lock);
+  return ESP_OK;
+}
+
+esp_err_t deauth_watch_start(uint16_t threshold) {
+  if (deauth_active) {
+    return ESP_OK;
+  }
+  if (deauth_tables_reset() != ESP_OK) {
+    ESP_LOGE(TAG, "No memory for the deauth tables");
+    return ESP_ERR_NO_MEM;
+  }
+  if (deauth_queue == NULL) {
+    deauth_queue = xQueueCreate(DEAUTH_WATCH_QUEUE_LEN, sizeof(deauth_alert_t));
+    if (deauth_queue == NULL ||
+        xTaskCreate(deauth_watch_task, "deauthwatch", 3072, NULL, 1, NULL) != pdPASS) {
+      ESP_LOGE(TAG, "Failed to start the alert worker");
+      if (deauth_queue != NULL) {
+        vQueueDelete(deauth_queue);
+        deauth_queue = NULL;
+      }
+      return ESP_ERR_NO_MEM;
+    }
+  }
+  deauth_threshold = threshold ? threshold : CONFIG_DEAUTHWATCH_THRESHOLD;
+  deauth_frames = 0;
+  deauth_alerts = 0;
+  deauth_dropped = 0;
+
+  wifi_manager_start_monitor_mode(DEAUTH_WATCH_CONSUMER,
+                                  FRAME_MGMT_BIT(FRAME_SUBTYPE_DEAUTH) |
+                                      FRAME_MGMT_BIT(FRAME_SUBTYPE_DISASSOC),
+                                  deauth_rx);
+  esp_err_t ret = channel_hopper_acquire();
+  if (ret != ESP_OK) {
+    wifi_manager_stop_monitor_consumer(DEAUTH_WATCH_CONSUMER);
+    return ret;
+  }
+  deauth_active = true;
+  return ESP_OK;
+}
+
+void deauth_watch_stop(void) {
+  if (!deauth_active) {
+    return;
+  }
+  wifi_manager_stop_monitor_consumer(DEAUTH_WATCH_CONSUMER);
+  channel_hopper_release();
+  deauth_active = false;
+}
+
+bool deauth_watch_running(void) { return deauth_active; }
+
+void deauth_watch_get_stats(deauth_watch_stats_t *stats) {
+  taskENTER_CRITICAL(&deauth_lock);
+  stats->frames = deauth_frames;
+  mac_table_get_stats(&deauth_bssids, &stats->bssids);
+  mac_table_get_stats(&deauth_targets, &stats->targets);
+  taskEXIT_CRITICAL(&deauth_lock);
+  stats->alerts = deauth_alerts;
+  stats->dropped = deauth_dropped;
+  stats->threshold = deauth_threshold;
+}
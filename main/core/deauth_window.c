@@ -0,0 +1,87 @@
+// deauth_window.c
+//
+// Keep this file free of ESP-IDF headers; it is also built on the host.
+
+#include "core/deauth_window.h"
+#include <string.h>
+
+uint16_t deauth_window_advance(deauth_window_t *window, uint32_t now) {
+  if (now <= window->head) {
+    return window->sum;
+  }
+  uint32_t steps = now - window->head;
+  if (steps >= DEAUTH_WINDOW_BUCKETS) {
+    memset(window->counts, 0, sizeof(window->counts));
+    window->sum = 0;
+  } else {
+    // At most DEAUTH_WINDOW_BUCKETS - 1 buckets slide out per call.
+    for (uint32_t i = 1; i <= steps; i++) {
+      uint8_t *count = &window->counts[(window->head + i) % DEAUTH_WINDOW_BUCKETS];
+      window->sum -= *count;
+      *count = 0;
+    }
+  }
+  window->head = now;
+  return window->sum;
+}
+
+uint16_t deauth_window_add(deauth_window_t *window, uint32_t now) {
+  deauth_window_advance(window, now);
+  uint8_t *count = &window->counts[window->head % DEAUTH_WINDOW_BUCKETS];
+  if (*count < UINT8_MAX) {
+    (*count)++;
+    window->sum++;
+  }
+  return window->sum;
+}
+
+static deauth_flood_event_t flood_check(deauth_flood_t *flood, uint16_t rate,
+                                        uint16_t threshold) {
+  if (flood->flooding) {
+    if (rate > flood->peak) {
+      flood->peak = rate;
+    }
+    if (rate < (threshold + 1) / 2) {
+      flood->flooding = false;
+      return DEAUTH_FLOOD_ENDED;
+    }
+  } else if (rate >= threshold) {
+    flood->flooding = true;
+    flood->peak = rate;
+    return DEAUTH_FLOOD_STARTED;
+  }
+  return DEAUTH_FLOOD_NONE;
+}
+
+deauth_flood_event_t deauth_flood_record(deauth_flood_t *flood,
+                                         const deauth_frame_t *frame,
+                                         uint32_t now, uint16_t threshold) {
+  if (!flood->flooding && deauth_window_advance(&flood->window, now) == 0) {
+    flood->frames = 0;
+    flood->broadcast = 0;
+    flood->peak = 0;
+    flood->sources_vary = false;
+    memcpy(flood->source, frame->source, 6);
+  }
+
+  flood->frames++;
+  if (frame->broadcast) {
+    flood->broadcast++;
+  }
+  if (memcmp(flood->source, frame->source, 6) != 0) {
+    flood->sources_vary = true;
+    memcpy(flood->source, frame->source, 6);
+  }
+  flood->reason = frame->reason;
+  flood->subtype = frame->subtype;
+
+  return flood_check(flood, deauth_window_add(&flood->window, now), threshold);
+}
+
+deauth_flood_event_t deauth_flood_expire(deauth_flood_t *flood, uint32_t now,
+                                         uint16_t threshold) {
+  if (!flood->flooding) {
+    return DEAUTH_FLOOD_NONE;
+  }
+  return flood_check(flood, deauth_window_advance(&flood->window, now), threshold);
+}
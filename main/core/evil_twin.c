@@ -0,0 +1,179 @@
+// evil_twin.c
+
+#include "core/evil_twin.h"
+#include "core/channel_hopper.h"
+#include "core/frame_dispatch.h"
+#include "core/ieee80211_ie.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "managers/views/terminal_screen.h"
+#include "managers/wifi_manager.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TAG "EvilTwin"
+#define EVIL_TWIN_CONSUMER "evilwatch"
+#define EVIL_TWIN_QUEUE_LEN 16
+
+#ifndef CONFIG_EVILWATCH_MAX_APS
+#define CONFIG_EVILWATCH_MAX_APS 512
+#endif
+
+typedef struct {
+  ssid_map_alert_t alert;
+  char ssid[IEEE80211_SSID_MAX_LEN + 1];
+  int8_t rssi;
+} evil_twin_event_t;
+
+static ssid_map_t evil_twin_map;
+static portMUX_TYPE evil_twin_lock = portMUX_INITIALIZER_UNLOCKED;
+static QueueHandle_t evil_twin_queue = NULL;
+static uint32_t evil_twin_dropped = 0;
+static bool evil_twin_active = false;
+
+static void format_reasons(uint8_t reasons, char *out, size_t len) {
+  snprintf(out, len, "%s%s%s", (reasons & SSID_MAP_MISMATCH_SECURITY) ? "security," : "",
+           (reasons & SSID_MAP_MISMATCH_VENDOR) ? "vendor," : "",
+           (reasons & SSID_MAP_MISMATCH_CHANNEL) ? "channel," : "");
+  size_t end = strlen(out);
+  if (end > 0) {
+    out[end - 1] = '\0';
+  }
+}
+
+static void evil_twin_print(const evil_twin_event_t *event) {
+  const ssid_map_alert_t *alert = &event->alert;
+  const uint8_t *a = alert->ap.bssid;
+  const uint8_t *b = alert->other.bssid;
+  char reasons[32];
+  format_reasons(alert->reasons, reasons, sizeof(reasons));
+
+  printf("EVILWATCH ssid=\"%s\" bssid=%02x:%02x:%02x:%02x:%02x:%02x ch=%u sec=%s rssi=%d "
+         "vs bssid=%02x:%02x:%02x:%02x:%02x:%02x ch=%u sec=%s reasons=%s aps=%u%s\n",
+         event->ssid, a[0], a[1], a[2], a[3], a[4], a[5], alert->ap.channel,
+         ieee80211_security_name(alert->ap.security), event->rssi, b[0], b[1], b[2], b[3],
+         b[4], b[5], alert->other.channel, ieee80211_security_name(alert->other.security),
+         reasons, alert->aps, alert->changed ? " changed" : "");
+  TERMINAL_VIEW_ADD_TEXT("Possible evil twin:\n'%s'\n%02x:%02x:%02x:%02x:%02x:%02x ch %u %s\n"
+                         "vs %02x:%02x:%02x:%02x:%02x:%02x ch %u %s\n(%s)\n",
+                         event->ssid, a[0], a[1], a[2], a[3], a[4], a[5], alert->ap.channel,
+                         ieee80211_security_name(alert->ap.security), b[0], b[1], b[2], b[3],
+                         b[4], b[5], alert->other.channel,
+                         ieee80211_security_name(alert->other.security), reasons);
+}
+
+// Prints alerts away from the Wi-Fi task. Lives for the rest of the session
+// once the watch has been started.
+static void evil_twin_task(void *arg) {
+  evil_twin_event_t event;
+  while (1) {
+    if (xQueueReceive(evil_twin_queue, &event, portMAX_DELAY) == pdTRUE) {
+      evil_twin_print(&event);
+    }
+  }
+}
+
+void evil_twin_record(const wifi_promiscuous_pkt_t *pkt) {
+  ieee80211_ies_t ies;
+  if (!ieee80211_parse_mgmt(pkt->payload, pkt->rx_ctrl.sig_len, &ies) || !ies.has_ssid) {
+    return;
+  }
+
+  // Hidden networks beacon an empty or zeroed SSID.
+  bool hidden = true;
+  for (uint8_t i = 0; i < ies.ssid_len; i++) {
+    if (ies.ssid[i] != 0) {
+      hidden = false;
+      break;
+    }
+  }
+  if (hidden) {
+    return;
+  }
+
+  ssid_map_ap_t ap = {
+      .security = ieee80211_security(&ies),
+      .channel = ies.channel ? ies.channel : pkt->rx_ctrl.channel,
+  };
+  memcpy(ap.bssid, pkt->payload + 16, 6);
+
+  evil_twin_event_t event;
+  taskENTER_CRITICAL(&evil_twin_lock);
+  bool alert = ssid_map_observe(&evil_twin_map, ies.ssid, ies.ssid_len, &ap, &event.alert);
+  taskEXIT_CRITICAL(&evil_twin_lock);
+  if (!alert) {
+    return;
+  }
+
+  ieee80211_ssid_copy(&ies, event.ssid);
+  event.rssi = pkt->rx_ctrl.rssi;
+  if (xQueueSend(evil_twin_queue, &event, 0) != pdTRUE) {
+    evil_twin_dropped++;
+  }
+}
+
+static void evil_twin_rx(void *buf, wifi_promiscuous_pkt_type_t type) {
+  evil_twin_record((const wifi_promiscuous_pkt_t *)buf);
+}
+
+esp_err_t evil_twin_start(void) {
+  if (evil_twin_active) {
+    return ESP_OK;
+  }
+  if (evil_twin_map.aps == NULL) {
+    if (!ssid_map_init(&evil_twin_map, CONFIG_EVILWATCH_MAX_APS,
+                       CONFIG_EVILWATCH_MAX_APS / 2)) {
+      ESP_LOGE(TAG, "No memory for the SSID map");
+      return ESP_ERR_NO_MEM;
+    }
+  } else {
+    taskENTER_CRITICAL(&evil_twin_lock);
+    ssid_map_clear(&evil_twin_map);
+    taskEXIT_CRITICAL(&evil_twin_lock);
+  }
+  if (evil_twin_queue == NULL) {
+    evil_twin_queue = xQueueCreate(EVIL_TWIN_QUEUE_LEN, sizeof(evil_twin_event_t));
+    if (evil_twin_queue == NULL ||
+        xTaskCreate(evil_twin_task, "evilwatch", 3072, NULL, 1, NULL) != pdPASS) {
+      ESP_LOGE(TAG, "Failed to start the alert worker");
+      if (evil_twin_queue != NULL) {
+        vQueueDelete(evil_twin_queue);
+        evil_twin_queue = NULL;
+      }
+      return ESP_ERR_NO_MEM;
+    }
+  }
+  evil_twin_dropped = 0;
+
+  wifi_manager_start_monitor_mode(EVIL_TWIN_CONSUMER,
+                                  FRAME_MGMT_BIT(FRAME_SUBTYPE_BEACON) |
+                                      FRAME_MGMT_BIT(FRAME_SUBTYPE_PROBE_RESP),
+                                  evil_twin_rx);
+  esp_err_t ret = channel_hopper_acquire();
+  if (ret != ESP_OK) {
+    wifi_manager_stop_monitor_consumer(EVIL_TWIN_CONSUMER);
+    return ret;
+  }
+  evil_twin_active = true;
+  return ESP_OK;
+}
+
+void evil_twin_stop(void) {
+  if (!evil_twin_active) {
+    return;
+  }
+  wifi_manager_stop_monitor_consumer(EVIL_TWIN_CONSUMER);
+  channel_hopper_release();
+  evil_twin_active = false;
+}
+
+bool evil_twin_running(void) { return evil_twin_active; }
+
+void evil_twin_get_stats(ssid_map_stats_t *stats, uint32_t *dropped) {
+  taskENTER_CRITICAL(&evil_twin_lock);
+  ssid_map_get_stats(&evil_twin_map, stats);
+  taskEXIT_CRITICAL(&evil_twin_lock);
+  *dropped = evil_twin_dropped;
+}
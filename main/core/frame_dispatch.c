@@ -0,0 +1,207 @@
+// frame_dispatch.c
+
+#include "core/frame_dispatch.h"
+#include "core/channel_hopper.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+typedef struct {
+  char name[FRAME_DISPATCH_NAME_LEN];
+  frame_consumer_cb_t callback; // NULL while the slot is free
+  uint64_t mask;
+  uint32_t hits;
+  uint64_t cycles;
+} frame_consumer_t;
+
+_Static_assert(FRAME_DISPATCH_MAX_CONSUMERS <= 8,
+               "class table entries are one byte wide");
+
+static frame_consumer_t consumers[FRAME_DISPATCH_MAX_CONSUMERS];
+// Bit i of entry c is set when consumer slot i wants frame class c.
+static uint8_t class_consumers[64];
+static uint32_t frames_seen = 0;
+static uint32_t frames_unclaimed = 0;
+static portMUX_TYPE dispatch_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Called with dispatch_lock held.
+static void frame_dispatch_rebuild(void) {
+  for (int c = 0; c < 64; c++) {
+    uint8_t slots = 0;
+    for (int i = 0; i < FRAME_DISPATCH_MAX_CONSUMERS; i++) {
+      if (consumers[i].callback != NULL && (consumers[i].mask >> c) & 1) {
+        slots |= 1 << i;
+      }
+    }
+    class_consumers[c] = slots;
+  }
+}
+
+static int frame_dispatch_find(const char *name) {
+  for (int i = 0; i < FRAME_DISPATCH_MAX_CONSUMERS; i++) {
+    if (consumers[i].callback != NULL &&
+        strncmp(consumers[i].name, name, FRAME_DISPATCH_NAME_LEN) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+esp_err_t frame_dispatch_add(const char *name, uint64_t mask,
+                             frame_consumer_cb_t callback) {
+  if (name == NULL || callback == NULL || mask == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  esp_err_t ret = ESP_OK;
+  taskENTER_CRITICAL(&dispatch_lock);
+  int slot = frame_dispatch_find(name);
+  if (slot < 0) {
+    for (int i = 0; i < FRAME_DISPATCH_MAX_CONSUMERS; i++) {
+      if (consumers[i].callback == NULL) {
+        slot = i;
+        memset(&consumers[i], 0, sizeof(consumers[i]));
+        strncpy(consumers[i].name, name, FRAME_DISPATCH_NAME_LEN - 1);
+        break;
+      }
+    }
+  }
+  if (slot >= 0) {
+    consumers[slot].mask = mask;
+    consumers[slot].callback = callback;
+    frame_dispatch_rebuild();
+  } else {
+    ret = ESP_ERR_NO_MEM;
+  }
+  taskEXIT_CRITICAL(&dispatch_lock);
+  return ret;
+}
+
+esp_err_t frame_dispatch_remove(const char *name) {
+  esp_err_t ret = ESP_ERR_NOT_FOUND;
+  taskENTER_CRITICAL(&dispatch_lock);
+  int slot = frame_dispatch_find(name);
+  if (slot >= 0) {
+    consumers[slot].callback = NULL;
+    consumers[slot].mask = 0;
+    frame_dispatch_rebuild();
+    ret = ESP_OK;
+  }
+  taskEXIT_CRITICAL(&dispatch_lock);
+  return ret;
+}
+
+void frame_dispatch_clear(void) {
+  taskENTER_CRITICAL(&dispatch_lock);
+  for (int i = 0; i < FRAME_DISPATCH_MAX_CONSUMERS; i++) {
+    consumers[i].callback = NULL;
+    consumers[i].mask = 0;
+  }
+  memset(class_consumers, 0, sizeof(class_consumers));
+  taskEXIT_CRITICAL(&dispatch_lock);
+}
+
+uint64_t frame_dispatch_mask(void) {
+  uint64_t mask = 0;
+  taskENTER_CRITICAL(&dispatch_lock);
+  for (int i = 0; i < FRAME_DISPATCH_MAX_CONSUMERS; i++) {
+    if (consumers[i].callback != NULL) {
+      mask |= consumers[i].mask;
+    }
+  }
+  taskEXIT_CRITICAL(&dispatch_lock);
+  return mask;
+}
+
+int frame_dispatch_count(void) {
+  int count = 0;
+  for (int i = 0; i < FRAME_DISPATCH_MAX_CONSUMERS; i++) {
+    if (consumers[i].callback != NULL) {
+      count++;
+    }
+  }
+  return count;
+}
+
+void frame_dispatch_rx(void *buf, wifi_promiscuous_pkt_type_t type) {
+  const wifi_promiscuous_pkt_t *pkt = (const wifi_promiscuous_pkt_t *)buf;
+
+  frames_seen++;
+  if (type == WIFI_PKT_MISC || pkt->rx_ctrl.sig_len < 2) {
+    frames_unclaimed++;
+    return;
+  }
+
+  uint8_t fc = pkt->payload[0];
+  uint8_t frame_class = FRAME_CLASS((fc >> 2) & 0x3, fc >> 4);
+  channel_hopper_note_frame(frame_class ==
+                            FRAME_CLASS(FRAME_TYPE_MGMT, FRAME_SUBTYPE_BEACON));
+
+  uint8_t slots = class_consumers[frame_class];
+  if (slots == 0) {
+    frames_unclaimed++;
+    return;
+  }
+
+  while (slots != 0) {
+    int i = __builtin_ctz(slots);
+    slots &= slots - 1;
+
+    // Re-checked in case the slot was reused since the table was read.
+    frame_consumer_cb_t callback = consumers[i].callback;
+    if (callback == NULL || ((consumers[i].mask >> frame_class) & 1) == 0) {
+      continue;
+    }
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    callback(buf, type);
+    consumers[i].cycles += esp_cpu_get_cycle_count() - start;
+    consumers[i].hits++;
+  }
+}
+
+int frame_dispatch_get_stats(frame_consumer_stats_t *stats, int max,
+                             frame_dispatch_totals_t *totals) {
+  uint32_t ticks_per_us = esp_rom_get_cpu_ticks_per_us();
+  int count = 0;
+
+  if (ticks_per_us == 0) {
+    ticks_per_us = 1;
+  }
+
+  for (int i = 0; i < FRAME_DISPATCH_MAX_CONSUMERS && count < max; i++) {
+    frame_consumer_t consumer = consumers[i];
+    if (consumer.callback == NULL) {
+      continue;
+    }
+
+    frame_consumer_stats_t *out = &stats[count++];
+    memcpy(out->name, consumer.name, sizeof(out->name));
+    out->mask = consumer.mask;
+    out->hits = consumer.hits;
+    out->total_us = consumer.cycles / ticks_per_us;
+    out->avg_us_x100 =
+        consumer.hits ? (uint32_t)(consumer.cycles * 100 / ticks_per_us /
+                                   consumer.hits)
+                      : 0;
+  }
+
+  if (totals != NULL) {
+    totals->frames = frames_seen;
+    totals->unclaimed = frames_unclaimed;
+  }
+  return count;
+}
+
+void frame_dispatch_reset_stats(void) {
+  taskENTER_CRITICAL(&dispatch_lock);
+  for (int i = 0; i < FRAME_DISPATCH_MAX_CONSUMERS; i++) {
+    consumers[i].hits = 0;
+    consumers[i].cycles = 0;
+  }
+  frames_seen = 0;
+  frames_unclaimed = 0;
+  taskEXIT_CRITICAL(&dispatch_lock);
+}
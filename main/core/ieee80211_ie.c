@@ -0,0 +1,257 @@
+// ieee80211_ie.c
+
+#include "core/ieee80211_ie.h"
+#include <string.h>
+
+// Allowed element lengths. Elements without an entry (max == 0) may have any
+// length; the table keeps the rules the PCAP length check used to switch on.
+typedef struct {
+  uint8_t min;
+  uint8_t max;
+} ie_length_rule_t;
+
+static const ie_length_rule_t ie_length_rules[256] = {
+    [9] = {4, 255},    // Hopping Pattern Table
+    [32] = {1, 1},     // Power Constraint
+    [33] = {2, 2},     // Power Capability
+    [35] = {2, 2},     // TPC Report
+    [36] = {3, 255},   // Channels
+    [37] = {3, 3},     // Channel Switch Announcement
+    [38] = {3, 255},   // Measurement Request
+    [39] = {3, 255},   // Measurement Report
+    [41] = {7, 255},   // IBSS DFS
+    [42] = {1, 1},     // ERP Information
+    [45] = {26, 26},   // HT Capabilities
+    [47] = {22, 255},  // HT Operation (pre-standard)
+    [48] = {2, 255},   // RSN
+    [50] = {1, 255},   // Extended Supported Rates
+    [51] = {3, 255},   // AP Channel Report
+    [61] = {22, 255},  // HT Operation
+    [62] = {1, 1},     // Secondary Channel Offset
+    [74] = {14, 14},   // Overlapping BSS Scan Parameters
+    [93] = {4, 255},   // WNM-Sleep Mode
+    [107] = {1, 255},  // Interworking
+    [127] = {1, 255},  // Extended Capabilities
+    [142] = {3, 255},  // Page Slice
+    [191] = {12, 12},  // VHT Capabilities
+    [192] = {5, 255},  // VHT Operation
+    [195] = {2, 255},  // VHT Transmit Power Envelope
+    [216] = {4, 255},  // Target Wake Time
+    [221] = {3, 255},  // Vendor Specific
+    [232] = {5, 255},  // DMG Operation
+    [235] = {7, 255},  // S1G Beacon Compatibility
+    [255] = {1, 255},  // Extended tag
+};
+
+static const uint8_t microsoft_oui[3] = {0x00, 0x50, 0xf2};
+#define MICROSOFT_OUI_TYPE_WPA 0x01
+#define MICROSOFT_OUI_TYPE_WPS 0x04
+
+bool ieee80211_ie_length_valid(uint8_t id, uint8_t len) {
+  const ie_length_rule_t *rule = &ie_length_rules[id];
+  return rule->max == 0 || (len >= rule->min && len <= rule->max);
+}
+
+void ieee80211_ie_iter_init(ieee80211_ie_iter_t *it, const uint8_t *ies,
+                            size_t len) {
+  it->pos = ies;
+  it->end = ies + len;
+  it->malformed = false;
+}
+
+bool ieee80211_ie_next(ieee80211_ie_iter_t *it, ieee80211_ie_t *ie) {
+  if (it->malformed || it->end - it->pos < 2) {
+    return false;
+  }
+
+  uint8_t id = it->pos[0];
+  uint8_t len = it->pos[1];
+  if (it->end - it->pos - 2 < len || !ieee80211_ie_length_valid(id, len)) {
+    it->malformed = true; // pos stays on the offending element
+    return false;
+  }
+
+  ie->id = id;
+  ie->len = len;
+  ie->data = it->pos + 2;
+  it->pos += 2 + len;
+  return true;
+}
+
+size_t ieee80211_mgmt_ie_offset(const uint8_t *frame, size_t len) {
+  if (len < IEEE80211_MGMT_HDR_LEN || ((frame[0] >> 2) & 0x3) != 0) {
+    return 0;
+  }
+
+  size_t fixed;
+  switch ((frame[0] >> 4) & 0xF) {
+  case 0x0: // Association Request: capability, listen interval
+    fixed = 4;
+    break;
+  case 0x1: // Association Response: capability, status, AID
+  case 0x3: // Reassociation Response
+    fixed = 6;
+    break;
+  case 0x2: // Reassociation Request: capability, listen interval, AP
+    fixed = 10;
+    break;
+  case 0x4: // Probe Request
+    fixed = 0;
+    break;
+  case 0x5: // Probe Response: timestamp, interval, capability
+  case 0x8: // Beacon
+    fixed = 12;
+    break;
+  case 0xb: // Authentication: algorithm, sequence, status
+    fixed = 6;
+    break;
+  default:
+    return 0;
+  }
+
+  size_t offset = IEEE80211_MGMT_HDR_LEN + fixed;
+  return offset <= len ? offset : 0;
+}
+
+void ieee80211_parse_ies(const uint8_t *ies, size_t len, ieee80211_ies_t *out) {
+  ieee80211_ie_iter_t it;
+  ieee80211_ie_t ie;
+  uint8_t ht_channel = 0;
+
+  memset(out, 0, sizeof(*out));
+  ieee80211_ie_iter_init(&it, ies, len);
+
+  while (ieee80211_ie_next(&it, &ie)) {
+    out->ie_count++;
+
+    switch (ie.id) {
+    case IEEE80211_IE_SSID:
+      // Only the first one counts; some frames carry a second, hidden one.
+      if (!out->has_ssid && ie.len <= IEEE80211_SSID_MAX_LEN) {
+        out->ssid = ie.data;
+        out->ssid_len = ie.len;
+        out->has_ssid = true;
+      }
+      break;
+    case IEEE80211_IE_DS_PARAMS:
+      if (ie.len >= 1) {
+        out->channel = ie.data[0];
+      }
+      break;
+    case IEEE80211_IE_HT_OPERATION:
+      ht_channel = ie.data[0];
+      break;
+    case IEEE80211_IE_RSN:
+      out->rsn = ie.data;
+      out->rsn_len = ie.len;
+      break;
+    case IEEE80211_IE_HT_CAP:
+      out->ht_cap = ie.data;
+      break;
+    case IEEE80211_IE_VHT_CAP:
+      out->vht_cap = ie.data;
+      break;
+    case IEEE80211_IE_VENDOR:
+      if (ie.len >= 4 && memcmp(ie.data, microsoft_oui, 3) == 0) {
+        if (ie.data[3] == MICROSOFT_OUI_TYPE_WPA && out->wpa == NULL) {
+          out->wpa = ie.data + 4;
+          out->wpa_len = ie.len - 4;
+        } else if (ie.data[3] == MICROSOFT_OUI_TYPE_WPS && out->wps == NULL) {
+          out->wps = ie.data + 4;
+          out->wps_len = ie.len - 4;
+        }
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  if (out->channel == 0) {
+    out->channel = ht_channel;
+  }
+  out->malformed = it.malformed;
+}
+
+bool ieee80211_parse_mgmt(const uint8_t *frame, size_t len,
+                          ieee80211_ies_t *out) {
+  size_t offset = ieee80211_mgmt_ie_offset(frame, len);
+  if (offset == 0) {
+    memset(out, 0, sizeof(*out));
+    return false;
+  }
+
+  ieee80211_parse_ies(frame + offset, len - offset, out);
+
+  uint8_t subtype = (frame[0] >> 4) & 0xF;
+  if (subtype == 0x8 || subtype == 0x5) {
+    out->capability = frame[IEEE80211_MGMT_HDR_LEN + 10] |
+                      (frame[IEEE80211_MGMT_HDR_LEN + 11] << 8);
+  }
+  return true;
+}
+
+ieee80211_security_t ieee80211_security(const ieee80211_ies_t *ies) {
+  if (ies->rsn != NULL) {
+    return IEEE80211_SECURITY_WPA2;
+  }
+  if (ies->wpa != NULL) {
+    return IEEE80211_SECURITY_WPA;
+  }
+  if (ies->capability & IEEE80211_CAP_PRIVACY) {
+    return IEEE80211_SECURITY_WEP;
+  }
+  return IEEE80211_SECURITY_OPEN;
+}
+
+const char *ieee80211_security_name(ieee80211_security_t security) {
+  switch (security) {
+  case IEEE80211_SECURITY_WEP:
+    return "WEP";
+  case IEEE80211_SECURITY_WPA:
+    return "WPA";
+  case IEEE80211_SECURITY_WPA2:
+    return "WPA2";
+  default:
+    return "OPEN";
+  }
+}
+
+size_t ieee80211_ssid_copy(const ieee80211_ies_t *ies, char *out) {
+  size_t len = ies->has_ssid ? ies->ssid_len : 0;
+
+  while (len > 0 && (ies->ssid[len - 1] == ' ' || ies->ssid[len - 1] == '\t' ||
+                     ies->ssid[len - 1] == '\n' || ies->ssid[len - 1] == '\r')) {
+    len--;
+  }
+  if (len > 0) {
+    memcpy(out, ies->ssid, len);
+  }
+  out[len] = '\0';
+  return len;
+}
+
+bool ieee80211_wps_attr_find(const ieee80211_ies_t *ies, uint16_t attr_id,
+                             const uint8_t **value, uint16_t *value_len) {
+  if (ies->wps == NULL) {
+    return false;
+  }
+
+  const uint8_t *pos = ies->wps;
+  const uint8_t *end = ies->wps + ies->wps_len;
+
+  while (end - pos >= 4) {
+    uint16_t id = (pos[0] << 8) | pos[1];
+    uint16_t len = (pos[2] << 8) | pos[3];
+    if (end - pos - 4 < len) {
+      return false;
+    }
+    if (id == attr_id) {
+      *value = pos + 4;
+      *value_len = len;
+      return true;
+    }
+    pos += 4 + len;
+  }
+  return false;
+}
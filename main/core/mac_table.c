@@ -0,0 +1,163 @@
+// mac_table.c
+
+#include "core/mac_table.h"
+#include "esp_heap_caps.h"
+#include <string.h>
+
+typedef struct {
+  uint8_t mac[6];
+  uint8_t used;
+  uint8_t reserved;
+  uint32_t last_used;
+} mac_entry_t;
+
+static inline mac_entry_t *mac_slot(const mac_table_t *table, uint32_t index) {
+  return (mac_entry_t *)(table->slots + (size_t)(index & table->mask) * table->slot_size);
+}
+
+static inline void *mac_value(mac_entry_t *entry) { return entry + 1; }
+
+// FNV-1a; the low bytes of a MAC are the most random, so every byte counts.
+static uint32_t mac_hash(const uint8_t mac[6]) {
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < 6; i++) {
+    hash = (hash ^ mac[i]) * 16777619u;
+  }
+  return hash ^ (hash >> 15);
+}
+
+esp_err_t mac_table_init(mac_table_t *table, uint32_t capacity, size_t value_size) {
+  uint32_t slots = MAC_TABLE_PROBE;
+  while (slots < capacity) {
+    slots <<= 1;
+  }
+
+  memset(table, 0, sizeof(*table));
+  table->value_size = value_size;
+  table->slot_size = (sizeof(mac_entry_t) + value_size + 3) & ~(size_t)3;
+  table->mask = slots - 1;
+
+  // Large tables go to PSRAM when the board has it.
+  size_t bytes = (size_t)slots * table->slot_size;
+  table->slots = heap_caps_calloc(1, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (table->slots == NULL) {
+    table->slots = heap_caps_calloc(1, bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  }
+  if (table->slots == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+  table->stats.capacity = slots;
+  return ESP_OK;
+}
+
+void mac_table_free(mac_table_t *table) {
+  heap_caps_free(table->slots);
+  memset(table, 0, sizeof(*table));
+}
+
+void mac_table_clear(mac_table_t *table) {
+  if (table->slots == NULL) {
+    return;
+  }
+  memset(table->slots, 0, (size_t)(table->mask + 1) * table->slot_size);
+  uint32_t capacity = table->stats.capacity;
+  memset(&table->stats, 0, sizeof(table->stats));
+  table->stats.capacity = capacity;
+  table->clock = 0;
+}
+
+static mac_entry_t *mac_lookup(mac_table_t *table, const uint8_t mac[6]) {
+  uint32_t start = mac_hash(mac);
+  for (uint32_t i = 0; i < MAC_TABLE_PROBE; i++) {
+    mac_entry_t *entry = mac_slot(table, start + i);
+    if (entry->used && memcmp(entry->mac, mac, 6) == 0) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+void *mac_table_find(mac_table_t *table, const uint8_t mac[6]) {
+  mac_entry_t *entry = mac_lookup(table, mac);
+  if (entry == NULL) {
+    table->stats.misses++;
+    return NULL;
+  }
+  table->stats.hits++;
+  entry->last_used = ++table->clock;
+  return mac_value(entry);
+}
+
+void *mac_table_upsert(mac_table_t *table, const uint8_t mac[6], bool *created) {
+  uint32_t start = mac_hash(mac);
+  mac_entry_t *free_slot = NULL;
+  mac_entry_t *oldest = NULL;
+
+  // One pass finds the entry, or else the first free slot, or else the
+  // least recently used entry to evict.
+  for (uint32_t i = 0; i < MAC_TABLE_PROBE; i++) {
+    mac_entry_t *entry = mac_slot(table, start + i);
+    if (!entry->used) {
+      if (free_slot == NULL) {
+        free_slot = entry;
+      }
+      continue;
+    }
+    if (memcmp(entry->mac, mac, 6) == 0) {
+      table->stats.hits++;
+      entry->last_used = ++table->clock;
+      if (created) {
+        *created = false;
+      }
+      return mac_value(entry);
+    }
+    // Unsigned difference keeps the comparison right across clock wrap.
+    if (oldest == NULL ||
+        table->clock - entry->last_used > table->clock - oldest->last_used) {
+      oldest = entry;
+    }
+  }
+
+  mac_entry_t *entry = free_slot;
+  table->stats.misses++;
+  table->stats.inserts++;
+  if (entry == NULL) {
+    entry = oldest;
+    table->stats.evictions++;
+  } else {
+    table->stats.count++;
+  }
+
+  memcpy(entry->mac, mac, 6);
+  entry->used = 1;
+  entry->last_used = ++table->clock;
+  memset(mac_value(entry), 0, table->value_size);
+  if (created) {
+    *created = true;
+  }
+  return mac_value(entry);
+}
+
+bool mac_table_remove(mac_table_t *table, const uint8_t mac[6]) {
+  mac_entry_t *entry = mac_lookup(table, mac);
+  if (entry == NULL) {
+    return false;
+  }
+  // Lookups scan the whole probe window, so a hole needs no tombstone.
+  entry->used = 0;
+  table->stats.count--;
+  return true;
+}
+
+void mac_table_foreach(mac_table_t *table, mac_table_visit_cb_t visit, void *ctx) {
+  for (uint32_t i = 0; i <= table->mask; i++) {
+    mac_entry_t *entry = mac_slot(table, i);
+    if (entry->used) {
+      visit(entry->mac, mac_value(entry), ctx);
+    }
+  }
+}
+
+void mac_table_get_stats(const mac_table_t *table, mac_table_stats_t *stats) {
+  *stats = table->stats;
+}
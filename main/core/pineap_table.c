@@ -0,0 +1,75 @@
+// pineap_table.c
+//
+// Keep this file free of ESP-IDF headers; it is also built on the host.
+
+#include "core/pineap_table.h"
+#include <ctype.h>
+#include <string.h>
+
+uint32_t pineap_hash_ssid(const char *ssid) {
+  uint32_t hash = 5381;
+  int c;
+  while ((c = (unsigned char)*ssid++)) {
+    hash = ((hash << 5) + hash) + tolower(c); // hash * 33 + c
+  }
+  return hash;
+}
+
+bool pineap_note_ssid(pineap_network_t *network, uint32_t hash, uint32_t now_s,
+                      uint32_t age_s) {
+  int oldest = 0;
+  for (int i = 0; i < network->ssid_count;) {
+    if (now_s - network->ssid_seen_s[i] > age_s) {
+      network->ssid_count--;
+      network->ssid_hashes[i] = network->ssid_hashes[network->ssid_count];
+      network->ssid_seen_s[i] = network->ssid_seen_s[network->ssid_count];
+      continue;
+    }
+    if (network->ssid_hashes[i] == hash) {
+      network->ssid_seen_s[i] = now_s;
+      return false;
+    }
+    if (network->ssid_seen_s[i] < network->ssid_seen_s[oldest]) {
+      oldest = i;
+    }
+    i++;
+  }
+
+  int slot = network->ssid_count < PINEAP_SSIDS_PER_BSSID
+                 ? network->ssid_count++
+                 : oldest;
+  network->ssid_hashes[slot] = hash;
+  network->ssid_seen_s[slot] = now_s;
+  return true;
+}
+
+bool pineap_table_observe(mac_table_t *table, const uint8_t bssid[6],
+                          const char *ssid, int8_t channel, int8_t rssi,
+                          uint32_t now_s, uint32_t age_s,
+                          pineap_alert_t *alert) {
+  uint32_t hash = pineap_hash_ssid(ssid);
+  pineap_network_t *network = mac_table_upsert(table, bssid, NULL);
+  bool flagged = false;
+
+  network->last_channel = channel;
+  network->last_rssi = rssi;
+
+  // Each new SSID of a flagged BSSID is passed on so the report can list
+  // them.
+  if (pineap_note_ssid(network, hash, now_s, age_s)) {
+    flagged = network->ssid_count >= PINEAP_MIN_SSIDS;
+    if (flagged) {
+      memcpy(alert->bssid, bssid, 6);
+      strncpy(alert->ssid, ssid, sizeof(alert->ssid) - 1);
+      alert->ssid[sizeof(alert->ssid) - 1] = '\0';
+      memcpy(alert->previous_ssid, network->last_ssid,
+             sizeof(alert->previous_ssid));
+      alert->live_ssids = network->ssid_count;
+      alert->channel = channel;
+      alert->rssi = rssi;
+    }
+    strncpy(network->last_ssid, ssid, sizeof(network->last_ssid) - 1);
+    network->last_ssid[sizeof(network->last_ssid) - 1] = '\0';
+  }
+  return flagged;
+}
@@ -1,8 +1,10 @@
 #include "core/serial_manager.h"
+#include "core/serial_stream.h"
 #include "core/system_manager.h"
 #include "driver/uart.h"
 #include "driver/usb_serial_jtag.h"
 #include "esp_task_wdt.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include "freertos/task.h"
@@ -12,6 +14,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 
 #if defined(CONFIG_IDF_TARGET_ESP32S3) ||                                      \
     defined(CONFIG_IDF_TARGET_ESP32C3) || defined(CONFIG_IDF_TARGET_ESP32C6)
@@ -20,15 +23,45 @@
 #define JTAG_SUPPORTED 0
 #endif
 
+#ifndef CONFIG_SERIAL_UART_TX_BUFFER_KB
+#define CONFIG_SERIAL_UART_TX_BUFFER_KB 8
+#endif
+#ifndef CONFIG_SERIAL_UART_RX_BUFFER_KB
+#define CONFIG_SERIAL_UART_RX_BUFFER_KB 4
+#endif
+
 #define UART_NUM UART_NUM_0
 #define BUF_SIZE (1024)
 #define SERIAL_BUFFER_SIZE 528
 
+// Baud negotiation: after switching, the probe line is repeated at the new
+// rate until the host answers with SERIAL_BAUD_ACK on a line of its own.
+#define SERIAL_BAUD_PROBE "[BAUD/PROBE]"
+#define SERIAL_BAUD_ACK "ok"
+#define SERIAL_BAUD_PROBE_INTERVAL_MS 500
+#define SERIAL_BAUD_FLUSH_MS 1000
+
 char serial_buffer[SERIAL_BUFFER_SIZE];
 
 // Forward declaration of command handler
 int handle_serial_command(const char *command);
 
+// With framing on, a command's console output goes out as reply frames
+// instead of raw text between capture frames.
+static void run_serial_command(const char *command) {
+  FILE *reply = serial_stream_reply_file();
+  if (reply == NULL) {
+    handle_serial_command(command);
+    return;
+  }
+
+  FILE *console = stdout;
+  stdout = reply;
+  handle_serial_command(command);
+  fflush(reply);
+  stdout = console;
+}
+
 void serial_task(void *pvParameter) {
   uint8_t *data = (uint8_t *)malloc(BUF_SIZE);
   int index = 0;
@@ -54,7 +87,7 @@ void serial_task(void *pvParameter) {
         if (incoming_char == '\n' || incoming_char == '\r') {
           serial_buffer[index] = '\0';
           if (index > 0) {
-            handle_serial_command(serial_buffer);
+            run_serial_command(serial_buffer);
             index = 0;
           }
         } else if (index < SERIAL_BUFFER_SIZE - 1) {
@@ -68,7 +101,7 @@ void serial_task(void *pvParameter) {
     // Check command queue for simulated commands
     SerialCommand command;
     if (xQueueReceive(commandQueue, &command, 0) == pdTRUE) {
-      handle_serial_command(command.command);
+      run_serial_command(command.command);
     }
 
     vTaskDelay(10 / portTICK_PERIOD_MS);
@@ -89,7 +122,10 @@ void serial_manager_init() {
   };
 
   uart_param_config(UART_NUM, &uart_config);
-  uart_driver_install(UART_NUM, BUF_SIZE * 2, 0, 0, NULL, 0);
+  // A TX buffer lets writers queue a whole burst and return instead of
+  // waiting on the 128 byte FIFO, which matters above 921600 baud.
+  uart_driver_install(UART_NUM, CONFIG_SERIAL_UART_RX_BUFFER_KB * 1024,
+                      CONFIG_SERIAL_UART_TX_BUFFER_KB * 1024, 0, NULL, 0);
 
 #if JTAG_SUPPORTED
   usb_serial_jtag_driver_config_t usb_serial_jtag_config = {
@@ -105,6 +141,107 @@ void serial_manager_init() {
   printf("Serial Started...\n");
 }
 
+uint32_t serial_manager_get_baud(void) {
+  uint32_t baud = 0;
+  uart_get_baudrate(UART_NUM, &baud);
+  return baud;
+}
+
+// Reads one line from the UART into line, giving up at the deadline.
+static bool serial_read_line(char *line, size_t size, int64_t deadline_us) {
+  size_t len = 0;
+  uint8_t c;
+
+  while (esp_timer_get_time() < deadline_us) {
+    if (uart_read_bytes(UART_NUM, &c, 1, pdMS_TO_TICKS(20)) != 1) {
+      continue;
+    }
+    if (c == '\n' || c == '\r') {
+      if (len > 0) {
+        line[len] = '\0';
+        return true;
+      }
+      continue;
+    }
+    if (len < size - 1) {
+      line[len++] = (char)c;
+    } else {
+      len = 0; // Too long to be the answer
+    }
+  }
+  return false;
+}
+
+esp_err_t serial_manager_set_baud(uint32_t baud, uint32_t confirm_ms) {
+  if (baud < SERIAL_BAUD_MIN || baud > SERIAL_BAUD_MAX) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  uint32_t previous = serial_manager_get_baud();
+  fflush(stdout);
+  serial_stream_flush(SERIAL_BAUD_FLUSH_MS);
+
+  esp_err_t ret = uart_set_baudrate(UART_NUM, baud);
+  if (ret != ESP_OK) {
+    return ret;
+  }
+  // Whatever arrived while the two ends disagreed is garbage.
+  uart_flush_input(UART_NUM);
+
+  char probe[48];
+  int probe_len =
+      snprintf(probe, sizeof(probe), "\n%s %lu\n", SERIAL_BAUD_PROBE,
+               (unsigned long)baud);
+  int64_t deadline = esp_timer_get_time() + (int64_t)confirm_ms * 1000;
+  char line[16];
+
+  while (esp_timer_get_time() < deadline) {
+    uart_write_bytes(UART_NUM, probe, probe_len);
+
+    int64_t next_probe =
+        esp_timer_get_time() + SERIAL_BAUD_PROBE_INTERVAL_MS * 1000;
+    if (next_probe > deadline) {
+      next_probe = deadline;
+    }
+    if (serial_read_line(line, sizeof(line), next_probe) &&
+        strcasecmp(line, SERIAL_BAUD_ACK) == 0) {
+      return ESP_OK;
+    }
+  }
+
+  // Nobody answered at the new rate; go back so the host is not locked out.
+  uart_wait_tx_done(UART_NUM, pdMS_TO_TICKS(SERIAL_BAUD_FLUSH_MS));
+  uart_set_baudrate(UART_NUM, previous);
+  uart_flush_input(UART_NUM);
+  return ESP_ERR_TIMEOUT;
+}
+
+esp_err_t serial_manager_selftest(uint32_t duration_ms,
+                                  serial_selftest_result_t *result) {
+  // One printable line, so a terminal left open only scrolls.
+  static const char pattern[] =
+      "[SELFTEST] 0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqr\n";
+
+  memset(result, 0, sizeof(*result));
+  result->baud = serial_manager_get_baud();
+  fflush(stdout);
+  serial_stream_flush(SERIAL_BAUD_FLUSH_MS);
+
+  int64_t start = esp_timer_get_time();
+  int64_t end = start + (int64_t)duration_ms * 1000;
+  while (esp_timer_get_time() < end) {
+    int written = uart_write_bytes(UART_NUM, pattern, sizeof(pattern) - 1);
+    if (written < 0) {
+      return ESP_FAIL;
+    }
+    result->bytes += written;
+  }
+  // Count the time to get the buffered tail onto the wire as well.
+  uart_wait_tx_done(UART_NUM, pdMS_TO_TICKS(SERIAL_BAUD_FLUSH_MS));
+  result->elapsed_us = esp_timer_get_time() - start;
+  return ESP_OK;
+}
+
 int handle_serial_command(const char *input) {
   char *input_copy = strdup(input);
   if (input_copy == NULL) {
@@ -0,0 +1,354 @@
+// serial_stream.c
+
+#include "core/serial_stream.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef CONFIG_SERIAL_STREAM_TX_RING_KB
+#define CONFIG_SERIAL_STREAM_TX_RING_KB 16
+#endif
+
+#define SERIAL_STREAM_UART UART_NUM_0
+#define SERIAL_STREAM_RING_SIZE (CONFIG_SERIAL_STREAM_TX_RING_KB * 1024)
+// Largest encoded frame plus slack; every UART write is cut to whole frames
+// so text printed by other tasks can only land between frames.
+#define SERIAL_STREAM_TX_CHUNK 2048
+#define SERIAL_STREAM_TX_IDLE_MS 20
+#define SERIAL_STREAM_TX_PRIORITY 4
+#define SERIAL_STREAM_LOG_LINE 256
+
+// Frame bytes before COBS, and the worst case once encoded with a leading
+// and trailing delimiter.
+#define SERIAL_FRAME_RAW_MAX                                                   \
+  (SERIAL_STREAM_HEADER_LEN + SERIAL_STREAM_MAX_PAYLOAD + SERIAL_STREAM_CRC_LEN)
+#define SERIAL_FRAME_ENCODED_MAX(n) ((n) + (n) / 254 + 1 + 2)
+
+_Static_assert((SERIAL_STREAM_RING_SIZE & (SERIAL_STREAM_RING_SIZE - 1)) == 0,
+               "SERIAL_STREAM_TX_RING_KB must be a power of two");
+_Static_assert(SERIAL_FRAME_ENCODED_MAX(SERIAL_FRAME_RAW_MAX) <
+                   SERIAL_STREAM_TX_CHUNK,
+               "a frame must fit in one UART write");
+
+static const char *SERIAL_STREAM_TAG = "SerialStream";
+
+static uint8_t *tx_ring = NULL;
+static uint8_t *tx_chunk = NULL; // Linear copy handed to the UART driver
+static uint32_t tx_head = 0; // Written by producers under tx_mutex
+static uint32_t tx_tail = 0; // Written by the TX task
+static SemaphoreHandle_t tx_mutex = NULL;
+static TaskHandle_t tx_task = NULL;
+
+static bool framing_enabled = false;
+static uint16_t channel_seq[SERIAL_CHANNEL_COUNT];
+static bool channel_open_pending[SERIAL_CHANNEL_COUNT];
+static serial_stream_stats_t stream_stats;
+
+static FILE *reply_file = NULL;
+static vprintf_like_t previous_vprintf = NULL;
+
+// COBS encoder writing straight into the TX ring.
+typedef struct {
+  uint32_t pos;      // Next free ring position
+  uint32_t code_pos; // Where the current block's length byte goes
+  uint8_t code;
+} cobs_writer_t;
+
+static inline void ring_put(uint32_t pos, uint8_t byte) {
+  tx_ring[pos & (SERIAL_STREAM_RING_SIZE - 1)] = byte;
+}
+
+static void cobs_start(cobs_writer_t *w, uint32_t pos) {
+  ring_put(pos++, 0); // Ends any text that was printed before this frame
+  w->code_pos = pos++;
+  w->pos = pos;
+  w->code = 1;
+}
+
+static void cobs_feed(cobs_writer_t *w, const uint8_t *data, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    if (data[i] == 0) {
+      ring_put(w->code_pos, w->code);
+      w->code_pos = w->pos++;
+      w->code = 1;
+      continue;
+    }
+    ring_put(w->pos++, data[i]);
+    if (++w->code == 0xFF) {
+      ring_put(w->code_pos, w->code);
+      w->code_pos = w->pos++;
+      w->code = 1;
+    }
+  }
+}
+
+static uint32_t cobs_finish(cobs_writer_t *w) {
+  ring_put(w->code_pos, w->code);
+  ring_put(w->pos++, 0);
+  return w->pos;
+}
+
+// Capture channels carry one continuous file each, so losing a frame would
+// corrupt everything after it. Their writers wait for ring space instead;
+// they run on their own tasks and the capture rings in front of them drop
+// whole packets if they fall behind. Log and reply frames are dropped.
+static bool serial_channel_lossless(serial_channel_t channel) {
+  return channel == SERIAL_CHANNEL_PCAP || channel == SERIAL_CHANNEL_CSV;
+}
+
+static esp_err_t serial_stream_send_frame(serial_channel_t channel,
+                                          const uint8_t *payload, size_t len) {
+  if (tx_ring == NULL) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  uint32_t needed = SERIAL_FRAME_ENCODED_MAX(SERIAL_STREAM_HEADER_LEN + len +
+                                             SERIAL_STREAM_CRC_LEN);
+  uint32_t tail;
+  for (;;) {
+    if (xSemaphoreTake(tx_mutex, portMAX_DELAY) != pdTRUE) {
+      return ESP_FAIL;
+    }
+    tail = __atomic_load_n(&tx_tail, __ATOMIC_ACQUIRE);
+    if (SERIAL_STREAM_RING_SIZE - (tx_head - tail) >= needed) {
+      break;
+    }
+    if (!serial_channel_lossless(channel)) {
+      // The number is used up so the host can count the gap.
+      channel_seq[channel]++;
+      stream_stats.frames_dropped++;
+      xSemaphoreGive(tx_mutex);
+      return ESP_ERR_NO_MEM;
+    }
+    stream_stats.tx_waits++;
+    xSemaphoreGive(tx_mutex);
+    xTaskNotifyGive(tx_task);
+    vTaskDelay(1);
+  }
+
+  uint8_t header[SERIAL_STREAM_HEADER_LEN];
+  uint16_t seq = channel_seq[channel]++;
+  header[0] = channel;
+  header[1] = channel_open_pending[channel] ? SERIAL_FRAME_FLAG_OPEN : 0;
+  header[2] = seq & 0xFF;
+  header[3] = seq >> 8;
+  channel_open_pending[channel] = false;
+
+  uint32_t crc = esp_rom_crc32_le(0, header, sizeof(header));
+  crc = esp_rom_crc32_le(crc, payload, len);
+  uint8_t crc_le[SERIAL_STREAM_CRC_LEN] = {crc & 0xFF, (crc >> 8) & 0xFF,
+                                           (crc >> 16) & 0xFF, crc >> 24};
+
+  cobs_writer_t w;
+  cobs_start(&w, tx_head);
+  cobs_feed(&w, header, sizeof(header));
+  cobs_feed(&w, payload, len);
+  cobs_feed(&w, crc_le, sizeof(crc_le));
+  uint32_t head = cobs_finish(&w);
+
+  stream_stats.frames_sent++;
+  stream_stats.bytes_queued += head - tx_head;
+  if (head - tail > stream_stats.ring_high_water) {
+    stream_stats.ring_high_water = head - tail;
+  }
+  __atomic_store_n(&tx_head, head, __ATOMIC_RELEASE);
+  xSemaphoreGive(tx_mutex);
+
+  xTaskNotifyGive(tx_task);
+  return ESP_OK;
+}
+
+static void serial_stream_tx_task(void *pvParameters) {
+  uint8_t *chunk = tx_chunk;
+
+  while (1) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SERIAL_STREAM_TX_IDLE_MS));
+
+    uint32_t head = __atomic_load_n(&tx_head, __ATOMIC_ACQUIRE);
+    uint32_t tail = tx_tail;
+    while (tail != head) {
+      uint32_t len = head - tail;
+      if (len > SERIAL_STREAM_TX_CHUNK) {
+        len = SERIAL_STREAM_TX_CHUNK;
+      }
+      for (uint32_t i = 0; i < len; i++) {
+        chunk[i] = tx_ring[(tail + i) & (SERIAL_STREAM_RING_SIZE - 1)];
+      }
+      // Cut after the last complete frame in the chunk.
+      if (tail + len != head) {
+        while (len > 0 && chunk[len - 1] != 0) {
+          len--;
+        }
+        if (len == 0) {
+          break; // Cannot happen while frames fit in a chunk
+        }
+      }
+      uart_write_bytes(SERIAL_STREAM_UART, (const char *)chunk, len);
+      tail += len;
+      __atomic_store_n(&tx_tail, tail, __ATOMIC_RELEASE);
+    }
+  }
+}
+
+static int serial_stream_log_vprintf(const char *fmt, va_list args) {
+  char line[SERIAL_STREAM_LOG_LINE];
+  int len = vsnprintf(line, sizeof(line), fmt, args);
+  if (len < 0) {
+    return len;
+  }
+  if (len >= (int)sizeof(line)) {
+    len = sizeof(line) - 1;
+  }
+  serial_stream_put(SERIAL_CHANNEL_LOG, line, len);
+  return len;
+}
+
+static int serial_stream_reply_write(void *cookie, const char *data, int len) {
+  serial_stream_put(SERIAL_CHANNEL_REPLY, data, len);
+  return len;
+}
+
+esp_err_t serial_stream_init(void) {
+  if (tx_ring != NULL) {
+    return ESP_OK;
+  }
+
+  if (tx_mutex == NULL) {
+    tx_mutex = xSemaphoreCreateMutex();
+  }
+  tx_ring = malloc(SERIAL_STREAM_RING_SIZE);
+  tx_chunk = malloc(SERIAL_STREAM_TX_CHUNK);
+  if (tx_mutex == NULL || tx_ring == NULL || tx_chunk == NULL) {
+    ESP_LOGE(SERIAL_STREAM_TAG, "Failed to allocate %d byte TX ring",
+             SERIAL_STREAM_RING_SIZE);
+    goto fail;
+  }
+
+  if (xTaskCreate(serial_stream_tx_task, "serial_tx", 3072, NULL,
+                  SERIAL_STREAM_TX_PRIORITY, &tx_task) != pdPASS) {
+    goto fail;
+  }
+  return ESP_OK;
+
+fail:
+  free(tx_ring);
+  free(tx_chunk);
+  tx_ring = NULL;
+  tx_chunk = NULL;
+  return ESP_ERR_NO_MEM;
+}
+
+esp_err_t serial_stream_set_framing(bool enabled) {
+  if (enabled == framing_enabled) {
+    return ESP_OK;
+  }
+
+  if (enabled) {
+    esp_err_t ret = serial_stream_init();
+    if (ret != ESP_OK) {
+      return ret;
+    }
+    if (reply_file == NULL) {
+      reply_file = funopen(NULL, NULL, serial_stream_reply_write, NULL, NULL);
+      if (reply_file != NULL) {
+        setvbuf(reply_file, NULL, _IOLBF, SERIAL_STREAM_LOG_LINE);
+      }
+    }
+    memset(channel_open_pending, 0, sizeof(channel_open_pending));
+    framing_enabled = true;
+    previous_vprintf = esp_log_set_vprintf(serial_stream_log_vprintf);
+  } else {
+    esp_log_set_vprintf(previous_vprintf ? previous_vprintf : vprintf);
+    if (reply_file != NULL) {
+      fflush(reply_file);
+    }
+    framing_enabled = false;
+  }
+  return ESP_OK;
+}
+
+bool serial_stream_framing_enabled(void) { return framing_enabled; }
+
+FILE *serial_stream_reply_file(void) {
+  return framing_enabled ? reply_file : NULL;
+}
+
+void serial_stream_begin(serial_channel_t channel, bool new_capture) {
+  if (!framing_enabled) {
+    const char *mark_begin = "[BUF/BEGIN]";
+    uart_write_bytes(SERIAL_STREAM_UART, mark_begin, strlen(mark_begin));
+    return;
+  }
+  if (new_capture) {
+    channel_open_pending[channel] = true;
+  }
+}
+
+esp_err_t serial_stream_put(serial_channel_t channel, const void *data,
+                            size_t len) {
+  if (!framing_enabled) {
+    uart_write_bytes(SERIAL_STREAM_UART, (const char *)data, len);
+    return ESP_OK;
+  }
+
+  const uint8_t *bytes = data;
+  esp_err_t ret = ESP_OK;
+  while (len > 0) {
+    size_t part = len > SERIAL_STREAM_MAX_PAYLOAD ? SERIAL_STREAM_MAX_PAYLOAD
+                                                  : len;
+    if (serial_stream_send_frame(channel, bytes, part) != ESP_OK) {
+      ret = ESP_ERR_NO_MEM;
+    }
+    bytes += part;
+    len -= part;
+  }
+  return ret;
+}
+
+void serial_stream_end(serial_channel_t channel, bool line_break) {
+  if (!framing_enabled) {
+    const char *mark_close = "[BUF/CLOSE]";
+    uart_write_bytes(SERIAL_STREAM_UART, mark_close, strlen(mark_close));
+    if (line_break) {
+      uart_write_bytes(SERIAL_STREAM_UART, "\n", 1);
+    }
+  }
+}
+
+void serial_stream_get_stats(serial_stream_stats_t *stats) {
+  if (tx_mutex != NULL && xSemaphoreTake(tx_mutex, portMAX_DELAY) == pdTRUE) {
+    *stats = stream_stats;
+    xSemaphoreGive(tx_mutex);
+  } else {
+    *stats = stream_stats;
+  }
+}
+
+esp_err_t serial_stream_flush(uint32_t timeout_ms) {
+  TickType_t start = xTaskGetTickCount();
+  TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+
+  if (reply_file != NULL) {
+    fflush(reply_file);
+  }
+  if (tx_ring != NULL) {
+    while (__atomic_load_n(&tx_tail, __ATOMIC_ACQUIRE) !=
+           __atomic_load_n(&tx_head, __ATOMIC_ACQUIRE)) {
+      if (xTaskGetTickCount() - start >= timeout) {
+        return ESP_ERR_TIMEOUT;
+      }
+      xTaskNotifyGive(tx_task);
+      vTaskDelay(1);
+    }
+  }
+
+  TickType_t elapsed = xTaskGetTickCount() - start;
+  return uart_wait_tx_done(SERIAL_STREAM_UART,
+                           elapsed < timeout ? timeout - elapsed : 0);
+}
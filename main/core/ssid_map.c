@@ -0,0 +1,283 @@
+// ssid_map.c
+//
+// Keep this file free of ESP-IDF headers; it is also built on the host.
+
+#include "core/ssid_map.h"
+#include <stdlib.h>
+#include <string.h>
+
+// One (BSSID, SSID) pair. last_used is 0 for a free slot.
+typedef struct {
+  uint8_t bssid[6];
+  uint8_t security;
+  uint8_t channel;
+  uint32_t ssid_hash;
+  uint32_t last_used;
+  uint8_t alerted; // SSID_MAP_MISMATCH_* already reported for this pair
+} ap_entry_t;
+
+// One SSID and the profile of the first AP heard with it.
+typedef struct {
+  uint32_t hash;
+  uint32_t last_used;
+  uint16_t aps;
+  uint8_t bssid[6];
+  uint8_t security;
+  uint8_t channel;
+} ssid_entry_t;
+
+static uint32_t round_pow2(uint32_t n) {
+  uint32_t slots = SSID_MAP_PROBE;
+  while (slots < n) {
+    slots <<= 1;
+  }
+  return slots;
+}
+
+// Never 0, which marks a free slot.
+static inline uint32_t tick(ssid_map_t *map) {
+  if (++map->clock == 0) {
+    map->clock = 1;
+  }
+  return map->clock;
+}
+
+// FNV-1a; SSIDs are compared byte for byte, as clients do.
+uint32_t ssid_map_hash(const uint8_t *ssid, size_t len) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; i++) {
+    hash = (hash ^ ssid[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static uint32_t ap_hash(const uint8_t bssid[6], uint32_t ssid_hash) {
+  uint32_t hash = ssid_hash;
+  for (int i = 0; i < 6; i++) {
+    hash = (hash ^ bssid[i]) * 16777619u;
+  }
+  return hash ^ (hash >> 15);
+}
+
+static inline ap_entry_t *ap_slot(const ssid_map_t *map, uint32_t index) {
+  return (ap_entry_t *)map->aps + (index & map->ap_mask);
+}
+
+static inline ssid_entry_t *ssid_slot(const ssid_map_t *map, uint32_t index) {
+  return (ssid_entry_t *)map->ssids + (index & map->ssid_mask);
+}
+
+bool ssid_map_init(ssid_map_t *map, uint32_t aps, uint32_t ssids) {
+  memset(map, 0, sizeof(*map));
+  uint32_t ap_slots = round_pow2(aps);
+  uint32_t ssid_slots = round_pow2(ssids);
+  map->aps = calloc(ap_slots, sizeof(ap_entry_t));
+  map->ssids = calloc(ssid_slots, sizeof(ssid_entry_t));
+  if (map->aps == NULL || map->ssids == NULL) {
+    ssid_map_free(map);
+    return false;
+  }
+  map->ap_mask = ap_slots - 1;
+  map->ssid_mask = ssid_slots - 1;
+  map->stats.ap_capacity = ap_slots;
+  map->stats.ssid_capacity = ssid_slots;
+  return true;
+}
+
+void ssid_map_free(ssid_map_t *map) {
+  free(map->aps);
+  free(map->ssids);
+  memset(map, 0, sizeof(*map));
+}
+
+void ssid_map_clear(ssid_map_t *map) {
+  if (map->aps == NULL) {
+    return;
+  }
+  memset(map->aps, 0, (size_t)(map->ap_mask + 1) * sizeof(ap_entry_t));
+  memset(map->ssids, 0, (size_t)(map->ssid_mask + 1) * sizeof(ssid_entry_t));
+  ssid_map_stats_t stats = {.ap_capacity = map->stats.ap_capacity,
+                            .ssid_capacity = map->stats.ssid_capacity};
+  map->stats = stats;
+  map->clock = 0;
+}
+
+// Finds the SSID, or claims a slot for it: a free one, else the least
+// recently heard in the window. *created tells the cases apart.
+static ssid_entry_t *ssid_upsert(ssid_map_t *map, uint32_t hash, bool *created) {
+  ssid_entry_t *victim = NULL;
+  for (uint32_t i = 0; i < SSID_MAP_PROBE; i++) {
+    ssid_entry_t *entry = ssid_slot(map, hash + i);
+    if (entry->last_used == 0) {
+      if (victim == NULL || victim->last_used != 0) {
+        victim = entry;
+      }
+      continue;
+    }
+    if (entry->hash == hash) {
+      entry->last_used = tick(map);
+      *created = false;
+      return entry;
+    }
+    if (victim == NULL || (victim->last_used != 0 &&
+                           map->clock - entry->last_used > map->clock - victim->last_used)) {
+      victim = entry;
+    }
+  }
+
+  if (victim->last_used == 0) {
+    map->stats.ssids++;
+  }
+  memset(victim, 0, sizeof(*victim));
+  victim->hash = hash;
+  victim->last_used = tick(map);
+  *created = true;
+  return victim;
+}
+
+static ssid_entry_t *ssid_find(const ssid_map_t *map, uint32_t hash) {
+  for (uint32_t i = 0; i < SSID_MAP_PROBE; i++) {
+    ssid_entry_t *entry = ssid_slot(map, hash + i);
+    if (entry->last_used != 0 && entry->hash == hash) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+static ap_entry_t *ap_upsert(ssid_map_t *map, const uint8_t bssid[6], uint32_t ssid_hash,
+                             bool *created) {
+  uint32_t start = ap_hash(bssid, ssid_hash);
+  ap_entry_t *victim = NULL;
+  for (uint32_t i = 0; i < SSID_MAP_PROBE; i++) {
+    ap_entry_t *entry = ap_slot(map, start + i);
+    if (entry->last_used == 0) {
+      if (victim == NULL || victim->last_used != 0) {
+        victim = entry;
+      }
+      continue;
+    }
+    if (entry->ssid_hash == ssid_hash && memcmp(entry->bssid, bssid, 6) == 0) {
+      entry->last_used = tick(map);
+      *created = false;
+      return entry;
+    }
+    if (victim == NULL || (victim->last_used != 0 &&
+                           map->clock - entry->last_used > map->clock - victim->last_used)) {
+      victim = entry;
+    }
+  }
+
+  if (victim->last_used == 0) {
+    map->stats.aps++;
+  } else {
+    // The evicted pair no longer counts towards its SSID.
+    ssid_entry_t *ssid = ssid_find(map, victim->ssid_hash);
+    if (ssid != NULL && ssid->aps > 0) {
+      ssid->aps--;
+    }
+    map->stats.evictions++;
+  }
+  memset(victim, 0, sizeof(*victim));
+  memcpy(victim->bssid, bssid, 6);
+  victim->ssid_hash = ssid_hash;
+  victim->last_used = tick(map);
+  *created = true;
+  return victim;
+}
+
+static uint8_t profile_mismatch(const ssid_entry_t *profile, const ssid_map_ap_t *ap) {
+  uint8_t reasons = 0;
+  if (ap->security != profile->security) {
+    reasons |= SSID_MAP_MISMATCH_SECURITY;
+  }
+  // Locally administered addresses say nothing about the vendor; APs use
+  // them for their extra BSSIDs.
+  bool global = !(ap->bssid[0] & 0x02) && !(profile->bssid[0] & 0x02);
+  if (global && memcmp(ap->bssid, profile->bssid, 3) != 0) {
+    reasons |= SSID_MAP_MISMATCH_VENDOR;
+  }
+  if (ap->channel != 0 && profile->channel != 0 && ap->channel != profile->channel) {
+    reasons |= SSID_MAP_MISMATCH_CHANNEL;
+  }
+  return reasons;
+}
+
+static void profile_copy(ssid_map_ap_t *out, const ssid_entry_t *profile) {
+  memcpy(out->bssid, profile->bssid, 6);
+  out->security = profile->security;
+  out->channel = profile->channel;
+}
+
+bool ssid_map_observe(ssid_map_t *map, const uint8_t *ssid, size_t ssid_len,
+                      const ssid_map_ap_t *ap, ssid_map_alert_t *alert) {
+  map->stats.beacons++;
+  uint32_t hash = ssid_map_hash(ssid, ssid_len);
+
+  bool new_ap, new_ssid;
+  ap_entry_t *entry = ap_upsert(map, ap->bssid, hash, &new_ap);
+  bool changed = !new_ap && (entry->security != ap->security || entry->channel != ap->channel);
+  entry->security = ap->security;
+  entry->channel = ap->channel;
+
+  ssid_entry_t *profile = ssid_upsert(map, hash, &new_ssid);
+  if (new_ssid || (profile->aps == 0 && new_ap)) {
+    // The first AP heard with an SSID defines what it should look like.
+    memcpy(profile->bssid, ap->bssid, 6);
+    profile->security = ap->security;
+    profile->channel = ap->channel;
+    profile->aps = 1;
+    return false;
+  }
+  if (new_ap) {
+    profile->aps++;
+  } else if (!changed) {
+    return false;
+  }
+
+  // Each reason is reported once per pair, so an AP cloned onto two
+  // channels does not alert on every beacon.
+  uint8_t reasons = profile_mismatch(profile, ap) & ~entry->alerted;
+  if (reasons != 0) {
+    profile_copy(&alert->other, profile);
+  }
+  if (memcmp(profile->bssid, ap->bssid, 6) == 0) {
+    // The reference AP itself moved; check others against where it is now.
+    profile->security = ap->security;
+    profile->channel = ap->channel;
+  }
+  if (reasons == 0) {
+    return false;
+  }
+
+  entry->alerted |= reasons;
+  alert->reasons = reasons;
+  alert->changed = changed;
+  alert->ap = *ap;
+  alert->aps = profile->aps;
+  map->stats.alerts++;
+  return true;
+}
+
+int ssid_map_lookup(const ssid_map_t *map, const uint8_t *ssid, size_t ssid_len,
+                    ssid_map_ap_t *out, int max) {
+  if (map->aps == NULL) {
+    return 0;
+  }
+  uint32_t hash = ssid_map_hash(ssid, ssid_len);
+  int count = 0;
+  for (uint32_t i = 0; i <= map->ap_mask && count < max; i++) {
+    const ap_entry_t *entry = ap_slot(map, i);
+    if (entry->last_used != 0 && entry->ssid_hash == hash) {
+      memcpy(out[count].bssid, entry->bssid, 6);
+      out[count].security = entry->security;
+      out[count].channel = entry->channel;
+      count++;
+    }
+  }
+  return count;
+}
+
+void ssid_map_get_stats(const ssid_map_t *map, ssid_map_stats_t *stats) {
+  *stats = map->stats;
+}
@@ -0,0 +1,176 @@
+// station_tracker.c
+
+#include "core/station_tracker.h"
+#include "core/frame_dispatch.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "managers/wifi_manager.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TAG "Stations"
+#define STATION_CONSUMER "stations"
+// Each new RSSI sample moves the average 1/8 of the way.
+#define STATION_RSSI_SHIFT 3
+
+#ifndef CONFIG_STATION_TRACKER_ENTRIES
+#define CONFIG_STATION_TRACKER_ENTRIES 512
+#endif
+
+// Everything but the MAC, which is the table key.
+typedef struct {
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint32_t first_seen_ms;
+  uint32_t last_seen_ms;
+  uint32_t frames;
+  uint32_t bytes;
+  int16_t rssi_x16;
+} station_entry_t;
+
+static mac_table_t stations;
+static portMUX_TYPE station_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void station_rx(void *buf, wifi_promiscuous_pkt_type_t type) {
+  station_tracker_record((const wifi_promiscuous_pkt_t *)buf);
+}
+
+esp_err_t station_tracker_start(void) {
+  if (stations.slots == NULL &&
+      mac_table_init(&stations, CONFIG_STATION_TRACKER_ENTRIES, sizeof(station_entry_t)) !=
+          ESP_OK) {
+    ESP_LOGE(TAG, "No memory for the station table");
+    return ESP_ERR_NO_MEM;
+  }
+  wifi_manager_start_monitor_mode(STATION_CONSUMER, FRAME_MASK_DATA, station_rx);
+  return ESP_OK;
+}
+
+void station_tracker_stop(void) { wifi_manager_stop_monitor_consumer(STATION_CONSUMER); }
+
+void station_tracker_reset(void) {
+  taskENTER_CRITICAL(&station_lock);
+  mac_table_clear(&stations);
+  taskEXIT_CRITICAL(&station_lock);
+}
+
+void station_tracker_record(const wifi_promiscuous_pkt_t *pkt) {
+  const uint8_t *frame = pkt->payload;
+  uint16_t len = pkt->rx_ctrl.sig_len;
+  if (stations.slots == NULL || len < 24 || ((frame[0] >> 2) & 0x3) != FRAME_TYPE_DATA) {
+    return;
+  }
+
+  // ToDS/FromDS say which address is the station and which the BSSID.
+  const uint8_t *station, *bssid;
+  bool uplink;
+  switch (frame[1] & 0x03) {
+  case 0x01: // ToDS: station to AP
+    bssid = frame + 4;
+    station = frame + 10;
+    uplink = true;
+    break;
+  case 0x02: // FromDS: AP to station
+    station = frame + 4;
+    bssid = frame + 10;
+    uplink = false;
+    break;
+  case 0x00: // Direct link or IBSS
+    station = frame + 10;
+    bssid = frame + 16;
+    uplink = true;
+    break;
+  default: // WDS bridges carry no station of their own
+    return;
+  }
+  // Group addresses are not stations, and an AP is not its own client.
+  if ((station[0] & 0x01) || memcmp(station, bssid, 6) == 0) {
+    return;
+  }
+
+  uint32_t now_ms = esp_timer_get_time() / 1000;
+  bool created;
+  taskENTER_CRITICAL(&station_lock);
+  station_entry_t *entry = mac_table_upsert(&stations, station, &created);
+  if (created) {
+    entry->first_seen_ms = now_ms;
+  }
+  memcpy(entry->bssid, bssid, 6);
+  entry->last_seen_ms = now_ms;
+  entry->channel = pkt->rx_ctrl.channel;
+  entry->frames++;
+  entry->bytes += len;
+  // Downlink frames carry the AP's signal, not the station's.
+  if (uplink) {
+    int16_t sample = pkt->rx_ctrl.rssi * 16;
+    if (entry->rssi_x16 == 0) {
+      entry->rssi_x16 = sample;
+    } else {
+      entry->rssi_x16 += (sample - entry->rssi_x16) >> STATION_RSSI_SHIFT;
+    }
+  }
+  taskEXIT_CRITICAL(&station_lock);
+}
+
+typedef struct {
+  station_info_t *out;
+  int max;
+  int count;
+} station_snapshot_t;
+
+static void station_copy(const uint8_t mac[6], void *value, void *ctx) {
+  station_snapshot_t *snap = ctx;
+  const station_entry_t *entry = value;
+  if (snap->count == snap->max) {
+    return;
+  }
+  station_info_t *info = &snap->out[snap->count++];
+  memcpy(info->mac, mac, 6);
+  memcpy(info->bssid, entry->bssid, 6);
+  info->first_seen_ms = entry->first_seen_ms;
+  info->last_seen_ms = entry->last_seen_ms;
+  info->frames = entry->frames;
+  info->bytes = entry->bytes;
+  info->rssi_x16 = entry->rssi_x16;
+  info->channel = entry->channel;
+}
+
+static int by_recent(const void *a, const void *b) {
+  const station_info_t *x = a, *y = b;
+  return (y->last_seen_ms > x->last_seen_ms) - (y->last_seen_ms < x->last_seen_ms);
+}
+
+static int by_frames(const void *a, const void *b) {
+  const station_info_t *x = a, *y = b;
+  return (y->frames > x->frames) - (y->frames < x->frames);
+}
+
+// Stations never heard transmitting (average 0) sort last.
+static int by_rssi(const void *a, const void *b) {
+  const station_info_t *x = a, *y = b;
+  int rx = x->rssi_x16 ? x->rssi_x16 : INT16_MIN;
+  int ry = y->rssi_x16 ? y->rssi_x16 : INT16_MIN;
+  return (ry > rx) - (ry < rx);
+}
+
+int station_tracker_snapshot(station_info_t *out, int max, station_sort_t sort) {
+  station_snapshot_t snap = {.out = out, .max = max};
+  taskENTER_CRITICAL(&station_lock);
+  if (stations.slots != NULL) {
+    mac_table_foreach(&stations, station_copy, &snap);
+  }
+  taskEXIT_CRITICAL(&station_lock);
+
+  int (*compare)(const void *, const void *) =
+      sort == STATION_SORT_FRAMES ? by_frames : sort == STATION_SORT_RSSI ? by_rssi : by_recent;
+  qsort(out, snap.count, sizeof(*out), compare);
+  return snap.count;
+}
+
+void station_tracker_get_stats(mac_table_stats_t *stats) {
+  taskENTER_CRITICAL(&station_lock);
+  mac_table_get_stats(&stations, stats);
+  taskEXIT_CRITICAL(&station_lock);
+}
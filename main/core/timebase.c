@@ -0,0 +1,262 @@
+// timebase.c
+
+#include "core/timebase.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#ifdef CONFIG_HAS_RTC_CLOCK
+#include "vendor/drivers/pcf8563.h"
+#endif
+
+#define TAG "Timebase"
+
+// Errors beyond this are stepped out; smaller ones are slewed in a share at
+// a time.
+#define TIMEBASE_STEP_US 1000000LL
+#define TIMEBASE_OFFSET_GAIN 4
+// GPS fixes are filtered over this long before they reach the loop.
+#define TIMEBASE_GPS_WINDOW_US (16 * 1000000LL)
+// Drift is the slope of the offset over at least this long, averaged.
+#define TIMEBASE_DRIFT_WINDOW_US (300 * 1000000LL)
+#define TIMEBASE_DRIFT_WEIGHT 4
+#define TIMEBASE_DRIFT_LIMIT_PPB 500000
+// A better source not heard from for this long can be replaced.
+#define TIMEBASE_STALE_US (10 * 60 * 1000000LL)
+// The system clock is only stepped when it strays further than this.
+#define TIMEBASE_SYSTEM_TOLERANCE_US 50000
+#define TIMEBASE_RTC_WRITE_INTERVAL_US (60 * 60 * 1000000LL)
+
+// Double-buffered like the GPS snapshot: the writer fills the idle slot and
+// then bumps the sequence, so a reader in an ISR never waits on a writer it
+// preempted.
+static timebase_state_t timebase_states[2];
+static uint32_t timebase_seq = 0;
+static portMUX_TYPE timebase_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Writer-side state, guarded by timebase_lock.
+static int64_t drift_anchor_us = 0;
+static int64_t drift_anchor_offset = 0;
+static bool drift_known = false;
+static int64_t gps_window_start_us = 0;
+static int64_t gps_window_best = INT64_MIN;
+static int64_t gps_window_best_us = 0;
+#ifdef CONFIG_HAS_RTC_CLOCK
+static int64_t rtc_written_us = 0;
+#endif
+
+static const char *const source_names[] = {
+    [TIMEBASE_SOURCE_NONE] = "none", [TIMEBASE_SOURCE_SYSTEM] = "system",
+    [TIMEBASE_SOURCE_RTC] = "rtc",   [TIMEBASE_SOURCE_NTP] = "ntp",
+    [TIMEBASE_SOURCE_GPS] = "gps",
+};
+
+const char *timebase_source_name(timebase_source_t source) {
+    return source <= TIMEBASE_SOURCE_GPS ? source_names[source] : "?";
+}
+
+timebase_state_t timebase_get_state(void) {
+    timebase_state_t copy;
+    uint32_t before, after;
+    do {
+        before = __atomic_load_n(&timebase_seq, __ATOMIC_ACQUIRE);
+        copy = timebase_states[before & 1];
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&timebase_seq, __ATOMIC_RELAXED);
+    } while (before != after);
+    return copy;
+}
+
+static int64_t timebase_apply(const timebase_state_t *state, int64_t local_us) {
+    int64_t elapsed = local_us - state->synced_us;
+    return local_us + state->offset_us + elapsed * state->drift_ppb / 1000000000LL;
+}
+
+int64_t timebase_to_utc_us(int64_t local_us) {
+    timebase_state_t state = timebase_get_state();
+    return timebase_apply(&state, local_us);
+}
+
+int64_t timebase_now_utc_us(void) { return timebase_to_utc_us(esp_timer_get_time()); }
+
+static void timebase_publish(const timebase_state_t *state) {
+    uint32_t seq = __atomic_load_n(&timebase_seq, __ATOMIC_RELAXED) + 1;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    timebase_states[seq & 1] = *state;
+    __atomic_store_n(&timebase_seq, seq, __ATOMIC_RELEASE);
+}
+
+#ifdef CONFIG_HAS_RTC_CLOCK
+// Days since 1970-01-01 for a proleptic Gregorian date.
+static int64_t days_from_civil(int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    unsigned yoe = (unsigned)(year - era * 400);
+    unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+static void timebase_write_rtc(int64_t utc_us) {
+    int64_t secs = utc_us / 1000000;
+    int64_t z = secs / 86400 + 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = (unsigned)(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    unsigned month = mp < 10 ? mp + 3 : mp - 9;
+
+    RTC_Date date = {
+        .year = (uint16_t)(yoe + era * 400 + (month <= 2)),
+        .month = month,
+        .day = doy - (153 * mp + 2) / 5 + 1,
+        .hour = secs % 86400 / 3600,
+        .minute = secs % 3600 / 60,
+        .second = secs % 60,
+    };
+    if (pcf8563_set_datetime(&date) != ESP_OK) {
+        ESP_LOGW(TAG, "Could not update the RTC");
+    }
+}
+#endif
+
+// One observation through the loop; called with timebase_lock held.
+static bool timebase_feed(timebase_source_t source, int64_t measured, int64_t local_us) {
+    timebase_state_t state = timebase_get_state();
+    int64_t predicted = timebase_apply(&state, local_us) - local_us;
+    int64_t error = measured - predicted;
+    bool stepped = source != state.source || llabs(error) > TIMEBASE_STEP_US;
+
+    if (stepped) {
+        state.offset_us = measured;
+        state.drift_ppb = 0;
+        state.syncs = 1;
+        drift_known = false;
+        drift_anchor_us = local_us;
+        drift_anchor_offset = measured;
+    } else {
+        state.offset_us = predicted + error / TIMEBASE_OFFSET_GAIN;
+        state.syncs++;
+
+        // The drift window opens once the step has been slewed out.
+        int64_t window = local_us - drift_anchor_us;
+        if (state.syncs <= TIMEBASE_OFFSET_GAIN) {
+            drift_anchor_us = local_us;
+            drift_anchor_offset = state.offset_us;
+        } else if (window >= TIMEBASE_DRIFT_WINDOW_US) {
+            int64_t slope = (state.offset_us - drift_anchor_offset) * 1000000000LL / window;
+            if (drift_known) {
+                slope = state.drift_ppb + (slope - state.drift_ppb) / TIMEBASE_DRIFT_WEIGHT;
+            }
+            if (slope > TIMEBASE_DRIFT_LIMIT_PPB) {
+                slope = TIMEBASE_DRIFT_LIMIT_PPB;
+            } else if (slope < -TIMEBASE_DRIFT_LIMIT_PPB) {
+                slope = -TIMEBASE_DRIFT_LIMIT_PPB;
+            }
+            state.drift_ppb = slope;
+            drift_known = true;
+            drift_anchor_us = local_us;
+            drift_anchor_offset = state.offset_us;
+        }
+    }
+    state.source = source;
+    state.synced_us = local_us;
+    timebase_publish(&state);
+    return stepped;
+}
+
+void timebase_discipline(timebase_source_t source, int64_t utc_us, int64_t local_us) {
+    if (source == TIMEBASE_SOURCE_NONE || source > TIMEBASE_SOURCE_GPS) {
+        return;
+    }
+
+    bool stepped = false;
+    int64_t measured = utc_us - local_us;
+    portENTER_CRITICAL(&timebase_lock);
+    timebase_state_t state = timebase_get_state();
+    bool stale = local_us - state.synced_us > TIMEBASE_STALE_US;
+    if (source < state.source && !stale) {
+        portEXIT_CRITICAL(&timebase_lock);
+        return;
+    }
+
+    if (source != TIMEBASE_SOURCE_GPS || state.source != TIMEBASE_SOURCE_GPS) {
+        stepped = timebase_feed(source, measured, local_us);
+        gps_window_start_us = local_us;
+        gps_window_best = INT64_MIN;
+    } else {
+        // A fix is stamped when it is handled, always somewhat after the
+        // epoch it describes, so the least delayed fix of a window is the
+        // best estimate of the true offset.
+        if (measured > gps_window_best) {
+            gps_window_best = measured;
+            gps_window_best_us = local_us;
+        }
+        if (local_us - gps_window_start_us >= TIMEBASE_GPS_WINDOW_US) {
+            stepped = timebase_feed(source, gps_window_best, gps_window_best_us);
+            gps_window_start_us = local_us;
+            gps_window_best = INT64_MIN;
+        }
+    }
+    portEXIT_CRITICAL(&timebase_lock);
+
+    if (stepped) {
+        ESP_LOGI(TAG, "Synced to %s", timebase_source_name(source));
+    }
+
+    // Keep time(NULL) and gettimeofday() users on the same clock. NTP has
+    // already set it, and the system clock is where SYSTEM came from.
+    if (source != TIMEBASE_SOURCE_SYSTEM && source != TIMEBASE_SOURCE_NTP) {
+        int64_t now_utc = timebase_now_utc_us();
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        int64_t system_us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+        if (llabs(system_us - now_utc) > TIMEBASE_SYSTEM_TOLERANCE_US) {
+            tv.tv_sec = now_utc / 1000000;
+            tv.tv_usec = now_utc % 1000000;
+            settimeofday(&tv, NULL);
+        }
+    }
+
+#ifdef CONFIG_HAS_RTC_CLOCK
+    if (source >= TIMEBASE_SOURCE_NTP &&
+        (stepped || local_us - rtc_written_us > TIMEBASE_RTC_WRITE_INTERVAL_US)) {
+        rtc_written_us = local_us;
+        timebase_write_rtc(timebase_to_utc_us(local_us));
+    }
+#endif
+}
+
+void timebase_adopt_system_clock(void) {
+    if (timebase_get_state().source != TIMEBASE_SOURCE_NONE) {
+        return;
+    }
+    struct timeval tv;
+    int64_t local_us = esp_timer_get_time();
+    gettimeofday(&tv, NULL);
+    // Anything before 2020 means the clock was never set.
+    if (tv.tv_sec > 1577836800) {
+        timebase_discipline(TIMEBASE_SOURCE_SYSTEM, (int64_t)tv.tv_sec * 1000000 + tv.tv_usec,
+                            local_us);
+    }
+}
+
+void timebase_init(void) {
+#ifdef CONFIG_HAS_RTC_CLOCK
+    RTC_Date date;
+    bool voltage_low = true;
+    if (pcf8563_check_voltage_low(&voltage_low) != ESP_OK || voltage_low ||
+        pcf8563_get_datetime(&date) != ESP_OK || date.year < 2020 || date.month < 1 ||
+        date.month > 12) {
+        ESP_LOGW(TAG, "RTC time not trusted");
+        return;
+    }
+    int64_t secs = days_from_civil(date.year, date.month, date.day) * 86400 + date.hour * 3600 +
+                   date.minute * 60 + date.second;
+    timebase_discipline(TIMEBASE_SOURCE_RTC, secs * 1000000, esp_timer_get_time());
+#endif
+}
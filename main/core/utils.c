@@ -1,9 +1,9 @@
 #include "core/utils.h"
+#include "core/capture_index.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <esp_log.h>
 #include <string.h>
-#include <sys/dirent.h>
 
 #define TAG "Utils"
 
@@ -53,57 +53,11 @@ int get_query_param_value(const char *query, const char *key, char *value,
   return ESP_ERR_NOT_FOUND;
 }
 
+// Both lookups come from the capture manifest instead of scanning the card.
 int get_next_pcap_file_index(const char *base_name) {
-  char path[128];
-  int max_index = -1;
-
-  DIR *dir = opendir("/mnt/ghostesp/pcaps");
-  if (!dir) {
-    ESP_LOGE(TAG, "Failed to open directory /mnt/ghostesp/pcaps");
-    return -1;
-  }
-
-  struct dirent *entry;
-  while ((entry = readdir(dir)) != NULL) {
-
-    if (strncmp(entry->d_name, base_name, strlen(base_name)) == 0) {
-
-      int index;
-      if (sscanf(entry->d_name + strlen(base_name), "_%d.pcap", &index) == 1) {
-
-        if (index > max_index) {
-          max_index = index;
-        }
-      }
-    }
-  }
-
-  closedir(dir);
-  return max_index + 1;
+  return capture_index_peek(CAPTURE_FILE_PCAP, base_name);
 }
 
 int get_next_csv_file_index(const char *base_name) {
-  char path[128];
-  int max_index = -1;
-
-  DIR *dir = opendir("/mnt/ghostesp/wardriving");
-  if (!dir) {
-    ESP_LOGE(TAG, "Failed to open directory /mnt/ghostesp/wardriving");
-    return -1;
-  }
-
-  struct dirent *entry;
-  while ((entry = readdir(dir)) != NULL) {
-    if (strncmp(entry->d_name, base_name, strlen(base_name)) == 0) {
-      int index;
-      if (sscanf(entry->d_name + strlen(base_name), "_%d.csv", &index) == 1) {
-        if (index > max_index) {
-          max_index = index;
-        }
-      }
-    }
-  }
-
-  closedir(dir);
-  return max_index + 1;
-}
\ No newline at end of file
+  return capture_index_peek(CAPTURE_FILE_CSV, base_name);
+}
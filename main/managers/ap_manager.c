@@ -1,4 +1,6 @@
 #include "managers/ap_manager.h"
+#include "core/capture_index.h"
+#include "core/channel_survey.h"
 #include "managers/ghost_esp_site.h"
 #include "managers/settings_manager.h"
 #include <cJSON.h>
@@ -29,6 +31,8 @@ static esp_err_t api_settings_handler(httpd_req_t *req);
 static esp_err_t api_command_handler(httpd_req_t *req);
 static esp_err_t api_settings_get_handler(httpd_req_t *req);
 static esp_err_t api_logs_handler(httpd_req_t *req);
+static esp_err_t api_captures_get_handler(httpd_req_t *req);
+static esp_err_t api_survey_get_handler(httpd_req_t *req);
 
 static void event_handler(void *arg, esp_event_base_t event_base, int32_t event_id,
                           void *event_data);
@@ -147,6 +151,66 @@ static esp_err_t api_sd_card_get_handler(httpd_req_t *req) {
     return ESP_OK;
 }
 
+// Lists recent captures from the manifest, which is much cheaper than
+// /api/sdcard walking every directory on the card.
+static esp_err_t api_captures_get_handler(httpd_req_t *req) {
+    capture_index_entry_t *entries =
+        malloc(CAPTURE_INDEX_LIST_MAX * sizeof(capture_index_entry_t));
+    if (!entries) {
+        httpd_resp_set_status(req, "500 Internal Server Error");
+        httpd_resp_sendstr(req, "{\"error\": \"Out of memory.\"}");
+        return ESP_FAIL;
+    }
+
+    size_t count = capture_index_list(entries, CAPTURE_INDEX_LIST_MAX);
+    cJSON *response_json = cJSON_CreateArray();
+    for (size_t i = 0; i < count; i++) {
+        char path[128];
+        capture_index_format_path(path, sizeof(path), entries[i].type, entries[i].base_name,
+                                  entries[i].file_index);
+
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "path", path);
+        cJSON_AddStringToObject(item, "name", entries[i].base_name);
+        cJSON_AddStringToObject(item, "type", capture_index_type_name(entries[i].type));
+        cJSON_AddNumberToObject(item, "index", entries[i].file_index);
+        cJSON_AddNumberToObject(item, "start_time", entries[i].start_time);
+        cJSON_AddBoolToObject(item, "closed", entries[i].closed);
+        cJSON_AddNumberToObject(item, "size", entries[i].size);
+        cJSON_AddNumberToObject(item, "packets", entries[i].packets);
+        cJSON_AddItemToArray(response_json, item);
+    }
+    free(entries);
+
+    char *response_string = cJSON_PrintUnformatted(response_json);
+    cJSON_Delete(response_json);
+    if (!response_string) {
+        httpd_resp_set_status(req, "500 Internal Server Error");
+        httpd_resp_sendstr(req, "{\"error\": \"Failed to serialize capture list.\"}");
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, response_string);
+    free(response_string);
+    return ESP_OK;
+}
+
+// Current channel survey report; see the `survey` command.
+static esp_err_t api_survey_get_handler(httpd_req_t *req) {
+    char *response_string = channel_survey_to_json();
+    if (!response_string) {
+        httpd_resp_set_status(req, "500 Internal Server Error");
+        httpd_resp_sendstr(req, "{\"error\": \"Failed to serialize survey.\"}");
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, response_string);
+    free(response_string);
+    return ESP_OK;
+}
+
 static esp_err_t api_sd_card_post_handler(httpd_req_t *req) {
     char buf[512];
     int received = httpd_req_recv(req, buf, sizeof(buf));
@@ -292,6 +356,7 @@ esp_err_t api_sd_card_delete_file_handler(httpd_req_t *req) {
             int res = _unlink_r(&r, filepath);
             if (res == 0) {
                 ESP_LOGI(TAG, "File deleted successfully");
+                capture_index_forget_path(filepath);
                 httpd_resp_set_status(req, "200 OK");
                 httpd_resp_send(req, "File deleted successfully", HTTPD_RESP_USE_STRLEN);
                 return ESP_OK;
@@ -709,6 +774,16 @@ esp_err_t ap_manager_init(void) {
                                 .handler = api_logs_handler,
                                 .user_ctx = NULL};
 
+    httpd_uri_t uri_get_captures = {.uri = "/api/captures",
+                                    .method = HTTP_GET,
+                                    .handler = api_captures_get_handler,
+                                    .user_ctx = NULL};
+
+    httpd_uri_t uri_get_survey = {.uri = "/api/survey",
+                                  .method = HTTP_GET,
+                                  .handler = api_survey_get_handler,
+                                  .user_ctx = NULL};
+
     httpd_uri_t uri_delete_command = {.uri = "/api/sdcard",
                                       .method = HTTP_DELETE,
                                       .handler = api_sd_card_delete_file_handler,
@@ -762,6 +837,16 @@ esp_err_t ap_manager_init(void) {
         printf("Error registering URI\n");
     }
 
+    ret = httpd_register_uri_handler(server, &uri_get_captures);
+    if (ret != ESP_OK) {
+        printf("Error registering URI\n");
+    }
+
+    ret = httpd_register_uri_handler(server, &uri_get_survey);
+    if (ret != ESP_OK) {
+        printf("Error registering URI\n");
+    }
+
     printf("HTTP server started\n");
 
     esp_wifi_set_ps(WIFI_PS_NONE);
@@ -921,6 +1006,16 @@ esp_err_t ap_manager_start_services() {
                                 .handler = api_logs_handler,
                                 .user_ctx = NULL};
 
+    httpd_uri_t uri_get_captures = {.uri = "/api/captures",
+                                    .method = HTTP_GET,
+                                    .handler = api_captures_get_handler,
+                                    .user_ctx = NULL};
+
+    httpd_uri_t uri_get_survey = {.uri = "/api/survey",
+                                  .method = HTTP_GET,
+                                  .handler = api_survey_get_handler,
+                                  .user_ctx = NULL};
+
     ret = httpd_register_uri_handler(server, &uri_delete_command);
     if (ret != ESP_OK) {
         printf("Error registering URI\n");
@@ -969,6 +1064,16 @@ esp_err_t ap_manager_start_services() {
         printf("Error registering URI \n");
     }
 
+    ret = httpd_register_uri_handler(server, &uri_get_captures);
+    if (ret != ESP_OK) {
+        printf("Error registering URI \n");
+    }
+
+    ret = httpd_register_uri_handler(server, &uri_get_survey);
+    if (ret != ESP_OK) {
+        printf("Error registering URI \n");
+    }
+
     printf("HTTP server started\n");
 
     return ESP_OK;
@@ -120,8 +120,8 @@ void ble_stop_skimmer_detection(void) {
 
     // Unregister the skimmer detection callback
     ble_unregister_handler(ble_skimmer_scan_callback);
-    pcap_flush_buffer_to_file(); // Final flush
-    pcap_file_close();           // Close the file after final flush
+    // Close only the BLE capture; a Wi-Fi capture may still be running.
+    pcap_file_close_type(PCAP_CAPTURE_BLUETOOTH);
 
     int rc = ble_gap_disc_cancel();
 
@@ -462,6 +462,17 @@ static bool wait_for_ble_ready(void) {
     return true;
 }
 
+// A longer interval than the stack default, so a partial window still
+// leaves Wi-Fi usable stretches of airtime under coexistence.
+#define BLE_DUTY_SCAN_ITVL 0x0060 // 60 ms in 0.625 ms units
+#define BLE_DUTY_SCAN_WINDOW_MIN 0x0004
+
+static uint8_t scan_duty_percent = 0;
+
+void ble_set_scan_duty(uint8_t percent) {
+    scan_duty_percent = percent > 100 ? 100 : percent;
+}
+
 void ble_start_scanning(void) {
     if (!ble_initialized) {
         ble_init();
@@ -477,6 +488,13 @@ void ble_start_scanning(void) {
     disc_params.itvl = BLE_HCI_SCAN_ITVL_DEF;
     disc_params.window = BLE_HCI_SCAN_WINDOW_DEF;
     disc_params.filter_duplicates = 1;
+    if (scan_duty_percent != 0) {
+        disc_params.itvl = BLE_DUTY_SCAN_ITVL;
+        disc_params.window = BLE_DUTY_SCAN_ITVL * scan_duty_percent / 100;
+        if (disc_params.window < BLE_DUTY_SCAN_WINDOW_MIN) {
+            disc_params.window = BLE_DUTY_SCAN_WINDOW_MIN;
+        }
+    }
 
     // Start a new BLE scan
     int rc = ble_gap_disc(BLE_OWN_ADDR_PUBLIC, BLE_HS_FOREVER, &disc_params, ble_gap_event_general,
@@ -593,6 +611,9 @@ void ble_deinit(void) {
 }
 
 void ble_stop(void) {
+    // A reduced duty belongs to the scan that asked for it, e.g. startwd -ble.
+    scan_duty_percent = 0;
+
     if (!ble_initialized) {
         return;
     }
@@ -618,8 +639,9 @@ void ble_stop(void) {
     ble_unregister_handler(airtag_scanner_callback);
     ble_unregister_handler(ble_print_raw_packet_callback);
     ble_unregister_handler(detect_ble_spam_callback);
-    pcap_flush_buffer_to_file(); // Final flush
-    pcap_file_close();           // Close the file after final flush
+    ble_unregister_handler(ble_wardriving_callback);
+    // Close only the BLE capture; a Wi-Fi capture may still be running.
+    pcap_file_close_type(PCAP_CAPTURE_BLUETOOTH);
 
     int rc = ble_gap_disc_cancel();
 
@@ -665,68 +687,50 @@ void ble_start_airtag_scanner(void) {
     ble_start_scanning();
 }
 
+esp_err_t ble_pcap_write_adv_report(const struct ble_gap_event *event) {
+    if (!event || event->type != BLE_GAP_EVENT_DISC)
+        return ESP_ERR_INVALID_ARG;
+
+    // HCI LE Advertising Report, assembled from fragments so the payload is
+    // copied once, straight into the capture ring.
+    uint8_t hci_header[14];
+    hci_header[0] = 0x04;                            // HCI packet type: Event
+    hci_header[1] = 0x3E;                            // LE Meta Event
+    hci_header[2] = 12 + event->disc.length_data;    // Parameter length
+    hci_header[3] = 0x02;                            // LE Advertising Report
+    hci_header[4] = 0x01;                            // Number of reports
+    hci_header[5] = event->disc.event_type;          // ADV_IND, SCAN_RSP, ...
+    hci_header[6] = event->disc.addr.type;           // Address type
+    memcpy(&hci_header[7], event->disc.addr.val, 6); // Address
+    hci_header[13] = event->disc.length_data;        // Data length
+
+    uint8_t rssi = (uint8_t)event->disc.rssi;
+
+    pcap_iovec_t iov[] = {
+        {.base = hci_header, .len = sizeof(hci_header)},
+        {.base = event->disc.data, .len = event->disc.length_data},
+        {.base = &rssi, .len = 1},
+    };
+
+    return pcap_write_packetv(iov, sizeof(iov) / sizeof(iov[0]), PCAP_CAPTURE_BLUETOOTH);
+}
+
 static void ble_pcap_callback(struct ble_gap_event *event, size_t len) {
     if (!event || len == 0)
         return;
 
-    uint8_t hci_buffer[258]; // Max HCI packet size
-    size_t hci_len = 0;
-
-    if (event->type == BLE_GAP_EVENT_DISC) {
-        // [1] HCI packet type (0x04 for HCI Event)
-        hci_buffer[0] = 0x04;
-
-        // [2] HCI Event Code (0x3E for LE Meta Event)
-        hci_buffer[1] = 0x3E;
-
-        // [3] Calculate total parameter length
-        uint8_t param_len = 10 + event->disc.length_data; // 1 (subevent) + 1 (num reports) + 1
-                                                          // (event type) + 1 (addr type) + 6 (addr)
-        hci_buffer[2] = param_len;
-
-        // [4] LE Meta Subevent (0x02 for LE Advertising Report)
-        hci_buffer[3] = 0x02;
-
-        // [5] Number of reports
-        hci_buffer[4] = 0x01;
-
-        // [6] Event type (ADV_IND = 0x00)
-        hci_buffer[5] = 0x00;
-
-        // [7] Address type
-        hci_buffer[6] = event->disc.addr.type;
-
-        // [8] Address (6 bytes)
-        memcpy(&hci_buffer[7], event->disc.addr.val, 6);
-
-        // [9] Data length
-        hci_buffer[13] = event->disc.length_data;
-
-        // [10] Data
-        if (event->disc.length_data > 0) {
-            memcpy(&hci_buffer[14], event->disc.data, event->disc.length_data);
-        }
-
-        // [11] RSSI
-        hci_buffer[14 + event->disc.length_data] = (uint8_t)event->disc.rssi;
-
-        hci_len = 15 + event->disc.length_data; // Total length
-
-        // packet logging (don't print to display terminal to prevent overwhelming)
-        printf("BLE Packet Received:\nType: 0x04 (HCI Event)\nMeta: 0x3E "
-               "(LE)\nLength: %d\n",
-               hci_len);
-
-        pcap_write_packet_to_buffer(hci_buffer, hci_len, PCAP_CAPTURE_BLUETOOTH);
-    }
+    ble_pcap_write_adv_report(event);
 }
 
 void ble_start_capture(void) {
-    // Open PCAP file first
-    esp_err_t err = pcap_file_open("ble_capture", PCAP_CAPTURE_BLUETOOTH);
-    if (err != ESP_OK) {
-        ESP_LOGE("BLE_PCAP", "Failed to open PCAP file");
-        return;
+    // Open PCAP file first, unless a PCAPNG capture is already running that
+    // can take the BLE packets alongside Wi-Fi
+    if (!pcap_is_capturing(PCAP_CAPTURE_BLUETOOTH)) {
+        esp_err_t err = pcap_file_open("ble_capture", PCAP_CAPTURE_BLUETOOTH);
+        if (err != ESP_OK) {
+            ESP_LOGE("BLE_PCAP", "Failed to open PCAP file");
+            return;
+        }
     }
 
     // Register BLE handler only after file is open
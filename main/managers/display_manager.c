@@ -23,6 +23,7 @@
 #endif
 
 #ifdef CONFIG_HAS_RTC_CLOCK
+#include "core/timebase.h"
 #include "vendor/drivers/pcf8563.h"
 #endif
 
@@ -391,6 +392,7 @@ void display_manager_init(void) {
   axp2101_init();
 #ifdef CONFIG_HAS_RTC_CLOCK
   pcf8563_init(I2C_NUM_1, 0x51);
+  timebase_init();
 #endif
 #endif
 
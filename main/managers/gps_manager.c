@@ -1,8 +1,10 @@
 #include "managers/gps_manager.h"
 #include "core/callbacks.h"
+#include "core/timebase.h"
 #include "driver/periph_ctrl.h"
 #include "driver/uart.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "managers/settings_manager.h"
 #include "soc/gpio_periph.h"
 #include "soc/io_mux_reg.h"
@@ -11,6 +13,7 @@
 #include "vendor/GPS/MicroNMEA.h"
 #include "vendor/GPS/gps_logger.h"
 #include <managers/views/terminal_screen.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -90,6 +93,11 @@ void gps_manager_init(GPSManager *manager) {
     config.uart.rx_pin = 2;
 #endif
 
+    if (config.uart.tx_pin >= 0) {
+        printf("GPS TX: IO%d\n", config.uart.tx_pin);
+        TERMINAL_VIEW_ADD_TEXT("GPS TX: IO%d\n", config.uart.tx_pin);
+    }
+
     nmea_hdl = nmea_parser_init(&config);
     nmea_parser_add_handler(nmea_hdl, gps_event_handler, NULL);
     manager->isinitilized = true;
@@ -99,6 +107,8 @@ void gps_manager_init(GPSManager *manager) {
 static void check_gps_connection_task(void *pvParameters) {
     const TickType_t timeout = pdMS_TO_TICKS(10000); // 10 second timeout
     TickType_t start_time = xTaskGetTickCount();
+    // Any publish after this one means the parser is decoding sentences.
+    uint32_t start_seq = gps_get_snapshot().seq;
 
     while (xTaskGetTickCount() - start_time < timeout) {
         if (!nmea_hdl) {
@@ -106,19 +116,10 @@ static void check_gps_connection_task(void *pvParameters) {
             continue;
         }
 
-        gps_t *gps = &((esp_gps_t *)nmea_hdl)->parent;
-
-        if (!gps) {
-            vTaskDelay(pdMS_TO_TICKS(500));
-            continue;
-        }
-
-        // Check if we're receiving valid GPS data
-        if (!gps_connection_logged &&
-            (gps->tim.hour != 0 || gps->tim.minute != 0 || gps->tim.second != 0 ||
-             gps->latitude != 0 || gps->longitude != 0)) {
-            printf("GPS Module Connected\nReceiving Data\n");
-            TERMINAL_VIEW_ADD_TEXT("GPS Module Connected\nReceiving Data\n");
+        if (!gps_connection_logged && gps_get_snapshot().seq != start_seq) {
+            const char *protocol = ((esp_gps_t *)nmea_hdl)->ubx ? "UBX" : "NMEA";
+            printf("GPS Module Connected\nReceiving %s Data\n", protocol);
+            TERMINAL_VIEW_ADD_TEXT("GPS Module Connected\nReceiving %s Data\n", protocol);
             gps_connection_logged = true;
             gps_check_task_handle = NULL;
             vTaskDelete(NULL);
@@ -146,172 +147,186 @@ void gps_manager_deinit(GPSManager *manager) {
 
         nmea_parser_remove_handler(nmea_hdl, gps_event_handler);
         nmea_parser_deinit(nmea_hdl);
+        // The parser task is gone, so this is the only writer left.
+        gps_t none = {0};
+        gps_manager_publish(&none);
         manager->isinitilized = false;
         gps_connection_logged = false;
     }
 }
 
 #define GPS_STATUS_MESSAGE "GPS: %s\nSats: %u/%u\nSpeed: %.1f km/h\nAccuracy: %s\n"
-#define GPS_UPDATE_INTERVAL 4 // Show status every 4th update (25% chance)
+#define GPS_STATUS_INTERVAL_US (5 * 1000000) // Status line at most every 5 seconds
+#define GPS_SNAPSHOT_MAX_AGE_US (5 * 1000000)
 
 #define MIN_SPEED_THRESHOLD 0.1   // Minimum 0.1 m/s (~0.36 km/h)
 #define MAX_SPEED_THRESHOLD 340.0 // Maximum 340 m/s (~1224 km/h)
 
-esp_err_t gps_manager_log_wardriving_data(wardriving_data_t *data) {
-    if (!data || !nmea_hdl) {
-        return ESP_ERR_INVALID_ARG;
-    }
-    gps_t *gps = &((esp_gps_t *)nmea_hdl)->parent;
-    if (!data->ble_data.is_ble_device) {
-        if (!gps->valid || strlen(data->ssid) <= 2) {
-            return ESP_ERR_INVALID_ARG;
-        }
-    } else {
-        // For BLE entries, only check GPS validity
-        if (!gps->valid || gps->fix < GPS_FIX_GPS || gps->fix_mode < GPS_MODE_2D ||
-            gps->sats_in_use < 3 || gps->sats_in_use > GPS_MAX_SATELLITES_IN_USE) {
-            return ESP_ERR_INVALID_STATE;
-        }
-    }
+// Seconds since 1970 for a GPS date and time (days-from-civil, no tables).
+static uint32_t gps_epoch_seconds(const gps_date_t *date, const gps_time_t *tim) {
+    int year = gps_get_absolute_year(date->year);
+    int month = date->month;
+    year -= month <= 2;
+    int era = year / 400;
+    int yoe = year - era * 400;
+    int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + date->day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int days = era * 146097 + doe - 719468;
+    return (uint32_t)days * 86400 + tim->hour * 3600 + tim->minute * 60 + tim->second;
+}
 
-    // Validate GPS data
-    if (!is_valid_date(&gps->date)) {
-        if (!has_valid_cached_date) {
-            ESP_LOGW(GPS_TAG, "No valid GPS date available");
-            return ESP_ERR_INVALID_STATE;
-        }
+// Double-buffered seqlock. The parser fills the slot readers are not using,
+// then bumps the sequence; a reader copies the slot the sequence points at
+// and retries only if a publish completed meanwhile. A writer preempted
+// mid-copy never touches the published slot, so readers never spin on it.
+static gps_snapshot_t gps_snapshots[2];
+static uint32_t gps_snapshot_seq = 0;
+
+// Range checks that used to run on every logged record; now once per fix.
+static bool gps_fix_loggable(const gps_t *gps) {
+    if (!gps->valid || gps->fix < GPS_FIX_GPS || gps->fix_mode < GPS_MODE_2D ||
+        gps->sats_in_use < 3 || gps->sats_in_use > GPS_MAX_SATELLITES_IN_USE) {
+        return false;
+    }
 
-        // Only log warning for good GPS fixes
-        if (gps->valid && gps->fix >= GPS_FIX_GPS && gps->fix_mode >= GPS_MODE_2D &&
-            gps->sats_in_use >= 3 && gps->sats_in_use <= GPS_MAX_SATELLITES_IN_USE &&
-            rand() % 100 == 0) {
+    if (!is_valid_date(&gps->date) || gps->tim.hour > 23 || gps->tim.minute > 59 ||
+        gps->tim.second > 59) {
+        static bool warned = false;
+        if (!warned) {
             ESP_LOGW(GPS_TAG,
                      "Invalid date despite good fix: %04d-%02d-%02d "
                      "(Fix: %d, Mode: %d, Sats: %d)",
                      gps_get_absolute_year(gps->date.year), gps->date.month, gps->date.day,
                      gps->fix, gps->fix_mode, gps->sats_in_use);
+            warned = true;
         }
-
-        // Use cached date for validation
-        ESP_LOGD(GPS_TAG, "Using cached date: %04d-%02d-%02d",
-                 gps_get_absolute_year(cacheddate.year), cacheddate.month, cacheddate.day);
-    } else if (!has_valid_cached_date) {
-        // Valid date - update cache
-        cacheddate = gps->date;
-        has_valid_cached_date = true;
-        ESP_LOGI(GPS_TAG, "Cached valid GPS date: %04d-%02d-%02d",
-                 gps_get_absolute_year(cacheddate.year), cacheddate.month, cacheddate.day);
+        return false;
     }
 
-    data->latitude = gps->latitude;
-    data->longitude = gps->longitude;
-    data->altitude = gps->altitude;
-    data->accuracy = gps->dop_h * 5.0;
-
-    // First, validate the current GPS date
-    if (!is_valid_date(&gps->date)) {
-        // Only show warning if we have a truly valid fix
-        if (gps->valid && gps->fix >= GPS_FIX_GPS && gps->fix_mode >= GPS_MODE_2D &&
-            gps->sats_in_use >= 3 &&
-            gps->sats_in_use <= GPS_MAX_SATELLITES_IN_USE && // Should be ≤ 12
-            rand() % 100 == 0) {
-            printf("Warning: GPS date is out of range despite good fix: %04d-%02d-%02d "
-                   "(Fix: %d, Mode: %d, Sats: %d)\n",
-                   gps_get_absolute_year(gps->date.year), gps->date.month, gps->date.day, gps->fix,
-                   gps->fix_mode, gps->sats_in_use);
-        }
-        return ESP_OK;
+    return !(gps->latitude < -90.0 || gps->latitude > 90.0 || gps->longitude < -180.0 ||
+             gps->longitude > 180.0 || gps->speed < 0.0 || gps->speed > MAX_SPEED_THRESHOLD ||
+             gps->dop_h < 0.0 || gps->dop_p < 0.0 || gps->dop_v < 0.0 || gps->dop_h > 50.0 ||
+             gps->dop_p > 50.0 || gps->dop_v > 50.0);
+}
+
+void gps_manager_publish(const gps_t *gps) {
+    uint32_t seq = __atomic_load_n(&gps_snapshot_seq, __ATOMIC_RELAXED) + 1;
+    gps_snapshot_t *next = &gps_snapshots[seq & 1];
+    // Readers that see these writes must also see the previous publish.
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    next->seq = seq;
+    next->has_fix = gps->valid;
+    next->valid = gps_fix_loggable(gps);
+    next->fix = gps->fix;
+    next->fix_mode = gps->fix_mode;
+    next->sats = gps->sats_in_use > GPS_MAX_SATELLITES_IN_USE ? 0 : gps->sats_in_use;
+    next->lat_e7 = gps->lat_e7;
+    next->lon_e7 = gps->lon_e7;
+    next->alt_cm = gps->alt_cm;
+    float accuracy_dm = gps->dop_h * 5.0f * 10.0f;
+    next->accuracy_dm = accuracy_dm < 0.0f          ? 0
+                        : accuracy_dm > UINT16_MAX ? UINT16_MAX
+                                                   : (uint16_t)accuracy_dm;
+    next->millis = gps->tim.thousand;
+    next->timestamp = next->valid ? gps_epoch_seconds(&gps->date, &gps->tim) : 0;
+    next->speed = gps->speed;
+    next->course = gps->cog;
+    next->dop_h = gps->dop_h;
+    next->published_us = esp_timer_get_time();
+
+    if (next->valid && next->timestamp != 0) {
+        timebase_discipline(TIMEBASE_SOURCE_GPS,
+                            (int64_t)next->timestamp * 1000000 + next->millis * 1000,
+                            next->published_us);
     }
 
-    // Then, only if we don't have a cached date and the current date is valid,
-    // cache it
-    if (cacheddate.year <= 0) {
+    if (next->valid && !has_valid_cached_date) {
         cacheddate = gps->date;
+        has_valid_cached_date = true;
     }
 
-    if (gps->tim.hour > 23 || gps->tim.minute > 59 || gps->tim.second > 59) {
-        if (rand() % 20 == 0) {
-            printf("Warning: GPS time is invalid: %02d:%02d:%02d\n", gps->tim.hour, gps->tim.minute,
-                   gps->tim.second);
-        }
-        return ESP_OK;
-    }
+    __atomic_store_n(&gps_snapshot_seq, seq, __ATOMIC_RELEASE);
+}
 
-    if (gps->latitude < -90.0 || gps->latitude > 90.0 || gps->longitude < -180.0 ||
-        gps->longitude > 180.0) {
-        if (rand() % 20 == 0) {
-            printf("GPS Error: Invalid location detected (Lat: %f, Lon: %f)\n", gps->latitude,
-                   gps->longitude);
+gps_snapshot_t gps_get_snapshot(void) {
+    gps_snapshot_t copy;
+    uint32_t before, after;
+    do {
+        before = __atomic_load_n(&gps_snapshot_seq, __ATOMIC_ACQUIRE);
+        if (before == 0) {
+            memset(&copy, 0, sizeof(copy));
+            return copy;
         }
-        return ESP_OK;
-    }
+        copy = gps_snapshots[before & 1];
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&gps_snapshot_seq, __ATOMIC_RELAXED);
+    } while (before != after);
+    return copy;
+}
 
-    if (gps->speed < 0.0 || gps->speed > 340.0) {
-        if (rand() % 20 == 0) {
-            printf("Warning: GPS speed is out of range: %f m/s\n", gps->speed);
-        }
-        return ESP_OK;
-    }
+// Runs on the Wi-Fi and BLE callback paths, so it only copies numbers out of
+// the snapshot; the logger task does the formatting.
+bool gps_snapshot_fresh(const gps_snapshot_t *fix) {
+    return fix->valid && esp_timer_get_time() - fix->published_us <= GPS_SNAPSHOT_MAX_AGE_US;
+}
 
-    if (gps->dop_h < 0.0 || gps->dop_p < 0.0 || gps->dop_v < 0.0 || gps->dop_h > 50.0 ||
-        gps->dop_p > 50.0 || gps->dop_v > 50.0) {
-        if (rand() % 20 == 0) {
-            printf("Warning: GPS DOP values are out of range: HDOP: %f, PDOP: %f, "
-                   "VDOP: %f\n",
-                   gps->dop_h, gps->dop_p, gps->dop_v);
-        }
-        return ESP_OK;
+esp_err_t gps_manager_log_wardriving_record(wardrive_record_t *record, const gps_snapshot_t *fix) {
+    if (!record || !fix) {
+        return ESP_ERR_INVALID_ARG;
     }
-
-    esp_err_t ret = csv_write_data_to_buffer(data);
-    if (ret != ESP_OK) {
-        ESP_LOGE(GPS_TAG, "Failed to write wardriving data to CSV buffer");
-        return ret;
+    if (!gps_snapshot_fresh(fix)) {
+        return ESP_ERR_INVALID_STATE;
     }
 
-    // Update display periodically
-    if (rand() % GPS_UPDATE_INTERVAL == 0) {
-        // Determine GPS fix status
-        const char *fix_status = (!gps->valid || gps->fix == GPS_FIX_INVALID) ? "No Fix"
-                                 : (gps->fix_mode == GPS_MODE_2D)             ? "Basic"
-                                 : (gps->fix_mode == GPS_MODE_3D)             ? "Locked"
-                                                                              : "Unknown";
-
-        // Validate satellite counts (clamp between 0 and max)
-        uint8_t sats_in_use = (gps->sats_in_use > GPS_MAX_SATELLITES_IN_USE) ? 0 : gps->sats_in_use;
-
-        // Determine accuracy based on HDOP
-        const char *accuracy = (gps->dop_h < 0.0 || gps->dop_h > 50.0) ? "Invalid"
-                               : (gps->dop_h <= 1.0)                   ? "Perfect"
-                               : (gps->dop_h <= 2.0)                   ? "High"
-                               : (gps->dop_h <= 5.0)                   ? "Good"
-                               : (gps->dop_h <= 10.0)                  ? "Okay"
-                                                                       : "Poor";
-
-        // Convert speed from m/s to km/h for display with validation
-        float speed_kmh = 0.0;
-        if (gps->valid && gps->fix >= GPS_FIX_GPS) { // Only trust speed with a valid fix
-            if (gps->speed >= MIN_SPEED_THRESHOLD && gps->speed <= MAX_SPEED_THRESHOLD) {
-                speed_kmh = gps->speed * 3.6; // Convert m/s to km/h
-            } else if (gps->speed < MIN_SPEED_THRESHOLD && gps->speed >= 0.0) {
-                speed_kmh = 0.0; // Show as stopped if below threshold but not negative
-            }
-            // Speeds above MAX_SPEED_THRESHOLD remain at 0.0
-        }
+    record->lat_e7 = fix->lat_e7;
+    record->lon_e7 = fix->lon_e7;
+    record->alt_cm = fix->alt_cm;
+    record->accuracy_dm = fix->accuracy_dm;
+    record->sats = fix->sats;
+    record->timestamp = fix->timestamp;
+    record->millis = fix->millis;
+
+    return wardrive_logger_submit(record);
+}
 
-        // Add newline before status update for better readability
-        printf("\n");
-        printf(
-            GPS_STATUS_MESSAGE, fix_status, data->gps_quality.satellites_used,
-            GPS_MAX_SATELLITES_IN_USE,
-            data->gps_quality.speed * 3.6, // Convert m/s to km/h
-            get_gps_quality_string(data)); // Only keep the arguments that match the format string
-        TERMINAL_VIEW_ADD_TEXT(GPS_STATUS_MESSAGE, fix_status, data->gps_quality.satellites_used,
-                               GPS_MAX_SATELLITES_IN_USE, data->gps_quality.speed * 3.6,
-                               get_gps_quality_string(data));
+void gps_manager_print_status(void) {
+    static int64_t last_status_us = 0;
+    int64_t now = esp_timer_get_time();
+    if (!nmea_hdl || (last_status_us != 0 && now - last_status_us < GPS_STATUS_INTERVAL_US)) {
+        return;
+    }
+    last_status_us = now;
+
+    gps_snapshot_t fix = gps_get_snapshot();
+
+    // Determine GPS fix status
+    const char *fix_status = (!fix.has_fix || fix.fix == GPS_FIX_INVALID) ? "No Fix"
+                             : (fix.fix_mode == GPS_MODE_2D)              ? "Basic"
+                             : (fix.fix_mode == GPS_MODE_3D)              ? "Locked"
+                                                                          : "Unknown";
+
+    // Determine accuracy based on HDOP
+    const char *accuracy = (fix.dop_h < 0.0 || fix.dop_h > 50.0) ? "Invalid"
+                           : (fix.dop_h <= 1.0)                  ? "Perfect"
+                           : (fix.dop_h <= 2.0)                  ? "High"
+                           : (fix.dop_h <= 5.0)                  ? "Good"
+                           : (fix.dop_h <= 10.0)                 ? "Okay"
+                                                                 : "Poor";
+
+    // Convert speed from m/s to km/h for display with validation
+    float speed_kmh = 0.0;
+    if (fix.has_fix && fix.fix >= GPS_FIX_GPS) { // Only trust speed with a valid fix
+        if (fix.speed >= MIN_SPEED_THRESHOLD && fix.speed <= MAX_SPEED_THRESHOLD) {
+            speed_kmh = fix.speed * 3.6; // Convert m/s to km/h
+        }
     }
 
-    return ret;
+    printf("\n");
+    printf(GPS_STATUS_MESSAGE, fix_status, fix.sats, GPS_MAX_SATELLITES_IN_USE, speed_kmh,
+           accuracy);
+    TERMINAL_VIEW_ADD_TEXT(GPS_STATUS_MESSAGE, fix_status, fix.sats, GPS_MAX_SATELLITES_IN_USE,
+                           speed_kmh, accuracy);
 }
 
 bool gps_is_timeout_detected(void) { return gps_timeout_detected; }
\ No newline at end of file
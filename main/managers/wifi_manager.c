@@ -1,6 +1,8 @@
 // wifi_manager.c
 
 #include "managers/wifi_manager.h"
+#include "core/channel_hopper.h"
+#include "core/frame_dispatch.h"
 #include "esp_crt_bundle.h"
 #include "esp_event.h"
 #include "esp_http_client.h"
@@ -245,31 +247,6 @@ static void generate_random_mac(uint8_t *mac) {
     mac[0] |= 0x02; // Locally administered MAC address (set the second least significant bit)
 }
 
-static bool station_exists(const uint8_t *station_mac, const uint8_t *ap_bssid) {
-    for (int i = 0; i < station_count; i++) {
-        if (memcmp(station_ap_list[i].station_mac, station_mac, 6) == 0 &&
-            memcmp(station_ap_list[i].ap_bssid, ap_bssid, 6) == 0) {
-            return true;
-        }
-    }
-    return false;
-}
-
-static void add_station_ap_pair(const uint8_t *station_mac, const uint8_t *ap_bssid) {
-    if (station_count < MAX_STATIONS) {
-        // Copy MAC addresses to the list
-        memcpy(station_ap_list[station_count].station_mac, station_mac, 6);
-        memcpy(station_ap_list[station_count].ap_bssid, ap_bssid, 6);
-        station_count++;
-
-        // Print formatted MAC addresses
-
-    } else {
-        printf("Station list full\nCan't add more stations.\n");
-        TERMINAL_VIEW_ADD_TEXT("Station list full\nCan't add more stations.\n");
-    }
-}
-
 // Function to match the BSSID to a company based on OUI
 ECompany match_bssid_to_company(const uint8_t *bssid) {
     char oui[7]; // First 3 bytes of the BSSID
@@ -328,29 +305,6 @@ ECompany match_bssid_to_company(const uint8_t *bssid) {
     return COMPANY_UNKNOWN;
 }
 
-void wifi_stations_sniffer_callback(void *buf, wifi_promiscuous_pkt_type_t type) {
-    if (type != WIFI_PKT_DATA) {
-        return;
-    }
-
-    const wifi_promiscuous_pkt_t *packet = (wifi_promiscuous_pkt_t *)buf;
-    const wifi_ieee80211_packet_t *ipkt = (wifi_ieee80211_packet_t *)packet->payload;
-    const wifi_ieee80211_hdr_t *hdr = &ipkt->hdr;
-
-    const uint8_t *src_mac = hdr->addr2;  // Station MAC
-    const uint8_t *dest_mac = hdr->addr1; // AP BSSID
-
-    printf(
-        "station MAC: %02X:%02X:%02X:%02X:%02X:%02X -> AP BSSID: %02X:%02X:%02X:%02X:%02X:%02X\n",
-        src_mac[0], src_mac[1], src_mac[2], src_mac[3], src_mac[4], src_mac[5], dest_mac[0],
-        dest_mac[1], dest_mac[2], dest_mac[3], dest_mac[4], dest_mac[5]);
-    
-    // check if this station-ap pair already exists before adding it
-    if (!station_exists(src_mac, dest_mac)) {
-        add_station_ap_pair(src_mac, dest_mac);
-    }
-}
-
 esp_err_t stream_data_to_client(httpd_req_t *req, const char *url, const char *content_type) {
     printf("Requesting URL: %s\n", url);
 
@@ -863,24 +817,72 @@ void wifi_manager_stop_evil_portal() {
     ap_manager_init();
 }
 
-void wifi_manager_start_monitor_mode(wifi_promiscuous_cb_t_t callback) {
+static bool monitor_active = false;
 
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_NULL));
+// Lets the driver drop frame types no consumer is subscribed to.
+static void wifi_manager_apply_monitor_filter(void) {
+    uint64_t mask = frame_dispatch_mask();
+    wifi_promiscuous_filter_t filter = {0};
 
-    ESP_ERROR_CHECK(esp_wifi_set_promiscuous(true));
+    if (mask & FRAME_MASK_MGMT)
+        filter.filter_mask |= WIFI_PROMIS_FILTER_MASK_MGMT;
+    if (mask & FRAME_MASK_CTRL)
+        filter.filter_mask |= WIFI_PROMIS_FILTER_MASK_CTRL;
+    if (mask & FRAME_MASK_DATA)
+        filter.filter_mask |= WIFI_PROMIS_FILTER_MASK_DATA;
+    esp_wifi_set_promiscuous_filter(&filter);
 
-    ESP_ERROR_CHECK(esp_wifi_set_promiscuous_rx_cb(callback));
+    if (mask & FRAME_MASK_CTRL) {
+        wifi_promiscuous_filter_t ctrl_filter = {.filter_mask = WIFI_PROMIS_CTRL_FILTER_MASK_ALL};
+        esp_wifi_set_promiscuous_ctrl_filter(&ctrl_filter);
+    }
+}
+
+void wifi_manager_start_monitor_mode(const char *name, uint64_t frame_mask,
+                                     wifi_promiscuous_cb_t_t callback) {
+    if (frame_dispatch_add(name, frame_mask, callback) != ESP_OK) {
+        printf("Cannot start %s: too many monitor consumers.\n", name);
+        TERMINAL_VIEW_ADD_TEXT("Too many monitor consumers.\n");
+        return;
+    }
+
+    if (!monitor_active) {
+        ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_NULL));
+
+        ESP_ERROR_CHECK(esp_wifi_set_promiscuous(true));
+
+        ESP_ERROR_CHECK(esp_wifi_set_promiscuous_rx_cb(frame_dispatch_rx));
+        monitor_active = true;
+    }
+    wifi_manager_apply_monitor_filter();
 
     printf("WiFi monitor started.\n");
     TERMINAL_VIEW_ADD_TEXT("WiFi monitor started.\n");
 }
 
-void wifi_manager_stop_monitor_mode() {
+// Leaves promiscuous mode once the last consumer is gone. Modes stop
+// themselves through wifi_manager_stop_monitor_consumer(), so each one's
+// state stays in step with its registration.
+static void wifi_manager_stop_monitor_mode(void) {
+    channel_hopper_reset();
+    frame_dispatch_clear();
     ESP_ERROR_CHECK(esp_wifi_set_promiscuous(false));
+    monitor_active = false;
     printf("WiFi monitor stopped.\n");
     TERMINAL_VIEW_ADD_TEXT("WiFi monitor stopped.\n");
 }
 
+void wifi_manager_stop_monitor_consumer(const char *name) {
+    frame_dispatch_remove(name);
+    if (frame_dispatch_count() == 0) {
+        if (monitor_active) {
+            wifi_manager_stop_monitor_mode();
+        }
+    } else if (monitor_active) {
+        wifi_manager_apply_monitor_filter();
+    }
+}
+
 void wifi_manager_init(void) {
 
     esp_log_level_set("wifi", ESP_LOG_ERROR); // Only show errors, not warnings
@@ -992,7 +994,6 @@ void wifi_manager_stop_scan() {
         return;
     }
 
-    wifi_manager_stop_monitor_mode();
     rgb_manager_set_color(&rgb_manager, 0, 0, 0, 0, false);
 
     uint16_t initial_ap_count = 0;
@@ -1037,26 +1038,6 @@ void wifi_manager_stop_scan() {
     }
 }
 
-void wifi_manager_list_stations() {
-    if (station_count == 0) {
-        printf("No stations found.\n");
-        return;
-    }
-
-    printf("Listing all stations and their associated APs:\n");
-
-    for (int i = 0; i < station_count; i++) {
-        printf("Station MAC: %02X:%02X:%02X:%02X:%02X:%02X\n"
-               "     -> AP BSSID: %02X:%02X:%02X:%02X:%02X:%02X\n",
-               station_ap_list[i].station_mac[0], station_ap_list[i].station_mac[1],
-               station_ap_list[i].station_mac[2], station_ap_list[i].station_mac[3],
-               station_ap_list[i].station_mac[4], station_ap_list[i].station_mac[5],
-               station_ap_list[i].ap_bssid[0], station_ap_list[i].ap_bssid[1],
-               station_ap_list[i].ap_bssid[2], station_ap_list[i].ap_bssid[3],
-               station_ap_list[i].ap_bssid[4], station_ap_list[i].ap_bssid[5]);
-    }
-}
-
 static bool check_packet_rate(void) {
     uint32_t current_time = esp_timer_get_time() / 1000; // Convert to milliseconds
 
@@ -2085,7 +2066,6 @@ void wifi_manager_stop_deauth() {
             deauth_task_handle = NULL;
             beacon_task_running = false;
             rgb_manager_set_color(&rgb_manager, 0, 0, 0, 0, false);
-            wifi_manager_stop_monitor_mode();
             esp_wifi_stop();
             ap_manager_start_services();
         }
@@ -0,0 +1,273 @@
+// ghost_stream_decode.c
+//
+// Splits a recording of Ghost ESP framed serial output ("serial framing on")
+// back into capture files. Build with any C99 compiler:
+//
+//   cc -O2 -o ghost_stream_decode ghost_stream_decode.c
+//
+// Frames are COBS encoded and delimited by zero bytes. Decoded, each frame is
+// channel(1) flags(1) seq(2, LE) payload crc32(4, LE). Anything between
+// frames that does not decode is plain console text and goes to the log.
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHANNEL_PCAP 1
+#define CHANNEL_CSV 2
+#define CHANNEL_LOG 3
+#define CHANNEL_REPLY 4
+#define CHANNEL_COUNT 5
+
+#define FLAG_OPEN 0x01
+#define FRAME_OVERHEAD 8 // Header plus CRC
+#define MAX_FRAME 2048
+#define MAX_TEXT_CHUNK 65536
+
+typedef struct {
+  const char *name;
+  FILE *out;
+  int file_count;
+  int have_seq;
+  uint16_t next_seq;
+  unsigned long frames;
+  unsigned long lost;
+  unsigned long long bytes;
+} channel_state_t;
+
+static const char *prefix = "ghost";
+static channel_state_t channels[CHANNEL_COUNT] = {
+    [CHANNEL_PCAP] = {.name = "pcap"},
+    [CHANNEL_CSV] = {.name = "csv"},
+    [CHANNEL_LOG] = {.name = "log"},
+    [CHANNEL_REPLY] = {.name = "console"},
+};
+static unsigned long bad_frames = 0;
+static FILE *text_out = NULL;
+
+static uint32_t crc_table[256];
+
+static void crc32_init(void) {
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; k++) {
+      c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+    }
+    crc_table[i] = c;
+  }
+}
+
+// Same as esp_rom_crc32_le(0, ...) on the device.
+static uint32_t crc32(const uint8_t *data, size_t len) {
+  uint32_t c = 0xFFFFFFFFu;
+  for (size_t i = 0; i < len; i++) {
+    c = crc_table[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+  }
+  return c ^ 0xFFFFFFFFu;
+}
+
+// Returns the decoded length, or -1 if the input is not valid COBS.
+static long cobs_decode(const uint8_t *in, size_t len, uint8_t *out,
+                        size_t out_size) {
+  size_t i = 0, o = 0;
+  while (i < len) {
+    uint8_t code = in[i++];
+    if (code == 0 || i + code - 1 > len) {
+      return -1;
+    }
+    for (uint8_t k = 1; k < code; k++) {
+      if (o >= out_size) {
+        return -1;
+      }
+      out[o++] = in[i++];
+    }
+    if (code != 0xFF && i < len) {
+      if (o >= out_size) {
+        return -1;
+      }
+      out[o++] = 0;
+    }
+  }
+  return (long)o;
+}
+
+static FILE *open_output(const char *name) {
+  FILE *f = fopen(name, "wb");
+  if (f == NULL) {
+    fprintf(stderr, "cannot create %s: %s\n", name, strerror(errno));
+    exit(1);
+  }
+  return f;
+}
+
+static FILE *text_file(void) {
+  if (text_out == NULL) {
+    char name[512];
+    snprintf(name, sizeof(name), "%s.log", prefix);
+    text_out = open_output(name);
+  }
+  return text_out;
+}
+
+// Capture channels get a numbered file per capture; log and console output
+// each go to a single file.
+static FILE *channel_file(int channel, int open_flag, const uint8_t *payload,
+                          size_t len) {
+  channel_state_t *ch = &channels[channel];
+  char name[512];
+
+  if (channel == CHANNEL_LOG) {
+    return text_file();
+  }
+  if (channel == CHANNEL_REPLY) {
+    if (ch->out == NULL) {
+      snprintf(name, sizeof(name), "%s_console.txt", prefix);
+      ch->out = open_output(name);
+    }
+    return ch->out;
+  }
+
+  if (ch->out != NULL && !open_flag) {
+    return ch->out;
+  }
+  if (ch->out != NULL) {
+    fclose(ch->out);
+  }
+
+  const char *ext = "csv";
+  if (channel == CHANNEL_PCAP) {
+    static const uint8_t pcapng_magic[4] = {0x0A, 0x0D, 0x0D, 0x0A};
+    ext = (len >= 4 && memcmp(payload, pcapng_magic, 4) == 0) ? "pcapng"
+                                                               : "pcap";
+  }
+  snprintf(name, sizeof(name), "%s_%s_%d.%s", prefix, ch->name,
+           ch->file_count++, ext);
+  if (!open_flag) {
+    fprintf(stderr, "%s: joined mid-capture, %s may lack its header\n",
+            ch->name, name);
+  }
+  ch->out = open_output(name);
+  fprintf(stderr, "writing %s\n", name);
+  return ch->out;
+}
+
+static void handle_text(const uint8_t *data, size_t len) {
+  if (len > 0) {
+    fwrite(data, 1, len, text_file());
+  }
+}
+
+static void handle_chunk(const uint8_t *data, size_t len) {
+  static uint8_t frame[MAX_FRAME];
+
+  if (len == 0) {
+    return;
+  }
+
+  long n = cobs_decode(data, len, frame, sizeof(frame));
+  if (n < FRAME_OVERHEAD) {
+    handle_text(data, len);
+    return;
+  }
+
+  uint32_t crc = frame[n - 4] | (frame[n - 3] << 8) |
+                 ((uint32_t)frame[n - 2] << 16) | ((uint32_t)frame[n - 1] << 24);
+  int channel = frame[0];
+  if (crc32(frame, n - 4) != crc || channel <= 0 || channel >= CHANNEL_COUNT) {
+    // Either text that happened to decode, or a damaged frame.
+    if (n >= FRAME_OVERHEAD && channel > 0 && channel < CHANNEL_COUNT) {
+      bad_frames++;
+    }
+    handle_text(data, len);
+    return;
+  }
+
+  channel_state_t *ch = &channels[channel];
+  uint16_t seq = frame[2] | (frame[3] << 8);
+  if (ch->have_seq && seq != ch->next_seq) {
+    uint16_t gap = (uint16_t)(seq - ch->next_seq);
+    ch->lost += gap;
+    fprintf(stderr, "%s: %u frame(s) lost before seq %u\n", ch->name, gap, seq);
+  }
+  ch->have_seq = 1;
+  ch->next_seq = seq + 1;
+  ch->frames++;
+
+  const uint8_t *payload = frame + 4;
+  size_t payload_len = n - FRAME_OVERHEAD;
+  FILE *out = channel_file(channel, frame[1] & FLAG_OPEN, payload, payload_len);
+  fwrite(payload, 1, payload_len, out);
+  ch->bytes += payload_len;
+}
+
+int main(int argc, char **argv) {
+  const char *input = "-";
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      prefix = argv[++i];
+    } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+      fprintf(stderr,
+              "usage: %s [-o prefix] [recording|-]\n"
+              "  Writes <prefix>_pcap_N.pcap[ng], <prefix>_csv_N.csv,\n"
+              "  <prefix>.log and <prefix>_console.txt\n",
+              argv[0]);
+      return 2;
+    } else {
+      input = argv[i];
+    }
+  }
+
+  FILE *in = strcmp(input, "-") == 0 ? stdin : fopen(input, "rb");
+  if (in == NULL) {
+    fprintf(stderr, "cannot open %s: %s\n", input, strerror(errno));
+    return 1;
+  }
+
+  crc32_init();
+
+  uint8_t *chunk = malloc(MAX_TEXT_CHUNK);
+  if (chunk == NULL) {
+    return 1;
+  }
+  size_t used = 0;
+  int c;
+  while ((c = getc(in)) != EOF) {
+    if (c == 0) {
+      handle_chunk(chunk, used);
+      used = 0;
+      continue;
+    }
+    chunk[used++] = (uint8_t)c;
+    if (used == MAX_TEXT_CHUNK) {
+      // Far longer than any frame, so it can only be text.
+      handle_text(chunk, used);
+      used = 0;
+    }
+  }
+  handle_text(chunk, used);
+  free(chunk);
+
+  for (int i = 1; i < CHANNEL_COUNT; i++) {
+    channel_state_t *ch = &channels[i];
+    if (ch->out != NULL) {
+      fclose(ch->out);
+    }
+    if (ch->frames > 0 || ch->lost > 0) {
+      fprintf(stderr, "%-8s %lu frames, %llu bytes, %lu lost\n", ch->name,
+              ch->frames, ch->bytes, ch->lost);
+    }
+  }
+  if (bad_frames > 0) {
+    fprintf(stderr, "%lu frame(s) failed the CRC check\n", bad_frames);
+  }
+  if (text_out != NULL) {
+    fclose(text_out);
+  }
+  if (in != stdin) {
+    fclose(in);
+  }
+  return 0;
+}
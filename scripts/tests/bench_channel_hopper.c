@@ -0,0 +1,218 @@
+// bench_channel_hopper.c
+//
+// Time to first beacon under the fixed and weighted hopping policies.
+// channel_hopper.c runs against a simulated clock and radio: esp_timer and
+// esp_wifi_set_channel are defined below, and every millisecond the frames
+// on the tuned channel are fed to channel_hopper_note_frame() as the frame
+// dispatcher would. Each site is a per-channel profile of APs and data
+// frames per second, in the shape the survey command reports. The hopper
+// learns a site for WARMUP_S, then every AP restarts its beacon phase as if
+// just switched on, and the time until the hopper first hears each one is
+// measured, split between the busy channels and the rest.
+
+#include "core/channel_hopper.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "test.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define CHANNELS 13
+#define BEACON_US 102400 // 100 TU
+#define HEARD_PERCENT 90 // Beacons lost to collisions and fading
+#define WARMUP_S 20
+#define WINDOW_S 30
+#define SEEDS 20
+#define MAX_APS 64
+
+typedef struct {
+  const char *name;
+  uint8_t aps[CHANNELS];        // APs on channels 1-13
+  uint16_t data_fps[CHANNELS];  // Other frames per second
+} site_t;
+
+static const site_t sites[] = {
+    {"apartment",
+     {14, 1, 1, 0, 1, 18, 0, 1, 2, 0, 15, 0, 1},
+     {300, 10, 10, 0, 5, 600, 0, 5, 20, 0, 400, 0, 5}},
+    {"office",
+     {6, 0, 0, 1, 0, 8, 0, 0, 1, 0, 7, 0, 0},
+     {1500, 0, 0, 10, 0, 2500, 0, 0, 10, 0, 2000, 0, 0}},
+    {"rural",
+     {2, 0, 0, 0, 0, 1, 0, 0, 0, 0, 3, 0, 0},
+     {20, 0, 0, 0, 0, 10, 0, 0, 0, 0, 30, 0, 0}},
+};
+
+// Simulated clock, radio and the hopper's one timer.
+static int64_t now_us;
+static uint8_t tuned_channel;
+static struct esp_timer {
+  esp_timer_cb_t callback;
+  void *arg;
+  int64_t deadline; // -1 when stopped
+} hop_timer;
+
+int64_t esp_timer_get_time(void) { return now_us; }
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args,
+                           esp_timer_handle_t *handle) {
+  hop_timer.callback = args->callback;
+  hop_timer.arg = args->arg;
+  hop_timer.deadline = -1;
+  *handle = &hop_timer;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+  timer->deadline = now_us + (int64_t)timeout_us;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  timer->deadline = -1;
+  return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second) {
+  tuned_channel = primary;
+  return ESP_OK;
+}
+
+typedef struct {
+  uint8_t channel;
+  int64_t next_beacon;
+  int64_t found_us; // -1 until heard after the warm-up
+} ap_t;
+
+static ap_t aps[MAX_APS];
+static int ap_count;
+static uint32_t rng;
+
+static uint32_t next_random(void) {
+  rng = rng * 1103515245u + 12345u;
+  return rng >> 8;
+}
+
+// Runs the site for duration_us in 1 ms steps.
+static void simulate(const site_t *site, int64_t duration_us, int64_t start_us) {
+  uint32_t data_credit[CHANNELS] = {0};
+  for (int64_t end = now_us + duration_us; now_us < end; now_us += 1000) {
+    if (hop_timer.deadline >= 0 && hop_timer.deadline <= now_us) {
+      hop_timer.deadline = -1;
+      hop_timer.callback(hop_timer.arg);
+    }
+
+    int ch = tuned_channel - 1;
+    // Data frames, spread evenly over the second
+    data_credit[ch] += site->data_fps[ch];
+    while (data_credit[ch] >= 1000) {
+      data_credit[ch] -= 1000;
+      channel_hopper_note_frame(false);
+    }
+
+    for (int i = 0; i < ap_count; i++) {
+      ap_t *ap = &aps[i];
+      while (ap->next_beacon < now_us + 1000) {
+        if (ap->channel == tuned_channel &&
+            next_random() % 100 < HEARD_PERCENT) {
+          channel_hopper_note_frame(true);
+          if (start_us >= 0 && ap->found_us < 0) {
+            ap->found_us = ap->next_beacon - start_us;
+          }
+        }
+        ap->next_beacon += BEACON_US;
+      }
+    }
+  }
+}
+
+static int compare_us(const void *a, const void *b) {
+  int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static void report(const char *site, const char *policy, const char *group,
+                   int64_t *found, int count) {
+  if (count == 0) {
+    return;
+  }
+  qsort(found, count, sizeof(found[0]), compare_us);
+  double sum = 0;
+  int missed = 0;
+  for (int i = 0; i < count; i++) {
+    sum += found[i];
+    missed += found[i] >= (int64_t)WINDOW_S * 1000000;
+  }
+  printf("channel_hopper: %-9s %-8s %-5s %4d APs: mean %5.2f s, p90 %5.2f s, "
+         "%d not heard in %d s\n",
+         site, policy, group, count, sum / count / 1e6,
+         found[count * 9 / 10] / 1e6, missed, WINDOW_S);
+}
+
+static void run(const site_t *site, channel_hop_policy_t policy) {
+  static int64_t busy[SEEDS * MAX_APS], quiet[SEEDS * MAX_APS];
+  int busy_count = 0, quiet_count = 0;
+
+  // The three channels with the most APs count as busy.
+  bool is_busy[CHANNELS] = {false};
+  for (int n = 0; n < 3; n++) {
+    int best = -1;
+    for (int c = 0; c < CHANNELS; c++) {
+      if (!is_busy[c] && (best < 0 || site->aps[c] > site->aps[best])) {
+        best = c;
+      }
+    }
+    is_busy[best] = true;
+  }
+
+  channel_hop_config_t config = CHANNEL_HOP_CONFIG_DEFAULT();
+  config.policy = policy;
+  channel_hopper_set_config(&config);
+
+  for (int seed = 1; seed <= SEEDS; seed++) {
+    rng = (uint32_t)seed;
+    ap_count = 0;
+    for (int c = 0; c < CHANNELS; c++) {
+      for (int i = 0; i < site->aps[c] && ap_count < MAX_APS; i++) {
+        aps[ap_count].channel = (uint8_t)(c + 1);
+        aps[ap_count].next_beacon = now_us + next_random() % BEACON_US;
+        aps[ap_count].found_us = -1;
+        ap_count++;
+      }
+    }
+
+    channel_hopper_reset_stats();
+    channel_hopper_acquire();
+    simulate(site, (int64_t)WARMUP_S * 1000000, -1);
+
+    int64_t start = now_us;
+    for (int i = 0; i < ap_count; i++) {
+      aps[i].next_beacon = now_us + next_random() % BEACON_US;
+    }
+    simulate(site, (int64_t)WINDOW_S * 1000000, start);
+    channel_hopper_release();
+
+    for (int i = 0; i < ap_count; i++) {
+      int64_t found =
+          aps[i].found_us < 0 ? (int64_t)WINDOW_S * 1000000 : aps[i].found_us;
+      if (is_busy[aps[i].channel - 1]) {
+        busy[busy_count++] = found;
+      } else {
+        quiet[quiet_count++] = found;
+      }
+    }
+  }
+
+  const char *name = channel_hopper_policy_name(policy);
+  report(site->name, name, "busy", busy, busy_count);
+  report(site->name, name, "quiet", quiet, quiet_count);
+}
+
+int main(void) {
+  channel_hopper_default_channels();
+  for (size_t s = 0; s < sizeof(sites) / sizeof(sites[0]); s++) {
+    run(&sites[s], CHANNEL_HOP_FIXED);
+    run(&sites[s], CHANNEL_HOP_WEIGHTED);
+  }
+  return 0;
+}
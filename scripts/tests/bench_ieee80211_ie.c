@@ -0,0 +1,175 @@
+// bench_ieee80211_ie.c
+//
+// Parse throughput of ieee80211_parse_mgmt. With no argument it runs over a
+// built-in set of beacons and probe requests; given a classic .pcap with raw
+// 802.11 (linktype 105) or radiotap (127) frames, such as one written by
+// "capture -beacon", it runs over the management frames in that file.
+
+#include "core/ieee80211_ie.h"
+#include "test.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_FRAMES 4096
+#define ROUNDS_TARGET 4000000u
+
+typedef struct {
+  uint8_t *data;
+  size_t len;
+} frame_t;
+
+static frame_t frames[MAX_FRAMES];
+static size_t frame_count;
+
+static void add_frame(const uint8_t *data, size_t len) {
+  if (frame_count < MAX_FRAMES && ieee80211_mgmt_ie_offset(data, len) != 0) {
+    frames[frame_count].data = malloc(len);
+    memcpy(frames[frame_count].data, data, len);
+    frames[frame_count].len = len;
+    frame_count++;
+  }
+}
+
+static size_t put_ie(uint8_t *p, uint8_t id, const void *data, uint8_t len) {
+  p[0] = id;
+  p[1] = len;
+  if (data != NULL) {
+    memcpy(p + 2, data, len);
+  } else {
+    memset(p + 2, 0, len);
+  }
+  return 2 + len;
+}
+
+// Beacons shaped like those from common home and enterprise APs.
+static void build_frames(void) {
+  static const uint8_t rates[] = {0x82, 0x84, 0x8b, 0x96, 0x0c, 0x12, 0x18,
+                                  0x24};
+  static const uint8_t rsn[] = {1, 0, 0x00, 0x0f, 0xac, 4, 1, 0,
+                                0x00, 0x0f, 0xac, 4, 1, 0, 0x00, 0x0f,
+                                0xac, 2, 0x0c, 0};
+  static const uint8_t wmm[] = {0x00, 0x50, 0xf2, 0x02, 0x01, 0x01, 0x80,
+                                0x00, 0x03, 0xa4, 0x00, 0x00, 0x27, 0xa4,
+                                0x00, 0x00, 0x42, 0x43, 0x5e, 0x00, 0x62,
+                                0x32, 0x2f, 0x00};
+  static const uint8_t wps[] = {0x00, 0x50, 0xf2, 0x04, 0x10, 0x4a,
+                                0x00, 0x01, 0x10, 0x10, 0x44, 0x00,
+                                0x01, 0x02, 0x10, 0x08, 0x00, 0x02,
+                                0x31, 0x48};
+  uint8_t f[512];
+
+  for (int i = 0; i < 64; i++) {
+    char ssid[24];
+    int ssid_len = snprintf(ssid, sizeof(ssid), "network-%d", i * 7919);
+    uint8_t channel = 1 + i % 11;
+    size_t n;
+
+    memset(f, 0, IEEE80211_MGMT_HDR_LEN + 12);
+    f[0] = i % 8 == 7 ? 0x40 : 0x80;
+    n = IEEE80211_MGMT_HDR_LEN + (f[0] == 0x80 ? 12 : 0);
+    if (f[0] == 0x80) {
+      f[IEEE80211_MGMT_HDR_LEN + 10] = 0x11;
+    }
+    n += put_ie(f + n, IEEE80211_IE_SSID, ssid, ssid_len);
+    n += put_ie(f + n, 1, rates, sizeof(rates));
+    n += put_ie(f + n, IEEE80211_IE_DS_PARAMS, &channel, 1);
+    n += put_ie(f + n, 5, "\x00\x01\x00\x00", 4); // TIM
+    n += put_ie(f + n, 42, "\x04", 1);
+    n += put_ie(f + n, IEEE80211_IE_RSN, rsn, sizeof(rsn));
+    n += put_ie(f + n, IEEE80211_IE_HT_CAP, NULL, 26);
+    n += put_ie(f + n, IEEE80211_IE_HT_OPERATION, NULL, 22);
+    n += put_ie(f + n, 127, "\x04\x00\x08\x00\x00\x00\x00\x40", 8);
+    if (i % 2 == 0) {
+      n += put_ie(f + n, IEEE80211_IE_VHT_CAP, NULL, 12);
+      n += put_ie(f + n, IEEE80211_IE_VHT_OPERATION, NULL, 5);
+    }
+    n += put_ie(f + n, IEEE80211_IE_VENDOR, wmm, sizeof(wmm));
+    if (i % 4 == 0) {
+      n += put_ie(f + n, IEEE80211_IE_VENDOR, wps, sizeof(wps));
+    }
+    add_frame(f, n);
+  }
+}
+
+static uint32_t rd32(const uint8_t *p, bool swap) {
+  uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+  return swap ? __builtin_bswap32(v) : v;
+}
+
+static bool load_pcap(const char *path) {
+  FILE *in = fopen(path, "rb");
+  uint8_t hdr[24], rec[16];
+  static uint8_t buf[65536];
+
+  if (in == NULL) {
+    fprintf(stderr, "%s: cannot open\n", path);
+    return false;
+  }
+  if (fread(hdr, 1, sizeof(hdr), in) != sizeof(hdr)) {
+    fprintf(stderr, "%s: cannot read pcap header\n", path);
+    fclose(in);
+    return false;
+  }
+  bool swap = rd32(hdr, false) == 0xd4c3b2a1;
+  if (!swap && rd32(hdr, false) != 0xa1b2c3d4) {
+    fprintf(stderr, "%s: not a classic pcap file\n", path);
+    fclose(in);
+    return false;
+  }
+  uint32_t linktype = rd32(hdr + 20, swap);
+
+  while (fread(rec, 1, sizeof(rec), in) == sizeof(rec)) {
+    uint32_t caplen = rd32(rec + 8, swap);
+    if (caplen > sizeof(buf) || fread(buf, 1, caplen, in) != caplen) {
+      break;
+    }
+    size_t skip = 0;
+    if (linktype == 127 && caplen >= 4) {
+      skip = buf[2] | (buf[3] << 8); // Radiotap header length
+    }
+    if (skip < caplen) {
+      add_frame(buf + skip, caplen - skip);
+    }
+  }
+  fclose(in);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) {
+    if (!load_pcap(argv[1])) {
+      return 1;
+    }
+  } else {
+    build_frames();
+  }
+  if (frame_count == 0) {
+    fprintf(stderr, "no management frames to parse\n");
+    return 1;
+  }
+
+  size_t bytes = 0;
+  for (size_t i = 0; i < frame_count; i++) {
+    bytes += frames[i].len;
+  }
+
+  uint32_t rounds = ROUNDS_TARGET / frame_count + 1;
+  volatile uint32_t sink = 0;
+  ieee80211_ies_t ies;
+  uint64_t start = test_now_ns();
+  for (uint32_t r = 0; r < rounds; r++) {
+    for (size_t i = 0; i < frame_count; i++) {
+      ieee80211_parse_mgmt(frames[i].data, frames[i].len, &ies);
+      sink += ies.ie_count + ies.channel + ieee80211_security(&ies);
+    }
+  }
+  uint64_t elapsed = test_now_ns() - start;
+  double parsed = (double)rounds * frame_count;
+
+  printf("ieee80211_ie: %zu frames (%zu bytes avg), %.1f ns/frame, "
+         "%.0f frames/s, %.1f MB/s\n",
+         frame_count, bytes / frame_count, elapsed / parsed,
+         parsed * 1e9 / elapsed, (double)rounds * bytes * 1e3 / elapsed);
+  (void)sink;
+  return 0;
+}
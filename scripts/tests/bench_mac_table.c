@@ -0,0 +1,93 @@
+// bench_mac_table.c
+//
+// The wardriving dedup table on a drive past thousands of BSSIDs. The route
+// passes each AP in turn and keeps the WINDOW most recent ones in range, each
+// beaconing once per step, so a table too small for what is in range forgets
+// BSSIDs and logs them again. should_log() is a host copy of the decision in
+// wardriving_should_log() and wardriving_mark_logged() (callbacks.c) with
+// signal and position held steady, so every row past the first per BSSID is
+// one an eviction caused. Reports the time per beacon, evictions and those
+// extra rows at the Kconfig default CONFIG_WARDRIVE_DEDUP_ENTRIES and above.
+
+#include "core/mac_table.h"
+#include "test.h"
+#include <string.h>
+
+#define RSSI_DB 6 // CONFIG_WARDRIVE_DEDUP_RSSI_DB
+
+typedef struct {
+  int32_t lat_e7;
+  int32_t lon_e7;
+  int8_t best_rssi;
+  bool has_fix;
+  bool logged;
+} sighting_t;
+
+typedef struct {
+  const char *name;
+  uint32_t bssids;
+  uint32_t window; // APs in range at once
+} route_t;
+
+static void bssid_of(uint32_t i, uint8_t mac[6]) {
+  uint32_t h = i * 2654435761u;
+  mac[0] = 0x24;
+  mac[1] = (uint8_t)(i >> 16);
+  mac[2] = (uint8_t)(i >> 8);
+  memcpy(&mac[3], &h, 3);
+}
+
+static bool should_log(mac_table_t *table, const uint8_t mac[6], int rssi) {
+  sighting_t *seen = mac_table_upsert(table, mac, NULL);
+  if (seen->logged && rssi < seen->best_rssi + RSSI_DB) {
+    return false;
+  }
+  seen->best_rssi = (int8_t)rssi;
+  seen->logged = true;
+  return true;
+}
+
+static void run(const route_t *route, uint32_t capacity) {
+  mac_table_t table;
+  if (mac_table_init(&table, capacity, sizeof(sighting_t)) != ESP_OK) {
+    return;
+  }
+
+  uint64_t beacons = 0, rows = 0;
+  uint8_t mac[6];
+  uint64_t start = test_now_ns();
+  for (uint32_t step = 0; step < route->bssids + route->window; step++) {
+    uint32_t first = step < route->window ? 0 : step - route->window + 1;
+    uint32_t last = step < route->bssids ? step : route->bssids - 1;
+    for (uint32_t i = first; i <= last; i++) {
+      bssid_of(i, mac);
+      rows += should_log(&table, mac, -70);
+      beacons++;
+    }
+  }
+  double ns = (double)(test_now_ns() - start) / beacons;
+
+  mac_table_stats_t stats;
+  mac_table_get_stats(&table, &stats);
+  printf("mac_table: %-8s %5u BSSIDs, %4u in range, %5u slots: %.1f ns/beacon, "
+         "%u evictions, %llu extra rows\n",
+         route->name, route->bssids, route->window, stats.capacity, ns,
+         stats.evictions, (unsigned long long)(rows - route->bssids));
+  mac_table_free(&table);
+}
+
+int main(void) {
+  static const route_t routes[] = {
+      {"suburb", 5000, 200},
+      {"city", 10000, 800},
+      {"downtown", 20000, 2000},
+  };
+  static const uint32_t capacities[] = {1024, 4096, 16384};
+
+  for (size_t r = 0; r < sizeof(routes) / sizeof(routes[0]); r++) {
+    for (size_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]); c++) {
+      run(&routes[r], capacities[c]);
+    }
+  }
+  return 0;
+}
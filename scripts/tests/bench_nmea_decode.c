@@ -0,0 +1,185 @@
+// bench_nmea_decode.c
+//
+// Sentences per second through nmea_decode_line, next to the item parser
+// MicroNMEA.c used before it. The old parser is wired to the UART task and
+// esp_gps_t, so legacy_decode() below is a host copy of its byte loop and
+// its GGA/RMC field conversions (atoi/strtof/strtol), with the event
+// posting left out. Also reports how far the old float coordinates drift
+// from the exact value.
+
+#include "vendor/GPS/nmea_decode.h"
+#include "test.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ROUNDS 2000000
+
+static const char *lines[] = {
+    "$GPGGA,123519.25,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*6E\r\n",
+    "$GPRMC,123519,A,4807.038,S,01131.000,W,022.4,084.4,230394,003.1,W*65\r\n",
+};
+
+typedef struct {
+  char item[32];
+  int item_pos, item_num, statement;
+  uint8_t crc;
+  bool asterisk;
+  float latitude, longitude, altitude, dop_h, speed, cog, variation;
+  int fix, sats, hour, minute, second, day, month, year;
+  bool valid;
+  uint32_t parsed;
+} legacy_gps_t;
+
+enum { LEGACY_UNKNOWN, LEGACY_GGA, LEGACY_RMC };
+
+static float legacy_lat_long(const legacy_gps_t *g, bool latitude) {
+  int width = latitude ? 2 : 3;
+  char deg[4] = {0};
+  if (!g->item[0]) {
+    return 0.0f;
+  }
+  memcpy(deg, g->item, width); // atoi stops at a shorter item's NUL
+  return atoi(deg) + strtof(g->item + width, NULL) / 60.0f;
+}
+
+static void legacy_time(legacy_gps_t *g) {
+  g->hour = 10 * (g->item[0] - '0') + (g->item[1] - '0');
+  g->minute = 10 * (g->item[2] - '0') + (g->item[3] - '0');
+  g->second = 10 * (g->item[4] - '0') + (g->item[5] - '0');
+}
+
+static void legacy_item(legacy_gps_t *g) {
+  if (g->item_num == 0 && g->item[0] == '$') {
+    g->statement = strstr(g->item, "GGA")   ? LEGACY_GGA
+                   : strstr(g->item, "RMC") ? LEGACY_RMC
+                                            : LEGACY_UNKNOWN;
+    return;
+  }
+  bool south = g->item[0] == 'S' || g->item[0] == 's';
+  bool west = g->item[0] == 'W' || g->item[0] == 'w';
+  if (g->statement == LEGACY_GGA) {
+    switch (g->item_num) {
+    case 1: legacy_time(g); break;
+    case 2: g->latitude = legacy_lat_long(g, true); break;
+    case 3: if (south) g->latitude *= -1; break;
+    case 4: g->longitude = legacy_lat_long(g, false); break;
+    case 5: if (west) g->longitude *= -1; break;
+    case 6: g->fix = strtol(g->item, NULL, 10); break;
+    case 7: g->sats = strtol(g->item, NULL, 10); break;
+    case 8: g->dop_h = strtof(g->item, NULL); break;
+    case 9: g->altitude = strtof(g->item, NULL); break;
+    case 11: g->altitude += strtof(g->item, NULL); break;
+    }
+  } else if (g->statement == LEGACY_RMC) {
+    switch (g->item_num) {
+    case 1: legacy_time(g); break;
+    case 2: g->valid = g->item[0] == 'A'; break;
+    case 3: g->latitude = legacy_lat_long(g, true); break;
+    case 4: if (south) g->latitude *= -1; break;
+    case 5: g->longitude = legacy_lat_long(g, false); break;
+    case 6: if (west) g->longitude *= -1; break;
+    case 7: g->speed = strtof(g->item, NULL) * 1.852f / 3.6f; break;
+    case 8: g->cog = strtof(g->item, NULL); break;
+    case 9:
+      g->day = 10 * (g->item[0] - '0') + (g->item[1] - '0');
+      g->month = 10 * (g->item[2] - '0') + (g->item[3] - '0');
+      g->year = 10 * (g->item[4] - '0') + (g->item[5] - '0');
+      break;
+    case 10: g->variation = strtof(g->item, NULL); break;
+    case 11: if (west) g->variation *= -1; break;
+    }
+  }
+}
+
+static void legacy_decode(legacy_gps_t *g, const char *d) {
+  for (; *d; d++) {
+    if (*d == '$') {
+      g->asterisk = false;
+      g->item_num = 0;
+      g->statement = 0;
+      g->crc = 0;
+      g->item[0] = '$';
+      g->item[1] = '\0';
+      g->item_pos = 1;
+    } else if (*d == ',' || *d == '*') {
+      legacy_item(g);
+      if (*d == ',') {
+        g->crc ^= (uint8_t)*d;
+      } else {
+        g->asterisk = true;
+      }
+      g->item_pos = 0;
+      g->item[0] = '\0';
+      g->item_num++;
+    } else if (*d == '\r') {
+      if (g->crc == (uint8_t)strtol(g->item, NULL, 16)) {
+        g->parsed |= 1u << g->statement;
+      }
+    } else if (*d != '\n') {
+      if (!g->asterisk) {
+        g->crc ^= (uint8_t)*d;
+      }
+      if (g->item_pos < (int)sizeof(g->item) - 1) {
+        g->item[g->item_pos++] = *d;
+        g->item[g->item_pos] = '\0';
+      }
+    }
+  }
+}
+
+int main(void) {
+  size_t lens[2] = {strlen(lines[0]), strlen(lines[1])};
+  nmea_data_t d;
+  legacy_gps_t g;
+
+  memset(&d, 0, sizeof(d));
+  uint64_t start = test_now_ns();
+  for (long i = 0; i < ROUNDS; i++) {
+    nmea_decode_line(lines[i & 1], lens[i & 1], 0x7e, &d);
+  }
+  double fixed_s = (test_now_ns() - start) / 1e9;
+
+  memset(&g, 0, sizeof(g));
+  start = test_now_ns();
+  for (long i = 0; i < ROUNDS; i++) {
+    legacy_decode(&g, lines[i & 1]);
+  }
+  double legacy_s = (test_now_ns() - start) / 1e9;
+
+  if (d.checksum_errors != 0 || d.malformed != 0 ||
+      g.parsed != (1u << LEGACY_GGA | 1u << LEGACY_RMC)) {
+    fprintf(stderr, "benchmark sentences did not decode\n");
+    return 1;
+  }
+
+  printf("nmea_decode: %.0f sentences/s (%.0f ns each), old item parser "
+         "%.0f sentences/s (%.0f ns each)\n",
+         ROUNDS / fixed_s, fixed_s * 1e9 / ROUNDS, ROUNDS / legacy_s,
+         legacy_s * 1e9 / ROUNDS);
+
+  // Coordinate precision over random ddmm.mmmmm values
+  double worst_float = 0, worst_fixed = 0;
+  char body[48], line[80];
+  srand(1);
+  for (int i = 0; i < 100000; i++) {
+    int deg = rand() % 90, min = rand() % 60, frac = rand() % 100000;
+    snprintf(body, sizeof(body), "GPGGA,120000,%02d%02d.%05d,N,,,1,08,,,,,,,",
+             deg, min, frac);
+    uint8_t sum = 0;
+    for (const char *p = body; *p; p++) {
+      sum ^= (uint8_t)*p;
+    }
+    int len = snprintf(line, sizeof(line), "$%s*%02X\r\n", body, sum);
+    double exact = deg + (min + frac / 1e5) / 60;
+
+    nmea_decode_line(line, len, 0x7e, &d);
+    legacy_decode(&g, line);
+    worst_fixed = fmax(worst_fixed, fabs(d.lat_e7 / 1e7 - exact));
+    worst_float = fmax(worst_float, fabs(g.latitude - exact));
+  }
+  printf("nmea_decode: worst latitude error %.2e deg (%.3f m), old float "
+         "path %.2e deg (%.2f m)\n",
+         worst_fixed, worst_fixed * 111320, worst_float, worst_float * 111320);
+  return 0;
+}
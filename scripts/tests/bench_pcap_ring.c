@@ -0,0 +1,128 @@
+// bench_pcap_ring.c
+//
+// Sustained capture rate through pcap.c: producer threads push frames
+// through pcap_write_wifi_packet / pcap_write_packet_to_buffer into the
+// session's ring while its writer task drains it to a file under build/.
+// Reports accepted frames per second and drops for an unthrottled burst,
+// for a paced busy channel, and for a PCAPNG session shared by a Wi-Fi and
+// a BLE producer. The ring size is CONFIG_PCAP_RING_SIZE_KB. On a one-core
+// host the writer thread shares the CPU with the producers, so small paced
+// drop rates there say as much about the scheduler as about the ring.
+
+#include "vendor/pcap.h"
+#include "freertos/task.h"
+#include "test.h"
+#include <pthread.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define FRAME_LEN 300
+#define RUN_NS 1000000000ull
+
+typedef struct {
+  uint32_t rate; // Frames per second; 0 = as fast as possible
+  bool ble;
+  uint32_t offered;
+} producer_t;
+
+static volatile bool stop;
+
+static void *produce(void *arg) {
+  producer_t *p = arg;
+  static const uint8_t hci[] = {0x04, 0x3e, 0x0c, 0x02, 0x01, 0x00, 0x00, 0x11,
+                                0x22, 0x33, 0x44, 0x55, 0x66, 0x00, 0xc5};
+  struct {
+    wifi_pkt_rx_ctrl_t rx_ctrl;
+    uint8_t payload[FRAME_LEN];
+  } pkt;
+  memset(&pkt, 0, sizeof(pkt));
+  pkt.rx_ctrl.channel = 6;
+  pkt.rx_ctrl.rssi = -60;
+  pkt.rx_ctrl.rate = 11;
+  pkt.rx_ctrl.sig_len = FRAME_LEN;
+  pkt.payload[0] = 0x88; // QoS data: kept whole, no IE walk
+  pkt.payload[1] = 0x01;
+
+  uint64_t start = test_now_ns();
+  while (!stop) {
+    // Paced producers sleep between 1 ms bursts rather than spinning, so the
+    // writer thread gets the CPU on small hosts.
+    if (p->rate != 0 &&
+        p->offered >= (test_now_ns() - start) * p->rate / 1000000000ull) {
+      vTaskDelay(1);
+      continue;
+    }
+    if (p->ble) {
+      pcap_write_packet_to_buffer(hci, sizeof(hci), PCAP_CAPTURE_BLUETOOTH);
+    } else {
+      pcap_write_wifi_packet((const wifi_promiscuous_pkt_t *)&pkt);
+    }
+    p->offered++;
+  }
+  return NULL;
+}
+
+static void run(const char *name, pcap_format_t format, producer_t *producers,
+                int count) {
+  pcap_session_config_t config = PCAP_SESSION_CONFIG_DEFAULT();
+  config.format = format;
+  pcap_session_t *session = pcap_session_open_ex(name, PCAP_CAPTURE_WIFI, &config);
+  if (session == NULL) {
+    fprintf(stderr, "pcap_ring: cannot open a session\n");
+    return;
+  }
+
+  pthread_t threads[2];
+  stop = false;
+  uint64_t start = test_now_ns();
+  for (int i = 0; i < count; i++) {
+    producers[i].offered = 0;
+    pthread_create(&threads[i], NULL, produce, &producers[i]);
+  }
+  while (test_now_ns() - start < RUN_NS) {
+    vTaskDelay(10);
+  }
+  stop = true;
+  uint32_t offered = 0;
+  for (int i = 0; i < count; i++) {
+    pthread_join(threads[i], NULL);
+    offered += producers[i].offered;
+  }
+  double seconds = (test_now_ns() - start) / 1e9;
+
+  pcap_stats_t stats;
+  pcap_session_get_stats(session, &stats);
+  pcap_session_close(session);
+
+  char path[64];
+  struct stat st;
+  snprintf(path, sizeof(path), "build/%s.%s", name,
+           format == PCAP_FORMAT_PCAPNG ? "pcapng" : "pcap");
+  if (stat(path, &st) != 0 || (uint64_t)st.st_size < stats.bytes_flushed) {
+    fprintf(stderr, "pcap_ring: %s is shorter than what was flushed\n", path);
+  }
+
+  printf("pcap_ring: %-16s %9.0f frames/s offered, %9.0f written, %5.1f%% "
+         "dropped, ring high water %u/%d\n",
+         name, offered / seconds, stats.packets_written / seconds,
+         100.0 * stats.packets_dropped / (offered ? offered : 1),
+         stats.ring_high_water, PCAP_RING_SIZE);
+  remove(path);
+}
+
+int main(void) {
+  if (pcap_init() != ESP_OK) {
+    return 1;
+  }
+
+  producer_t burst = {0};
+  run("ring_burst", PCAP_FORMAT_PCAP, &burst, 1);
+
+  // A busy 2.4 GHz channel in promiscuous mode
+  producer_t busy = {.rate = 20000};
+  run("ring_20k", PCAP_FORMAT_PCAP, &busy, 1);
+
+  producer_t shared[2] = {{.rate = 20000}, {.rate = 2000, .ble = true}};
+  run("ring_shared", PCAP_FORMAT_PCAPNG, shared, 2);
+  return 0;
+}
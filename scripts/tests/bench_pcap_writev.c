@@ -0,0 +1,98 @@
+// bench_pcap_writev.c
+//
+// Cost of appending one BLE advertising report to the capture ring, the way
+// ble_pcap_write_adv_report() builds it: a 14-byte HCI header, 31 bytes of
+// advertising data and the RSSI byte. The old path put the three pieces
+// together in a malloc'd buffer and wrote that; the new one hands the
+// fragments to pcap_write_packetv() or pcap_session_writev(), which copy them
+// straight into the ring. Packets go in batches that stay under the writer's
+// wake threshold, and only the appends are timed.
+
+#include "vendor/pcap.h"
+#include "freertos/task.h"
+#include "test.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ROUNDS 1000
+#define BATCH 100
+
+enum { OLD_MALLOC, PACKETV, SESSION_WRITEV };
+
+static uint8_t hci_header[14] = {0x04, 0x3e, 12 + 31, 0x02, 0x01, 0x00, 0x00,
+                                 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 31};
+static uint8_t adv_data[31];
+static uint8_t rssi = (uint8_t)-70;
+
+static esp_err_t write_report(int path, pcap_session_t *session) {
+  pcap_iovec_t iov[] = {
+      {.base = hci_header, .len = sizeof(hci_header)},
+      {.base = adv_data, .len = sizeof(adv_data)},
+      {.base = &rssi, .len = 1},
+  };
+
+  switch (path) {
+  case OLD_MALLOC: {
+    size_t len = sizeof(hci_header) + sizeof(adv_data) + 1;
+    uint8_t *packet = malloc(len);
+    if (packet == NULL) {
+      return ESP_ERR_NO_MEM;
+    }
+    memcpy(packet, hci_header, sizeof(hci_header));
+    memcpy(packet + sizeof(hci_header), adv_data, sizeof(adv_data));
+    packet[len - 1] = rssi;
+    esp_err_t ret =
+        pcap_write_packet_to_buffer(packet, len, PCAP_CAPTURE_BLUETOOTH);
+    free(packet);
+    return ret;
+  }
+  case PACKETV:
+    return pcap_write_packetv(iov, 3, PCAP_CAPTURE_BLUETOOTH);
+  default:
+    return pcap_session_writev(session, iov, 3);
+  }
+}
+
+static void run(const char *name, int path) {
+  pcap_session_config_t config = PCAP_SESSION_CONFIG_DEFAULT();
+  pcap_session_t *session =
+      pcap_session_open_ex("writev", PCAP_CAPTURE_BLUETOOTH, &config);
+  if (session == NULL) {
+    fprintf(stderr, "pcap_writev: cannot open a session\n");
+    return;
+  }
+
+  uint64_t elapsed = 0;
+  uint32_t failed = 0;
+  for (int round = 0; round < ROUNDS; round++) {
+    uint64_t start = test_now_ns();
+    for (int i = 0; i < BATCH; i++) {
+      adv_data[0] = (uint8_t)i;
+      failed += write_report(path, session) != ESP_OK;
+    }
+    elapsed += test_now_ns() - start;
+    // Let the writer empty the ring outside the timed part.
+    pcap_session_flush(session);
+    vTaskDelay(1);
+  }
+
+  pcap_stats_t stats;
+  pcap_session_get_stats(session, &stats);
+  pcap_session_close(session);
+  remove("build/writev.pcap");
+
+  printf("pcap_writev: %-20s %6.1f ns/packet, %u written, %u failed\n", name,
+         (double)elapsed / (ROUNDS * BATCH), stats.packets_written, failed);
+}
+
+int main(void) {
+  if (pcap_init() != ESP_OK) {
+    return 1;
+  }
+  memset(adv_data, 0xa5, sizeof(adv_data));
+
+  run("malloc + copy", OLD_MALLOC);
+  run("pcap_write_packetv", PACKETV);
+  run("pcap_session_writev", SESSION_WRITEV);
+  return 0;
+}
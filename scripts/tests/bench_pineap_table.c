@@ -0,0 +1,59 @@
+// bench_pineap_table.c
+//
+// Memory and per-beacon cost of pineap_table_observe with 500 BSSIDs in
+// range, 10 of them rotating SSIDs like a PineAP, at several table sizes
+// (CONFIG_PINEAP_MAX_NETWORKS).
+
+#include "core/pineap_table.h"
+#include "test.h"
+#include <string.h>
+
+#define BSSIDS 500
+#define ROTATING 10
+#define BEACONS_PER_S 5000 // About ten per AP
+#define BEACONS 10000000
+
+static char ssids[BSSIDS][33];
+static uint8_t bssids[BSSIDS][6];
+
+int main(void) {
+  static const uint32_t sizes[] = {512, 1024, 2048};
+  uint32_t rng = 1;
+
+  for (int i = 0; i < BSSIDS; i++) {
+    rng = rng * 1103515245u + 12345u;
+    bssids[i][0] = 0x24;
+    bssids[i][1] = 0x0a;
+    bssids[i][2] = 0xc4;
+    memcpy(&bssids[i][3], &rng, 3);
+    snprintf(ssids[i], sizeof(ssids[i]), "network-%05u", rng % 100000);
+  }
+
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    mac_table_t table;
+    if (mac_table_init(&table, sizes[s], sizeof(pineap_network_t)) != ESP_OK) {
+      return 1;
+    }
+    pineap_alert_t alert;
+    uint32_t alerts = 0;
+    uint64_t start = test_now_ns();
+    for (uint32_t b = 0; b < BEACONS; b++) {
+      uint32_t ap = (b * 7919u) % BSSIDS;
+      // The first ROTATING APs cycle through their neighbours' SSIDs
+      const char *ssid = ap < ROTATING ? ssids[(ap + b / BSSIDS) % BSSIDS]
+                                       : ssids[ap];
+      alerts += pineap_table_observe(&table, bssids[ap], ssid, 6, -60,
+                                     b / BEACONS_PER_S, 300, &alert);
+    }
+    double ns = (double)(test_now_ns() - start) / BEACONS;
+
+    mac_table_stats_t stats;
+    mac_table_get_stats(&table, &stats);
+    printf("pineap_table: %4u slots, %3zu KB, %.1f ns/beacon, %u BSSIDs "
+           "held, %u evictions, %u alerts\n",
+           stats.capacity, (size_t)stats.capacity * table.slot_size / 1024, ns,
+           stats.count, stats.evictions, alerts);
+    mac_table_free(&table);
+  }
+  return 0;
+}
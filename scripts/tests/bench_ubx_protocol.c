@@ -0,0 +1,65 @@
+// bench_ubx_protocol.c
+//
+// CPU and UART cost per fix: a NAV-PVT frame fed byte by byte through
+// ubx_parser_feed and decoded, next to the GGA and RMC pair nmea_decode_line
+// needs for the same fields.
+
+#include "vendor/GPS/ubx_protocol.h"
+#include "test.h"
+#include <string.h>
+
+#define ROUNDS 2000000
+
+static const char *lines[] = {
+    "$GPGGA,123519.25,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*6E\r\n",
+    "$GPRMC,123519,A,4807.038,S,01131.000,W,022.4,084.4,230394,003.1,W*65\r\n",
+};
+
+int main(void) {
+  uint8_t payload[UBX_NAV_PVT_LEN] = {0};
+  uint8_t frame[UBX_NAV_PVT_LEN + UBX_FRAME_OVERHEAD];
+  payload[4] = 2026 & 0xff;
+  payload[5] = 2026 >> 8;
+  payload[6] = 3;
+  payload[7] = 17;
+  payload[11] = 0x03;
+  payload[20] = 3;
+  payload[21] = 0x01;
+  payload[23] = 8;
+  memcpy(payload + 28, &(int32_t){481173000}, 4);
+  memcpy(payload + 24, &(int32_t){115166667}, 4);
+  size_t frame_len = ubx_build_frame(frame, UBX_CLASS_NAV, UBX_ID_NAV_PVT,
+                                     payload, sizeof(payload));
+
+  ubx_parser_t parser;
+  nmea_data_t d;
+  memset(&parser, 0, sizeof(parser));
+  memset(&d, 0, sizeof(d));
+  uint32_t fixes = 0;
+  uint64_t start = test_now_ns();
+  for (int r = 0; r < ROUNDS; r++) {
+    for (size_t i = 0; i < frame_len; i++) {
+      if (ubx_parser_feed(&parser, frame[i])) {
+        fixes += ubx_decode_nav_pvt(parser.payload, parser.len, &d);
+      }
+    }
+  }
+  double ubx_ns = (double)(test_now_ns() - start) / ROUNDS;
+  if (fixes != ROUNDS || d.lat_e7 != 481173000) {
+    fprintf(stderr, "ubx_protocol: decoded %u of %d fixes\n", fixes, ROUNDS);
+    return 1;
+  }
+
+  size_t lens[2] = {strlen(lines[0]), strlen(lines[1])};
+  start = test_now_ns();
+  for (int r = 0; r < ROUNDS; r++) {
+    nmea_decode_line(lines[0], lens[0], 0x7e, &d);
+    nmea_decode_line(lines[1], lens[1], 0x7e, &d);
+  }
+  double nmea_ns = (double)(test_now_ns() - start) / ROUNDS;
+
+  printf("ubx_protocol: %.0f ns/fix over %zu UART bytes, NMEA GGA+RMC "
+         "%.0f ns/fix over %zu bytes\n",
+         ubx_ns, frame_len, nmea_ns, lens[0] + lens[1]);
+  return 0;
+}
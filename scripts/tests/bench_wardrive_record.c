@@ -0,0 +1,133 @@
+// bench_wardrive_record.c
+//
+// What a wardriving sighting costs the radio callback. Before records were
+// queued, the callback formatted the MAC, the timestamp and the whole WiGLE
+// row with snprintf and float conversions; legacy_row() below is a host copy
+// of that path. Now the callback fills a 64-byte wardrive_record_t and posts
+// it to the logger queue, modelled here as a copy into a ring of
+// CONFIG_WARDRIVE_QUEUE_LEN records, and wardrive_format_csv_row() runs on
+// the logger task. The FreeRTOS queue's own locking is not included.
+
+#include "vendor/GPS/wardrive_format.h"
+#include "test.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define ROUNDS 2000000
+#define QUEUE_LEN 64 // CONFIG_WARDRIVE_QUEUE_LEN default
+
+typedef struct {
+  int32_t lat_e7, lon_e7, alt_cm;
+  uint16_t accuracy_dm, millis;
+  uint8_t sats;
+  uint32_t timestamp;
+} fix_t;
+
+typedef struct {
+  uint8_t bssid[6];
+  char ssid[33];
+  uint8_t ssid_len;
+  uint8_t channel, auth;
+  int8_t rssi;
+} sighting_t;
+
+static const char *const legacy_auth[] = {"[OPEN][ESS]", "[WEP][ESS]",
+                                          "[WPA][ESS]", "[WPA2][ESS]"};
+
+static wardrive_record_t queue[QUEUE_LEN];
+static uint32_t queue_head;
+
+// The old callback path: MAC and timestamp strings, then the row with
+// double coordinates, into the stack buffer it then copied to csv_buffer.
+static int legacy_row(const sighting_t *s, const fix_t *fix, char *out,
+                      size_t size) {
+  char bssid[18];
+  snprintf(bssid, sizeof(bssid), "%02x:%02x:%02x:%02x:%02x:%02x", s->bssid[0],
+           s->bssid[1], s->bssid[2], s->bssid[3], s->bssid[4], s->bssid[5]);
+
+  time_t t = fix->timestamp;
+  struct tm tm;
+  gmtime_r(&t, &tm);
+  char timestamp[64];
+  snprintf(timestamp, sizeof(timestamp), "%04d-%02d-%02d %02d:%02d:%02d.%03d",
+           tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour,
+           tm.tm_min, tm.tm_sec, fix->millis);
+
+  int frequency =
+      s->channel > 14 ? 5000 + s->channel * 5 : 2407 + s->channel * 5;
+  return snprintf(out, size, "%s,%s,%s,%s,%d,%d,%d,%.6f,%.6f,%.1f,%.1f,WIFI\n",
+                  bssid, s->ssid, legacy_auth[s->auth & 3], timestamp,
+                  s->channel, frequency, s->rssi, fix->lat_e7 / 1e7,
+                  fix->lon_e7 / 1e7, fix->alt_cm / 100.0,
+                  fix->accuracy_dm / 10.0);
+}
+
+// The new callback path, as wardriving_scan_callback() and
+// gps_manager_log_wardriving_record() do it.
+static void pack_record(const sighting_t *s, const fix_t *fix) {
+  wardrive_record_t record = {0};
+  memcpy(record.mac, s->bssid, 6);
+  record.kind = WARDRIVE_RECORD_WIFI;
+  record.channel = s->channel;
+  record.rssi = s->rssi;
+  record.auth = s->auth;
+  record.name_len = s->ssid_len;
+  memcpy(record.name, s->ssid, s->ssid_len);
+  record.lat_e7 = fix->lat_e7;
+  record.lon_e7 = fix->lon_e7;
+  record.alt_cm = fix->alt_cm;
+  record.accuracy_dm = fix->accuracy_dm;
+  record.sats = fix->sats;
+  record.timestamp = fix->timestamp;
+  record.millis = fix->millis;
+  queue[queue_head++ % QUEUE_LEN] = record;
+}
+
+int main(void) {
+  static sighting_t sightings[16];
+  for (int i = 0; i < 16; i++) {
+    sighting_t *s = &sightings[i];
+    for (int j = 0; j < 6; j++) {
+      s->bssid[j] = (uint8_t)(0x10 * j + i);
+    }
+    s->ssid_len = (uint8_t)snprintf(s->ssid, sizeof(s->ssid), "network-%02d", i);
+    s->channel = (uint8_t)(1 + i % 11);
+    s->auth = (uint8_t)(i % 4);
+    s->rssi = (int8_t)(-40 - i);
+  }
+  fix_t fix = {.lat_e7 = 481173000, .lon_e7 = 115167000, .alt_cm = 54540,
+               .accuracy_dm = 45, .millis = 250, .sats = 9,
+               .timestamp = 1760000000};
+
+  char row[WARDRIVE_CSV_ROW_MAX];
+  size_t bytes = 0;
+  uint64_t start = test_now_ns();
+  for (int i = 0; i < ROUNDS; i++) {
+    fix.millis = (uint16_t)(i % 1000);
+    bytes += legacy_row(&sightings[i & 15], &fix, row, sizeof(row));
+  }
+  double legacy_ns = (double)(test_now_ns() - start) / ROUNDS;
+
+  start = test_now_ns();
+  for (int i = 0; i < ROUNDS; i++) {
+    fix.millis = (uint16_t)(i % 1000);
+    pack_record(&sightings[i & 15], &fix);
+  }
+  double pack_ns = (double)(test_now_ns() - start) / ROUNDS;
+
+  start = test_now_ns();
+  for (int i = 0; i < ROUNDS; i++) {
+    int len = wardrive_format_csv_row(&queue[i % QUEUE_LEN], row, sizeof(row));
+    bytes += len > 0 ? (size_t)len : 0;
+  }
+  double format_ns = (double)(test_now_ns() - start) / ROUNDS;
+
+  printf("wardrive_record: callback %.1f ns/sighting packing a record, "
+         "%.1f ns formatting the row inline (%.0fx)\n",
+         pack_ns, legacy_ns, legacy_ns / pack_ns);
+  printf("wardrive_record: logger task %.1f ns/row in wardrive_format_csv_row "
+         "(%zu bytes formatted)\n",
+         format_ns, bytes);
+  return 0;
+}
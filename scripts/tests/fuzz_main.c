@@ -0,0 +1,94 @@
+// fuzz_main.c
+//
+// Runs a libFuzzer target without libFuzzer. Given files, it feeds each one
+// once, which is how a crash found by "make fuzz" is replayed under gcc.
+// Without arguments it feeds random mutations of the seed inputs the target
+// provides, so "make" gets a quick smoke run on any compiler.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+// Seeds come from the target's fuzz_seeds[] table.
+extern const char *const fuzz_seeds[];
+
+#define FUZZ_RUNS 200000
+#define FUZZ_MAX_LEN 256
+
+static uint32_t fuzz_rand(void) {
+  static uint32_t state = 0x2545f491;
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+static int run_file(const char *path) {
+  FILE *in = fopen(path, "rb");
+  if (in == NULL) {
+    perror(path);
+    return 1;
+  }
+  static uint8_t buf[1 << 20];
+  size_t len = fread(buf, 1, sizeof(buf), in);
+  fclose(in);
+  LLVMFuzzerTestOneInput(buf, len);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) {
+    for (int i = 1; i < argc; i++) {
+      if (run_file(argv[i]) != 0) {
+        return 1;
+      }
+    }
+    return 0;
+  }
+
+  size_t seeds = 0;
+  while (fuzz_seeds[seeds] != NULL) {
+    seeds++;
+  }
+
+  uint8_t buf[FUZZ_MAX_LEN];
+  for (long run = 0; run < FUZZ_RUNS; run++) {
+    const char *seed = fuzz_seeds[fuzz_rand() % seeds];
+    size_t len = strlen(seed);
+    memcpy(buf, seed, len);
+
+    int edits = 1 + fuzz_rand() % 4;
+    for (int e = 0; e < edits; e++) {
+      size_t pos = len > 0 ? fuzz_rand() % len : 0;
+      switch (fuzz_rand() % 4) {
+      case 0: // Flip a bit
+        if (len > 0) {
+          buf[pos] ^= 1u << (fuzz_rand() % 8);
+        }
+        break;
+      case 1: // Replace with an interesting byte
+        if (len > 0) {
+          buf[pos] = ",.*$-0987\r\n"[fuzz_rand() % 11];
+        }
+        break;
+      case 2: // Cut
+        len = pos;
+        break;
+      case 3: // Duplicate a chunk
+        if (len > 0 && len < FUZZ_MAX_LEN / 2) {
+          size_t n = 1 + fuzz_rand() % len;
+          memmove(buf + pos + n, buf + pos, len - pos);
+          len += n;
+        }
+        break;
+      }
+    }
+    LLVMFuzzerTestOneInput(buf, len);
+  }
+  printf("%s: %d runs\n", argv[0], FUZZ_RUNS);
+  return 0;
+}
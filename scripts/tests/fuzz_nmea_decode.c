@@ -0,0 +1,75 @@
+// fuzz_nmea_decode.c
+//
+// libFuzzer target for nmea_decode_line ("make fuzz", needs clang). Checks
+// that a rejected line leaves the fix untouched and that decoded fields stay
+// in range. Random input almost never carries a valid checksum, so each
+// input is also decoded with its checksum fixed up, which lets mutations
+// reach the field parsers. fuzz_main.c runs it without libFuzzer as part of
+// "make".
+
+#include "vendor/GPS/nmea_decode.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char *const fuzz_seeds[] = {
+    "$GPGGA,123519.25,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*00\r\n",
+    "$GPRMC,123519,A,4807.038,S,01131.000,W,022.4,084.4,230394,003.1,W*00\r\n",
+    "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*00\r\n",
+    "$GPGSV,2,1,08,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45*00\r\n",
+    "$GNVTG,054.7,T,034.4,M,005.5,N,010.2,K,A*00\r\n",
+    "$GPGLL,4916.45,N,12311.12,W,225444,A,*00\r\n",
+    "$PUBX,00,081350.00,4717.113210,N*00\r\n",
+    NULL,
+};
+
+static void decode(const char *data, size_t size) {
+  static nmea_data_t state;
+  nmea_data_t before = state;
+
+  // Exact-size copy so ASan catches reads past the end of the line
+  char *line = malloc(size > 0 ? size : 1);
+  memcpy(line, data, size);
+  nmea_sentence_t type = nmea_decode_line(line, size, 0xffffffff, &state);
+  free(line);
+
+  if (type <= NMEA_SENTENCE_UNKNOWN) {
+    before.checksum_errors = state.checksum_errors;
+    before.malformed = state.malformed;
+    if (memcmp(&before, &state, sizeof(state)) != 0) {
+      abort();
+    }
+  }
+  if (state.lat_e7 > 900000000 || state.lat_e7 < -900000000 ||
+      state.lon_e7 > 1800000000 || state.lon_e7 < -1800000000 ||
+      state.hour > 23 || state.minute > 59 || state.second > 60 ||
+      state.millis > 999 || state.month > 12 || state.day > 31 ||
+      state.gsv_num > state.gsv_total) {
+    abort();
+  }
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  decode((const char *)data, size);
+
+  const char *star = memchr(data, '*', size);
+  if (star == NULL) {
+    return 0;
+  }
+  size_t at = star - (const char *)data;
+  if (at + 3 > size) {
+    return 0;
+  }
+  char *fixed = malloc(size);
+  memcpy(fixed, data, size);
+  uint8_t sum = 0;
+  for (size_t i = 1; i < at; i++) {
+    sum ^= (uint8_t)fixed[i];
+  }
+  char hex[3];
+  snprintf(hex, sizeof(hex), "%02X", sum);
+  memcpy(fixed + at + 1, hex, 2);
+  decode(fixed, size);
+  free(fixed);
+  return 0;
+}
@@ -0,0 +1,126 @@
+// gen_wardrive_log.c
+//
+// Writes the inputs for the wardriving round trip ("make roundtrip"). For a
+// set of sightings it writes a binary log the way the device does, with
+// wardrive_log_header_init and wardrive_block_seal, and the CSV the device
+// would have written for the same sightings with wardrive_format_csv_row.
+// ghost_wardrive_convert must turn each .gwd into exactly its .csv.
+//
+//   <prefix>_clean.gwd / .csv     Several full blocks and a partial one
+//   <prefix>_damaged.gwd / .csv   One block corrupted after sealing and
+//                                 zeroed pre-allocated space at the end; the
+//                                 CSV leaves out the corrupted block
+
+#include "vendor/GPS/wardrive_format.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RECORDS 200
+#define CORRUPT_BLOCK 1
+
+static const char *names[] = {
+    "Home",       "",
+    "a,\"b\"",    "caf\xc3\xa9 wifi",
+    "   spaces ", "0123456789abcdef0123456789abcdef", // 32 bytes
+    "tab\there",  "line\nbreak",
+};
+
+static void make_record(wardrive_record_t *r, int i) {
+  memset(r, 0, sizeof(*r));
+  r->mac[0] = 0xaa;
+  r->mac[1] = 0xbb;
+  r->mac[4] = i >> 8;
+  r->mac[5] = i & 0xff;
+  r->kind = i % 5 == 0 ? WARDRIVE_RECORD_BLE : WARDRIVE_RECORD_WIFI;
+  r->channel = i % 7 == 0 ? 36 + 4 * (i % 8) : 1 + i % 14;
+  r->rssi = -30 - i % 65;
+  r->auth = i % 4;
+  const char *name = names[i % (sizeof(names) / sizeof(names[0]))];
+  r->name_len = strlen(name);
+  memcpy(r->name, name, r->name_len);
+  r->sats = i % 13;
+  // Both hemispheres, and a sighting without a fix
+  if (i % 11 != 10) {
+    r->lat_e7 = (i % 2 ? -337654321 : 515074000) + i * 37;
+    r->lon_e7 = (i % 3 ? 1512345678 : -1278000) - i * 53;
+    r->alt_cm = i % 2 ? -1234 : 4567 + i;
+    r->accuracy_dm = 25 + i % 100;
+  }
+  r->millis = (i * 37) % 1000;
+  r->timestamp = 1709210096u + i * 3607u;
+}
+
+static bool write_pair(const char *prefix, const char *name, bool damaged) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s_%s.gwd", prefix, name);
+  FILE *gwd = fopen(path, "wb");
+  snprintf(path, sizeof(path), "%s_%s.csv", prefix, name);
+  FILE *csv = fopen(path, "w");
+  if (gwd == NULL || csv == NULL) {
+    perror(path);
+    return false;
+  }
+
+  wardrive_log_header_t header;
+  wardrive_log_header_init(&header, 1709210000u);
+  fwrite(&header, 1, sizeof(header), gwd);
+
+  // Same buffer size as csv_write_header on the device
+  char text[384];
+  int len = wardrive_format_csv_header(text, sizeof(text));
+  if (len < 0 || len >= (int)sizeof(text)) {
+    fprintf(stderr, "CSV header does not fit\n");
+    return false;
+  }
+  fwrite(text, 1, len, csv);
+
+  char row[WARDRIVE_CSV_ROW_MAX];
+
+  wardrive_record_t records[WARDRIVE_BLOCK_RECORDS];
+  uint32_t seq = 0;
+  for (int i = 0; i < RECORDS; seq++) {
+    bool corrupt = damaged && seq == CORRUPT_BLOCK;
+    uint16_t count = 0;
+    for (; count < WARDRIVE_BLOCK_RECORDS && i < RECORDS; count++, i++) {
+      make_record(&records[count], i);
+      len = wardrive_format_csv_row(&records[count], row, sizeof(row));
+      if (len <= 0) {
+        fprintf(stderr, "record %d did not format\n", i);
+        return false;
+      }
+      if (!corrupt) {
+        fwrite(row, 1, len, csv);
+      }
+    }
+
+    wardrive_block_header_t block;
+    wardrive_block_seal(&block, seq, records, count);
+    if (corrupt) {
+      records[count / 2].rssi ^= 1; // One bit flipped on the card
+    }
+    fwrite(&block, 1, sizeof(block), gwd);
+    fwrite(records, sizeof(records[0]), count, gwd);
+  }
+
+  if (damaged) {
+    static const uint8_t zeros[3 * sizeof(wardrive_record_t)];
+    fwrite(zeros, 1, sizeof(zeros), gwd);
+  }
+  fclose(gwd);
+  fclose(csv);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s <output prefix>\n", argv[0]);
+    return 2;
+  }
+  if (!write_pair(argv[1], "clean", false) ||
+      !write_pair(argv[1], "damaged", true)) {
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,80 @@
+// pcap_host.c
+//
+// What pcap.c needs from the rest of the firmware, for the PCAP benchmarks:
+// capture files are plain files under build/ with no index or rotation,
+// the serial stream only counts bytes and the timebase is the host clock.
+
+#include "core/capture_rotate.h"
+#include "core/serial_stream.h"
+#include "core/timebase.h"
+#include "managers/sd_card_manager.h"
+#include "test.h"
+#include <string.h>
+
+uint64_t pcap_host_serial_bytes;
+
+int64_t esp_timer_get_time(void) { return test_now_ns() / 1000; }
+
+bool sd_card_exists(const char *path) { return true; }
+
+esp_err_t capture_file_create(const capture_spare_t *spare, capture_file_t *out) {
+  snprintf(out->path, sizeof(out->path), "build/%s.%s", spare->base_name,
+           spare->type == CAPTURE_FILE_PCAPNG ? "pcapng" : "pcap");
+  out->index = -1;
+  out->file = fopen(out->path, "wb");
+  if (out->file == NULL) {
+    return ESP_FAIL;
+  }
+  long before = ftell(out->file);
+  if (spare->write_header(out->file, spare->ctx) != ESP_OK) {
+    fclose(out->file);
+    out->file = NULL;
+    return ESP_FAIL;
+  }
+  out->header_bytes = ftell(out->file) - before;
+  return ESP_OK;
+}
+
+void capture_file_finalize(capture_file_t *file, capture_file_type_t type,
+                           const char *base_name, uint32_t packets) {
+  if (file->file != NULL) {
+    fclose(file->file);
+    file->file = NULL;
+  }
+}
+
+esp_err_t capture_spare_prepare(capture_spare_t *spare) { return ESP_OK; }
+bool capture_spare_swap(capture_spare_t *spare, capture_file_t *current,
+                        uint32_t packets) {
+  return false;
+}
+void capture_spare_shutdown(capture_spare_t *spare) {}
+
+void serial_stream_begin(serial_channel_t channel, bool new_capture) {}
+esp_err_t serial_stream_put(serial_channel_t channel, const void *data,
+                            size_t len) {
+  pcap_host_serial_bytes += len;
+  return ESP_OK;
+}
+void serial_stream_end(serial_channel_t channel, bool line_break) {}
+
+int64_t timebase_now_utc_us(void) { return esp_timer_get_time(); }
+void timebase_adopt_system_clock(void) {}
+timebase_state_t timebase_get_state(void) {
+  timebase_state_t state;
+  memset(&state, 0, sizeof(state));
+  return state;
+}
+const char *timebase_source_name(timebase_source_t source) { return "host"; }
+
+#ifdef HOST_COMPAT_STRLCPY
+size_t strlcpy(char *dst, const char *src, size_t size) {
+  size_t len = strlen(src);
+  if (size > 0) {
+    size_t n = len < size - 1 ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return len;
+}
+#endif
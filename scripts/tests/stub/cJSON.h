@@ -0,0 +1,36 @@
+#ifndef STUB_CJSON_H
+#define STUB_CJSON_H
+
+// JSON output is not under test; every builder is a no-op.
+typedef struct cJSON cJSON;
+
+static inline cJSON *cJSON_CreateObject(void) { return 0; }
+static inline cJSON *cJSON_CreateArray(void) { return 0; }
+static inline cJSON *cJSON_CreateNumber(double n) { (void)n; return 0; }
+static inline cJSON *cJSON_CreateString(const char *s) { (void)s; return 0; }
+static inline cJSON *cJSON_AddArrayToObject(cJSON *o, const char *k) {
+  (void)o; (void)k; return 0;
+}
+static inline cJSON *cJSON_AddObjectToObject(cJSON *o, const char *k) {
+  (void)o; (void)k; return 0;
+}
+static inline cJSON *cJSON_AddNumberToObject(cJSON *o, const char *k, double n) {
+  (void)o; (void)k; (void)n; return 0;
+}
+static inline cJSON *cJSON_AddBoolToObject(cJSON *o, const char *k, int b) {
+  (void)o; (void)k; (void)b; return 0;
+}
+static inline cJSON *cJSON_AddStringToObject(cJSON *o, const char *k,
+                                             const char *s) {
+  (void)o; (void)k; (void)s; return 0;
+}
+static inline int cJSON_AddItemToArray(cJSON *a, cJSON *i) {
+  (void)a; (void)i; return 0;
+}
+static inline int cJSON_AddItemToObject(cJSON *o, const char *k, cJSON *i) {
+  (void)o; (void)k; (void)i; return 0;
+}
+static inline char *cJSON_PrintUnformatted(const cJSON *o) { (void)o; return 0; }
+static inline void cJSON_Delete(cJSON *o) { (void)o; }
+
+#endif // STUB_CJSON_H
@@ -0,0 +1,7 @@
+#ifndef STUB_CORE_UTILS_H
+#define STUB_CORE_UTILS_H
+
+// The firmware's utils.h defines functions in the header and needs
+// esp_types.h; nothing from it is used by the modules built here.
+
+#endif // STUB_CORE_UTILS_H
@@ -0,0 +1,6 @@
+#ifndef STUB_DRIVER_UART_H
+#define STUB_DRIVER_UART_H
+
+// Included by pcap.c; nothing from it is used on the host.
+
+#endif // STUB_DRIVER_UART_H
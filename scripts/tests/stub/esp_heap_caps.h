@@ -0,0 +1,14 @@
+#ifndef STUB_ESP_HEAP_CAPS_H
+#define STUB_ESP_HEAP_CAPS_H
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT 0x04
+#define MALLOC_CAP_INTERNAL 0x800
+#define MALLOC_CAP_SPIRAM 0x400
+
+#define heap_caps_malloc(size, caps) malloc(size)
+#define heap_caps_calloc(n, size, caps) calloc(n, size)
+#define heap_caps_free(ptr) free(ptr)
+
+#endif // STUB_ESP_HEAP_CAPS_H
@@ -0,0 +1,9 @@
+#ifndef STUB_ESP_LOG_H
+#define STUB_ESP_LOG_H
+
+#define ESP_LOGE(tag, ...) ((void)(tag))
+#define ESP_LOGW(tag, ...) ((void)(tag))
+#define ESP_LOGI(tag, ...) ((void)(tag))
+#define ESP_LOGD(tag, ...) ((void)(tag))
+
+#endif // STUB_ESP_LOG_H
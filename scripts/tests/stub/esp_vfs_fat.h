@@ -0,0 +1,6 @@
+#ifndef STUB_ESP_VFS_FAT_H
+#define STUB_ESP_VFS_FAT_H
+
+#include "esp_err.h"
+
+#endif // STUB_ESP_VFS_FAT_H
@@ -0,0 +1,16 @@
+#ifndef STUB_ESP_WIFI_H
+#define STUB_ESP_WIFI_H
+
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+
+typedef enum {
+  WIFI_SECOND_CHAN_NONE,
+  WIFI_SECOND_CHAN_ABOVE,
+  WIFI_SECOND_CHAN_BELOW,
+} wifi_second_chan_t;
+
+// Defined by the test, which tunes its simulated radio.
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second);
+
+#endif // STUB_ESP_WIFI_H
@@ -0,0 +1,31 @@
+#ifndef STUB_ESP_WIFI_TYPES_H
+#define STUB_ESP_WIFI_TYPES_H
+
+#include <stdint.h>
+
+// Plain fields with the names the driver's bitfields use; channel is wider
+// than on the chip so tests can go past 15.
+typedef struct {
+  int8_t rssi;
+  uint8_t rate;
+  uint8_t sig_mode; // 0 = 11b/g, 1 = HT, 3 = VHT
+  uint8_t mcs;
+  uint8_t cwb; // 1 = 40 MHz
+  uint8_t sgi;
+  uint8_t channel;
+  uint16_t sig_len;
+} wifi_pkt_rx_ctrl_t;
+
+typedef struct {
+  wifi_pkt_rx_ctrl_t rx_ctrl;
+  uint8_t payload[];
+} wifi_promiscuous_pkt_t;
+
+typedef enum {
+  WIFI_PKT_MGMT,
+  WIFI_PKT_CTRL,
+  WIFI_PKT_DATA,
+  WIFI_PKT_MISC,
+} wifi_promiscuous_pkt_type_t;
+
+#endif // STUB_ESP_WIFI_TYPES_H
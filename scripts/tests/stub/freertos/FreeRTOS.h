@@ -0,0 +1,28 @@
+#ifndef STUB_FREERTOS_H
+#define STUB_FREERTOS_H
+
+#include <stdint.h>
+
+// Critical sections are spinlocks, so modules that share state between the
+// tasks of freertos_host.c keep their locking on the host. Ticks are 1 ms.
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portMUX_INITIALIZE(mux) (*(mux) = 0)
+
+#define portENTER_CRITICAL(mux)                                                \
+  do {                                                                         \
+  } while (__atomic_exchange_n((mux), 1, __ATOMIC_ACQUIRE))
+#define portEXIT_CRITICAL(mux) __atomic_store_n((mux), 0, __ATOMIC_RELEASE)
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL 0
+#define pdPASS 1
+#define portMAX_DELAY ((TickType_t)0xffffffffu)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+#endif // STUB_FREERTOS_H
@@ -0,0 +1,160 @@
+// freertos_host.c
+//
+// The FreeRTOS calls the firmware modules make, on pthreads: tasks are
+// detached threads with a notification counter, semaphores are counters
+// under a mutex. Enough for a writer task and its producers to run
+// concurrently on a host; priorities are ignored.
+
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+struct host_task {
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  uint32_t notified;
+  TaskFunction_t fn;
+  void *arg;
+};
+
+struct host_semaphore {
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  uint32_t count;
+};
+
+static __thread struct host_task *current_task;
+
+// Deadline ticks milliseconds from now, for pthread_cond_timedwait.
+static struct timespec deadline(TickType_t ticks) {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_sec += ticks / 1000;
+  ts.tv_nsec += (long)(ticks % 1000) * 1000000;
+  if (ts.tv_nsec >= 1000000000) {
+    ts.tv_sec++;
+    ts.tv_nsec -= 1000000000;
+  }
+  return ts;
+}
+
+// Waits on cond until *counter is non-zero or ticks pass; lock is held.
+static void wait_for(pthread_cond_t *cond, pthread_mutex_t *lock,
+                     const uint32_t *counter, TickType_t ticks) {
+  struct timespec until = deadline(ticks);
+  while (*counter == 0) {
+    if (ticks == portMAX_DELAY) {
+      pthread_cond_wait(cond, lock);
+    } else if (pthread_cond_timedwait(cond, lock, &until) == ETIMEDOUT) {
+      break;
+    }
+  }
+}
+
+static void *task_main(void *arg) {
+  current_task = arg;
+  current_task->fn(current_task->arg);
+  return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack,
+                       void *arg, UBaseType_t priority, TaskHandle_t *handle) {
+  struct host_task *task = calloc(1, sizeof(*task));
+  if (task == NULL) {
+    return pdFAIL;
+  }
+  pthread_mutex_init(&task->lock, NULL);
+  pthread_cond_init(&task->cond, NULL);
+  task->fn = fn;
+  task->arg = arg;
+  if (handle != NULL) {
+    *handle = task;
+  }
+  if (pthread_create(&task->thread, NULL, task_main, task) != 0) {
+    free(task);
+    return pdFAIL;
+  }
+  pthread_detach(task->thread);
+  return pdPASS;
+}
+
+// Only a task deleting itself is supported, which is all the firmware does.
+void vTaskDelete(TaskHandle_t task) {
+  struct host_task *self = current_task;
+  if (task != NULL && task != self) {
+    abort();
+  }
+  pthread_mutex_destroy(&self->lock);
+  pthread_cond_destroy(&self->cond);
+  free(self);
+  current_task = NULL;
+  pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks) {
+  struct timespec ts = {.tv_sec = ticks / 1000,
+                        .tv_nsec = (long)(ticks % 1000) * 1000000};
+  nanosleep(&ts, NULL);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+  struct host_task *self = current_task;
+  pthread_mutex_lock(&self->lock);
+  wait_for(&self->cond, &self->lock, &self->notified, ticks);
+  uint32_t value = self->notified;
+  if (value != 0) {
+    self->notified = clear ? 0 : value - 1;
+  }
+  pthread_mutex_unlock(&self->lock);
+  return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  pthread_mutex_lock(&task->lock);
+  task->notified++;
+  pthread_cond_signal(&task->cond);
+  pthread_mutex_unlock(&task->lock);
+  return pdPASS;
+}
+
+static SemaphoreHandle_t semaphore_create(uint32_t count) {
+  struct host_semaphore *sem = calloc(1, sizeof(*sem));
+  if (sem != NULL) {
+    pthread_mutex_init(&sem->lock, NULL);
+    pthread_cond_init(&sem->cond, NULL);
+    sem->count = count;
+  }
+  return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) { return semaphore_create(1); }
+SemaphoreHandle_t xSemaphoreCreateBinary(void) { return semaphore_create(0); }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+  pthread_mutex_lock(&sem->lock);
+  wait_for(&sem->cond, &sem->lock, &sem->count, ticks);
+  BaseType_t taken = sem->count != 0;
+  if (taken) {
+    sem->count--;
+  }
+  pthread_mutex_unlock(&sem->lock);
+  return taken ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+  pthread_mutex_lock(&sem->lock);
+  sem->count = 1;
+  pthread_cond_signal(&sem->cond);
+  pthread_mutex_unlock(&sem->lock);
+  return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+  pthread_mutex_destroy(&sem->lock);
+  pthread_cond_destroy(&sem->cond);
+  free(sem);
+}
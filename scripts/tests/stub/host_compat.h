@@ -0,0 +1,13 @@
+#ifndef STUB_HOST_COMPAT_H
+#define STUB_HOST_COMPAT_H
+
+// Forced in with -include for firmware sources that use newlib extensions.
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__GLIBC__) && !(__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 38))
+size_t strlcpy(char *dst, const char *src, size_t size);
+#define HOST_COMPAT_STRLCPY 1
+#endif
+
+#endif // STUB_HOST_COMPAT_H
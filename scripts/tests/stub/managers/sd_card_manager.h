@@ -0,0 +1,9 @@
+#ifndef STUB_SD_CARD_MANAGER_H
+#define STUB_SD_CARD_MANAGER_H
+
+#include <stdbool.h>
+
+// Defined by the test.
+bool sd_card_exists(const char *path);
+
+#endif // STUB_SD_CARD_MANAGER_H
@@ -0,0 +1,15 @@
+#ifndef STUB_WIFI_MANAGER_H
+#define STUB_WIFI_MANAGER_H
+
+#include "esp_wifi_types.h"
+#include <stdint.h>
+
+typedef void (*wifi_promiscuous_cb_t_t)(void *buf,
+                                        wifi_promiscuous_pkt_type_t type);
+
+// Defined by the test.
+void wifi_manager_start_monitor_mode(const char *name, uint64_t frame_mask,
+                                     wifi_promiscuous_cb_t_t callback);
+void wifi_manager_stop_monitor_consumer(const char *name);
+
+#endif // STUB_WIFI_MANAGER_H
@@ -0,0 +1,46 @@
+#ifndef GHOST_TEST_H
+#define GHOST_TEST_H
+
+// Minimal check macros for the host tests. A failed CHECK prints where it
+// failed and keeps going; main returns test_report().
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+static int test_checks;
+static int test_failures;
+
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    test_checks++;                                                             \
+    if (!(cond)) {                                                             \
+      test_failures++;                                                         \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+    }                                                                          \
+  } while (0)
+
+#define CHECK_EQ(a, b)                                                         \
+  do {                                                                         \
+    long long check_a_ = (long long)(a), check_b_ = (long long)(b);            \
+    test_checks++;                                                             \
+    if (check_a_ != check_b_) {                                                \
+      test_failures++;                                                         \
+      fprintf(stderr, "%s:%d: %s == %s failed (%lld != %lld)\n", __FILE__,     \
+              __LINE__, #a, #b, check_a_, check_b_);                           \
+    }                                                                          \
+  } while (0)
+
+static inline int test_report(const char *name) {
+  printf("%s: %d checks, %d failed\n", name, test_checks, test_failures);
+  return test_failures == 0 ? 0 : 1;
+}
+
+// Monotonic clock for the benchmarks
+static inline uint64_t test_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+#endif // GHOST_TEST_H
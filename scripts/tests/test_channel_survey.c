@@ -0,0 +1,186 @@
+// test_channel_survey.c
+//
+// Per-channel accounting of main/core/channel_survey.c: frames replayed
+// through channel_survey_record, then read back with channel_survey_get.
+
+#include "core/channel_survey.h"
+#include "core/frame_dispatch.h"
+#include "managers/wifi_manager.h"
+#include "test.h"
+#include <math.h>
+#include <string.h>
+
+// Hopper and monitor stand-ins; the survey only reads dwell times.
+static channel_hop_stats_t hop_stats[CHANNEL_HOPPER_MAX_CHANNELS];
+static int hop_count;
+static int hop_resets;
+
+int channel_hopper_get_stats(channel_hop_stats_t *stats, int max) {
+  int count = hop_count < max ? hop_count : max;
+  memcpy(stats, hop_stats, count * sizeof(*stats));
+  return count;
+}
+void channel_hopper_reset_stats(void) { hop_resets++; }
+esp_err_t channel_hopper_acquire(void) { return ESP_OK; }
+void channel_hopper_release(void) {}
+void wifi_manager_start_monitor_mode(const char *name, uint64_t frame_mask,
+                                     wifi_promiscuous_cb_t_t callback) {
+  (void)name, (void)frame_mask, (void)callback;
+}
+void wifi_manager_stop_monitor_consumer(const char *name) { (void)name; }
+
+typedef struct {
+  wifi_pkt_rx_ctrl_t rx_ctrl;
+  uint8_t payload[64];
+} test_pkt_t;
+
+static void record(uint8_t channel, uint8_t type, uint8_t subtype,
+                   uint32_t addr2, int8_t rssi, uint16_t len) {
+  test_pkt_t pkt;
+  memset(&pkt, 0, sizeof(pkt));
+  pkt.rx_ctrl.channel = channel;
+  pkt.rx_ctrl.rssi = rssi;
+  pkt.rx_ctrl.rate = 11; // 6 Mbps OFDM
+  pkt.rx_ctrl.sig_len = len;
+  pkt.payload[0] = (subtype << 4) | (type << 2);
+  pkt.payload[10] = 0x02;
+  memcpy(pkt.payload + 12, &addr2, sizeof(addr2));
+  channel_survey_record((const wifi_promiscuous_pkt_t *)&pkt);
+}
+
+static uint32_t airtime(uint8_t rate, uint8_t sig_mode, uint8_t mcs,
+                        uint8_t cwb, uint8_t sgi, uint16_t len) {
+  wifi_pkt_rx_ctrl_t rx = {
+      .rate = rate, .sig_mode = sig_mode, .mcs = mcs, .cwb = cwb, .sgi = sgi,
+      .sig_len = len};
+  return channel_survey_airtime_us(&rx);
+}
+
+static void test_airtime(void) {
+  // Preamble plus payload bits at the PHY rate, rounded up
+  CHECK_EQ(airtime(0, 0, 0, 0, 0, 100), 192 + 800);   // 1 Mbps long
+  CHECK_EQ(airtime(7, 0, 0, 0, 0, 100), 96 + 73);     // 11 Mbps short
+  CHECK_EQ(airtime(11, 0, 0, 0, 0, 100), 20 + 134);   // 6 Mbps
+  CHECK_EQ(airtime(12, 0, 0, 0, 0, 1500), 20 + 223);  // 54 Mbps
+  CHECK_EQ(airtime(0, 1, 7, 0, 0, 100), 36 + 13);     // HT20 MCS7, 65 Mbps
+  CHECK_EQ(airtime(0, 1, 7, 1, 1, 100), 36 + 6);      // HT40 SGI, 150 Mbps
+  CHECK_EQ(airtime(0, 1, 15, 0, 0, 100), 36 + 7);     // Two streams
+  CHECK_EQ(airtime(0, 1, 0, 0, 0, 0), 36);
+}
+
+static void test_record(void) {
+  channel_survey_t s[SURVEY_MAX_CHANNELS];
+
+  channel_survey_reset();
+  CHECK_EQ(channel_survey_get(s, SURVEY_MAX_CHANNELS), 0);
+
+  // Channel 6: three APs beaconing, a station sending data, an RTS/ACK
+  // exchange. ACKs have no transmitter address.
+  for (uint32_t ap = 1; ap <= 3; ap++) {
+    record(6, FRAME_TYPE_MGMT, FRAME_SUBTYPE_BEACON, ap, -55, 200);
+  }
+  for (int i = 0; i < 4; i++) {
+    record(6, FRAME_TYPE_DATA, 0x8, 100, -70, 1000);
+  }
+  record(6, FRAME_TYPE_CTRL, 0xb, 200, -95, 20); // RTS
+  record(6, FRAME_TYPE_CTRL, 0xd, 300, -30, 14); // ACK
+  record(6, FRAME_TYPE_CTRL, 0xd, 400, -10, 14);
+  // Channel 1 is heard after 6, so it is reported second
+  record(1, FRAME_TYPE_MGMT, FRAME_SUBTYPE_PROBE_REQ, 500, -90, 60);
+  record(1, FRAME_TYPE_MGMT, FRAME_SUBTYPE_PROBE_REQ, 500, -81, 60);
+  // Too short to have a frame control field: ignored
+  record(1, FRAME_TYPE_MGMT, FRAME_SUBTYPE_BEACON, 600, -40, 1);
+
+  CHECK_EQ(channel_survey_get(s, SURVEY_MAX_CHANNELS), 2);
+  CHECK_EQ(s[0].channel, 6);
+  CHECK_EQ(s[0].mgmt_frames, 3);
+  CHECK_EQ(s[0].data_frames, 4);
+  CHECK_EQ(s[0].ctrl_frames, 3);
+  CHECK_EQ(s[0].bytes, 3 * 200 + 4 * 1000 + 20 + 2 * 14);
+  uint64_t expect_us = 3 * (20 + 267) + 4 * (20 + 1334) + (20 + 27) +
+                       2 * (20 + 19);
+  CHECK_EQ(s[0].airtime_us, expect_us);
+  CHECK_EQ(s[0].rssi_max, -10);
+  CHECK_EQ(s[0].rssi_hist[0], 1); // -95
+  CHECK_EQ(s[0].rssi_hist[3], 4); // -70
+  CHECK_EQ(s[0].rssi_hist[4], 3); // -55
+  CHECK_EQ(s[0].rssi_hist[7], 2); // -30 and -10 share the top bucket
+  CHECK_EQ(s[0].transmitters, 5); // 3 APs, the station, the RTS sender
+  CHECK_EQ(s[0].dwell_ms, 0);
+  CHECK_EQ(s[0].busy_x10, 0);
+
+  CHECK_EQ(s[1].channel, 1);
+  CHECK_EQ(s[1].mgmt_frames, 2);
+  CHECK_EQ(s[1].rssi_hist[1], 2); // -90 and -81
+  CHECK_EQ(s[1].rssi_max, -81);
+  CHECK_EQ(s[1].transmitters, 1);
+
+  // Busy share is airtime over the hopper's dwell there, per mille
+  hop_count = 2;
+  hop_stats[0] = (channel_hop_stats_t){.channel = 1, .dwell_ms = 1};
+  hop_stats[1] = (channel_hop_stats_t){.channel = 6, .dwell_ms = 50};
+  CHECK_EQ(channel_survey_get(s, 1), 1);
+  CHECK_EQ(s[0].dwell_ms, 50);
+  CHECK_EQ(s[0].busy_x10, expect_us / 50);
+  CHECK_EQ(channel_survey_get(s, SURVEY_MAX_CHANNELS), 2);
+  CHECK_EQ(s[1].dwell_ms, 1);
+  CHECK_EQ(s[1].busy_x10, 2 * (20 + 80));
+  hop_stats[1].dwell_ms = 5;
+  CHECK_EQ(channel_survey_get(s, 1), 1);
+  CHECK_EQ(s[0].busy_x10, 1000); // Clamped at 100%
+  hop_count = 0;
+
+  int resets = hop_resets;
+  channel_survey_reset();
+  CHECK_EQ(hop_resets, resets + 1);
+  CHECK_EQ(channel_survey_get(s, SURVEY_MAX_CHANNELS), 0);
+  record(6, FRAME_TYPE_MGMT, FRAME_SUBTYPE_BEACON, 1, -55, 200);
+  CHECK_EQ(channel_survey_get(s, SURVEY_MAX_CHANNELS), 1);
+  CHECK_EQ(s[0].mgmt_frames, 1); // Slot starts clean after a reset
+  CHECK_EQ(s[0].bytes, 200);
+}
+
+static void test_limits(void) {
+  channel_survey_t s[SURVEY_MAX_CHANNELS + 1];
+
+  // Channels past the table size are dropped, not mixed into others
+  channel_survey_reset();
+  for (int ch = 1; ch <= SURVEY_MAX_CHANNELS + 4; ch++) {
+    record(ch, FRAME_TYPE_MGMT, FRAME_SUBTYPE_BEACON, ch, -60, 100);
+  }
+  CHECK_EQ(channel_survey_get(s, SURVEY_MAX_CHANNELS + 1), SURVEY_MAX_CHANNELS);
+  CHECK_EQ(s[SURVEY_MAX_CHANNELS - 1].channel, SURVEY_MAX_CHANNELS);
+  CHECK_EQ(s[SURVEY_MAX_CHANNELS - 1].mgmt_frames, 1);
+
+  // Linear counting stays close well past the bitmap size
+  static const int populations[] = {50, 300, 1000};
+  for (size_t p = 0; p < sizeof(populations) / sizeof(populations[0]); p++) {
+    int n = populations[p];
+    channel_survey_reset();
+    for (int rounds = 0; rounds < 3; rounds++) {
+      for (int i = 0; i < n; i++) {
+        record(11, FRAME_TYPE_DATA, 0, 0x10000 + i * 2654435761u, -60, 100);
+      }
+    }
+    CHECK_EQ(channel_survey_get(s, 1), 1);
+    double error = fabs((double)s[0].transmitters - n) / n;
+    printf("  %d transmitters estimated as %u\n", n, s[0].transmitters);
+    CHECK(error < 0.15);
+  }
+
+  // A saturated bitmap reports its ceiling instead of dividing by zero
+  channel_survey_reset();
+  for (uint32_t i = 0; i < 20000; i++) {
+    record(3, FRAME_TYPE_DATA, 0, i * 2654435761u, -60, 100);
+  }
+  CHECK_EQ(channel_survey_get(s, 1), 1);
+  CHECK_EQ(s[0].transmitters,
+           lround(SURVEY_TX_BITMAP_BITS * log(SURVEY_TX_BITMAP_BITS)));
+}
+
+int main(void) {
+  test_airtime();
+  test_record();
+  test_limits();
+  return test_report("channel_survey");
+}
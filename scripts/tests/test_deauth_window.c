@@ -0,0 +1,169 @@
+// test_deauth_window.c
+//
+// Flood detection timelines for main/core/deauth_window.c. Times are
+// bucket numbers (seconds), as deauth_watch passes them in.
+
+#include "core/deauth_window.h"
+#include "test.h"
+#include <string.h>
+
+#define THRESHOLD 16
+
+static const uint8_t ap[6] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55};
+static const uint8_t spoof[6] = {0x02, 0x99, 0x99, 0x99, 0x99, 0x99};
+
+// Records count frames in bucket now and returns the last event.
+static deauth_flood_event_t burst(deauth_flood_t *flood,
+                                  const deauth_frame_t *frame, uint32_t now,
+                                  int count) {
+  deauth_flood_event_t event = DEAUTH_FLOOD_NONE;
+  for (int i = 0; i < count; i++) {
+    deauth_flood_event_t e = deauth_flood_record(flood, frame, now, THRESHOLD);
+    if (e != DEAUTH_FLOOD_NONE) {
+      event = e;
+    }
+  }
+  return event;
+}
+
+static void test_window(void) {
+  deauth_window_t w;
+  memset(&w, 0, sizeof(w));
+
+  for (int i = 0; i < 3; i++) {
+    deauth_window_add(&w, 0);
+  }
+  CHECK_EQ(deauth_window_add(&w, 1), 4);
+  CHECK_EQ(deauth_window_add(&w, 1), 5);
+  CHECK_EQ(deauth_window_advance(&w, 7), 5); // Bucket 0 is still inside
+  CHECK_EQ(deauth_window_advance(&w, 8), 2);
+  CHECK_EQ(deauth_window_advance(&w, 9), 0);
+
+  // Buckets saturate at 255 frames
+  memset(&w, 0, sizeof(w));
+  for (int i = 0; i < 1000; i++) {
+    deauth_window_add(&w, 5);
+  }
+  CHECK_EQ(w.sum, 255);
+  for (uint32_t t = 6; t < 13; t++) {
+    for (int i = 0; i < 1000; i++) {
+      deauth_window_add(&w, t);
+    }
+  }
+  CHECK_EQ(w.sum, 8 * 255);
+  CHECK_EQ(deauth_window_advance(&w, 13), 7 * 255);
+  CHECK_EQ(deauth_window_advance(&w, 5), 7 * 255); // Time going back
+  CHECK_EQ(deauth_window_add(&w, 5), 7 * 255 + 1); // Counts in the head
+  CHECK_EQ(w.counts[13 % DEAUTH_WINDOW_BUCKETS], 1);
+  CHECK_EQ(deauth_window_advance(&w, 1000), 0);
+}
+
+static void test_broadcast_flood(void) {
+  deauth_flood_t f;
+  deauth_frame_t frame = {.source = ap, .broadcast = true, .reason = 7,
+                          .subtype = 12};
+  memset(&f, 0, sizeof(f));
+
+  // 16 broadcast deauths in one second from the AP's address
+  CHECK_EQ(burst(&f, &frame, 100, 15), DEAUTH_FLOOD_NONE);
+  CHECK_EQ(deauth_flood_record(&f, &frame, 100, THRESHOLD),
+           DEAUTH_FLOOD_STARTED);
+  CHECK(f.flooding && f.frames == 16 && f.broadcast == 16);
+  CHECK(!f.sources_vary && memcmp(f.source, ap, 6) == 0);
+
+  // A second transmitter joins
+  frame.source = spoof;
+  frame.broadcast = false;
+  CHECK_EQ(deauth_flood_record(&f, &frame, 101, THRESHOLD), DEAUTH_FLOOD_NONE);
+  CHECK(f.sources_vary && memcmp(f.source, spoof, 6) == 0);
+  CHECK(f.peak == 17 && f.frames == 17 && f.broadcast == 16);
+
+  // Ends once the window falls below half the threshold
+  CHECK_EQ(deauth_flood_expire(&f, 107, THRESHOLD), DEAUTH_FLOOD_NONE);
+  CHECK_EQ(deauth_flood_expire(&f, 108, THRESHOLD), DEAUTH_FLOOD_ENDED);
+  CHECK_EQ(deauth_flood_expire(&f, 109, THRESHOLD), DEAUTH_FLOOD_NONE);
+  CHECK(!f.flooding && f.peak == 17);
+
+  // After an empty window the next frame starts a fresh episode
+  frame.source = ap;
+  CHECK_EQ(deauth_flood_record(&f, &frame, 200, THRESHOLD), DEAUTH_FLOOD_NONE);
+  CHECK(f.frames == 1 && f.broadcast == 0 && f.peak == 0 && !f.sources_vary);
+}
+
+static void test_targeted_flood(void) {
+  deauth_flood_t f;
+  // Disassociations aimed at one client, reason 8 (leaving the BSS)
+  deauth_frame_t frame = {.source = ap, .broadcast = false, .reason = 8,
+                          .subtype = 10};
+  memset(&f, 0, sizeof(f));
+
+  // 10 frames a second: the threshold is reached 6 frames into the second
+  CHECK_EQ(burst(&f, &frame, 50, 10), DEAUTH_FLOOD_NONE);
+  CHECK_EQ(burst(&f, &frame, 51, 5), DEAUTH_FLOOD_NONE);
+  CHECK_EQ(deauth_flood_record(&f, &frame, 51, THRESHOLD),
+           DEAUTH_FLOOD_STARTED);
+  CHECK(f.broadcast == 0 && f.frames == 16);
+  CHECK(f.subtype == 10 && f.reason == 8);
+
+  // Protected frames carry no readable reason; the last frame wins
+  frame.subtype = 12;
+  frame.reason = 0;
+  CHECK_EQ(burst(&f, &frame, 52, 10), DEAUTH_FLOOD_NONE);
+  CHECK(f.subtype == 12 && f.reason == 0);
+  CHECK_EQ(f.peak, 26);
+  CHECK_EQ(f.frames, 26);
+}
+
+static void test_hysteresis(void) {
+  deauth_flood_t f;
+  deauth_frame_t frame = {.source = ap, .broadcast = true, .reason = 7,
+                          .subtype = 12};
+
+  // One frame short of the threshold per window never starts a flood
+  memset(&f, 0, sizeof(f));
+  for (uint32_t t = 0; t < 100; t += 8) {
+    CHECK_EQ(burst(&f, &frame, t, THRESHOLD - 1), DEAUTH_FLOOD_NONE);
+  }
+  CHECK(!f.flooding);
+
+  // Once started, a steady half rate keeps it going
+  memset(&f, 0, sizeof(f));
+  CHECK_EQ(burst(&f, &frame, 0, THRESHOLD), DEAUTH_FLOOD_STARTED);
+  bool ended = false;
+  for (uint32_t t = 1; t <= 30; t++) {
+    ended |= deauth_flood_record(&f, &frame, t, THRESHOLD) != DEAUTH_FLOOD_NONE;
+    ended |= deauth_flood_expire(&f, t, THRESHOLD) != DEAUTH_FLOOD_NONE;
+  }
+  CHECK(!ended && f.flooding);
+  CHECK_EQ(f.window.sum, THRESHOLD / 2);
+  CHECK_EQ(f.frames, THRESHOLD + 30);
+  CHECK_EQ(f.peak, THRESHOLD + 7); // Before bucket 0 slid out
+
+  // One quiet second drops it below half
+  CHECK_EQ(deauth_flood_expire(&f, 31, THRESHOLD), DEAUTH_FLOOD_ENDED);
+  // The window is not empty yet, so this is still the same episode
+  CHECK_EQ(deauth_flood_record(&f, &frame, 32, THRESHOLD), DEAUTH_FLOOD_NONE);
+  CHECK_EQ(f.frames, THRESHOLD + 31);
+
+  // Odd thresholds round the half up: 5 ends below 3
+  memset(&f, 0, sizeof(f));
+  deauth_flood_record(&f, &frame, 0, 5);
+  deauth_flood_record(&f, &frame, 0, 5);
+  deauth_flood_record(&f, &frame, 1, 5);
+  deauth_flood_record(&f, &frame, 1, 5);
+  CHECK_EQ(deauth_flood_record(&f, &frame, 1, 5), DEAUTH_FLOOD_STARTED);
+  CHECK_EQ(deauth_flood_expire(&f, 8, 5), DEAUTH_FLOOD_NONE); // 3 left
+  CHECK_EQ(deauth_flood_expire(&f, 9, 5), DEAUTH_FLOOD_ENDED);
+
+  // Nothing to expire when no flood is running
+  memset(&f, 0, sizeof(f));
+  CHECK_EQ(deauth_flood_expire(&f, 1000, THRESHOLD), DEAUTH_FLOOD_NONE);
+}
+
+int main(void) {
+  test_window();
+  test_broadcast_flood();
+  test_targeted_flood();
+  test_hysteresis();
+  return test_report("deauth_window");
+}
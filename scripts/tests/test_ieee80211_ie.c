@@ -0,0 +1,268 @@
+// test_ieee80211_ie.c
+//
+// Element walking, length validation and the one-pass parse of
+// main/core/ieee80211_ie.c, on frames built element by element.
+
+#include "core/ieee80211_ie.h"
+#include "test.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  uint8_t data[512];
+  size_t len;
+} frame_t;
+
+// 24-byte management header followed by the subtype's fixed fields.
+static void frame_mgmt(frame_t *f, uint8_t subtype, size_t fixed) {
+  memset(f, 0, sizeof(*f));
+  f->data[0] = subtype << 4;
+  f->len = IEEE80211_MGMT_HDR_LEN + fixed;
+}
+
+static void frame_beacon(frame_t *f, uint16_t capability) {
+  frame_mgmt(f, 0x8, 12);
+  f->data[IEEE80211_MGMT_HDR_LEN + 10] = capability & 0xFF;
+  f->data[IEEE80211_MGMT_HDR_LEN + 11] = capability >> 8;
+}
+
+static void frame_ie(frame_t *f, uint8_t id, const void *data, uint8_t len) {
+  f->data[f->len++] = id;
+  f->data[f->len++] = len;
+  if (len > 0) {
+    if (data != NULL) {
+      memcpy(f->data + f->len, data, len);
+    } else {
+      memset(f->data + f->len, 0xA5, len);
+    }
+  }
+  f->len += len;
+}
+
+static void test_iterator(void) {
+  const uint8_t ies[] = {0, 3, 'a', 'b', 'c', 3, 1, 6, 221, 0};
+  ieee80211_ie_iter_t it;
+  ieee80211_ie_t ie;
+
+  ieee80211_ie_iter_init(&it, ies, sizeof(ies));
+  CHECK(ieee80211_ie_next(&it, &ie));
+  CHECK(ie.id == 0 && ie.len == 3 && ie.data == ies + 2);
+  CHECK(ieee80211_ie_next(&it, &ie));
+  CHECK(ie.id == 3 && ie.data[0] == 6);
+  // Vendor elements need at least an OUI
+  CHECK(!ieee80211_ie_next(&it, &ie));
+  CHECK(it.malformed && it.pos == ies + 8);
+  CHECK(!ieee80211_ie_next(&it, &ie));
+
+  // Truncated: claims 10 bytes, has 2
+  const uint8_t cut[] = {0, 10, 'x', 'y'};
+  ieee80211_ie_iter_init(&it, cut, sizeof(cut));
+  CHECK(!ieee80211_ie_next(&it, &ie));
+  CHECK(it.malformed);
+
+  // A lone trailing byte is padding, not an error
+  const uint8_t pad[] = {3, 1, 11, 0};
+  ieee80211_ie_iter_init(&it, pad, sizeof(pad));
+  CHECK(ieee80211_ie_next(&it, &ie));
+  CHECK(!ieee80211_ie_next(&it, &ie));
+  CHECK(!it.malformed);
+
+  ieee80211_ie_iter_init(&it, ies, 0);
+  CHECK(!ieee80211_ie_next(&it, &ie));
+  CHECK(!it.malformed);
+}
+
+static void test_length_rules(void) {
+  CHECK(ieee80211_ie_length_valid(IEEE80211_IE_HT_CAP, 26));
+  CHECK(!ieee80211_ie_length_valid(IEEE80211_IE_HT_CAP, 25));
+  CHECK(!ieee80211_ie_length_valid(IEEE80211_IE_HT_CAP, 27));
+  CHECK(ieee80211_ie_length_valid(IEEE80211_IE_VHT_CAP, 12));
+  CHECK(!ieee80211_ie_length_valid(IEEE80211_IE_VHT_CAP, 11));
+  CHECK(!ieee80211_ie_length_valid(IEEE80211_IE_RSN, 1));
+  CHECK(ieee80211_ie_length_valid(IEEE80211_IE_RSN, 20));
+  CHECK(!ieee80211_ie_length_valid(IEEE80211_IE_HT_OPERATION, 21));
+  CHECK(!ieee80211_ie_length_valid(32, 2)); // Power Constraint
+  // No rule: anything goes, including the SSID and DS elements
+  CHECK(ieee80211_ie_length_valid(IEEE80211_IE_SSID, 0));
+  CHECK(ieee80211_ie_length_valid(IEEE80211_IE_SSID, 255));
+  CHECK(ieee80211_ie_length_valid(IEEE80211_IE_DS_PARAMS, 0));
+}
+
+static void test_ie_offset(void) {
+  static const struct {
+    uint8_t subtype;
+    size_t offset;
+  } cases[] = {
+      {0x0, 28}, {0x1, 30}, {0x2, 34}, {0x3, 30}, {0x4, 24},
+      {0x5, 36}, {0x8, 36}, {0xb, 30}, {0xc, 0},  {0xa, 0},
+  };
+  uint8_t frame[64] = {0};
+
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    frame[0] = cases[i].subtype << 4;
+    CHECK_EQ(ieee80211_mgmt_ie_offset(frame, sizeof(frame)), cases[i].offset);
+  }
+
+  // Too short for the header or for the fixed fields
+  frame[0] = 0x80;
+  CHECK_EQ(ieee80211_mgmt_ie_offset(frame, 23), 0);
+  CHECK_EQ(ieee80211_mgmt_ie_offset(frame, 35), 0);
+  CHECK_EQ(ieee80211_mgmt_ie_offset(frame, 36), 36);
+  // Data frames carry no elements
+  frame[0] = 0x88;
+  CHECK_EQ(ieee80211_mgmt_ie_offset(frame, sizeof(frame)), 0);
+}
+
+static void test_parse_beacon(void) {
+  static const uint8_t rsn[] = {1, 0, 0x00, 0x0f, 0xac, 4, 1, 0,
+                                0x00, 0x0f, 0xac, 4, 1, 0, 0x00, 0x0f,
+                                0xac, 2, 0, 0};
+  static const uint8_t wps[] = {0x00, 0x50, 0xf2, 0x04, 0x10, 0x4a, 0x00,
+                                0x01, 0x10, 0x10, 0x08, 0x00, 0x02, 0x31,
+                                0x48};
+  static const uint8_t other_vendor[] = {0x00, 0x10, 0x18, 0x02, 0x00};
+  uint8_t ht_op[22] = {40};
+  frame_t f;
+  ieee80211_ies_t ies;
+  char ssid[IEEE80211_SSID_MAX_LEN + 1];
+
+  frame_beacon(&f, IEEE80211_CAP_ESS | IEEE80211_CAP_PRIVACY);
+  frame_ie(&f, IEEE80211_IE_SSID, "ghost net  ", 11);
+  frame_ie(&f, 1, "\x82\x84\x8b\x96", 4);
+  frame_ie(&f, IEEE80211_IE_DS_PARAMS, "\x06", 1);
+  frame_ie(&f, IEEE80211_IE_HT_CAP, NULL, 26);
+  frame_ie(&f, IEEE80211_IE_HT_OPERATION, ht_op, sizeof(ht_op));
+  frame_ie(&f, IEEE80211_IE_VHT_CAP, NULL, 12);
+  frame_ie(&f, IEEE80211_IE_RSN, rsn, sizeof(rsn));
+  frame_ie(&f, IEEE80211_IE_VENDOR, other_vendor, sizeof(other_vendor));
+  frame_ie(&f, IEEE80211_IE_VENDOR, wps, sizeof(wps));
+
+  CHECK(ieee80211_parse_mgmt(f.data, f.len, &ies));
+  CHECK(!ies.malformed);
+  CHECK_EQ(ies.ie_count, 9);
+  CHECK_EQ(ies.capability, IEEE80211_CAP_ESS | IEEE80211_CAP_PRIVACY);
+  CHECK(ies.has_ssid && ies.ssid_len == 11);
+  CHECK(ies.ssid >= f.data && ies.ssid < f.data + f.len); // Points into frame
+  CHECK_EQ(ieee80211_ssid_copy(&ies, ssid), 9);
+  CHECK(strcmp(ssid, "ghost net") == 0);
+  CHECK_EQ(ies.channel, 6); // DS wins over HT operation
+  CHECK(ies.rsn != NULL && ies.rsn_len == sizeof(rsn));
+  CHECK(ies.wpa == NULL);
+  CHECK(ies.wps != NULL && ies.wps_len == sizeof(wps) - 4);
+  CHECK(ies.ht_cap != NULL && ies.vht_cap != NULL);
+  CHECK_EQ(ieee80211_security(&ies), IEEE80211_SECURITY_WPA2);
+  CHECK(strcmp(ieee80211_security_name(ieee80211_security(&ies)), "WPA2") ==
+        0);
+
+  const uint8_t *value = NULL;
+  uint16_t value_len = 0;
+  CHECK(ieee80211_wps_attr_find(&ies, WPS_ATTR_CONFIG_METHODS, &value,
+                                &value_len));
+  CHECK(value_len == 2 && value[0] == 0x31 && value[1] == 0x48);
+  CHECK(!ieee80211_wps_attr_find(&ies, 0x1011, &value, &value_len));
+}
+
+static void test_parse_fallbacks(void) {
+  static const uint8_t wpa[] = {0x00, 0x50, 0xf2, 0x01, 0x01, 0x00};
+  uint8_t ht_op[22] = {149};
+  frame_t f;
+  ieee80211_ies_t ies;
+  char ssid[IEEE80211_SSID_MAX_LEN + 1];
+
+  // 5 GHz beacon without DS parameters: the channel comes from HT operation
+  frame_beacon(&f, IEEE80211_CAP_ESS);
+  frame_ie(&f, IEEE80211_IE_SSID, "", 0);
+  frame_ie(&f, IEEE80211_IE_HT_OPERATION, ht_op, sizeof(ht_op));
+  CHECK(ieee80211_parse_mgmt(f.data, f.len, &ies));
+  CHECK_EQ(ies.channel, 149);
+  CHECK(ies.has_ssid && ies.ssid_len == 0);
+  CHECK_EQ(ieee80211_ssid_copy(&ies, ssid), 0);
+  CHECK_EQ(ieee80211_security(&ies), IEEE80211_SECURITY_OPEN);
+
+  frame_beacon(&f, IEEE80211_CAP_ESS);
+  frame_ie(&f, IEEE80211_IE_VENDOR, wpa, sizeof(wpa));
+  CHECK(ieee80211_parse_mgmt(f.data, f.len, &ies));
+  CHECK(!ies.has_ssid);
+  CHECK(ies.wpa != NULL && ies.wpa_len == 2);
+  CHECK_EQ(ieee80211_security(&ies), IEEE80211_SECURITY_WPA);
+
+  frame_beacon(&f, IEEE80211_CAP_ESS | IEEE80211_CAP_PRIVACY);
+  CHECK(ieee80211_parse_mgmt(f.data, f.len, &ies));
+  CHECK_EQ(ies.ie_count, 0);
+  CHECK_EQ(ieee80211_security(&ies), IEEE80211_SECURITY_WEP);
+
+  // Only the first SSID counts, and an over-long one is ignored
+  frame_mgmt(&f, 0x4, 0);
+  frame_ie(&f, IEEE80211_IE_SSID, NULL, 33);
+  frame_ie(&f, IEEE80211_IE_SSID, "probe", 5);
+  frame_ie(&f, IEEE80211_IE_SSID, "second", 6);
+  CHECK(ieee80211_parse_mgmt(f.data, f.len, &ies));
+  CHECK(ies.capability == 0);
+  CHECK(ies.has_ssid && ies.ssid_len == 5 &&
+        memcmp(ies.ssid, "probe", 5) == 0);
+
+  // Not a management frame with elements
+  frame_mgmt(&f, 0xc, 2);
+  CHECK(!ieee80211_parse_mgmt(f.data, f.len, &ies));
+  CHECK(ies.ie_count == 0 && !ies.has_ssid);
+}
+
+static void test_parse_malformed(void) {
+  frame_t f;
+  ieee80211_ies_t ies;
+  const uint8_t *value;
+  uint16_t value_len;
+
+  // Elements before the bad one are kept; nothing after it is read
+  frame_beacon(&f, 0);
+  frame_ie(&f, IEEE80211_IE_SSID, "ok", 2);
+  frame_ie(&f, IEEE80211_IE_HT_CAP, NULL, 20);
+  frame_ie(&f, IEEE80211_IE_DS_PARAMS, "\x0b", 1);
+  CHECK(ieee80211_parse_mgmt(f.data, f.len, &ies));
+  CHECK(ies.malformed);
+  CHECK_EQ(ies.ie_count, 1);
+  CHECK(ies.has_ssid && ies.ht_cap == NULL && ies.channel == 0);
+
+  // Last element runs past the end of the frame
+  frame_beacon(&f, 0);
+  frame_ie(&f, IEEE80211_IE_DS_PARAMS, "\x01", 1);
+  frame_ie(&f, IEEE80211_IE_RSN, NULL, 20);
+  CHECK(ieee80211_parse_mgmt(f.data, f.len - 1, &ies));
+  CHECK(ies.malformed && ies.rsn == NULL && ies.channel == 1);
+
+  // WPS attribute whose length overruns the element
+  static const uint8_t wps[] = {0x00, 0x50, 0xf2, 0x04,
+                                0x10, 0x08, 0x00, 0x09, 0x00};
+  frame_beacon(&f, 0);
+  frame_ie(&f, IEEE80211_IE_VENDOR, wps, sizeof(wps));
+  CHECK(ieee80211_parse_mgmt(f.data, f.len, &ies));
+  CHECK(ies.wps != NULL);
+  CHECK(!ieee80211_wps_attr_find(&ies, WPS_ATTR_CONFIG_METHODS, &value,
+                                 &value_len));
+
+  // Every truncation of a full beacon stays inside the buffer; each copy is
+  // exactly len bytes so ASan sees any overread.
+  static const uint8_t rsn[] = {1, 0, 0x00, 0x0f, 0xac, 4};
+  frame_beacon(&f, 0);
+  frame_ie(&f, IEEE80211_IE_SSID, "truncate me", 11);
+  frame_ie(&f, IEEE80211_IE_DS_PARAMS, "\x03", 1);
+  frame_ie(&f, IEEE80211_IE_RSN, rsn, sizeof(rsn));
+  frame_ie(&f, IEEE80211_IE_VHT_CAP, NULL, 12);
+  for (size_t len = 0; len <= f.len; len++) {
+    uint8_t *copy = malloc(len > 0 ? len : 1);
+    memcpy(copy, f.data, len);
+    ieee80211_parse_mgmt(copy, len, &ies);
+    CHECK(ies.vht_cap == NULL || len == f.len);
+    free(copy);
+  }
+}
+
+int main(void) {
+  test_iterator();
+  test_length_rules();
+  test_ie_offset();
+  test_parse_beacon();
+  test_parse_fallbacks();
+  test_parse_malformed();
+  return test_report("ieee80211_ie");
+}
@@ -0,0 +1,296 @@
+// test_nmea_decode.c
+//
+// Sentence decoding of main/vendor/GPS/nmea_decode.c: field conversion for
+// each sentence type, coordinate precision, checksum and field rejection,
+// and a replay of a receiver's output burst.
+
+#include "vendor/GPS/nmea_decode.h"
+#include "test.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALL_SENTENCES 0xfe
+
+// Wraps body in '$', '*hh' and CRLF.
+static size_t sentence(char *out, size_t size, const char *body) {
+  uint8_t sum = 0;
+  for (const char *p = body; *p; p++) {
+    sum ^= (uint8_t)*p;
+  }
+  return snprintf(out, size, "$%s*%02X\r\n", body, sum);
+}
+
+static nmea_sentence_t decode(const char *body, nmea_data_t *data) {
+  char line[160];
+  size_t len = sentence(line, sizeof(line), body);
+  return nmea_decode_line(line, len, ALL_SENTENCES, data);
+}
+
+// Everything but the error counters, which are expected to move.
+static bool same_fix(const nmea_data_t *a, const nmea_data_t *b) {
+  nmea_data_t x = *a, y = *b;
+  x.checksum_errors = y.checksum_errors = 0;
+  x.malformed = y.malformed = 0;
+  return memcmp(&x, &y, sizeof(x)) == 0;
+}
+
+static void test_sentences(void) {
+  nmea_data_t d;
+  memset(&d, 0, sizeof(d));
+
+  CHECK_EQ(decode("GPGGA,123519.25,4807.038,N,01131.000,E,1,08,0.9,545.4,M,"
+                  "46.9,M,,",
+                  &d),
+           NMEA_SENTENCE_GGA);
+  CHECK_EQ(d.lat_e7, 481173000);
+  CHECK_EQ(d.lon_e7, 115166667);
+  CHECK_EQ(d.alt_cm, 54540);
+  CHECK_EQ(d.geoid_cm, 4690);
+  CHECK_EQ(d.hdop_x100, 90);
+  CHECK(d.hour == 12 && d.minute == 35 && d.second == 19 && d.millis == 250);
+  CHECK_EQ(d.fix, 1);
+  CHECK_EQ(d.sats_in_use, 8);
+
+  CHECK_EQ(decode("GPRMC,123520,A,4807.038,S,01131.000,W,022.4,084.4,230394,"
+                  "003.1,W",
+                  &d),
+           NMEA_SENTENCE_RMC);
+  CHECK_EQ(d.lat_e7, -481173000);
+  CHECK_EQ(d.lon_e7, -115166667);
+  CHECK_EQ(d.speed_mm_s, 11523); // 22.4 knots
+  CHECK_EQ(d.course_x100, 8440);
+  CHECK_EQ(d.variation_x100, -310);
+  CHECK(d.day == 23 && d.month == 3 && d.year == 94);
+  CHECK(d.second == 20 && d.millis == 0);
+  CHECK(d.valid);
+
+  CHECK_EQ(decode("GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1", &d),
+           NMEA_SENTENCE_GSA);
+  CHECK_EQ(d.fix_mode, 3);
+  CHECK_EQ(d.pdop_x100, 250);
+  CHECK_EQ(d.hdop_x100, 130);
+  CHECK_EQ(d.vdop_x100, 210);
+  CHECK(d.sats_id_in_use[0] == 4 && d.sats_id_in_use[2] == 0 &&
+        d.sats_id_in_use[7] == 24);
+
+  CHECK_EQ(decode("GPGSV,2,1,08,01,40,083,46,02,17,308,41,12,07,344,39,14,22,"
+                  "228,45",
+                  &d),
+           NMEA_SENTENCE_GSV);
+  CHECK_EQ(decode("GPGSV,2,2,08,15,40,083,46,16,17,308,,17,07,344,39,18,22,"
+                  "228,45",
+                  &d),
+           NMEA_SENTENCE_GSV);
+  CHECK_EQ(d.sats_in_view, 8);
+  CHECK(d.gsv_num == 2 && d.gsv_total == 2);
+  CHECK_EQ(d.sats_desc_in_view[2].num, 12);
+  CHECK_EQ(d.sats_desc_in_view[2].azimuth, 344);
+  CHECK_EQ(d.sats_desc_in_view[5].snr, 0); // Not tracked
+  CHECK_EQ(d.sats_desc_in_view[7].num, 18);
+  // A new group starts from a clean table
+  CHECK_EQ(decode("GPGSV,1,1,01,22,10,100,30", &d), NMEA_SENTENCE_GSV);
+  CHECK(d.sats_desc_in_view[0].num == 22 && d.sats_desc_in_view[1].num == 0);
+
+  CHECK_EQ(decode("GNVTG,054.7,T,034.4,M,005.5,N,010.2,K,A", &d),
+           NMEA_SENTENCE_VTG);
+  CHECK_EQ(d.course_x100, 5470);
+  CHECK_EQ(d.speed_mm_s, 2833); // From km/h
+  CHECK_EQ(decode("GNVTG,054.7,T,034.4,M,005.5,N,,K,A", &d), NMEA_SENTENCE_VTG);
+  CHECK_EQ(d.speed_mm_s, 2829); // From knots when km/h is missing
+
+  CHECK_EQ(decode("GPGLL,4916.45,N,12311.12,W,225444,A,", &d),
+           NMEA_SENTENCE_GLL);
+  CHECK_EQ(d.lat_e7, 492741667);
+  CHECK_EQ(d.lon_e7, -1231853333);
+  CHECK(d.hour == 22 && d.minute == 54 && d.second == 44);
+
+  CHECK_EQ(decode("GPZDA,201530.50,04,07,2031,-05,00", &d), NMEA_SENTENCE_ZDA);
+  CHECK(d.hour == 20 && d.minute == 15 && d.second == 30 && d.millis == 500);
+  CHECK(d.day == 4 && d.month == 7 && d.year == 31);
+  // Before the receiver knows the time every field is empty
+  nmea_data_t before = d;
+  CHECK_EQ(decode("GPZDA,,,,,,", &d), NMEA_SENTENCE_ZDA);
+  CHECK(same_fix(&d, &before));
+
+  CHECK_EQ(d.checksum_errors, 0);
+  CHECK_EQ(d.malformed, 0);
+}
+
+static void test_precision(void) {
+  nmea_data_t d;
+  char body[96];
+  int32_t worst = 0;
+
+  memset(&d, 0, sizeof(d));
+  // Seven minute decimals survive; a float path loses about a meter here.
+  CHECK_EQ(decode("GNGLL,4807.0381234,N,17959.9999999,E,120000,A", &d),
+           NMEA_SENTENCE_GLL);
+  CHECK_EQ(d.lat_e7, llround((48 + 7.0381234 / 60) * 1e7));
+  CHECK_EQ(d.lon_e7, llround((179 + 59.9999999 / 60) * 1e7));
+
+  srand(7);
+  for (int i = 0; i < 20000; i++) {
+    int deg = rand() % 90, min = rand() % 60, frac = rand() % 100000;
+    snprintf(body, sizeof(body), "GPGLL,%02d%02d.%05d,S,,,120000,A", deg, min,
+             frac);
+    if (decode(body, &d) != NMEA_SENTENCE_GLL) {
+      CHECK(false);
+      break;
+    }
+    int64_t exact = -llround((deg + (min + frac / 1e5) / 60) * 1e7);
+    int32_t error = (int32_t)llabs(d.lat_e7 - exact);
+    worst = error > worst ? error : worst;
+  }
+  CHECK(worst <= 1); // 1e-7 degrees, about a centimeter
+}
+
+static void test_rejects(void) {
+  nmea_data_t d, before;
+  char good[160], line[160];
+  size_t len = sentence(
+      good, sizeof(good),
+      "GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,");
+
+  memset(&d, 0, sizeof(d));
+  CHECK_EQ(nmea_decode_line(good, len, ALL_SENTENCES, &d), NMEA_SENTENCE_GGA);
+  before = d;
+
+  // Checksum: wrong digit, not hex, missing. Lowercase hex is fine.
+  char *hex = strchr(strcpy(line, good), '*') + 1;
+  hex[1] = hex[1] == '0' ? '1' : '0';
+  CHECK_EQ(nmea_decode_line(line, len, ALL_SENTENCES, &d),
+           NMEA_SENTENCE_INVALID);
+  CHECK_EQ(d.checksum_errors, 1);
+  hex[1] = 'G';
+  CHECK_EQ(nmea_decode_line(line, len, ALL_SENTENCES, &d),
+           NMEA_SENTENCE_INVALID);
+  CHECK_EQ(d.checksum_errors, 2);
+  CHECK_EQ(nmea_decode_line(good, len - 5, ALL_SENTENCES, &d),
+           NMEA_SENTENCE_INVALID);
+  CHECK(same_fix(&d, &before));
+
+  len = sentence(line, sizeof(line), "GPGLL,4916.45,N,12311.12,W,225444,A,");
+  hex = strchr(line, '*') + 1;
+  hex[0] = tolower((unsigned char)hex[0]);
+  hex[1] = tolower((unsigned char)hex[1]);
+  CHECK_EQ(nmea_decode_line(line, len, ALL_SENTENCES, &d), NMEA_SENTENCE_GLL);
+  before = d;
+
+  // A bad field rejects the whole sentence; nothing is half applied.
+  static const char *bad_fields[] = {
+      "GPGGA,123519,4860.000,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,",
+      "GPGGA,123519,9100.000,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,",
+      "GPGGA,123519,4807.038,X,01131.000,E,1,08,0.9,545.4,M,46.9,M,,",
+      "GPGGA,126019,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,",
+      "GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,5x5.4,M,46.9,M,,",
+      "GPGGA,123519,48,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,",
+      "GPRMC,123520,A,4807.038,S,01131.000,W,022.4,084.4,320394,003.1,W",
+      "GPRMC,123520,A,4807.038,S,01131.000,W,-22.4,084.4,230394,003.1,W",
+      "GPZDA,201530.00,32,07,2031,00,00",
+      "GPZDA,201530.00,04,07,1999,00,00",
+      "GPZDA,201530.00,04,07,31,00,00",
+      "GPZDA,201530.00,04,,2031,00,00",
+      "GPGSV,2,3,08,01,40,083,46",
+      "GPGSV,2,0,08,01,40,083,46",
+      "GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,9999.99",
+      "GPGGA,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24",
+  };
+  for (size_t i = 0; i < sizeof(bad_fields) / sizeof(bad_fields[0]); i++) {
+    uint32_t malformed = d.malformed;
+    CHECK_EQ(decode(bad_fields[i], &d), NMEA_SENTENCE_INVALID);
+    CHECK_EQ(d.malformed, malformed + 1);
+    CHECK(same_fix(&d, &before));
+  }
+
+  // Framing
+  CHECK_EQ(nmea_decode_line("GPGGA*00", 8, ALL_SENTENCES, &d),
+           NMEA_SENTENCE_INVALID);
+  CHECK_EQ(nmea_decode_line("$*00", 4, ALL_SENTENCES, &d),
+           NMEA_SENTENCE_INVALID);
+  CHECK_EQ(nmea_decode_line("", 0, ALL_SENTENCES, &d), NMEA_SENTENCE_INVALID);
+
+  // Verified but not decoded: other types, proprietary, or masked off
+  uint32_t malformed = d.malformed;
+  CHECK_EQ(decode("GPTXT,01,01,02,ANTSTATUS=OK", &d), NMEA_SENTENCE_UNKNOWN);
+  CHECK_EQ(decode("PUBX,00,081350.00,4717.113210,N", &d),
+           NMEA_SENTENCE_UNKNOWN);
+  sentence(line, sizeof(line),
+           "GPGGA,000000,0000.000,N,00000.000,E,0,00,9.9,0,M,0,M,,");
+  CHECK_EQ(nmea_decode_line(line, strlen(line),
+                            ALL_SENTENCES & ~(1u << NMEA_SENTENCE_GGA), &d),
+           NMEA_SENTENCE_UNKNOWN);
+  CHECK_EQ(d.malformed, malformed);
+  CHECK(same_fix(&d, &before));
+
+  // Every prefix short of the full checksum, in an exact-size buffer so
+  // ASan sees any overread
+  for (size_t n = 0; n < strlen(good) - 2; n++) {
+    char *copy = malloc(n > 0 ? n : 1);
+    memcpy(copy, good, n);
+    CHECK_EQ(nmea_decode_line(copy, n, ALL_SENTENCES, &d),
+             NMEA_SENTENCE_INVALID);
+    free(copy);
+  }
+  CHECK(same_fix(&d, &before));
+}
+
+// A u-blox receiver's output for one epoch, replayed the way MicroNMEA.c
+// feeds it: split at line ends, one call per sentence.
+static void test_replay(void) {
+  static const char *burst[] = {
+      "GNRMC,083559.00,A,5231.07241,N,01324.36528,E,0.135,,170326,,,A",
+      "GNVTG,,T,,M,0.135,N,0.250,K,A",
+      "GNGGA,083559.00,5231.07241,N,01324.36528,E,1,09,1.02,38.3,M,44.6,M,,",
+      "GNGSA,A,3,10,12,15,24,25,32,,,,,,,1.83,1.02,1.52",
+      "GNGSA,A,3,70,71,80,,,,,,,,,,1.83,1.02,1.52",
+      "GPGSV,3,1,10,10,52,294,30,12,56,081,25,15,17,041,31,18,05,347,",
+      "GPGSV,3,2,10,24,70,147,33,25,30,102,26,29,04,187,,32,32,222,28",
+      "GPGSV,3,3,10,36,26,145,,49,31,184,",
+      "GLGSV,1,1,03,70,30,057,24,71,58,141,27,80,29,300,22",
+      "GNGLL,5231.07241,N,01324.36528,E,083559.00,A,A",
+  };
+  char stream[1024];
+  size_t len = 0, vtg = 0;
+  for (size_t i = 0; i < sizeof(burst) / sizeof(burst[0]); i++) {
+    if (i == 1) {
+      vtg = len;
+    }
+    len += sentence(stream + len, sizeof(stream) - len, burst[i]);
+  }
+  stream[vtg + 20] ^= 0x01; // One corrupted bit on the UART, inside VTG
+
+  nmea_data_t d;
+  int decoded = 0;
+  memset(&d, 0, sizeof(d));
+  for (const char *p = stream, *end = stream + len; p < end;) {
+    const char *eol = memchr(p, '\n', end - p);
+    size_t n = (eol ? eol + 1 : end) - p;
+    if (nmea_decode_line(p, n, ALL_SENTENCES, &d) > NMEA_SENTENCE_UNKNOWN) {
+      decoded++;
+    }
+    p += n;
+  }
+
+  CHECK_EQ(decoded, 9);
+  CHECK_EQ(d.checksum_errors, 1);
+  CHECK_EQ(d.malformed, 0);
+  CHECK_EQ(d.lat_e7, llround((52 + 31.07241 / 60) * 1e7));
+  CHECK_EQ(d.lon_e7, llround((13 + 24.36528 / 60) * 1e7));
+  CHECK_EQ(d.alt_cm, 3830);
+  CHECK(d.valid && d.fix == 1 && d.fix_mode == 3);
+  CHECK_EQ(d.sats_in_use, 9);
+  CHECK_EQ(d.speed_mm_s, 69); // 0.250 km/h
+  CHECK(d.day == 17 && d.month == 3 && d.year == 26);
+  CHECK(d.hour == 8 && d.minute == 35 && d.second == 59);
+  CHECK_EQ(d.pdop_x100, 183);
+}
+
+int main(void) {
+  test_sentences();
+  test_precision();
+  test_rejects();
+  test_replay();
+  return test_report("nmea_decode");
+}
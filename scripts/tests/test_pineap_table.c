@@ -0,0 +1,120 @@
+// test_pineap_table.c
+//
+// PineAP detector state from main/core/pineap_table.c: beacon sequences
+// replayed through pineap_table_observe, checking when a BSSID is flagged,
+// what the alert carries and how SSIDs age out.
+
+#include "core/pineap_table.h"
+#include "test.h"
+#include <string.h>
+
+#define AGE_S 300
+
+static const uint8_t pineap[6] = {0x00, 0x13, 0x37, 0xaa, 0xbb, 0xcc};
+static const uint8_t home[6] = {0x10, 0x20, 0x30, 0x40, 0x50, 0x60};
+
+static int alerts;
+static pineap_alert_t last_alert;
+
+static void beacon(mac_table_t *table, const uint8_t *bssid, const char *ssid,
+                   uint32_t now_s) {
+  pineap_alert_t alert;
+  if (pineap_table_observe(table, bssid, ssid, 6, -50, now_s, AGE_S, &alert)) {
+    alerts++;
+    last_alert = alert;
+  }
+}
+
+static pineap_network_t *network(mac_table_t *table, const uint8_t *bssid) {
+  return mac_table_find(table, bssid);
+}
+
+static void test_flagging(void) {
+  mac_table_t table;
+  CHECK(mac_table_init(&table, 64, sizeof(pineap_network_t)) == ESP_OK);
+  alerts = 0;
+
+  // An ordinary AP repeating its SSID, in any case, is never flagged
+  for (uint32_t t = 0; t < 100; t++) {
+    beacon(&table, home, t % 2 ? "HomeNet" : "homenet", t);
+  }
+  CHECK_EQ(alerts, 0);
+  CHECK_EQ(network(&table, home)->ssid_count, 1);
+
+  // The second SSID flags the BSSID; the alert names both
+  beacon(&table, pineap, "Free WiFi", 10);
+  CHECK_EQ(alerts, 0);
+  beacon(&table, pineap, "attwifi", 11);
+  CHECK_EQ(alerts, 1);
+  CHECK(memcmp(last_alert.bssid, pineap, 6) == 0);
+  CHECK(strcmp(last_alert.ssid, "attwifi") == 0);
+  CHECK(strcmp(last_alert.previous_ssid, "Free WiFi") == 0);
+  CHECK_EQ(last_alert.live_ssids, 2);
+  CHECK(last_alert.channel == 6 && last_alert.rssi == -50);
+
+  // Repeats are quiet, every further new SSID raises one alert
+  beacon(&table, pineap, "ATTWIFI", 12);
+  beacon(&table, pineap, "Free WiFi", 12);
+  CHECK_EQ(alerts, 1);
+  static const char *more[] = {"xfinitywifi", "Starbucks", "Airport", "Hotel",
+                               "Guest", "Lobby"};
+  for (int i = 0; i < 6; i++) {
+    beacon(&table, pineap, more[i], 20 + i);
+  }
+  CHECK_EQ(alerts, 7);
+  CHECK_EQ(network(&table, pineap)->ssid_count, PINEAP_SSIDS_PER_BSSID);
+  CHECK_EQ(last_alert.live_ssids, PINEAP_SSIDS_PER_BSSID);
+
+  // The set is full: the SSID heard longest ago ("attwifi" and "Free WiFi"
+  // at 12) made room, so it counts as new again
+  beacon(&table, pineap, "attwifi", 30);
+  CHECK_EQ(alerts, 8);
+  mac_table_free(&table);
+}
+
+static void test_aging(void) {
+  mac_table_t table;
+  CHECK(mac_table_init(&table, 64, sizeof(pineap_network_t)) == ESP_OK);
+  alerts = 0;
+
+  // An AP renamed once is flagged, then forgotten after the age limit
+  beacon(&table, home, "OldName", 0);
+  beacon(&table, home, "NewName", 1000);
+  CHECK_EQ(alerts, 0); // OldName had aged out already
+  CHECK_EQ(network(&table, home)->ssid_count, 1);
+
+  beacon(&table, home, "Other", 1000 + AGE_S);
+  CHECK_EQ(alerts, 1); // Still exactly at the limit
+  beacon(&table, home, "Third", 1001 + 2 * AGE_S);
+  CHECK_EQ(alerts, 1);
+  CHECK_EQ(network(&table, home)->ssid_count, 1);
+
+  // Ages are unsigned differences, so a wrapped clock still reads 16 s
+  beacon(&table, pineap, "a", UINT32_MAX - 10);
+  beacon(&table, pineap, "b", 5);
+  CHECK_EQ(alerts, 2);
+  mac_table_free(&table);
+}
+
+static void test_long_ssid(void) {
+  mac_table_t table;
+  CHECK(mac_table_init(&table, 8, sizeof(pineap_network_t)) == ESP_OK);
+  alerts = 0;
+  const char *max = "0123456789abcdef0123456789abcdef";
+  beacon(&table, pineap, "short", 0);
+  beacon(&table, pineap, max, 1);
+  CHECK_EQ(alerts, 1);
+  CHECK(strcmp(last_alert.ssid, max) == 0);
+  beacon(&table, pineap, "third", 2);
+  CHECK(strcmp(last_alert.previous_ssid, max) == 0);
+  CHECK(pineap_hash_ssid("CaseTest") == pineap_hash_ssid("casetest"));
+  CHECK(pineap_hash_ssid("a") != pineap_hash_ssid("b"));
+  mac_table_free(&table);
+}
+
+int main(void) {
+  test_flagging();
+  test_aging();
+  test_long_ssid();
+  return test_report("pineap_table");
+}
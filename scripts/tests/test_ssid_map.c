@@ -0,0 +1,159 @@
+// test_ssid_map.c
+//
+// Evil-twin detection in main/core/ssid_map.c: beacon corpora replayed
+// through ssid_map_observe, one SSID heard from a reference AP and from
+// twins that differ in security, vendor or channel.
+
+#include "core/ssid_map.h"
+#include "core/ieee80211_ie.h"
+#include "test.h"
+#include <string.h>
+
+static ssid_map_t map;
+static ssid_map_alert_t alert;
+
+static ssid_map_ap_t ap(uint8_t oui0, uint8_t last, uint8_t security,
+                        uint8_t channel) {
+  ssid_map_ap_t a = {{oui0, 0x0a, 0xc4, 0x11, 0x22, last}, security, channel};
+  return a;
+}
+
+// Returns the alert reasons for one beacon, 0 when there was no alert.
+static int observe(const char *ssid, ssid_map_ap_t a) {
+  memset(&alert, 0, sizeof(alert));
+  if (!ssid_map_observe(&map, (const uint8_t *)ssid, strlen(ssid), &a,
+                        &alert)) {
+    return 0;
+  }
+  CHECK(memcmp(alert.ap.bssid, a.bssid, 6) == 0);
+  return alert.reasons;
+}
+
+static void test_twins(void) {
+  const ssid_map_ap_t ref = ap(0x24, 1, IEEE80211_SECURITY_WPA2, 6);
+  ssid_map_stats_t stats;
+
+  CHECK(ssid_map_init(&map, 64, 32));
+  for (int i = 0; i < 10; i++) {
+    CHECK_EQ(observe("CoffeeShop", ref), 0);
+  }
+
+  // Open twin: reported once for the pair, not on every beacon
+  ssid_map_ap_t open = ap(0x24, 2, IEEE80211_SECURITY_OPEN, 6);
+  CHECK_EQ(observe("CoffeeShop", open), SSID_MAP_MISMATCH_SECURITY);
+  CHECK_EQ(alert.aps, 2);
+  CHECK(!alert.changed);
+  CHECK(memcmp(alert.other.bssid, ref.bssid, 6) == 0);
+  CHECK_EQ(alert.other.security, IEEE80211_SECURITY_WPA2);
+  CHECK_EQ(observe("CoffeeShop", open), 0);
+
+  // Foreign OUI
+  ssid_map_ap_t foreign = ap(0xdc, 3, IEEE80211_SECURITY_WPA2, 6);
+  CHECK_EQ(observe("CoffeeShop", foreign), SSID_MAP_MISMATCH_VENDOR);
+  CHECK_EQ(alert.aps, 3);
+
+  // Locally administered addresses carry no vendor
+  ssid_map_ap_t local = ap(0xde, 4, IEEE80211_SECURITY_WPA2, 6);
+  CHECK_EQ(observe("CoffeeShop", local), 0);
+
+  // Different channel, then the AP moves back and drops its security
+  ssid_map_ap_t moved = ap(0x24, 5, IEEE80211_SECURITY_WPA2, 11);
+  CHECK_EQ(observe("CoffeeShop", moved), SSID_MAP_MISMATCH_CHANNEL);
+  moved.channel = 6;
+  CHECK_EQ(observe("CoffeeShop", moved), 0);
+  moved.security = IEEE80211_SECURITY_OPEN;
+  CHECK_EQ(observe("CoffeeShop", moved), SSID_MAP_MISMATCH_SECURITY);
+  CHECK(alert.changed);
+  CHECK_EQ(alert.aps, 5);
+
+  // No channel in the beacon is not a mismatch
+  CHECK_EQ(observe("CoffeeShop", ap(0x24, 6, IEEE80211_SECURITY_WPA2, 0)), 0);
+
+  // All three at once
+  CHECK_EQ(observe("CoffeeShop", ap(0xdc, 7, IEEE80211_SECURITY_WEP, 1)),
+           SSID_MAP_MISMATCH_SECURITY | SSID_MAP_MISMATCH_VENDOR |
+               SSID_MAP_MISMATCH_CHANNEL);
+
+  // The reference AP changing channel is reported against where it was,
+  // and later APs are compared against where it is now
+  ssid_map_ap_t ref_moved = ref;
+  ref_moved.channel = 1;
+  CHECK_EQ(observe("CoffeeShop", ref_moved), SSID_MAP_MISMATCH_CHANNEL);
+  CHECK(alert.changed);
+  CHECK_EQ(alert.other.channel, 6);
+  CHECK_EQ(observe("CoffeeShop", ap(0x24, 8, IEEE80211_SECURITY_WPA2, 1)), 0);
+
+  // The same BSSID under another SSID is a separate pair; SSIDs compare
+  // byte for byte
+  CHECK_EQ(observe("coffeeshop", open), 0);
+  CHECK_EQ(observe("coffeeshop", ap(0xdc, 9, IEEE80211_SECURITY_WPA2, 6)),
+           SSID_MAP_MISMATCH_SECURITY | SSID_MAP_MISMATCH_VENDOR);
+
+  ssid_map_ap_t found[16];
+  CHECK_EQ(ssid_map_lookup(&map, (const uint8_t *)"CoffeeShop", 10, found, 16),
+           8);
+  CHECK_EQ(ssid_map_lookup(&map, (const uint8_t *)"CoffeeShop", 10, found, 3),
+           3);
+  CHECK_EQ(ssid_map_lookup(&map, (const uint8_t *)"coffeeshop", 10, found, 16),
+           2);
+  CHECK_EQ(ssid_map_lookup(&map, (const uint8_t *)"nothing", 7, found, 16), 0);
+
+  ssid_map_get_stats(&map, &stats);
+  CHECK_EQ(stats.aps, 10);
+  CHECK_EQ(stats.ssids, 2);
+  CHECK_EQ(stats.alerts, 7);
+  CHECK_EQ(stats.evictions, 0);
+  CHECK_EQ(stats.beacons, 23);
+  CHECK(stats.ap_capacity == 64 && stats.ssid_capacity == 32);
+
+  ssid_map_clear(&map);
+  ssid_map_get_stats(&map, &stats);
+  CHECK(stats.aps == 0 && stats.beacons == 0 && stats.ap_capacity == 64);
+  CHECK_EQ(ssid_map_lookup(&map, (const uint8_t *)"CoffeeShop", 10, found, 16),
+           0);
+  ssid_map_free(&map);
+}
+
+static void test_eviction(void) {
+  ssid_map_stats_t stats;
+
+  // Eight pair slots: the least recently heard pair makes room, and no
+  // longer counts towards its SSID
+  CHECK(ssid_map_init(&map, 8, 8));
+  for (int i = 0; i < 20; i++) {
+    CHECK_EQ(observe("Mall", ap(0x24, i, IEEE80211_SECURITY_WPA2, 6)), 0);
+  }
+  ssid_map_get_stats(&map, &stats);
+  CHECK_EQ(stats.aps, 8);
+  CHECK_EQ(stats.evictions, 12);
+
+  CHECK_EQ(observe("Mall", ap(0x24, 99, IEEE80211_SECURITY_WPA2, 11)),
+           SSID_MAP_MISMATCH_CHANNEL);
+  CHECK_EQ(alert.aps, 8);
+
+  // With all of its APs gone, the next AP heard defines the SSID again
+  for (int i = 0; i < 8; i++) {
+    observe("Other", ap(0x24, 100 + i, IEEE80211_SECURITY_OPEN, 1));
+  }
+  CHECK_EQ(observe("Mall", ap(0xdc, 200, IEEE80211_SECURITY_OPEN, 1)), 0);
+  CHECK_EQ(observe("Mall", ap(0x24, 201, IEEE80211_SECURITY_WPA2, 1)),
+           SSID_MAP_MISMATCH_SECURITY | SSID_MAP_MISMATCH_VENDOR);
+  ssid_map_free(&map);
+}
+
+static void test_hash(void) {
+  // FNV-1a reference values
+  CHECK_EQ(ssid_map_hash((const uint8_t *)"", 0), 2166136261u);
+  CHECK_EQ(ssid_map_hash((const uint8_t *)"a", 1), 0xe40c292cu);
+  CHECK_EQ(ssid_map_hash((const uint8_t *)"foobar", 6), 0xbf9cf968u);
+  // Hidden networks with NUL-padded SSIDs hash by length
+  CHECK(ssid_map_hash((const uint8_t *)"\0\0\0", 3) !=
+        ssid_map_hash((const uint8_t *)"\0\0", 2));
+}
+
+int main(void) {
+  test_twins();
+  test_eviction();
+  test_hash();
+  return test_report("ssid_map");
+}
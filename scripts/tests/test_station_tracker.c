@@ -0,0 +1,185 @@
+// test_station_tracker.c
+//
+// Station accounting of main/core/station_tracker.c: data frames replayed
+// through station_tracker_record, then read back with the snapshot.
+
+#include "core/station_tracker.h"
+#include "core/frame_dispatch.h"
+#include "managers/wifi_manager.h"
+#include "test.h"
+#include <string.h>
+
+// Clock and monitor stand-ins
+static int64_t now_us;
+static const char *consumer;
+static uint64_t consumer_mask;
+
+int64_t esp_timer_get_time(void) { return now_us; }
+void wifi_manager_start_monitor_mode(const char *name, uint64_t frame_mask,
+                                     wifi_promiscuous_cb_t_t callback) {
+  consumer = name;
+  consumer_mask = frame_mask;
+}
+void wifi_manager_stop_monitor_consumer(const char *name) {
+  if (consumer != NULL && strcmp(consumer, name) == 0) {
+    consumer = NULL;
+  }
+}
+
+typedef struct {
+  wifi_pkt_rx_ctrl_t rx_ctrl;
+  uint8_t payload[64];
+} test_pkt_t;
+
+static const uint8_t sta1[6] = {0x3c, 0x22, 0xfb, 0, 0, 1};
+static const uint8_t sta2[6] = {0x3c, 0x22, 0xfb, 0, 0, 2};
+static const uint8_t sta3[6] = {0x3c, 0x22, 0xfb, 0, 0, 3};
+static const uint8_t ap1[6] = {0x00, 0x11, 0x22, 0, 0, 1};
+static const uint8_t ap2[6] = {0x00, 0x11, 0x22, 0, 0, 2};
+
+// addr1, addr2, addr3 as they appear in the header
+static void frame(uint8_t type, uint8_t ds, const uint8_t *a1,
+                  const uint8_t *a2, const uint8_t *a3, int8_t rssi,
+                  uint16_t len) {
+  test_pkt_t pkt;
+  memset(&pkt, 0, sizeof(pkt));
+  pkt.rx_ctrl.rssi = rssi;
+  pkt.rx_ctrl.channel = 6;
+  pkt.rx_ctrl.sig_len = len;
+  pkt.payload[0] = (type << 2) | 0x80; // Subtype 8: QoS data, or a beacon
+  pkt.payload[1] = ds;
+  memcpy(pkt.payload + 4, a1, 6);
+  memcpy(pkt.payload + 10, a2, 6);
+  memcpy(pkt.payload + 16, a3, 6);
+  station_tracker_record((const wifi_promiscuous_pkt_t *)&pkt);
+}
+
+static void uplink(const uint8_t *sta, const uint8_t *ap, int8_t rssi) {
+  frame(FRAME_TYPE_DATA, 0x01, ap, sta, ap, rssi, 100);
+}
+
+static void downlink(const uint8_t *sta, const uint8_t *ap, int8_t rssi) {
+  frame(FRAME_TYPE_DATA, 0x02, sta, ap, ap, rssi, 1500);
+}
+
+static const station_info_t *find(const station_info_t *list, int count,
+                                  const uint8_t *mac) {
+  for (int i = 0; i < count; i++) {
+    if (memcmp(list[i].mac, mac, 6) == 0) {
+      return &list[i];
+    }
+  }
+  return NULL;
+}
+
+static void test_record(void) {
+  static station_info_t list[8192];
+  const station_info_t *s;
+
+  // Nothing is kept before the table exists
+  uplink(sta1, ap1, -40);
+  CHECK_EQ(station_tracker_snapshot(list, 8192, STATION_SORT_RECENT), 0);
+
+  CHECK_EQ(station_tracker_start(), ESP_OK);
+  CHECK(consumer != NULL && strcmp(consumer, "stations") == 0);
+  CHECK(consumer_mask == FRAME_MASK_DATA);
+
+  now_us = 1000000;
+  uplink(sta1, ap1, -40);
+  now_us = 2000000;
+  downlink(sta1, ap1, -20); // The AP's signal: no RSSI sample
+  now_us = 3000000;
+  uplink(sta1, ap1, -56);
+
+  CHECK_EQ(station_tracker_snapshot(list, 8192, STATION_SORT_RECENT), 1);
+  CHECK(memcmp(list[0].mac, sta1, 6) == 0);
+  CHECK(memcmp(list[0].bssid, ap1, 6) == 0);
+  CHECK_EQ(list[0].first_seen_ms, 1000);
+  CHECK_EQ(list[0].last_seen_ms, 3000);
+  CHECK_EQ(list[0].frames, 3);
+  CHECK_EQ(list[0].bytes, 1700);
+  CHECK_EQ(list[0].channel, 6);
+  CHECK_EQ(list[0].rssi_x16, -640 - 32); // 1/8 of the way to -56 dBm
+
+  // Only heard from its AP, then roaming to another
+  now_us = 4000000;
+  downlink(sta2, ap1, -30);
+  downlink(sta2, ap1, -30);
+  downlink(sta2, ap1, -30);
+  downlink(sta2, ap1, -30);
+  now_us = 5000000;
+  downlink(sta2, ap2, -30);
+  // Direct link: the transmitter is the station, addr3 the BSSID
+  now_us = 6000000;
+  frame(FRAME_TYPE_DATA, 0x00, sta1, sta3, ap2, -70, 80);
+
+  // Not stations: WDS, group transmitter, AP to itself, management and
+  // runt frames
+  frame(FRAME_TYPE_DATA, 0x03, ap1, ap2, sta1, -50, 100);
+  static const uint8_t group[6] = {0x01, 0x00, 0x5e, 0, 0, 1};
+  uplink(group, ap1, -50);
+  uplink(ap1, ap1, -50);
+  frame(FRAME_TYPE_MGMT, 0x01, ap1, sta3, ap1, -50, 100);
+  frame(FRAME_TYPE_DATA, 0x01, ap1, sta3, ap1, -50, 23);
+
+  int count = station_tracker_snapshot(list, 8192, STATION_SORT_RECENT);
+  CHECK_EQ(count, 3);
+  CHECK(memcmp(list[0].mac, sta3, 6) == 0);
+  CHECK(memcmp(list[2].mac, sta1, 6) == 0);
+  s = find(list, count, sta2);
+  CHECK(s != NULL && memcmp(s->bssid, ap2, 6) == 0);
+  CHECK(s != NULL && s->rssi_x16 == 0 && s->frames == 5);
+  s = find(list, count, sta3);
+  CHECK(s != NULL && memcmp(s->bssid, ap2, 6) == 0 && s->frames == 1);
+
+  CHECK_EQ(station_tracker_snapshot(list, 8192, STATION_SORT_FRAMES), 3);
+  CHECK(memcmp(list[0].mac, sta2, 6) == 0);
+  CHECK(memcmp(list[1].mac, sta1, 6) == 0);
+
+  // Stations never heard transmitting sort last by signal
+  CHECK_EQ(station_tracker_snapshot(list, 8192, STATION_SORT_RSSI), 3);
+  CHECK(memcmp(list[0].mac, sta1, 6) == 0);
+  CHECK(memcmp(list[1].mac, sta3, 6) == 0);
+  CHECK(memcmp(list[2].mac, sta2, 6) == 0);
+
+  CHECK_EQ(station_tracker_snapshot(list, 2, STATION_SORT_RECENT), 2);
+
+  station_tracker_stop();
+  CHECK(consumer == NULL);
+  CHECK_EQ(station_tracker_snapshot(list, 8192, STATION_SORT_RECENT), 3);
+  station_tracker_reset();
+  CHECK_EQ(station_tracker_snapshot(list, 8192, STATION_SORT_RECENT), 0);
+}
+
+static void test_full_table(void) {
+  static station_info_t list[8192];
+  mac_table_stats_t stats;
+  uint8_t sta[6] = {0x3c, 0x22, 0xfb, 0, 0, 0};
+
+  // More stations than slots: the table stays full, never overflows
+  station_tracker_reset();
+  station_tracker_get_stats(&stats);
+  uint32_t capacity = stats.capacity;
+  CHECK(capacity > 0 && capacity <= 8192);
+  for (uint32_t i = 0; i < capacity + capacity / 2; i++) {
+    sta[3] = i >> 16;
+    sta[4] = i >> 8;
+    sta[5] = i;
+    now_us += 1000;
+    uplink(sta, ap1, -60);
+  }
+  station_tracker_get_stats(&stats);
+  CHECK(stats.count <= capacity && stats.count > capacity * 3 / 4);
+  CHECK(stats.evictions >= capacity / 2);
+  CHECK_EQ(station_tracker_snapshot(list, 8192, STATION_SORT_RECENT),
+           stats.count);
+  // The most recent station is always kept
+  CHECK(list[0].mac[3] == sta[3] && list[0].mac[4] == sta[4] &&
+        list[0].mac[5] == sta[5]);
+}
+
+int main(void) {
+  test_record();
+  test_full_table();
+  return test_report("station_tracker");
+}
@@ -0,0 +1,135 @@
+// test_timebase.c
+//
+// main/core/timebase.c against a simulated oscillator that runs 25 ppm slow
+// and a GPS receiver whose fixes reach the firmware 0-200 ms after the
+// second they describe. Checks the source ranking, the step on the first
+// fix, how close the disciplined clock settles and the drift it learns,
+// holdover without fixes, a stale source being replaced and the system
+// clock being kept in step. gettimeofday and settimeofday are redirected
+// to a simulated system clock by timebase_CFLAGS.
+
+#include "core/timebase.h"
+#include "test.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define EPOCH_US 1760000000000000LL // UTC at the start of the run
+#define SLOW_PPM 25
+#define LATENCY_MAX_US 200000
+
+static int64_t true_us; // Time since the start of the run
+static int64_t system_us; // The simulated system clock, UTC
+static uint32_t rng = 1;
+static int64_t drift_sum, drift_min, drift_max;
+static int drift_samples;
+
+// The oscillator loses SLOW_PPM microseconds every second.
+static int64_t local_of(int64_t t) { return t - t * SLOW_PPM / 1000000; }
+
+int64_t esp_timer_get_time(void) { return local_of(true_us); }
+
+int host_gettimeofday(struct timeval *tv, void *tz) {
+  tv->tv_sec = system_us / 1000000;
+  tv->tv_usec = system_us % 1000000;
+  return 0;
+}
+
+int host_settimeofday(const struct timeval *tv, const struct timezone *tz) {
+  system_us = (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+  return 0;
+}
+
+// Disciplined UTC minus true UTC, now.
+static int64_t error_us(void) {
+  return timebase_now_utc_us() - (EPOCH_US + true_us);
+}
+
+// One fix per second for seconds, each handled after a random delay.
+// Returns the largest error seen at the fixes after settle_s, and samples
+// the drift estimate once a minute from there on.
+static int64_t run_gps(int seconds, int settle_s) {
+  int64_t worst = 0;
+  int64_t first = true_us / 1000000 + 1;
+  for (int64_t k = first; k < first + seconds; k++) {
+    rng = rng * 1103515245u + 12345u;
+    true_us = k * 1000000 + (rng >> 8) % LATENCY_MAX_US;
+    timebase_discipline(TIMEBASE_SOURCE_GPS, EPOCH_US + k * 1000000,
+                        esp_timer_get_time());
+    if (k - first < settle_s) {
+      continue;
+    }
+    if (llabs(error_us()) > worst) {
+      worst = llabs(error_us());
+    }
+    if ((k - first) % 60 == 0) {
+      int64_t drift = timebase_get_state().drift_ppb;
+      drift_min = drift_samples == 0 || drift < drift_min ? drift : drift_min;
+      drift_max = drift_samples == 0 || drift > drift_max ? drift : drift_max;
+      drift_sum += drift;
+      drift_samples++;
+    }
+  }
+  return worst;
+}
+
+int main(void) {
+  CHECK_EQ(timebase_get_state().source, TIMEBASE_SOURCE_NONE);
+  CHECK_EQ(timebase_now_utc_us(), esp_timer_get_time());
+
+  // An RTC only knows whole seconds.
+  true_us = 400000;
+  timebase_discipline(TIMEBASE_SOURCE_RTC, EPOCH_US, esp_timer_get_time());
+  CHECK_EQ(timebase_get_state().source, TIMEBASE_SOURCE_RTC);
+  CHECK(llabs(error_us()) <= 400000);
+
+  // The first fix steps straight to GPS time.
+  run_gps(1, 0);
+  CHECK_EQ(timebase_get_state().source, TIMEBASE_SOURCE_GPS);
+  CHECK(llabs(error_us()) <= LATENCY_MAX_US);
+
+  // Two hours of fixes, judged over the second. Each drift estimate is a
+  // slope over a 300 s window of fixes jittered by up to 200 ms, so single
+  // estimates wander by several ppm; their mean is what has to be right.
+  drift_sum = drift_samples = 0;
+  int64_t settled = run_gps(7200, 3600);
+  int64_t drift_mean = drift_sum / drift_samples;
+  printf("  %d ppm slow clock, 0-%d ms fix latency: settled within %.1f ms, "
+         "drift estimate %.1f ppm (%.1f to %.1f)\n",
+         SLOW_PPM, LATENCY_MAX_US / 1000, settled / 1000.0,
+         drift_mean / 1000.0, drift_min / 1000.0, drift_max / 1000.0);
+  CHECK(settled < 40000);
+  CHECK(llabs(drift_mean - SLOW_PPM * 1000) < 5000);
+  CHECK(drift_min > 0 && drift_max < 2 * SLOW_PPM * 1000);
+  // The system clock was stepped onto the timebase and kept there.
+  CHECK(llabs(system_us - timebase_now_utc_us()) <= 50000);
+
+  // NTP does not override a GPS that is still being heard.
+  int64_t before = timebase_get_state().offset_us;
+  true_us += 1000000;
+  timebase_discipline(TIMEBASE_SOURCE_NTP, EPOCH_US + true_us + 300000,
+                      esp_timer_get_time());
+  CHECK_EQ(timebase_get_state().source, TIMEBASE_SOURCE_GPS);
+  CHECK_EQ(timebase_get_state().offset_us, before);
+
+  // Nine minutes without fixes coast on the learned drift.
+  true_us += 9 * 60 * 1000000LL;
+  int64_t holdover = llabs(error_us());
+  printf("  after 9 minutes without fixes: %.1f ms off\n", holdover / 1000.0);
+  // The settled bound plus nine minutes of a 5 ppm drift error.
+  CHECK(holdover < 40000 + 9 * 60 * 5);
+
+  // Past ten minutes GPS is stale and NTP takes over.
+  true_us += 2 * 60 * 1000000LL;
+  timebase_discipline(TIMEBASE_SOURCE_NTP, EPOCH_US + true_us,
+                      esp_timer_get_time());
+  CHECK_EQ(timebase_get_state().source, TIMEBASE_SOURCE_NTP);
+  CHECK(llabs(error_us()) < 1000);
+
+  // A GPS fix wins it back at once.
+  CHECK(run_gps(1, 0) <= LATENCY_MAX_US);
+  CHECK_EQ(timebase_get_state().source, TIMEBASE_SOURCE_GPS);
+
+  CHECK(strcmp(timebase_source_name(TIMEBASE_SOURCE_GPS), "gps") == 0);
+  return test_report("timebase");
+}
@@ -0,0 +1,305 @@
+// test_ubx_protocol.c
+//
+// UBX framing and NAV-PVT decoding from main/vendor/GPS/ubx_protocol.c:
+// a recorded-style stream of NAV-PVT frames mixed with NMEA text, damaged
+// and oversized frames is replayed byte by byte, and the CFG builders are
+// checked against bytes from the u-blox protocol description.
+
+#include "vendor/GPS/ubx_protocol.h"
+#include "test.h"
+#include <string.h>
+
+typedef struct {
+  uint16_t year;
+  uint8_t month, day, hour, minute, second;
+  uint8_t valid; // Bit 0 date, bit 1 time
+  int32_t nano;
+  uint8_t fix_type, flags, sats;
+  int32_t lon_e7, lat_e7, height_mm, msl_mm;
+  int32_t speed_mm_s, heading_e5;
+  uint16_t pdop;
+  int16_t mag_dec;
+} pvt_t;
+
+static void put32(uint8_t *p, uint32_t v) {
+  p[0] = v;
+  p[1] = v >> 8;
+  p[2] = v >> 16;
+  p[3] = v >> 24;
+}
+
+static size_t pvt_frame(uint8_t *out, const pvt_t *pvt) {
+  uint8_t p[UBX_NAV_PVT_LEN] = {0};
+  p[4] = pvt->year;
+  p[5] = pvt->year >> 8;
+  p[6] = pvt->month;
+  p[7] = pvt->day;
+  p[8] = pvt->hour;
+  p[9] = pvt->minute;
+  p[10] = pvt->second;
+  p[11] = pvt->valid;
+  put32(p + 16, pvt->nano);
+  p[20] = pvt->fix_type;
+  p[21] = pvt->flags;
+  p[23] = pvt->sats;
+  put32(p + 24, pvt->lon_e7);
+  put32(p + 28, pvt->lat_e7);
+  put32(p + 32, pvt->height_mm);
+  put32(p + 36, pvt->msl_mm);
+  put32(p + 60, pvt->speed_mm_s);
+  put32(p + 64, pvt->heading_e5);
+  p[76] = pvt->pdop;
+  p[77] = pvt->pdop >> 8;
+  p[88] = pvt->mag_dec;
+  p[89] = (uint16_t)pvt->mag_dec >> 8;
+  return ubx_build_frame(out, UBX_CLASS_NAV, UBX_ID_NAV_PVT, p, sizeof(p));
+}
+
+static const pvt_t moving = {
+    .year = 2026, .month = 3, .day = 17, .hour = 8, .minute = 35,
+    .second = 59, .valid = 0x03, .nano = 250000000, .fix_type = 3,
+    .flags = 0x01, .sats = 11, .lon_e7 = -1223456789, .lat_e7 = 473456789,
+    .height_mm = 60000, .msl_mm = 12345, .speed_mm_s = 1543,
+    .heading_e5 = 9012345, .pdop = 120, .mag_dec = -150,
+};
+
+typedef struct {
+  int fixes;
+  nmea_data_t data;
+} replay_t;
+
+static void replay(ubx_parser_t *parser, replay_t *r, const uint8_t *bytes,
+                   size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    if (ubx_parser_feed(parser, bytes[i]) && parser->cls == UBX_CLASS_NAV &&
+        parser->id == UBX_ID_NAV_PVT &&
+        ubx_decode_nav_pvt(parser->payload, parser->len, &r->data)) {
+      r->fixes++;
+    }
+  }
+}
+
+static void test_replay(void) {
+  static uint8_t stream[8192];
+  uint8_t frame[UBX_MAX_PAYLOAD + UBX_FRAME_OVERHEAD];
+  static const char nmea[] = "$GNGGA,,,,,,0,00,99.99,,,,,,*56\r\n";
+  size_t len = 0, n = pvt_frame(frame, &moving);
+
+  // Until the switch to UBX lands, NMEA text shares the line.
+  for (int epoch = 0; epoch < 20; epoch++) {
+    memcpy(stream + len, nmea, sizeof(nmea) - 1);
+    len += sizeof(nmea) - 1;
+    if (epoch == 3) {
+      stream[len++] = UBX_SYNC_1; // False start right before a real frame
+    }
+    memcpy(stream + len, frame, n);
+    if (epoch == 5) {
+      stream[len + 40] ^= 0x10; // Corrupted payload byte
+    }
+    if (epoch == 9) {
+      stream[len + n - 1] ^= 0x01; // Corrupted second checksum byte
+    }
+    len += n;
+    if (epoch == 12) {
+      // NAV-SAT is longer than the parser keeps: checked, then skipped
+      static uint8_t sat[8 + 300];
+      uint8_t body[300];
+      memset(body, 0xA5, sizeof(body));
+      sat[0] = UBX_SYNC_1;
+      sat[1] = UBX_SYNC_2;
+      sat[2] = UBX_CLASS_NAV;
+      sat[3] = 0x35;
+      sat[4] = sizeof(body) & 0xff;
+      sat[5] = sizeof(body) >> 8;
+      memcpy(sat + 6, body, sizeof(body));
+      uint8_t ck_a = 0, ck_b = 0;
+      for (size_t i = 2; i < 6 + sizeof(body); i++) {
+        ck_a += sat[i];
+        ck_b += ck_a;
+      }
+      sat[6 + sizeof(body)] = ck_a;
+      sat[7 + sizeof(body)] = ck_b;
+      memcpy(stream + len, sat, sizeof(sat));
+      len += sizeof(sat);
+    }
+  }
+
+  ubx_parser_t parser;
+  replay_t r;
+  memset(&parser, 0, sizeof(parser));
+  memset(&r, 0, sizeof(r));
+  replay(&parser, &r, stream, len);
+
+  CHECK_EQ(r.fixes, 18);
+  CHECK_EQ(parser.checksum_errors, 2);
+  CHECK_EQ(parser.frames, 19); // Includes the NAV-SAT frame
+
+  const nmea_data_t *d = &r.data;
+  CHECK_EQ(d->lat_e7, 473456789);
+  CHECK_EQ(d->lon_e7, -1223456789);
+  CHECK_EQ(d->alt_cm, 1234);
+  CHECK_EQ(d->geoid_cm, 4765);
+  CHECK(d->year == 26 && d->month == 3 && d->day == 17);
+  CHECK(d->hour == 8 && d->minute == 35 && d->second == 59);
+  CHECK_EQ(d->millis, 250);
+  CHECK(d->valid && d->fix == 1 && d->fix_mode == 3);
+  CHECK_EQ(d->sats_in_use, 11);
+  CHECK_EQ(d->speed_mm_s, 1543);
+  CHECK_EQ(d->course_x100, 9012);
+  CHECK_EQ(d->variation_x100, -150);
+  CHECK(d->pdop_x100 == 120 && d->hdop_x100 == 120 && d->vdop_x100 == 120);
+}
+
+static void test_decode_cases(void) {
+  uint8_t frame[UBX_MAX_PAYLOAD + UBX_FRAME_OVERHEAD];
+  nmea_data_t d;
+  pvt_t pvt;
+
+  memset(&d, 0, sizeof(d));
+  CHECK(ubx_decode_nav_pvt(frame + 6, pvt_frame(frame, &moving) - 8, &d));
+  CHECK(!ubx_decode_nav_pvt(frame + 6, UBX_NAV_PVT_LEN - 1, &d));
+
+  // Lost fix: position and date stay as they were, status drops
+  pvt = moving;
+  pvt.flags = 0;
+  pvt.valid = 0;
+  pvt.lat_e7 = 0;
+  pvt.year = 2030;
+  pvt_frame(frame, &pvt);
+  CHECK(ubx_decode_nav_pvt(frame + 6, UBX_NAV_PVT_LEN, &d));
+  CHECK(!d.valid && d.fix == 0 && d.fix_mode == 1);
+  CHECK_EQ(d.lat_e7, 473456789);
+  CHECK_EQ(d.year, 26);
+
+  // Differential, 2D, time-only and dead-reckoning-free cases
+  pvt = moving;
+  pvt.flags = 0x03;
+  pvt.fix_type = 2;
+  pvt_frame(frame, &pvt);
+  CHECK(ubx_decode_nav_pvt(frame + 6, UBX_NAV_PVT_LEN, &d));
+  CHECK(d.valid && d.fix == 2 && d.fix_mode == 2);
+  pvt.fix_type = 5; // Time only
+  pvt_frame(frame, &pvt);
+  CHECK(ubx_decode_nav_pvt(frame + 6, UBX_NAV_PVT_LEN, &d));
+  CHECK(!d.valid && d.fix == 0);
+
+  // Rounding edges: negative nanoseconds, full-circle heading, negative
+  // speed
+  pvt = moving;
+  pvt.nano = -5000;
+  pvt.heading_e5 = 36000000;
+  pvt.speed_mm_s = -3;
+  pvt_frame(frame, &pvt);
+  CHECK(ubx_decode_nav_pvt(frame + 6, UBX_NAV_PVT_LEN, &d));
+  CHECK_EQ(d.millis, 0);
+  CHECK_EQ(d.course_x100, 0);
+  CHECK_EQ(d.speed_mm_s, 0);
+  pvt.year = 1999;
+  pvt.day = 1;
+  pvt_frame(frame, &pvt);
+  CHECK(ubx_decode_nav_pvt(frame + 6, UBX_NAV_PVT_LEN, &d));
+  CHECK_EQ(d.day, 17); // Receiver without a date yet
+}
+
+static void test_ack(void) {
+  uint8_t frame[16];
+  const uint8_t target[2] = {UBX_CLASS_CFG, UBX_ID_CFG_RATE};
+  ubx_parser_t parser;
+  int result;
+
+  static const struct {
+    uint8_t id;
+    uint8_t cls, msg;
+    int expect;
+  } cases[] = {
+      {UBX_ID_ACK_ACK, UBX_CLASS_CFG, UBX_ID_CFG_RATE, 1},
+      {UBX_ID_ACK_NAK, UBX_CLASS_CFG, UBX_ID_CFG_RATE, 0},
+      {UBX_ID_ACK_ACK, UBX_CLASS_CFG, UBX_ID_CFG_PRT, -1},
+  };
+  for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+    uint8_t payload[2] = {cases[c].cls, cases[c].msg};
+    size_t n = ubx_build_frame(frame, UBX_CLASS_ACK, cases[c].id, payload, 2);
+    memset(&parser, 0, sizeof(parser));
+    result = -2;
+    for (size_t i = 0; i < n; i++) {
+      if (ubx_parser_feed(&parser, frame[i])) {
+        result = ubx_parser_ack(&parser, target[0], target[1]);
+      }
+    }
+    CHECK_EQ(result, cases[c].expect);
+  }
+
+  // A NAV frame is never an acknowledgement
+  memset(&parser, 0, sizeof(parser));
+  size_t n = ubx_build_frame(frame, UBX_CLASS_NAV, UBX_ID_NAV_PVT, target, 2);
+  for (size_t i = 0; i < n; i++) {
+    ubx_parser_feed(&parser, frame[i]);
+  }
+  CHECK_EQ(ubx_parser_ack(&parser, target[0], target[1]), -1);
+}
+
+static bool bytes_equal(const uint8_t *a, size_t a_len, const uint8_t *b,
+                        size_t b_len) {
+  return a_len == b_len && memcmp(a, b, a_len) == 0;
+}
+
+static void test_builders(void) {
+  uint8_t out[64];
+  size_t n;
+
+  // Frames as listed in the u-blox M8 protocol description
+  static const uint8_t rate_200ms[] = {0xB5, 0x62, 0x06, 0x08, 0x06, 0x00, 0xC8,
+                                       0x00, 0x01, 0x00, 0x01, 0x00, 0xDE, 0x6A};
+  n = ubx_build_cfg_rate(out, 200);
+  CHECK(bytes_equal(out, n, rate_200ms, sizeof(rate_200ms)));
+
+  static const uint8_t msg_pvt[] = {0xB5, 0x62, 0x06, 0x01, 0x03, 0x00,
+                                    0x01, 0x07, 0x01, 0x13, 0x51};
+  n = ubx_build_cfg_msg(out, UBX_CLASS_NAV, UBX_ID_NAV_PVT, 1);
+  CHECK(bytes_equal(out, n, msg_pvt, sizeof(msg_pvt)));
+
+  // CFG-VALSET: value sizes come from the key
+  const ubx_cfg_item_t items[] = {
+      {UBX_KEY_UART1OUTPROT_NMEA, 0},
+      {UBX_KEY_UART1_BAUDRATE, 115200},
+      {UBX_KEY_RATE_MEAS, 100},
+  };
+  static const uint8_t valset_payload[] = {
+      0x00, 0x01, 0x00, 0x00,                         // Version, RAM layer
+      0x02, 0x00, 0x74, 0x10, 0x00,                   // 1-byte value
+      0x01, 0x00, 0x52, 0x40, 0x00, 0xC2, 0x01, 0x00, // 4-byte value
+      0x01, 0x00, 0x21, 0x30, 0x64, 0x00,             // 2-byte value
+  };
+  n = ubx_build_cfg_valset(out, items, 3);
+  CHECK_EQ(n, sizeof(valset_payload) + UBX_FRAME_OVERHEAD);
+  CHECK(out[2] == UBX_CLASS_CFG && out[3] == UBX_ID_CFG_VALSET);
+  CHECK(out[4] == sizeof(valset_payload) && out[5] == 0);
+  CHECK(memcmp(out + 6, valset_payload, sizeof(valset_payload)) == 0);
+
+  // Everything built must parse back with a good checksum
+  ubx_parser_t parser;
+  int frames = 0;
+  memset(&parser, 0, sizeof(parser));
+  for (size_t i = 0; i < n; i++) {
+    frames += ubx_parser_feed(&parser, out[i]);
+  }
+  n = ubx_build_cfg_prt_uart1(out, 115200, false);
+  for (size_t i = 0; i < n; i++) {
+    frames += ubx_parser_feed(&parser, out[i]);
+  }
+  CHECK_EQ(frames, 2);
+  CHECK_EQ(parser.checksum_errors, 0);
+  CHECK(parser.cls == UBX_CLASS_CFG && parser.id == UBX_ID_CFG_PRT);
+  CHECK(parser.len == 20 && parser.payload[0] == 1);
+  CHECK(parser.payload[8] == 0x00 && parser.payload[9] == 0xC2 &&
+        parser.payload[10] == 0x01);
+  CHECK(parser.payload[14] == 0x01); // UBX out only
+}
+
+int main(void) {
+  test_replay();
+  test_decode_cases();
+  test_ack();
+  test_builders();
+  return test_report("ubx_protocol");
+}
@@ -0,0 +1,188 @@
+// ghost_wardrive_convert.c
+//
+// Turns Ghost ESP binary wardriving logs (.gwd, "startwd -bin") into WiGLE
+// 1.6 CSV. Build from this directory with any C99 compiler:
+//
+//   cc -O2 -I../../include -o ghost_wardrive_convert ghost_wardrive_convert.c
+//      ../../main/vendor/GPS/wardrive_format.c
+//
+// Rows are formatted by the same code the device uses for CSV logs, so both
+// paths give identical output. Blocks that fail their CRC are skipped and
+// counted; the converter then looks for the next block magic, so one bad
+// sector costs at most one block. Assumes a little endian host, like the
+// device.
+
+#include "vendor/GPS/wardrive_format.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned long blocks_ok = 0;
+static unsigned long blocks_bad = 0;
+static unsigned long records_out = 0;
+static unsigned long bytes_skipped = 0;
+
+static uint8_t *read_all(FILE *in, size_t *len) {
+  size_t cap = 1 << 16, used = 0;
+  uint8_t *data = malloc(cap);
+  size_t n;
+  while (data != NULL && (n = fread(data + used, 1, cap - used, in)) > 0) {
+    used += n;
+    if (used == cap) {
+      uint8_t *grown = realloc(data, cap * 2);
+      if (grown == NULL) {
+        free(data);
+        return NULL;
+      }
+      data = grown;
+      cap *= 2;
+    }
+  }
+  *len = used;
+  return data;
+}
+
+static void write_block(FILE *out, const uint8_t *records, uint16_t count,
+                        uint16_t record_size) {
+  char row[WARDRIVE_CSV_ROW_MAX];
+  for (uint16_t i = 0; i < count; i++) {
+    // Newer logs may append fields; the known prefix is all we format.
+    wardrive_record_t record;
+    memcpy(&record, records + (size_t)i * record_size, sizeof(record));
+    int len = wardrive_format_csv_row(&record, row, sizeof(row));
+    if (len > 0) {
+      fwrite(row, 1, len, out);
+      records_out++;
+    }
+  }
+}
+
+static int convert(const uint8_t *data, size_t len, FILE *out) {
+  wardrive_log_header_t header;
+  if (len < sizeof(header)) {
+    fprintf(stderr, "file too short for a log header\n");
+    return 1;
+  }
+  memcpy(&header, data, sizeof(header));
+  if (memcmp(header.magic, WARDRIVE_LOG_MAGIC, sizeof(header.magic)) != 0) {
+    fprintf(stderr, "not a Ghost ESP wardriving log\n");
+    return 1;
+  }
+  if (header.version != WARDRIVE_LOG_VERSION) {
+    fprintf(stderr, "log version %u, expected %u; trying anyway\n",
+            header.version, WARDRIVE_LOG_VERSION);
+  }
+  if (header.record_size < sizeof(wardrive_record_t) ||
+      header.block_records == 0) {
+    fprintf(stderr, "unsupported record size %u\n", header.record_size);
+    return 1;
+  }
+
+  char text[512];
+  int text_len = wardrive_format_csv_header(text, sizeof(text));
+  fwrite(text, 1, text_len, out);
+
+  size_t pos = sizeof(header);
+  // Rotated logs continue the sequence, so the first block sets it.
+  int have_seq = 0;
+  uint32_t expected_seq = 0;
+  while (pos + sizeof(wardrive_block_header_t) <= len) {
+    wardrive_block_header_t block;
+    memcpy(&block, data + pos, sizeof(block));
+    size_t body = (size_t)block.count * header.record_size;
+
+    if (block.magic != WARDRIVE_BLOCK_MAGIC || block.count == 0 ||
+        block.count > header.block_records) {
+      // Not a block start: pre-allocated space or damage. Resync.
+      pos++;
+      bytes_skipped++;
+      continue;
+    }
+    if (pos + sizeof(block) + body > len) {
+      fprintf(stderr, "block %u truncated, %u record(s) lost\n", block.seq,
+              block.count);
+      blocks_bad++;
+      break;
+    }
+
+    const uint8_t *records = data + pos + sizeof(block);
+    if (wardrive_crc32(0, records, body) != block.crc) {
+      fprintf(stderr, "block %u failed the CRC check, %u record(s) skipped\n",
+              block.seq, block.count);
+      blocks_bad++;
+      pos++;
+      continue;
+    }
+    if (have_seq && block.seq != expected_seq) {
+      fprintf(stderr, "blocks %u to %u missing\n", expected_seq, block.seq - 1);
+    }
+    have_seq = 1;
+    expected_seq = block.seq + 1;
+
+    write_block(out, records, block.count, header.record_size);
+    blocks_ok++;
+    pos += sizeof(block) + body;
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  const char *input = "-";
+  const char *output = "-";
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+      fprintf(stderr,
+              "usage: %s [-o out.csv] [log.gwd|-]\n"
+              "  Writes WiGLE 1.6 CSV to out.csv, or stdout\n",
+              argv[0]);
+      return 2;
+    } else {
+      input = argv[i];
+    }
+  }
+
+  FILE *in = strcmp(input, "-") == 0 ? stdin : fopen(input, "rb");
+  if (in == NULL) {
+    fprintf(stderr, "cannot open %s: %s\n", input, strerror(errno));
+    return 1;
+  }
+  size_t len;
+  uint8_t *data = read_all(in, &len);
+  if (in != stdin) {
+    fclose(in);
+  }
+  if (data == NULL) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  FILE *out = strcmp(output, "-") == 0 ? stdout : fopen(output, "w");
+  if (out == NULL) {
+    fprintf(stderr, "cannot create %s: %s\n", output, strerror(errno));
+    free(data);
+    return 1;
+  }
+
+  int ret = convert(data, len, out);
+  free(data);
+  if (out != stdout) {
+    fclose(out);
+  }
+  if (ret != 0) {
+    return ret;
+  }
+  fprintf(stderr, "%lu record(s) from %lu block(s)", records_out, blocks_ok);
+  if (blocks_bad > 0) {
+    fprintf(stderr, ", %lu bad block(s)", blocks_bad);
+  }
+  if (bytes_skipped > 0) {
+    fprintf(stderr, ", %lu byte(s) skipped", bytes_skipped);
+  }
+  fprintf(stderr, "\n");
+  return blocks_bad > 0 ? 3 : 0;
+}